@@ -0,0 +1,60 @@
+// AlgorithmParams.h - 类型化的算法参数（参数表集中声明，加载时解析与校验）
+
+#ifndef ALGORITHM_PARAMS_H
+#define ALGORITHM_PARAMS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// 参数类型
+enum class ParamType {
+    BOOL,    // 布尔值（true/false/1/0）
+    DOUBLE   // 浮点数
+};
+
+struct AlgorithmParams;
+
+// 参数声明（名称、类型、取值范围、默认值及对应的字段，只有与类型一致的字段指针非空）
+struct ParamSpec {
+    const char* name;                       // 参数名
+    ParamType type;                         // 参数类型
+    double minValue;                        // 最小值（布尔参数忽略）
+    double maxValue;                        // 最大值（布尔参数忽略）
+    double defaultValue;                    // 默认值（布尔参数非0为true）
+    bool AlgorithmParams::* boolField;      // 布尔字段
+    double AlgorithmParams::* doubleField;  // 浮点字段
+    const char* description;                // 说明
+};
+
+// 算法参数
+// 配置加载时按参数表解析成普通字段，处理路径上直接读取字段，不再按字符串查找映射表；
+// 未声明的参数名和无法解析、超出范围的值在加载时报告，保留默认值
+struct AlgorithmParams {
+    double smoothingFactor;      // 平滑系数
+    double confidenceThreshold;  // 置信度阈值
+    bool stopOnInvalid;          // 位置无效时提前终止处理器链
+
+    // 构造函数（按参数表设置默认值）
+    AlgorithmParams();
+
+    // 获取参数表
+    static const std::vector<ParamSpec>& schema();
+
+    // 查找参数声明，未声明时返回nullptr
+    static const ParamSpec* find(const std::string& name);
+
+    // 设置一个参数，参数未声明或值无效时返回false并在error中说明原因
+    bool set(const std::string& name, const std::string& value, std::string& error);
+
+    // 将一个参数恢复为默认值，参数未声明时返回false
+    bool reset(const std::string& name);
+
+    // 按参数表转换为"参数名 -> 值"（用于保存配置）
+    std::map<std::string, std::string> toMap() const;
+
+    // 从"参数名 -> 值"解析，问题（未声明的参数、无效的值）逐条加入errors
+    static AlgorithmParams resolve(const std::map<std::string, std::string>& raw, std::vector<std::string>& errors);
+};
+
+#endif // ALGORITHM_PARAMS_H
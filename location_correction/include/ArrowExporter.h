@@ -0,0 +1,60 @@
+// ArrowExporter.h - 位置历史数据导出为Arrow IPC文件
+
+#ifndef ARROW_EXPORTER_H
+#define ARROW_EXPORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StorageQuery.h"
+
+// Arrow IPC文件扩展名（Feather v2）
+extern const char* const ARROW_FILE_EXTENSION;
+
+// 导出统计
+struct ArrowExportStats {
+    size_t sourcesExported;  // 导出的文件数（含内存数据）
+    size_t sourcesPruned;    // 根据索引跳过的文件数
+    uint64_t rowsExported;   // 导出的行数
+    size_t recordBatches;    // 写入的记录批次数
+    uint64_t bytesWritten;   // 写入的字节数
+    long long elapsedMs;     // 导出耗时（毫秒）
+
+    ArrowExportStats() :
+        sourcesExported(0),
+        sourcesPruned(0),
+        rowsExported(0),
+        recordBatches(0),
+        bytesWritten(0),
+        elapsedMs(0) {}
+};
+
+// Arrow IPC文件导出器
+// 直接按Arrow列式格式编码，不依赖Arrow库：段文件逐块解码后按列筛选拷贝，不还原为LocationInfo。
+// 各文件由工作线程并行编码为记录批次，主线程按时间顺序写入，同时在途的文件数有上限以限制内存。
+// 导出的列：timestamp(毫秒时间戳，UTC)、device_id、latitude、longitude、altitude、accuracy、
+// speed、direction、source_type、status
+class ArrowExporter {
+private:
+    size_t threadCount;                    // 编码线程数
+    size_t batchRowCount;                  // 每个记录批次的最大行数
+    QueryExecutor::LineParser lineParser;  // CSV日志行解析函数
+
+public:
+    explicit ArrowExporter(size_t threads = 0);
+
+    // 设置每个记录批次的最大行数
+    void setBatchRowCount(size_t rowCount);
+
+    // 设置CSV日志行解析函数（未设置时遇到CSV日志文件导出失败）
+    void setLineParser(const QueryExecutor::LineParser& parser) { lineParser = parser; }
+
+    // 将一组段文件（.lcs）、日志文件（.log）和内存数据中满足条件的数据导出到Arrow IPC文件
+    // 先写入临时文件，成功后再替换目标文件；任一来源无法读取时导出失败，目标文件保持不变；
+    // 忽略predicate中的limit和latestFirst
+    bool exportFiles(const std::vector<std::string>& files, const QueryPredicate& predicate,
+                     const std::string& outputPath, ArrowExportStats* stats = nullptr,
+                     const LocationColumns* memoryRows = nullptr);
+};
+
+#endif // ARROW_EXPORTER_H
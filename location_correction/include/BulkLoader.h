@@ -0,0 +1,104 @@
+// BulkLoader.h - 历史数据批量导入
+
+#ifndef BULK_LOADER_H
+#define BULK_LOADER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "LocationCodec.h"
+
+// 批量导入时对单个设备轨迹的校正函数
+// 输入为按时间排序的同一设备的位置数据，可原地修改、删除或追加，返回后按时间重新排序。
+// 不同设备的轨迹在threadCount个线程中并发校正，校正函数必须可重入，访问共享状态时需自行加锁
+using BulkCorrection = std::function<void(const std::string& deviceId, std::vector<LocationInfo>& track)>;
+
+// 批量导入参数
+struct BulkLoadOptions {
+    size_t threadCount;         // 校正和写入线程数（0表示使用CPU核数），校正函数会被并发调用
+    size_t blockRowCount;       // 每个压缩块的行数
+    size_t segmentRowCount;     // 每个段文件的最大行数
+    size_t runRowCount;         // 内存中缓存的最大行数，达到后排序并写出一批段文件
+    BulkCorrection correction;  // 校正函数（为空表示数据已校正，直接写入）
+
+    BulkLoadOptions() :
+        threadCount(0),
+        blockRowCount(4096),
+        segmentRowCount(1024 * 1024),
+        runRowCount(4 * 1024 * 1024) {}
+};
+
+// 批量导入统计
+struct BulkLoadStats {
+    uint64_t rowsAdded;      // 添加的行数
+    uint64_t rowsWritten;    // 写入段文件的行数（校正可能增删数据）
+    size_t devicesCorrected; // 校正的设备轨迹数（同一设备在不同批次中分别计数）
+    size_t segmentsWritten;  // 写入的段文件数
+    uint64_t bytesWritten;   // 写入的字节数
+    long long elapsedMs;     // 耗时（毫秒）
+
+    BulkLoadStats() :
+        rowsAdded(0),
+        rowsWritten(0),
+        devicesCorrected(0),
+        segmentsWritten(0),
+        bytesWritten(0),
+        elapsedMs(0) {}
+};
+
+// 历史数据批量导入器
+// 不经过数据源、处理链、纠偏器和存储的实时写入路径，不写预写日志，也不触发监听回调：
+// 数据在内存中缓存到runRowCount行后，按设备分组并行校正（可选），再按时间排序切分为多个段文件并行编码写入。
+// 段文件先以临时文件名写入，finish()时全部落盘后才重命名发布，发布前对查询不可见；
+// 发布要么全部成功，要么撤销已完成的重命名，不留下部分导入的数据；中途放弃时删除所有临时文件。
+// 校正以批次为单位，同一设备跨批次的轨迹分别校正，按设备或按时间顺序添加数据可减少轨迹被切断
+class BulkLoader {
+private:
+    std::string storagePath;                         // 存储目录
+    BulkLoadOptions options;                         // 导入参数
+    LocationColumns buffer;                          // 尚未写出的数据
+    std::vector<std::string> stagedFiles;            // 已写入但尚未发布的段文件（最终路径）
+    BulkLoadStats stats;                             // 统计
+    std::chrono::steady_clock::time_point startTime; // 开始时间
+    bool failed;                                     // 是否已失败
+    bool finished;                                   // 是否已完成
+
+    // 校正、排序并写出缓存中的数据
+    bool flushRun();
+
+    // 按设备分组并行校正，校正函数抛出异常时返回false
+    bool correctRun(LocationColumns& run);
+
+    // 将排序后的第begin到end行写入段文件的临时文件
+    bool writeSegment(const LocationColumns& run, const std::vector<uint32_t>& order,
+                      size_t begin, size_t end, const std::string& path, uint64_t& bytes) const;
+
+    // 生成不冲突的段文件路径并加入待发布列表
+    std::string reservePath(long long minTimestamp);
+
+    // 撤销前count个段文件的发布
+    void unpublish(size_t count);
+
+public:
+    explicit BulkLoader(const std::string& storageDirectory, const BulkLoadOptions& loadOptions = BulkLoadOptions());
+    ~BulkLoader();
+
+    BulkLoader(const BulkLoader&) = delete;
+    BulkLoader& operator=(const BulkLoader&) = delete;
+
+    // 添加一批列式数据
+    bool add(const LocationColumns& rows);
+
+    // 添加一批位置数据
+    bool add(const std::vector<LocationInfo>& locations);
+
+    // 写出剩余数据并发布所有段文件
+    bool finish(BulkLoadStats* loadStats = nullptr);
+
+    // 放弃导入，删除已写入的临时文件
+    void abort();
+};
+
+#endif // BULK_LOADER_H
@@ -0,0 +1,122 @@
+// ChangeFeed.h - 存储变更订阅（CDC）
+
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "LocationCodec.h"
+
+class WriteAheadLog;
+class ChangeSubscription;
+
+// 一批变更（对应预写日志中的一条记录，即一次store或batchStore写入的数据）
+struct ChangeBatch {
+    uint64_t offset;       // 本批数据的偏移（记录起始LSN）
+    uint64_t nextOffset;   // 下一批数据的偏移，处理完本批后保存该值即可从此处继续订阅
+    LocationColumns rows;  // 本批位置数据（按写入顺序）
+
+    ChangeBatch() : offset(0), nextOffset(0) {}
+};
+
+// 存储变更订阅源
+// 以预写日志为变更日志：偏移为日志序号（LSN），单调递增且在重启和清空后不回退。
+// 写入方每追加一条记录后发布新的日志末尾并唤醒等待的订阅者；订阅者各自映射日志文件直接读取，
+// 不经过写入方的缓冲区，多个订阅者共享操作系统页缓存，不会成倍增加磁盘读取。
+// 日志清理时保留所有订阅者尚未读取的部分，以及最近retentionBytes字节供离线的消费者断点续读
+class ChangeFeed : public std::enable_shared_from_this<ChangeFeed> {
+private:
+    std::string directory;                  // 预写日志目录
+    mutable std::mutex mutex;               // 互斥锁
+    std::condition_variable appended;       // 有新数据或订阅源关闭
+    uint64_t publishedOffset;               // 已发布的日志末尾（此前的记录对订阅者可见）
+    uint64_t retentionBytes;                // 日志清理时额外保留的字节数
+    std::map<uint64_t, uint64_t> positions; // 订阅ID到读取位置
+    uint64_t nextSubscriptionId;            // 下一个订阅ID
+    bool closed;                            // 是否已关闭
+
+    friend class ChangeSubscription;
+
+    // 更新订阅的读取位置
+    void updatePosition(uint64_t id, uint64_t position);
+
+    // 注销订阅
+    void unregister(uint64_t id);
+
+public:
+    ChangeFeed(const std::string& walDirectory, uint64_t endOffset);
+
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // 发布新的日志末尾并唤醒订阅者（写入方在记录写入操作系统后调用）
+    void publish(uint64_t endOffset);
+
+    // 关闭订阅源，等待中的订阅者立即返回
+    void close();
+
+    // 清理检查点之前的日志，保留订阅者尚未读取的部分和最近retentionBytes字节
+    void truncateLog(WriteAheadLog& wal, uint64_t checkpointOffset);
+
+    // 从指定偏移开始订阅（偏移须为某批数据的offset或nextOffset），偏移已被清理或超出末尾时返回nullptr
+    std::unique_ptr<ChangeSubscription> subscribe(uint64_t fromOffset);
+
+    // 从最早仍保留的数据开始订阅
+    std::unique_ptr<ChangeSubscription> subscribeFromStart();
+
+    // 只订阅之后写入的数据
+    std::unique_ptr<ChangeSubscription> subscribeFromEnd();
+
+    // 获取最早仍保留的数据偏移
+    uint64_t getStartOffset() const;
+
+    // 获取已发布的日志末尾
+    uint64_t getEndOffset() const;
+
+    // 设置日志清理时额外保留的字节数
+    void setRetentionBytes(uint64_t bytes);
+
+    // 获取当前订阅数
+    size_t getSubscriptionCount() const;
+};
+
+// 变更订阅（单个消费者使用，不可跨线程并发调用）
+class ChangeSubscription {
+private:
+    struct Mapping;
+
+    std::shared_ptr<ChangeFeed> feed;  // 订阅源
+    uint64_t id;                       // 订阅ID
+    uint64_t position;                 // 下一批数据的偏移
+    std::unique_ptr<Mapping> mapping;  // 当前日志文件的映射
+    bool valid;                        // 是否仍可读取（偏移已被清理或日志损坏时失效）
+
+    // 读取position处的一条记录，记录尚未完整发布时返回false
+    bool readRecord(uint64_t endOffset, ChangeBatch& batch);
+
+    // 映射包含指定偏移的日志文件
+    bool mapFileFor(uint64_t offset);
+
+public:
+    ChangeSubscription(std::shared_ptr<ChangeFeed> changeFeed, uint64_t subscriptionId, uint64_t fromOffset);
+    ~ChangeSubscription();
+
+    ChangeSubscription(const ChangeSubscription&) = delete;
+    ChangeSubscription& operator=(const ChangeSubscription&) = delete;
+
+    // 读取下一批变更，没有新数据时最多等待timeoutMs毫秒（0表示不等待，负数表示一直等待）
+    // 返回false表示超时、订阅源已关闭或订阅已失效
+    bool next(ChangeBatch& batch, long long timeoutMs = 0);
+
+    // 获取下一批数据的偏移
+    uint64_t getPosition() const { return position; }
+
+    // 检查订阅是否仍可读取
+    bool isValid() const { return valid; }
+};
+
+#endif // CHANGE_FEED_H
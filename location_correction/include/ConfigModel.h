@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include "AlgorithmParams.h"
 
 // 融合策略枚举
 enum class FusionStrategy {
@@ -21,7 +22,7 @@ struct SceneConfig {
     double latitude;                // 场景中心点纬度
     double longitude;               // 场景中心点经度
     double radius;                  // 场景半径（米）
-    bool enableCorrection;          // 是否启用纠偏
+    bool enableCorrection;          // 是否启用纠偏（默认启用，只有显式关闭的区域不纠偏）
     std::map<std::string, double> correctionParams; // 纠偏参数
 
     // 构造函数
@@ -29,7 +30,7 @@ struct SceneConfig {
         latitude(0.0), 
         longitude(0.0), 
         radius(0.0), 
-        enableCorrection(false) {}
+        enableCorrection(true) {}
 };
 
 // 异常阈值配置
@@ -58,7 +59,7 @@ struct CorrectionConfig {
     FusionStrategy fusionStrategy;  // 融合策略
     std::vector<SceneConfig> sceneConfigs; // 场景配置
     AnomalyThresholds anomalyThresholds; // 异常阈值
-    std::map<std::string, double> algorithmParams; // 算法参数
+    AlgorithmParams algorithmParams; // 算法参数（加载时按参数表解析）
 
     // 构造函数
     CorrectionConfig() : 
@@ -69,15 +70,7 @@ struct CorrectionConfig {
     {}
 };
 
-// 默认配置定义
-static const CorrectionConfig DEFAULT_CONFIG = {
-    true,  // enableGnssCorrection
-    true,  // enableWifiCorrection
-    true,  // enableBaseStationCorrection
-    FusionStrategy::ADAPTIVE,  // fusionStrategy
-    {},    // sceneConfigs (默认空)
-    AnomalyThresholds(),  // 默认异常阈值
-    {{"smoothingFactor", 0.7}, {"confidenceThreshold", 0.6}}  // 默认算法参数
-};
+// 默认配置定义（各字段默认值见上方构造函数，场景配置默认为空）
+static const CorrectionConfig DEFAULT_CONFIG = CorrectionConfig();
 
 #endif // CONFIG_MODEL_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+// ConfigStore.h - 版本化配置存储（不可变快照、原子指针发布、按纪元延迟回收）
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 纪元回收域（所有配置存储共用）
+// 读取方进入时在自己的槽位中登记当前纪元，退出时清除；发布方替换指针后把旧快照连同当时的纪元放入待回收列表，
+// 所有活跃读取方登记的纪元都大于该纪元后才释放。读取方只写自己的槽位，发布方从不等待读取方
+class EpochDomain {
+public:
+    // 最多同时登记的读取线程数（超出的线程共用一个计数器，其存活期间暂停回收）
+    static constexpr size_t MAX_READERS = 256;
+
+private:
+    // 读取线程的槽位（独占缓存行，避免读取线程之间的伪共享）
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;  // 登记的纪元（0表示不在读取）
+        std::atomic<bool> inUse;      // 是否被存活的线程占用
+    };
+
+    // 待回收对象
+    struct Retired {
+        void* object;                 // 对象
+        void (*deleter)(void*);       // 释放函数
+        uint64_t epoch;               // 退役时的纪元
+    };
+
+    ReaderSlot slots[MAX_READERS];           // 读取线程的槽位
+    std::atomic<uint64_t> globalEpoch;       // 全局纪元（从1开始）
+    std::atomic<uint64_t> overflowReaders;   // 没有分到槽位的活跃读取方数
+    std::mutex slotMutex;                    // 槽位分配互斥锁
+    mutable std::mutex retireMutex;          // 待回收列表互斥锁
+    std::vector<Retired> retired;            // 待回收列表
+
+    EpochDomain();
+    ~EpochDomain();
+
+    // 获取当前线程槽位中登记纪元的位置（首次调用时分配槽位），没有空闲槽位时返回nullptr
+    std::atomic<uint64_t>* threadSlot();
+
+public:
+    // 获取单例实例
+    static EpochDomain& getInstance();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // 进入读取区（可嵌套）
+    void enter();
+
+    // 退出读取区
+    void exit();
+
+    // 将对象加入待回收列表，当前所有读取方退出后才释放
+    void retire(void* object, void (*deleter)(void*));
+
+    // 释放已没有读取方能访问的对象，返回释放的个数
+    size_t reclaim();
+
+    // 获取待回收的对象数
+    size_t getRetiredCount() const;
+};
+
+// 配置快照（发布后不再修改）
+template <typename T>
+struct ConfigSnapshot {
+    uint64_t version;  // 版本号（初始配置为1，每次发布加1）
+    T config;          // 配置内容
+};
+
+// 读取配置快照的守卫对象，存活期间快照不会被释放
+// 应在一批处理开始时获取、处理结束后销毁，不要长期持有（会推迟旧快照的回收）
+template <typename T>
+class ConfigReader {
+private:
+    const ConfigSnapshot<T>* snapshot; // 快照（移走后为nullptr）
+
+public:
+    explicit ConfigReader(const std::atomic<const ConfigSnapshot<T>*>& current);
+    ConfigReader(ConfigReader&& other) noexcept : snapshot(other.snapshot) { other.snapshot = nullptr; }
+    ConfigReader(const ConfigReader&) = delete;
+    ConfigReader& operator=(const ConfigReader&) = delete;
+    ConfigReader& operator=(ConfigReader&&) = delete;
+    ~ConfigReader();
+
+    // 获取配置内容
+    const T& operator*() const { return snapshot->config; }
+    const T* operator->() const { return &snapshot->config; }
+
+    // 获取快照的版本号
+    uint64_t version() const { return snapshot->version; }
+};
+
+// 版本化配置存储
+// 当前快照通过原子指针发布：读取方无锁获取，发布方复制并修改后替换指针，不暂停读取方。
+// 组件在每批处理开始时读取快照，版本号与上次应用的不同时再更新自身状态
+template <typename T>
+class ConfigStore {
+private:
+    std::atomic<const ConfigSnapshot<T>*> current; // 当前快照
+    std::atomic<uint64_t> version;                 // 当前版本号
+    std::mutex publishMutex;                       // 只串行化发布方
+
+    // 释放快照
+    static void destroySnapshot(void* snapshot);
+
+    // 替换当前快照（调用方持有publishMutex）
+    uint64_t publishLocked(const T& config);
+
+public:
+    explicit ConfigStore(const T& initial = T());
+    ~ConfigStore();
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    // 获取该配置类型的全局存储
+    static ConfigStore& getInstance();
+
+    // 读取当前快照
+    ConfigReader<T> read() const { return ConfigReader<T>(current); }
+
+    // 获取当前版本号
+    uint64_t getVersion() const { return version.load(std::memory_order_acquire); }
+
+    // 发布新配置，返回新版本号
+    uint64_t publish(const T& config);
+
+    // 在当前配置的副本上修改后发布（多个发布方并发修改时不会互相覆盖），返回新版本号
+    template <typename Mutator>
+    uint64_t update(Mutator&& mutate);
+};
+
+// 模板方法实现
+#include "ConfigStore.tpp"
+
+#endif // CONFIG_STORE_H
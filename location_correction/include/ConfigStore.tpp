@@ -0,0 +1,73 @@
+// ConfigStore.tpp - ConfigStore类模板方法实现
+
+#ifndef CONFIG_STORE_TPP
+#define CONFIG_STORE_TPP
+
+#include "ConfigStore.h"
+
+// 进入读取区后再加载指针：发布方替换指针并推进纪元后，读取方要么看到新快照，要么已登记旧纪元
+template <typename T>
+ConfigReader<T>::ConfigReader(const std::atomic<const ConfigSnapshot<T>*>& current) {
+    EpochDomain::getInstance().enter();
+    snapshot = current.load(std::memory_order_seq_cst);
+}
+
+template <typename T>
+ConfigReader<T>::~ConfigReader() {
+    if (snapshot) {
+        EpochDomain::getInstance().exit();
+    }
+}
+
+template <typename T>
+ConfigStore<T>::ConfigStore(const T& initial) :
+    current(new ConfigSnapshot<T>{1, initial}),
+    version(1) {}
+
+// 析构时不应再有读取方
+template <typename T>
+ConfigStore<T>::~ConfigStore() {
+    delete current.load(std::memory_order_acquire);
+}
+
+template <typename T>
+ConfigStore<T>& ConfigStore<T>::getInstance() {
+    static ConfigStore instance;
+    return instance;
+}
+
+template <typename T>
+void ConfigStore<T>::destroySnapshot(void* snapshot) {
+    delete static_cast<const ConfigSnapshot<T>*>(snapshot);
+}
+
+template <typename T>
+uint64_t ConfigStore<T>::publishLocked(const T& config) {
+    uint64_t nextVersion = version.load(std::memory_order_relaxed) + 1;
+    const ConfigSnapshot<T>* previous =
+        current.exchange(new ConfigSnapshot<T>{nextVersion, config}, std::memory_order_seq_cst);
+    version.store(nextVersion, std::memory_order_release);
+
+    EpochDomain& domain = EpochDomain::getInstance();
+    domain.retire(const_cast<ConfigSnapshot<T>*>(previous), &ConfigStore::destroySnapshot);
+    domain.reclaim();
+    return nextVersion;
+}
+
+template <typename T>
+uint64_t ConfigStore<T>::publish(const T& config) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return publishLocked(config);
+}
+
+// 当前快照只会由持有publishMutex的发布方退役，持锁期间可以直接访问
+template <typename T>
+template <typename Mutator>
+uint64_t ConfigStore<T>::update(Mutator&& mutate) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    T config = current.load(std::memory_order_acquire)->config;
+    mutate(config);
+    return publishLocked(config);
+}
+
+#endif // CONFIG_STORE_TPP
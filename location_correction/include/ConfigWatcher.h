@@ -0,0 +1,101 @@
+// ConfigWatcher.h - 配置文件监视器（启动时预加载，文件变化后按分节增量通知）
+
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 配置项（完整键名到值，如"scene.outdoor.maxSpeed" -> "120"）
+using ConfigEntries = std::map<std::string, std::string>;
+
+// 一个分节的变化
+// 分节为键名最后一个'.'之前的部分（"scene.outdoor.maxSpeed"属于"scene.outdoor"，没有'.'的键属于""）
+struct ConfigSectionDiff {
+    std::string section;       // 分节名
+    ConfigEntries changed;     // 新增或修改的配置项
+    std::vector<std::string> removed; // 删除的配置项
+};
+
+// 分节变化处理函数
+using ConfigSectionHandler = std::function<void(const ConfigSectionDiff& diff)>;
+
+// 重新加载处理函数（一次加载的所有分节变化一起传入）
+using ConfigReloadHandler = std::function<void(const std::vector<ConfigSectionDiff>& changes)>;
+
+// 配置文件监视器
+// start()时同步加载一次（所有分节作为新增项通知），之后在后台线程中监视文件所在目录：
+// Linux上使用inotify（同时覆盖原地写入和同步程序"写临时文件再重命名"的更新方式），其他平台定期检查修改时间。
+// 文件变化后重新解析并与上次的内容比较，只把有变化的分节通知给对应的处理函数；
+// 重新加载处理函数每次加载只调用一次，适合把同一次更新的所有变化作为一个配置版本发布
+class ConfigWatcher {
+private:
+    // 分节处理函数
+    struct SectionHandler {
+        std::string prefix;            // 分节前缀（""匹配所有分节）
+        ConfigSectionHandler handler;  // 处理函数
+    };
+
+    std::string filePath;              // 配置文件路径
+    mutable std::mutex mutex;          // 互斥锁（保护配置项和处理函数列表）
+    ConfigEntries entries;             // 上次加载的配置项
+    std::vector<SectionHandler> handlers; // 分节处理函数
+    std::vector<ConfigReloadHandler> reloadHandlers; // 重新加载处理函数
+    std::mutex reloadMutex;            // 串行化重新加载
+    std::atomic<bool> running;         // 监视线程是否运行
+    std::atomic<uint64_t> reloadCount; // 成功加载的次数
+    std::thread watchThread;           // 监视线程
+    int inotifyFd;                     // inotify描述符（-1表示不可用，改为定期检查修改时间）
+    int stopPipe[2];                   // 用于唤醒监视线程退出
+
+    // 监视线程主循环
+    void watchLoop();
+
+    // 分节名是否匹配处理函数的前缀
+    static bool sectionMatches(const std::string& section, const std::string& prefix);
+
+public:
+    explicit ConfigWatcher(const std::string& filePath);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // 添加分节处理函数：prefix为"scene"时接收"scene"及"scene.*"分节的变化，""接收所有分节
+    void addSectionHandler(const std::string& prefix, ConfigSectionHandler handler);
+
+    // 添加重新加载处理函数：每次加载有变化时调用一次，传入所有有变化的分节
+    void addReloadHandler(ConfigReloadHandler handler);
+
+    // 同步加载配置并启动监视线程（文件暂不存在时返回false，但仍会监视，文件出现后加载）
+    bool start();
+
+    // 停止监视线程
+    void stop();
+
+    // 重新加载配置并通知有变化的分节，返回是否加载成功
+    bool reload();
+
+    // 获取上次加载的配置项
+    ConfigEntries getEntries() const;
+
+    // 获取成功加载的次数
+    uint64_t getReloadCount() const { return reloadCount.load(std::memory_order_relaxed); }
+
+    // 解析"键=值"格式的配置文件（跳过空行和#开头的注释，键和值去除首尾空白）
+    static bool parseFile(const std::string& path, ConfigEntries& result);
+
+    // 获取配置项所属的分节
+    static std::string sectionOf(const std::string& key);
+
+    // 比较两次加载的配置项，按分节返回变化
+    static std::vector<ConfigSectionDiff> diff(const ConfigEntries& previous, const ConfigEntries& current);
+};
+
+#endif // CONFIG_WATCHER_H
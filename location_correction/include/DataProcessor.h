@@ -6,8 +6,10 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <optional>
 #include "LocationModel.h"
 #include "ConfigModel.h"
+#include "ConfigStore.h"
 #include "Logger.h"
 
 // 数据处理器接口
@@ -108,6 +110,9 @@ public:
     
     // 清空历史数据
     void clearHistory();
+    
+    // 用恢复的最近位置预填历史数据（只加入有效位置，替换当前历史）
+    void seedHistory(const std::vector<LocationInfo>& locations);
 };
 
 // 坐标转换器
@@ -142,8 +147,17 @@ class ProcessorChain {
 private:
     std::vector<std::shared_ptr<DataProcessor>> processors; // 处理器列表
     mutable std::mutex mutex; // 互斥锁
+    uint64_t appliedConfigVersion; // 已应用到各处理器的全局配置版本
+    bool stopOnInvalid; // 位置无效时提前终止（已合并链上参数和全局配置，处理时直接读取）
+    std::optional<bool> stopOnInvalidOverride; // 链上通过setParameter设置的stopOnInvalid（优先于全局配置）
+
+    // 全局配置有新版本时应用到各处理器（调用方持有mutex）
+    void refreshConfig();
 
 public:
+    // 设置处理器链参数（stopOnInvalid覆盖全局配置中的同名参数）
+    void setParameter(const std::string& key, const std::string& value);
+    
     // 添加处理器
     bool addProcessor(std::shared_ptr<DataProcessor> processor);
     
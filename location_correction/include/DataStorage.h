@@ -7,158 +7,460 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <map>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
 #include "LocationModel.h"
 #include "ConfigModel.h"
 #include "Logger.h"
+#include "LocationCodec.h"
+#include "SegmentFile.h"
+#include "RetentionManager.h"
+#include "WriteAheadLog.h"
+#include "StorageTee.h"
+#include "StorageQuery.h"
+#include "ArrowExporter.h"
+#include "PointQuery.h"
+#include "ChangeFeed.h"
+#include "BulkLoader.h"
+
+// 存储配置
+struct StorageConfig {
+    std::string storagePath; // 存储目录
+    size_t capacity; // 存储容量（0表示使用默认容量）
+
+    StorageConfig() :
+        storagePath("./data"),
+        capacity(0) {}
+};
 
 // 数据存储接口
 class DataStorage {
+protected:
+    bool initialized; // 是否已初始化
+    bool enabled; // 是否启用
+    size_t storageCapacity; // 存储容量（条数）
+    StorageConfig config; // 存储配置
+
 public:
-    virtual ~DataStorage() = default;
+    DataStorage();
+    virtual ~DataStorage();
     
     // 初始化存储
-    virtual bool initialize() = 0;
+    virtual bool initialize(const StorageConfig& config);
+    
+    // 关闭存储并释放资源
+    virtual bool close();
+    
+    // 检查是否已初始化
+    bool isInitialized() const;
+    
+    // 设置是否启用
+    void setEnabled(bool enable);
+    
+    // 检查是否启用
+    bool isEnabled() const;
+    
+    // 设置存储容量
+    void setStorageCapacity(size_t capacity);
+    
+    // 获取存储容量
+    size_t getStorageCapacity() const;
     
-    // 释放存储资源
-    virtual void release() = 0;
+    // 存储单个位置数据
+    virtual bool store(const LocationInfo& location) = 0;
     
-    // 保存单个位置数据
-    virtual bool saveLocation(const LocationInfo& location) = 0;
+    // 批量存储位置数据
+    virtual bool batchStore(const std::vector<LocationInfo>& locations) = 0;
     
-    // 批量保存位置数据
-    virtual bool saveLocations(const std::vector<LocationInfo>& locations) = 0;
+    // 根据时间范围查询位置数据
+    virtual std::vector<LocationInfo> queryByTimeRange(long long startTime, long long endTime) = 0;
     
-    // 获取最近的位置数据
-    virtual std::shared_ptr<LocationInfo> getLatestLocation() = 0;
+    // 根据数据源类型查询位置数据
+    virtual std::vector<LocationInfo> queryByDataSource(DataSourceType sourceType) = 0;
     
-    // 获取指定时间范围内的位置数据
-    virtual std::vector<std::shared_ptr<LocationInfo>> getLocationsByTimeRange(long long startTime, long long endTime) = 0;
+    // 获取最新的位置数据
+    virtual std::optional<LocationInfo> getLatestLocation() = 0;
     
-    // 获取指定数量的历史位置数据
-    virtual std::vector<std::shared_ptr<LocationInfo>> getRecentLocations(size_t count) = 0;
+    // 获取存储的位置数据总数
+    virtual size_t getStoredCount() const = 0;
     
-    // 清空所有位置数据
-    virtual bool clearAllLocations() = 0;
+    // 清空存储的数据
+    virtual bool clearAll() = 0;
     
-    // 获取存储名称
-    virtual std::string getName() const = 0;
+    // 打开流式查询游标，逐批返回满足条件的列式数据（columnMask指定需要返回的列）
+    // 默认实现先按时间范围查询再分批返回，子类可覆盖为按需扫描
+    virtual std::unique_ptr<LocationCursor> openCursor(const QueryPredicate& predicate,
+                                                       uint32_t columnMask = ALL_CODEC_COLUMNS,
+                                                       size_t batchSize = 4096);
+    
+    // 查找设备在指定时刻之前（含）和之后（含）最近的定位点，只查找时间差不超过maxDistanceMs的数据
+    // 默认实现按时间范围查询后逐条比较，子类可覆盖为按索引查找
+    virtual bool findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                                     std::optional<LocationInfo>& before, std::optional<LocationInfo>& after);
+    
+    // 查询设备在指定时刻的位置：取前后最近的定位点线性插值，精度值按时间间隔传播
+    std::optional<PointLocation> locateAt(const std::string& deviceId, long long timestamp,
+                                          const PointQueryOptions& options = PointQueryOptions());
+    
+    // 批量查询设备在指定时刻的位置，按时间排序后依次查找以顺序访问数据，结果与输入一一对应
+    std::vector<std::optional<PointLocation>> locateAtBatch(const std::vector<PointQuery>& queries,
+                                                            const PointQueryOptions& options = PointQueryOptions());
 };
 
 // 内存存储实现
 class MemoryStorage : public DataStorage {
 private:
-    std::vector<std::shared_ptr<LocationInfo>> locations; // 内存中的位置数据
+    std::deque<LocationInfo> locations; // 内存中的位置数据（按到达顺序）
     mutable std::mutex mutex; // 互斥锁
-    size_t maxCapacity; // 最大容量
-    bool initialized; // 是否已初始化
+    std::unique_ptr<WriteAheadLog> wal; // 预写日志（未启用时为空）
+    std::string walDirectory; // 预写日志目录
+    uint64_t checkpointIntervalBytes; // 两次检查点之间允许的日志字节数
+    uint64_t lastCheckpointLsn; // 最近一次检查点的LSN
+    std::string snapshotFile; // 最近一次检查点的快照文件
+    
+    // 从检查点快照和预写日志恢复内存数据
+    bool recoverFromWal();
+    
+    // 写入内存快照并记录检查点（调用方需持有锁）
+    bool writeCheckpoint();
 
 public:
-    MemoryStorage(size_t capacity = 1000);
-    ~MemoryStorage() override;
+    MemoryStorage();
+    
+    bool initialize(const StorageConfig& config) override;
     
-    bool initialize() override;
+    bool close() override;
     
-    void release() override;
+    bool store(const LocationInfo& location) override;
     
-    bool saveLocation(const LocationInfo& location) override;
+    bool batchStore(const std::vector<LocationInfo>& locations) override;
     
-    bool saveLocations(const std::vector<LocationInfo>& locations) override;
+    std::vector<LocationInfo> queryByTimeRange(long long startTime, long long endTime) override;
     
-    std::shared_ptr<LocationInfo> getLatestLocation() override;
+    std::vector<LocationInfo> queryByDataSource(DataSourceType sourceType) override;
     
-    std::vector<std::shared_ptr<LocationInfo>> getLocationsByTimeRange(long long startTime, long long endTime) override;
+    std::optional<LocationInfo> getLatestLocation() override;
     
-    std::vector<std::shared_ptr<LocationInfo>> getRecentLocations(size_t count) override;
+    size_t getStoredCount() const override;
     
-    bool clearAllLocations() override;
+    bool clearAll() override;
     
-    std::string getName() const override { return "MemoryStorage"; }
+    // 设置预写日志目录，启用后重启时可恢复内存数据（需在初始化前设置）
+    void setWalDirectory(const std::string& directory);
     
-    // 获取当前存储的位置数量
-    size_t getLocationCount() const;
+    // 设置两次检查点之间允许的日志字节数
+    void setCheckpointInterval(uint64_t bytes);
     
-    // 设置最大容量
-    void setMaxCapacity(size_t capacity);
+    // 立即写入检查点
+    bool checkpoint();
 };
 
 // 文件存储实现
 class FileStorage : public DataStorage {
 private:
-    std::string filePath; // 文件路径
-    mutable std::mutex mutex; // 互斥锁
+    std::ofstream* fileStream; // 当前日志文件流
+    size_t fileSize; // 当前日志文件大小（字节）
+    long long rotationInterval; // 文件轮转间隔（毫秒）
     size_t maxFileSize; // 最大文件大小（字节）
-    bool initialized; // 是否已初始化
+    long long lastRotationTime = 0; // 上次轮转时间
+    mutable std::mutex mutex; // 互斥锁
+    bool compressionEnabled; // 是否以压缩段格式存储
+    size_t blockRowCount; // 每个压缩块的行数
+    LocationColumns pendingBlock; // 尚未写入段文件的数据
+    SegmentWriter segmentWriter; // 当前段文件写入器
+    long long segmentOpenTime; // 当前段文件的创建时间
+    std::unique_ptr<RetentionManager> retentionManager; // 分级保留管理器
+    std::unique_ptr<QueryExecutor> queryExecutor; // 并行查询执行器（首次查询时创建）
+    size_t queryThreadCount; // 查询线程数（0表示使用CPU核数）
+    bool walEnabled; // 是否启用预写日志（仅压缩模式）
+    std::unique_ptr<WriteAheadLog> wal; // 预写日志，保护尚未写入段文件的数据
+    std::unique_ptr<DeviceTimeIndex> timeIndex; // 段文件的设备时间索引（首次时间点查询时创建）
+    std::shared_ptr<ChangeFeed> changeFeed; // 变更订阅源（启用预写日志时创建）
+    uint64_t changeRetentionBytes; // 为离线订阅者额外保留的预写日志字节数
+    
+    // 从预写日志恢复尚未写入段文件的数据
+    bool recoverFromWal();
+    
+    // 记录检查点：待写入块已全部落入段文件
+    void writeCheckpoint();
+    
+    // 截断CSV日志文件末尾不完整的行
+    static void truncateTornLine(const std::string& fileName);
+    
+    // 解析CSV日志中的一行，解析失败返回false
+    static bool parseLogLine(const std::string& line, LocationInfo& location);
+    
+    // 打开新的日志文件
+    void openFileStream();
+    
+    // 检查并切换日志文件
+    void checkAndRotateFile();
+
+    // 创建新的段文件
+    void openSegmentWriter();
+    
+    // 将待写入数据编码为一个块写入段文件
+    void flushPendingBlock();
+    
+    // 检查并切换段文件
+    void checkAndRotateSegment();
+    
+    // 以压缩格式存储单个位置数据
+    bool storeCompressed(const LocationInfo& location);
+    
+    // 获取目录下的所有段文件
+    static std::vector<std::string> getSegmentFilesInDirectory(const std::string& directoryPath);
+    
+    // 在段文件和未落盘的数据中查找最新的一条：按文件尾中的最大时间戳只解码最新段中最新的块
+    static std::optional<LocationInfo> latestInSegments(const std::vector<std::string>& segmentFiles,
+                                                        const LocationColumns& memoryRows);
+    
+    // 序列化位置数据为日志行
+    static std::string serializeLocation(const LocationInfo& location);
+    
+    // 从日志行反序列化位置数据
+    static LocationInfo deserializeLocation(const std::string& data);
+    
+    // 获取目录下的所有日志文件（sortByTime为true时按修改时间从新到旧排序）
+    static std::vector<std::string> getLogFilesInDirectory(const std::string& directoryPath, bool sortByTime = false);
 
 public:
-    FileStorage(const std::string& path = "location_data.dat", size_t maxSize = 10 * 1024 * 1024);
+    FileStorage();
     ~FileStorage() override;
     
-    bool initialize() override;
+    bool initialize(const StorageConfig& config) override;
     
-    void release() override;
+    bool close() override;
     
-    bool saveLocation(const LocationInfo& location) override;
+    bool store(const LocationInfo& location) override;
     
-    bool saveLocations(const std::vector<LocationInfo>& locations) override;
+    bool batchStore(const std::vector<LocationInfo>& locations) override;
     
-    std::shared_ptr<LocationInfo> getLatestLocation() override;
+    std::vector<LocationInfo> queryByTimeRange(long long startTime, long long endTime) override;
     
-    std::vector<std::shared_ptr<LocationInfo>> getLocationsByTimeRange(long long startTime, long long endTime) override;
+    std::vector<LocationInfo> queryByDataSource(DataSourceType sourceType) override;
     
-    std::vector<std::shared_ptr<LocationInfo>> getRecentLocations(size_t count) override;
+    std::optional<LocationInfo> getLatestLocation() override;
     
-    bool clearAllLocations() override;
+    size_t getStoredCount() const override;
     
-    std::string getName() const override { return "FileStorage"; }
+    bool clearAll() override;
     
-    // 设置文件路径
-    void setFilePath(const std::string& path);
+    // 设置文件轮转间隔（毫秒）
+    void setRotationInterval(long long intervalMs);
     
     // 设置最大文件大小
-    void setMaxFileSize(size_t size);
+    void setMaxFileSize(size_t sizeBytes);
     
-    // 检查并切换文件
-    void checkAndRotateFile();
+    // 设置是否以压缩段格式存储（需在初始化前设置）
+    void setCompressionEnabled(bool enable);
+    
+    // 检查是否以压缩段格式存储
+    bool isCompressionEnabled() const { return compressionEnabled; }
+    
+    // 设置每个压缩块的行数
+    void setBlockRowCount(size_t rowCount);
+    
+    // 设置是否启用预写日志（需在初始化前设置，仅对压缩模式生效）
+    void setWalEnabled(bool enable);
+    
+    // 获取变更订阅源（未启用预写日志时返回nullptr），订阅者按日志偏移顺序读取写入的每一条数据
+    std::shared_ptr<ChangeFeed> getChangeFeed() const;
+    
+    // 设置预写日志清理时为离线订阅者额外保留的字节数（0表示只保留在线订阅者未读取的部分）
+    void setChangeRetentionBytes(uint64_t bytes);
+    
+    // 按条件查询位置数据：并行扫描所有日志和段文件，结果按时间排序
+    std::vector<LocationInfo> query(const QueryPredicate& predicate, QueryStats* stats = nullptr);
+    
+    // 打开流式查询游标：按需逐个打开文件、逐块解码，内存占用与结果总量无关
+    std::unique_ptr<LocationCursor> openCursor(const QueryPredicate& predicate,
+                                               uint32_t columnMask = ALL_CODEC_COLUMNS,
+                                               size_t batchSize = 4096) override;
+    
+    // 查找设备在指定时刻前后最近的定位点：段文件按设备时间索引二分查找，待写入块直接扫描
+    bool findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                             std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) override;
+    
+    // 设置查询线程数（0表示使用CPU核数，需在首次查询前设置）
+    void setQueryThreadCount(size_t threadCount);
+    
+    // 将满足条件的数据并行导出为Arrow IPC文件（Feather v2），线程数与查询线程数相同
+    bool exportToArrow(const std::string& outputPath, const QueryPredicate& predicate,
+                       ArrowExportStats* stats = nullptr);
+    
+    // 创建批量导入器：数据直接写入存储目录下的段文件，不经过预写日志和待写入块（需在初始化后调用）
+    std::unique_ptr<BulkLoader> createBulkLoader(const BulkLoadOptions& options = BulkLoadOptions());
+    
+    // 启用分级保留策略（后台降采样和压实段文件，需在初始化后调用）
+    bool enableRetention(const RetentionConfig& retentionConfig);
+    
+    // 获取保留策略管理器（未启用时返回nullptr）
+    RetentionManager* getRetentionManager() const { return retentionManager.get(); }
+};
+
+// 分层存储统计
+struct TieredStorageStats {
+    size_t hotRows; // 热层数据条数
+    size_t hotMemoryBytes; // 热层估算内存占用（字节）
+    uint64_t demotedRows; // 已降级到冷层的数据条数
+    uint64_t hotOnlyQueries; // 只访问热层的查询次数
+    uint64_t coldQueries; // 访问冷层的查询次数
+
+    TieredStorageStats() :
+        hotRows(0),
+        hotMemoryBytes(0),
+        demotedRows(0),
+        hotOnlyQueries(0),
+        coldQueries(0) {}
+};
+
+// 冷热分层存储实现
+// 最近的数据保存在内存中（热层），超出内存预算后由后台线程按到达顺序批量降级到压缩段文件（冷层）；
+// 查询同时合并两层的数据，查询范围晚于冷层最新数据时不访问磁盘。
+// 降级先写入冷层再移出热层，写入冷层期间不阻塞查询，查询按序号识别可能同时位于两层的数据并去重
+class TieredStorage : public DataStorage {
+private:
+    std::deque<LocationInfo> hotLocations; // 热层数据（按到达顺序）
+    size_t hotMemoryBudget; // 热层内存预算（字节）
+    size_t hotMemoryUsage; // 热层估算内存占用（字节）
+    long long coldMaxTimestamp; // 冷层中最新数据的时间戳
+    std::shared_ptr<FileStorage> coldStorage; // 冷层存储
+    mutable std::mutex hotMutex; // 热层互斥锁
+    mutable std::shared_mutex tierMutex; // 清空互斥锁（降级和查询共享持有，清空时独占，避免降级写回已清空的冷层）
+    std::condition_variable demoteCondition; // 热层超出预算
+    std::condition_variable demoteFinished; // 一批降级结束
+    size_t demotingRows; // 热层头部正在写入冷层的数据条数（写入期间这些数据可能同时位于两层）
+    uint64_t demotedSeq; // 已移出热层的数据条数（热层第i条数据的序号为demotedSeq + i）
+    uint64_t demoteGeneration; // 已开始的降级批次数
+    std::thread demoteThread; // 后台降级线程
+    bool demoteRunning; // 降级线程是否运行
+    TieredStorageStats stats; // 统计（热层占用在读取时计算）
+
+    // 估算单条位置数据的内存占用
+    static size_t estimateMemoryUsage(const LocationInfo& location);
+
+    // 后台降级线程主循环
+    void demoteLoop();
+
+    // 将最早的热层数据降级到冷层，直到热层占用不超过targetBytes
+    bool demoteTo(size_t targetBytes);
+
+    // 将单条数据追加到热层（调用方需持有hotMutex）
+    void appendHot(const LocationInfo& location);
+
+    // 从热层结果中去掉冷层结果里已有的数据（只检查序号小于ambiguousEnd、可能已写入冷层的数据）
+    static void dropDemotedRows(std::vector<std::pair<uint64_t, LocationInfo>>& hotRows, uint64_t ambiguousEnd,
+                                const std::vector<LocationInfo>& coldRows);
+
+public:
+    TieredStorage();
+    ~TieredStorage() override;
+
+    bool initialize(const StorageConfig& config) override;
+
+    bool close() override;
+
+    bool store(const LocationInfo& location) override;
+
+    bool batchStore(const std::vector<LocationInfo>& locations) override;
+
+    std::vector<LocationInfo> queryByTimeRange(long long startTime, long long endTime) override;
+
+    std::vector<LocationInfo> queryByDataSource(DataSourceType sourceType) override;
+
+    std::optional<LocationInfo> getLatestLocation() override;
+
+    size_t getStoredCount() const override;
+
+    bool clearAll() override;
+
+    std::unique_ptr<LocationCursor> openCursor(const QueryPredicate& predicate,
+                                               uint32_t columnMask = ALL_CODEC_COLUMNS,
+                                               size_t batchSize = 4096) override;
+
+    // 查找设备在指定时刻前后最近的定位点（热层扫描，冷层按索引查找）
+    bool findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                             std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) override;
+
+    // 按条件查询两层数据，结果按时间排序
+    std::vector<LocationInfo> query(const QueryPredicate& predicate, QueryStats* queryStats = nullptr);
+
+    // 设置热层内存预算（字节）
+    void setHotMemoryBudget(size_t bytes);
+
+    // 获取热层内存预算（字节）
+    size_t getHotMemoryBudget() const;
+
+    // 获取冷层存储（可在初始化前配置预写日志、块大小等，初始化后可启用保留策略）
+    std::shared_ptr<FileStorage> getColdStorage() const { return coldStorage; }
+
+    // 获取统计
+    TieredStorageStats getStats() const;
 };
 
 // 存储管理器
 class StorageManager {
 private:
-    static StorageManager* instance; // 单例实例
-    static std::mutex instanceMutex; // 单例互斥锁
-    std::vector<std::shared_ptr<DataStorage>> storages; // 存储列表
-    mutable std::mutex storagesMutex; // 存储列表互斥锁
+    std::shared_ptr<DataStorage> defaultStorage; // 默认存储
+    std::map<std::string, std::shared_ptr<DataStorage>> namedStorages; // 已注册的存储
+    mutable std::mutex mutex; // 互斥锁
+    std::shared_ptr<StorageTee> tee; // 异步分发器（未启用分发模式时为空）
+    std::map<std::string, TeeBackendConfig> teeConfigs; // 各存储的分发配置
 
     // 私有构造函数
     StorageManager();
 
 public:
     // 获取单例实例
-    static StorageManager* getInstance();
-    
-    // 添加存储
-    bool addStorage(std::shared_ptr<DataStorage> storage);
+    static StorageManager& getInstance();
     
-    // 移除存储
-    bool removeStorage(const std::string& storageName);
+    // 注册存储实现（第一个注册的存储成为默认存储）
+    bool registerStorage(const std::string& name, std::shared_ptr<DataStorage> storage);
     
-    // 获取所有存储
-    std::vector<std::shared_ptr<DataStorage>> getAllStorages() const;
+    // 注销存储实现
+    bool unregisterStorage(const std::string& name);
     
     // 根据名称获取存储
-    std::shared_ptr<DataStorage> getStorageByName(const std::string& storageName) const;
+    std::shared_ptr<DataStorage> getStorage(const std::string& name);
     
-    // 初始化所有存储
-    bool initializeAllStorages();
+    // 获取默认存储
+    std::shared_ptr<DataStorage> getDefaultStorage();
     
-    // 释放所有存储
-    void releaseAllStorages();
+    // 设置默认存储
+    bool setDefaultStorage(const std::string& name);
+    
+    // 获取所有已注册存储的名称
+    std::vector<std::string> getRegisteredStorages();
     
     // 保存位置数据到所有存储
     bool saveLocationToAll(const LocationInfo& location);
     
-    // 保存位置数据到指定存储
-    bool saveLocationTo(const std::string& storageName, const LocationInfo& location);
+    // 批量保存位置数据到所有存储
+    bool saveLocationsToAll(const std::vector<LocationInfo>& locations);
+    
+    // 启用分发模式：每个存储由独立线程异步批量写入，调用方只需入队一次
+    bool enableTeeMode(size_t capacity = 8192);
+    
+    // 关闭分发模式（等待已入队数据写完）
+    void disableTeeMode();
+    
+    // 检查是否已启用分发模式
+    bool isTeeModeEnabled() const;
+    
+    // 设置存储的分发配置（在启用分发模式或注册存储时生效）
+    void setTeeBackendConfig(const std::string& storageName, const TeeBackendConfig& config);
+    
+    // 等待所有存储写完已入队的数据
+    void flushTee();
+    
+    // 获取存储的分发统计
+    bool getTeeStats(const std::string& storageName, TeeBackendStats& stats) const;
 };
 
 #endif // DATA_STORAGE_H
\ No newline at end of file
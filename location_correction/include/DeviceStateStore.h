@@ -0,0 +1,146 @@
+// DeviceStateStore.h - 设备算法状态存储与检查点
+
+#ifndef DEVICE_STATE_STORE_H
+#define DEVICE_STATE_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "LocationModel.h"
+
+// 设备状态检查点文件扩展名
+extern const char* const DEVICE_STATE_FILE_EXTENSION;
+
+// 每个设备保留的最近位置数（检测器窗口）
+constexpr size_t DEVICE_STATE_WINDOW_SIZE = 8;
+
+// 状态中的位置点（紧凑定长格式）
+struct StatePoint {
+    int64_t timestamp;   // 时间戳（毫秒）
+    double latitude;     // 纬度
+    double longitude;    // 经度
+    float altitude;      // 海拔
+    float accuracy;      // 精度（米）
+    float speed;         // 速度
+    float direction;     // 方向（度）
+    uint8_t sourceType;  // 数据源类型
+    uint8_t status;      // 位置状态
+    uint8_t reserved[6]; // 保留（填充到8字节对齐）
+};
+
+// 单个设备的算法状态
+// 定长且可平凡复制，检查点文件中按数组存放，加载时直接映射使用
+struct DeviceState {
+    StatePoint window[DEVICE_STATE_WINDOW_SIZE]; // 最近的输入位置（环形缓冲，检测器与融合的上下文）
+    StatePoint lastOutput;                       // 最近一次纠偏输出
+    uint32_t windowStart;                        // 环形缓冲中最早位置的下标
+    uint32_t windowCount;                        // 环形缓冲中的位置数
+    int32_t scene;                               // 当前场景
+    uint32_t flags;                              // 状态标志（DEVICE_STATE_HAS_OUTPUT等）
+    int64_t sceneCheckTime;                      // 上次场景检测时间（毫秒）
+    int64_t updateTime;                          // 最近一次更新的位置时间戳（毫秒）
+};
+
+static_assert(std::is_trivially_copyable<DeviceState>::value, "DeviceState must be trivially copyable");
+
+// 状态标志：已有纠偏输出
+constexpr uint32_t DEVICE_STATE_HAS_OUTPUT = 1u << 0;
+
+// 检查点统计
+struct DeviceCheckpointStats {
+    size_t deviceCount;   // 设备数
+    uint64_t bytes;       // 文件大小
+    long long elapsedMs;  // 耗时（毫秒）
+
+    DeviceCheckpointStats() : deviceCount(0), bytes(0), elapsedMs(0) {}
+};
+
+// 设备算法状态存储
+// 按设备ID分片加锁保存每个设备的检测窗口、最近输出和场景，重启后从检查点恢复，避免冷启动期间纠偏效果下降。
+// 检查点格式：[文件头][状态数组][设备ID索引][设备ID字符串区]，文件头记录各区偏移和CRC32C校验值。
+// 加载时以私有映射（写时复制）打开文件，状态数组原地使用，不逐条反序列化
+class DeviceStateStore {
+private:
+    struct Mapping;
+
+    // 分片
+    struct Shard {
+        mutable std::mutex mutex;                              // 分片互斥锁
+        std::unordered_map<std::string, DeviceState*> states;  // 设备ID到状态的映射
+        std::deque<DeviceState> owned;                         // 加载后新增设备的状态
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;  // 分片
+    std::shared_ptr<Mapping> mapping;            // 已加载的检查点映射
+    std::mutex checkpointMutex;                  // 检查点互斥锁（保存与加载互斥）
+
+    // 定期检查点
+    std::thread checkpointThread;                // 检查点线程
+    std::mutex timerMutex;                       // 检查点线程等待用互斥锁
+    std::condition_variable timerCondition;      // 检查点线程唤醒条件
+    bool checkpointStopping;                     // 是否正在停止检查点线程
+    std::string checkpointPath;                  // 检查点文件路径
+    long long checkpointIntervalMs;              // 检查点间隔（毫秒）
+
+    // 获取设备所在的分片
+    Shard& shardFor(const std::string& deviceId) const;
+
+    // 查找或创建设备状态（调用方需持有分片锁）
+    static DeviceState& findOrCreate(Shard& shard, const std::string& deviceId);
+
+    // 检查点线程主循环
+    void checkpointLoop();
+
+public:
+    explicit DeviceStateStore(size_t shardCount = 64);
+    ~DeviceStateStore();
+
+    DeviceStateStore(const DeviceStateStore&) = delete;
+    DeviceStateStore& operator=(const DeviceStateStore&) = delete;
+
+    // 记录设备的输入位置（加入检测窗口）
+    void recordInput(const std::string& deviceId, const LocationInfo& location);
+
+    // 记录设备的纠偏输出和当前场景
+    void recordOutput(const std::string& deviceId, const LocationInfo& corrected, int32_t scene, long long sceneCheckTime);
+
+    // 获取设备状态，设备不存在时返回false
+    bool getState(const std::string& deviceId, DeviceState& state) const;
+
+    // 获取最近更新的设备状态（按updateTime），没有任何设备时返回false
+    bool getLatestState(std::string& deviceId, DeviceState& state) const;
+
+    // 获取设备检测窗口中的位置（按时间顺序），可直接作为异常检测的上下文
+    std::vector<LocationInfo> getWindow(const std::string& deviceId) const;
+
+    // 获取设备数
+    size_t getDeviceCount() const;
+
+    // 清空所有状态
+    void clear();
+
+    // 将所有设备状态写入检查点文件（先写临时文件再替换），写入期间逐个分片加锁
+    bool saveCheckpoint(const std::string& path, DeviceCheckpointStats* stats = nullptr);
+
+    // 从检查点文件恢复状态（替换当前所有状态）
+    bool loadCheckpoint(const std::string& path, DeviceCheckpointStats* stats = nullptr);
+
+    // 启动定期检查点，停止时写入最后一次检查点
+    bool startCheckpointing(const std::string& path, long long intervalMs);
+
+    // 停止定期检查点
+    void stopCheckpointing();
+
+    // 位置与状态点之间的转换
+    static StatePoint toStatePoint(const LocationInfo& location);
+    static LocationInfo fromStatePoint(const StatePoint& point, const std::string& deviceId);
+};
+
+#endif // DEVICE_STATE_STORE_H
@@ -0,0 +1,154 @@
+// FlightRecorder.h - 飞行记录器（最近流水线事件的内存记录与转储）
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LocationInfo;
+struct FlightRing;
+
+// 流水线事件类型
+enum class FlightEventType : uint8_t {
+    FIX_INGESTED,     // 数据源采集到定位（附加值：精度）
+    FIX_FILTERED,     // 预处理标记或过滤定位（附加值：触发过滤的量，如精度、时间差、偏离距离）
+    ANOMALY_DETECTED, // 检测到异常（附加值：置信度）
+    FUSED,            // 多源融合完成（附加值：参与融合的数据源数）
+    STORED,           // 写入存储（附加值：本次写入的条数）
+    MARK              // 业务自定义标记
+};
+
+// 飞行记录器配置
+struct FlightRecorderConfig {
+    bool enabled;              // 是否记录
+    size_t eventsPerThread;    // 每个线程保留的最近事件数（调整为2的幂，只影响之后新分配的缓冲区）
+    std::string dumpDirectory; // 转储文件目录
+    int anomalyBurstCount;     // 窗口内异常事件数达到该值时自动转储（0表示不自动转储）
+    int anomalyBurstWindowMs;  // 异常突发的统计窗口（毫秒）
+    int dumpCooldownMs;        // 两次自动转储之间的最小间隔（毫秒）
+
+    FlightRecorderConfig() :
+        enabled(true),
+        eventsPerThread(4096),
+        dumpDirectory("."),
+        anomalyBurstCount(20),
+        anomalyBurstWindowMs(1000),
+        dumpCooldownMs(60000) {}
+};
+
+// 一条事件（32字节，定长二进制记录）
+struct FlightEvent {
+    long long wallTimeMs;    // 记录时间（毫秒）
+    long long fixTimestamp;  // 定位时间戳（毫秒）
+    int32_t latitudeE7;      // 纬度（1e-7度）
+    int32_t longitudeE7;     // 经度（1e-7度）
+    float value;             // 附加值（含义见FlightEventType）
+    uint8_t type;            // 事件类型
+    uint8_t source;          // 数据源类型
+    uint16_t threadSlot;     // 记录线程的缓冲区编号
+};
+
+// 飞行记录器
+// 每个线程把事件写入自己的定长环形缓冲区（不加锁、不分配内存、不格式化），始终保留最近的事件；
+// 在异常突发、显式调用dump或收到致命信号时才把所有线程的缓冲区写入文件。
+// 异常突发触发的转储交给后台线程写出，不阻塞记录事件的流水线线程。
+// 生产环境日志保持INFO级别，出问题时仍能拿到事故前后完整的流水线上下文
+class FlightRecorder {
+public:
+    // 最多同时记录的线程数（超出的线程不记录）
+    static constexpr size_t MAX_THREADS = 256;
+
+private:
+    mutable std::mutex configMutex;             // 配置互斥锁
+    FlightRecorderConfig config;                // 配置
+    std::atomic<uint64_t> configVersion;        // 配置版本（每次setConfig加1）
+    std::atomic<bool> enabled;                  // 是否记录（记录线程无锁读取）
+    std::atomic<size_t> eventsPerThread;        // 新分配缓冲区的容量
+
+    std::mutex ringMutex;                       // 缓冲区分配互斥锁
+    std::atomic<FlightRing*> rings[MAX_THREADS]; // 各线程的缓冲区（进程退出前不释放，信号处理函数可安全访问）
+    std::atomic<uint64_t> droppedCount;         // 因线程数超过上限未记录的事件数
+
+    std::mutex burstMutex;                      // 异常突发统计互斥锁
+    std::deque<long long> anomalyTimes;         // 窗口内异常事件的时间
+    long long lastAutoDumpMs;                   // 上次自动转储的时间
+    uint64_t burstConfigVersion;                // 以下突发参数对应的配置版本（配置变化后才重新读取）
+    int burstCount;                             // 突发阈值
+    int burstWindowMs;                          // 突发统计窗口（毫秒）
+    int burstCooldownMs;                        // 自动转储最小间隔（毫秒）
+
+    std::mutex dumpMutex;                       // 后台转储互斥锁
+    std::condition_variable dumpCondition;      // 有新的转储请求、转储完成或正在停止
+    std::deque<std::string> dumpRequests;       // 待写出的转储原因
+    size_t dumpsInProgress;                     // 正在写出的转储数
+    bool dumpStopping;                          // 是否正在停止后台转储线程
+    std::thread dumpThread;                     // 后台转储线程（首次请求时启动）
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // 获取当前线程的缓冲区（首次调用时分配或复用已退出线程的缓冲区），没有空闲槽位时返回nullptr
+    FlightRing* threadRing();
+
+    // 统计异常事件，达到突发阈值时请求后台转储
+    void noteAnomaly(long long nowMs);
+
+    // 后台转储线程主循环
+    void dumpLoop();
+
+    // 致命信号处理函数（只调用异步信号安全的函数）
+    static void onFatalSignal(int signalNumber);
+
+public:
+    // 获取单例实例
+    static FlightRecorder& getInstance();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // 设置配置
+    void setConfig(const FlightRecorderConfig& newConfig);
+
+    // 获取配置
+    FlightRecorderConfig getConfig() const;
+
+    // 记录一个与定位相关的事件
+    void record(FlightEventType type, const LocationInfo& location, float value = 0.0f);
+
+    // 记录一个事件
+    void record(FlightEventType type, long long fixTimestamp, double latitude, double longitude, int source,
+                float value);
+
+    // 复制所有线程缓冲区中的事件（按记录时间排序，同一线程内保持记录顺序）
+    // 与记录线程并发复制时，丢弃复制期间可能被覆盖的事件
+    std::vector<FlightEvent> snapshot() const;
+
+    // 将所有事件转储到文件，返回文件路径（失败返回空字符串）
+    std::string dump(const std::string& reason);
+
+    // 请求由后台线程转储（立即返回，快照在后台线程中获取）
+    void requestDump(const std::string& reason);
+
+    // 等待已请求的后台转储全部写出
+    void waitForDumps();
+
+    // 安装致命信号（SIGSEGV、SIGBUS、SIGFPE、SIGILL、SIGABRT）处理函数，收到信号时转储后按默认方式退出
+    // 处理函数在备用信号栈上运行（调用线程和之后记录事件的线程各自分配），栈溢出时也能写出转储
+    bool installCrashHandler();
+
+    // 获取因线程数超过上限未记录的事件数
+    uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    // 获取事件类型字符串
+    static const char* getEventTypeString(FlightEventType type);
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,85 @@
+// LegacyLogParser.h - CSV位置日志（locations_*.log）高速解析
+
+#ifndef LEGACY_LOG_PARSER_H
+#define LEGACY_LOG_PARSER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "LocationCodec.h"
+
+// 解析参数
+struct LegacyParseOptions {
+    size_t threadCount;  // 解析线程数（0表示使用CPU核数）
+    size_t chunkSize;    // 每个分片的字节数（分片边界向后对齐到换行符）
+    size_t maxErrors;    // 最多记录的格式错误行数（超出后只计数）
+
+    LegacyParseOptions() :
+        threadCount(0),
+        chunkSize(16 * 1024 * 1024),
+        maxErrors(100) {}
+};
+
+// 格式错误的行
+struct LegacyParseError {
+    uint64_t line;       // 行号（从1开始）
+    uint64_t offset;     // 行首在文件中的字节偏移
+    std::string reason;  // 错误原因
+    std::string text;    // 行内容（过长时截断）
+
+    LegacyParseError() : line(0), offset(0) {}
+};
+
+// 解析统计
+struct LegacyParseStats {
+    uint64_t bytesParsed;                 // 解析的字节数
+    uint64_t linesTotal;                  // 总行数（不含空行）
+    uint64_t rowsParsed;                  // 解析成功的行数
+    uint64_t linesMalformed;              // 格式错误的行数
+    size_t chunks;                        // 分片数
+    long long elapsedMs;                  // 耗时（毫秒）
+    std::vector<LegacyParseError> errors; // 前maxErrors个格式错误的行
+
+    LegacyParseStats() :
+        bytesParsed(0),
+        linesTotal(0),
+        rowsParsed(0),
+        linesMalformed(0),
+        chunks(0),
+        elapsedMs(0) {}
+};
+
+// CSV位置日志解析器
+// 解析FileStorage::serializeLocation写出的格式：时间戳,纬度,经度,海拔,精度,数据源类型,状态[,[键:值]...]。
+// 文件整体映射到内存后按chunkSize切分为以换行符为边界的分片，多个线程并行解析；
+// 分隔符用SIMD每次比较64字节得到逗号和换行符的位掩码，数值字段用from_chars直接从映射内存解析。
+// 额外信息按原始文本缓存：同一分片中相同的额外信息文本只在第一次出现时拆分和编码，之后只做一次哈希查找。
+// 格式错误的行不抛出异常，跳过后计入统计
+class LegacyLogParser {
+public:
+    // 分片回调，按文件顺序在调用线程中执行，返回false时停止解析
+    using ChunkCallback = std::function<bool(LocationColumns& rows)>;
+
+private:
+    LegacyParseOptions options;  // 解析参数
+
+public:
+    explicit LegacyLogParser(const LegacyParseOptions& parseOptions = LegacyParseOptions());
+
+    // 解析一行（不含换行符），失败时返回false并通过reason返回原因
+    static bool parseLine(const char* data, size_t size, LocationInfo& location, const char** reason = nullptr);
+
+    // 解析一行（不含换行符）
+    static bool parseLine(const std::string& line, LocationInfo& location, const char** reason = nullptr) {
+        return parseLine(line.data(), line.size(), location, reason);
+    }
+
+    // 并行解析文件，每个分片的结果按文件顺序交给回调；文件无法读取或回调要求停止时返回false
+    bool parseFile(const std::string& path, const ChunkCallback& callback, LegacyParseStats* stats = nullptr) const;
+
+    // 并行解析文件，结果按文件顺序追加到rows
+    bool parseFile(const std::string& path, LocationColumns& rows, LegacyParseStats* stats = nullptr) const;
+};
+
+#endif // LEGACY_LOG_PARSER_H
@@ -0,0 +1,135 @@
+// LocationCodec.h - 位置时间序列压缩编码
+
+#ifndef LOCATION_CODEC_H
+#define LOCATION_CODEC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "LocationModel.h"
+
+// 设备ID在LocationInfo额外信息中的键名
+extern const char* const DEVICE_ID_EXTRA_KEY;
+
+// 获取位置数据所属的设备ID（未设置时返回空字符串）
+std::string getDeviceIdOf(const LocationInfo& location);
+
+// 压缩块中的列编号
+enum class CodecColumn : uint8_t {
+    TIMESTAMP = 1,   // 时间戳（delta-of-delta）
+    LATITUDE = 2,    // 纬度（E7量化后差分）
+    LONGITUDE = 3,   // 经度（E7量化后差分）
+    ALTITUDE = 4,    // 海拔（厘米量化后差分）
+    ACCURACY = 5,    // 精度（厘米量化后差分）
+    SPEED = 6,       // 速度（厘米/秒量化后差分）
+    DIRECTION = 7,   // 方向（0.01度量化后差分）
+    SOURCE_TYPE = 8, // 数据源类型（字典编码）
+    STATUS = 9,      // 位置状态（字典编码）
+    DEVICE = 10,     // 设备ID（字典编码）
+    EXTRAS = 11      // 其他额外信息（字典编码）
+};
+
+// 获取列在列掩码中对应的位
+constexpr uint32_t codecColumnBit(CodecColumn column) {
+    return static_cast<uint8_t>(column) < 32 ? 1u << static_cast<uint8_t>(column) : 0u;
+}
+
+// 包含所有列的列掩码
+constexpr uint32_t ALL_CODEC_COLUMNS = 0xFFFFFFFFu;
+
+// 列式位置数据批次
+struct LocationColumns {
+    std::vector<long long> timestamps;          // 时间戳（毫秒）
+    std::vector<double> latitudes;              // 纬度
+    std::vector<double> longitudes;             // 经度
+    std::vector<double> altitudes;              // 海拔
+    std::vector<double> accuracies;             // 精度（米）
+    std::vector<double> speeds;                 // 速度（米/秒）
+    std::vector<double> directions;             // 方向（度）
+    std::vector<uint8_t> sourceTypes;           // 数据源类型
+    std::vector<uint8_t> statuses;              // 位置状态
+    std::vector<uint32_t> deviceIndexes;        // 设备ID在字典中的下标
+    std::vector<std::string> deviceDictionary;  // 设备ID字典
+    std::vector<uint32_t> extrasIndexes;        // 额外信息在字典中的下标
+    std::vector<std::string> extrasDictionary;  // 额外信息字典（已序列化）
+
+    // 获取行数
+    size_t size() const { return timestamps.size(); }
+
+    // 检查是否为空
+    bool empty() const { return timestamps.empty(); }
+
+    // 预留空间
+    void reserve(size_t count);
+
+    // 清空所有数据
+    void clear();
+
+    // 追加一条位置数据
+    void append(const LocationInfo& location);
+
+    // 追加另一批次中的一行
+    void appendRow(const LocationColumns& other, size_t row);
+
+    // 将指定行还原为LocationInfo
+    LocationInfo toLocationInfo(size_t row) const;
+
+    // 获取指定行的设备ID
+    const std::string& getDeviceId(size_t row) const;
+
+    // 将设备ID加入字典并返回下标
+    uint32_t internDevice(const std::string& deviceId);
+
+    // 将已序列化的额外信息加入字典并返回下标
+    uint32_t internExtras(const std::string& encodedExtras);
+
+    // 将两个字典截断到指定大小（撤销之后加入的条目）
+    void truncateDictionaries(size_t deviceCount, size_t extrasCount);
+
+private:
+    std::unordered_map<std::string, uint32_t> deviceLookup; // 设备ID到下标的映射
+    std::unordered_map<std::string, uint32_t> extrasLookup; // 额外信息到下标的映射
+};
+
+// 位置数据块编解码器
+class LocationCodec {
+public:
+    // 块格式版本号
+    static constexpr uint8_t BLOCK_VERSION = 1;
+
+    // 将一批位置数据编码为压缩块（追加到out末尾）
+    static void encodeBlock(const LocationColumns& columns, std::vector<uint8_t>& out);
+
+    // 将压缩块解码并追加到columns，失败时返回false且不修改columns（包括设备ID和额外信息字典）
+    // columnMask指定需要解码的列，未选中的列直接跳过并填充默认值
+    static bool decodeBlock(const uint8_t* data, size_t size, LocationColumns& columns,
+                            uint32_t columnMask = ALL_CODEC_COLUMNS);
+
+    // 仅读取块中的行数
+    static bool peekRowCount(const uint8_t* data, size_t size, uint32_t& rowCount);
+
+    // 序列化额外信息（不包含设备ID）
+    static std::string encodeExtras(const LocationInfo& location);
+
+    // 反序列化额外信息到位置数据
+    static void decodeExtras(const std::string& encoded, LocationInfo& location);
+
+    // 变长整数写入
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value);
+
+    // 变长整数读取
+    static bool readVarint(const uint8_t*& ptr, const uint8_t* end, uint64_t& value);
+
+    // ZigZag编码
+    static uint64_t zigzagEncode(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    // ZigZag解码
+    static int64_t zigzagDecode(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+};
+
+#endif // LOCATION_CODEC_H
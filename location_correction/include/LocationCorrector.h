@@ -3,16 +3,19 @@
 #ifndef LOCATION_CORRECTOR_H
 #define LOCATION_CORRECTOR_H
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <mutex>
 #include "LocationModel.h"
 #include "ConfigModel.h"
+#include "ConfigStore.h"
 #include "AnomalyDetector.h"
 #include "DataFusion.h"
 #include "DataProcessor.h"
 #include "DataStorage.h"
 #include "DataSource.h"
+#include "SceneIndex.h"
 #include "Logger.h"
 #include "Utils.h"
 
@@ -69,8 +72,28 @@ private:
     mutable std::mutex mutex; // 互斥锁
     bool initialized; // 是否已初始化
     std::shared_ptr<DataStorage> storage; // 数据存储
+    SceneLocator sceneLocator; // 场景区域定位（按设备缓存所在区域）
+    std::atomic<uint64_t> appliedConfigVersion_; // 已应用的全局配置版本
+    std::mutex configMutex_; // 串行化配置应用
 
 protected:
+    // 已应用的配置快照：配置与由其场景配置建立的区域索引一起发布（发布后不再修改）
+    struct AppliedConfig {
+        CorrectionConfig config; // 配置
+        std::shared_ptr<const SceneIndex> sceneIndex; // 场景区域索引
+    };
+
+    std::shared_ptr<const AppliedConfig> snapshot_; // 当前配置快照（原子读写）
+
+    // 全局配置有新版本时应用（每次纠偏前调用，版本未变化时只读取一次版本号）
+    void refreshConfig();
+
+    // 应用配置并发布新快照，场景区域变化时重建索引（调用方持有configMutex_）
+    virtual void applyConfig(const CorrectionConfig& config);
+
+    // 查找设备所在的最小场景区域，返回快照中的场景配置，不在任何区域内时返回nullptr
+    const SceneConfig* findSceneRegion(const LocationInfo& location, const AppliedConfig& applied);
+    
     // 通知位置变更
     void notifyLocationChanged(const CorrectedLocation& correctedLocation);
     
@@ -109,6 +132,9 @@ public:
     
     // 设置数据存储
     void setStorage(std::shared_ptr<DataStorage> dataStorage);
+
+    // 添加或替换（按sceneId）场景配置并重建场景区域索引，下一个全局配置版本会覆盖
+    void updateSceneConfig(const SceneConfig& sceneConfig);
 };
 
 // 自适应位置纠偏器
@@ -142,6 +168,10 @@ private:
     // 根据场景获取对应的配置
     CorrectionConfig getConfigForScene(UserScene scene);
 
+protected:
+    // 应用配置并按场景类型重建场景配置表
+    void applyConfig(const CorrectionConfig& config) override;
+
 public:
     AdaptiveLocationCorrector(size_t historySize = 50, long long checkInterval = 5000);
     
@@ -161,6 +191,12 @@ public:
     
     // 强制设置场景
     void forceSetScene(UserScene scene);
+
+    // 恢复场景和上次场景检测时间（服务重启时从设备状态检查点恢复）
+    void restoreScene(LocationScene scene, long long sceneCheckTime);
+
+    // 获取上次场景检测时间
+    long long getLastSceneCheckTime() const;
 };
 
 // 多模式位置纠偏器
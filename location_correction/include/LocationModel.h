@@ -3,6 +3,7 @@
 #ifndef LOCATION_MODEL_H
 #define LOCATION_MODEL_H
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -12,7 +13,8 @@ enum class DataSourceType {
     WIFI,          // Wi-Fi定位
     BASE_STATION,  // 基站定位
     SENSOR,        // 传感器定位
-    OTHER          // 其他定位方式
+    OTHER,         // 其他定位方式
+    FUSED          // 多源融合或插值得到的位置
 };
 
 // 位置状态枚举
@@ -29,49 +31,82 @@ struct LocationInfo {
     double longitude;    // 经度
     double altitude;     // 海拔高度，可选
     double accuracy;     // 精度（米）
-    long long timestamp; // 时间戳（毫秒）
     double speed;        // 速度（米/秒），可选
     double direction;    // 方向（度），可选
-    DataSourceType source; // 数据源类型
+    long long timestamp; // 时间戳（毫秒）
+    DataSourceType sourceType; // 数据源类型
+    LocationStatus status; // 位置状态
+    int satelliteCount;  // 卫星数量（GNSS）
+    int signalStrength;  // 信号强度
+    std::string locationType; // 定位类型
+    std::string provider; // 定位提供者
     std::string sourceId; // 数据源ID
+    std::map<std::string, std::string> extras; // 额外信息（如设备ID）
 
     // 构造函数
-    LocationInfo() : 
-        latitude(0.0), 
-        longitude(0.0), 
-        altitude(0.0), 
-        accuracy(0.0), 
-        timestamp(0), 
-        speed(0.0), 
-        direction(0.0), 
-        source(DataSourceType::OTHER) {}
-
-    LocationInfo(double lat, double lon, double acc, long long ts, DataSourceType src) : 
-        latitude(lat), 
-        longitude(lon), 
-        altitude(0.0), 
-        accuracy(acc), 
-        timestamp(ts), 
-        speed(0.0), 
-        direction(0.0), 
-        source(src) {}
+    LocationInfo();
+    LocationInfo(double lat, double lng, double acc, DataSourceType source);
+    LocationInfo(const LocationInfo& other);
+    LocationInfo& operator=(const LocationInfo& other);
+
+    // 检查位置数据是否有效
+    bool isValid() const;
+
+    // 获取当前时间戳（毫秒）
+    static long long getCurrentTimestampMs();
+
+    // 转换为字符串表示
+    std::string toString() const;
+
+    // 设置额外信息
+    void setExtra(const std::string& key, const std::string& value);
+
+    // 获取额外信息
+    std::string getExtra(const std::string& key, const std::string& defaultValue = "") const;
+
+    // 检查是否存在额外信息
+    bool hasExtra(const std::string& key) const;
+
+    // 获取所有额外信息
+    const std::map<std::string, std::string>& getExtras() const { return extras; }
 };
 
 // 纠偏结果结构
 struct CorrectedLocation {
-    LocationInfo original;  // 原始位置
-    LocationInfo corrected; // 纠偏后位置
-    double confidence;      // 置信度（0-1之间）
-    std::string correctionType; // 纠偏类型
+    LocationInfo originalLocation; // 原始位置
+    double correctedLatitude;      // 纠偏后纬度
+    double correctedLongitude;     // 纠偏后经度
+    double correctedAltitude;      // 纠偏后海拔
+    double correctionAccuracy;     // 纠偏后精度（米）
+    std::string correctionMethod;  // 纠偏方法
+    double confidenceScore;        // 置信度（0-1之间）
+    bool isAnomaly;                // 是否为异常位置
+    std::string anomalyType;       // 异常类型
+    long long correctionTime;      // 纠偏时间（毫秒）
+    double correctionDistance;     // 纠偏距离（米）
+    bool isFused;                  // 是否由多源融合得到
+    int sourceCount;               // 参与融合的数据源数量
+    std::map<std::string, std::string> correctionDetails; // 纠偏详情
 
     // 构造函数
-    CorrectedLocation() : confidence(0.0) {}
+    explicit CorrectedLocation(const LocationInfo& original = LocationInfo());
+    CorrectedLocation(const CorrectedLocation& other);
+    CorrectedLocation& operator=(const CorrectedLocation& other);
+
+    // 获取纠偏后的位置信息
+    LocationInfo getCorrectedLocationInfo() const;
+
+    // 转换为字符串表示
+    std::string toString() const;
+
+    // 设置纠偏详情
+    void setCorrectionDetail(const std::string& key, const std::string& value);
+
+    // 获取纠偏详情
+    std::string getCorrectionDetail(const std::string& key, const std::string& defaultValue = "") const;
 
-    CorrectedLocation(const LocationInfo& orig, const LocationInfo& corr, double conf, const std::string& type) :
-        original(orig), 
-        corrected(corr), 
-        confidence(conf), 
-        correctionType(type) {}
+    // 计算纠偏距离
+    void calculateCorrectionDistance();
 };
 
 // 位置变化监听器接口
@@ -12,6 +12,7 @@
 #include "LocationCorrector.h"
 #include "DataSource.h"
 #include "DataStorage.h"
+#include "DeviceStateStore.h"
 #include "Logger.h"
 #include "Utils.h"
 
@@ -67,12 +68,24 @@ private:
     std::thread dataCollectionThread;
     long long dataCollectionInterval; // 数据收集间隔（毫秒）
     
+    // 设备算法状态（重启后从检查点恢复）
+    std::shared_ptr<DeviceStateStore> deviceStateStore_; // 设备状态存储
+    std::string stateCheckpointPath_; // 检查点文件路径（为空时不保存检查点）
+    long long stateCheckpointIntervalMs_; // 检查点间隔（毫秒）
+    
     // 执行数据收集任务
     void dataCollectionTask();
     
+    // 从检查点恢复设备状态，并用最近更新的设备状态恢复纠偏器场景和最新位置
+    void restoreDeviceState();
+    
     // 处理新的位置数据
     void processNewLocation(std::shared_ptr<LocationInfo> location);
 
+protected:
+    // 记录一次纠偏的输入和输出
+    void recordDeviceState(const LocationInfo& input, const CorrectedLocation& corrected);
+
 public:
     BaseLocationService(long long interval = 1000);
     
@@ -107,6 +120,12 @@ public:
     // 设置数据收集间隔
     void setDataCollectionInterval(long long interval);
     
+    // 设置设备状态检查点（需在initialize之前设置；启动后按间隔保存，停止时保存最后一次）
+    void setStateCheckpoint(const std::string& path, long long intervalMs = 30000);
+    
+    // 获取设备状态存储
+    std::shared_ptr<DeviceStateStore> getDeviceStateStore() const { return deviceStateStore_; }
+    
     // 注册数据源
     bool registerDataSource(std::shared_ptr<DataSource> source);
     
@@ -3,11 +3,36 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include <string>
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <iostream>
-#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LOGGER_HAS_RDTSC 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define LOGGER_HAS_RDTSC 1
+#endif
+
+// 编译器检查printf风格的格式串与参数是否匹配
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_PRINTF_FORMAT(formatIndex, argsIndex) __attribute__((format(printf, formatIndex, argsIndex)))
+#else
+#define LOGGER_PRINTF_FORMAT(formatIndex, argsIndex)
+#endif
 
 // 日志级别枚举
 enum class LogLevel {
@@ -18,47 +43,286 @@ enum class LogLevel {
     FATAL    // 致命错误
 };
 
+// 线程日志缓冲区写满时的处理策略
+enum class LogOverflowPolicy {
+    BLOCK, // 等待日志线程腾出空间，不丢失日志
+    DROP   // 丢弃新日志并计数，不阻塞业务线程
+};
+
 // 日志配置结构体
 struct LoggerConfig {
-    LogLevel level;              // 日志级别
-    std::string logFilePath;     // 日志文件路径
-    bool enableConsoleOutput;    // 是否启用控制台输出
-    bool enableFileOutput;       // 是否启用文件输出
-    size_t maxFileSize;          // 最大文件大小（字节）
+    LogLevel logLevel;                // 日志级别
+    bool enableConsoleOutput;         // 是否启用控制台输出
+    bool enableFileOutput;            // 是否启用文件输出
+    std::string logFile;              // 日志文件路径
+    size_t maxLogFileSize;            // 最大文件大小（字节），超过后轮转
+    int maxBackupFiles;               // 保留的备份文件数
+    bool compressRotatedFiles;        // 是否将轮转后的备份文件压缩为.gz（需要zlib）
+    size_t fileWriteBufferSize;       // 文件输出缓冲区大小（字节），攒满后一次写出
+    int fileFlushIntervalMs;          // 文件输出缓冲区的最长停留时间（毫秒）
+    std::string consoleLogFormat;     // 控制台日志格式
+    std::string fileLogFormat;        // 文件日志格式
+    std::string dateFormat;           // 时间格式
+    size_t threadBufferSize;          // 每个线程的日志缓冲区大小（字节）
+    LogOverflowPolicy overflowPolicy; // 缓冲区写满时的处理策略
+    int rateLimitPerSecond;           // 每个调用点每秒允许输出的日志数（0表示不限速，默认不限速）
+    int rateLimitBurst;               // 每个调用点允许连续输出的日志数
+    LogLevel rateLimitLevel;          // 达到该级别的日志才限速（FATAL不限速）
+    int suppressionReportIntervalMs;  // 汇总输出被限速丢弃的日志数的间隔（毫秒）
 
     // 构造函数
-    LoggerConfig() : 
-        level(LogLevel::INFO),
-        logFilePath("location_correction.log"),
+    LoggerConfig() :
+        logLevel(LogLevel::INFO),
         enableConsoleOutput(true),
         enableFileOutput(false),
-        maxFileSize(10 * 1024 * 1024) // 默认10MB
+        logFile("location_correction.log"),
+        maxLogFileSize(10 * 1024 * 1024), // 默认10MB
+        maxBackupFiles(5),
+        compressRotatedFiles(false),
+        fileWriteBufferSize(64 * 1024),
+        fileFlushIntervalMs(100),
+        consoleLogFormat("[%TIME%] [%LEVEL%] %MESSAGE%"),
+        fileLogFormat("[%TIME%] [%LEVEL%] [%THREAD%] %MESSAGE%"),
+        dateFormat("%Y-%m-%d %H:%M:%S.%MS"),
+        threadBufferSize(256 * 1024),
+        overflowPolicy(LogOverflowPolicy::DROP),
+        rateLimitPerSecond(0),
+        rateLimitBurst(100),
+        rateLimitLevel(LogLevel::WARNING),
+        suppressionReportIntervalMs(10000)
     {}
 };
 
+// 延迟格式化日志的参数类型（按printf的默认实参提升归类）
+enum class LogArgType : uint8_t {
+    INT,                // int及更窄的整数
+    UNSIGNED_INT,       // unsigned int
+    LONG,               // long
+    UNSIGNED_LONG,      // unsigned long
+    LONG_LONG,          // long long
+    UNSIGNED_LONG_LONG, // unsigned long long
+    DOUBLE,             // float、double
+    LONG_DOUBLE,        // long double
+    STRING,             // C字符串（按内容复制）
+    POINTER             // 其他指针（只记录地址）
+};
+
+// C字符串参数的记录方式（注册调用点时按对应的转换说明确定）
+struct LogStringCapture {
+    enum class Mode : uint8_t {
+        CONTENT,       // %s：复制到结尾的'\0'
+        BOUNDED,       // %.Ns：最多复制precision个字符（内容可以不以'\0'结尾）
+        STAR_BOUNDED,  // %.*s：最多复制前一个整数参数个字符
+        ADDRESS        // %p：只记录地址
+    };
+
+    Mode mode;           // 记录方式
+    uint32_t precision;  // BOUNDED的精度
+
+    LogStringCapture() : mode(Mode::CONTENT), precision(0) {}
+};
+
+// 日志调用点（每个LOG_*宏展开处一个静态实例）
+// 首次调用时注册格式串和参数类型，得到格式描述ID，之后只记录ID和参数的原始字节
+struct LogSite {
+    std::atomic<uint32_t> id;                 // 格式描述ID（0表示尚未注册）
+    std::atomic<uint64_t> nextAllowedTicks;   // 限速：令牌桶恢复到能再输出一条的时间刻度（按GCRA记录）
+    std::atomic<uint32_t> suppressed;         // 自上次汇总以来被限速丢弃的日志数
+    const LogStringCapture* captures;         // 各参数的字符串记录方式（注册时写入，由格式描述持有）
+
+    LogSite() : id(0), nextAllowedTicks(0), suppressed(0), captures(nullptr) {}
+};
+
+// 获取日志时间刻度：x86上直接读时间戳计数器，由日志线程换算为墙上时间
+inline uint64_t logTicks() {
+#if defined(LOGGER_HAS_RDTSC)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+class LogBuffer;
+class LogFile;
+struct LogRecord;
+struct LogSiteInfo;
+struct LogLineFormat;
+struct LogTimeFormat;
+
 // 日志工具类
+// 业务线程把日志写入各自的单生产者单消费者环形缓冲区，不加锁、不分配内存；
+// 日志线程轮流批量取出所有缓冲区中的日志，按时间排序后一次性写出。
+// LOG_*宏采用延迟格式化：调用方只写入格式描述ID和参数的原始字节，格式化全部在日志线程中完成。
+// 只有线程第一次写日志（注册缓冲区）、调用点第一次执行（注册格式描述）和缓冲区写满时才会与其他线程同步。
+// 文件输出攒满缓冲区或超过停留时间后才一次写出；轮转时日志线程只重命名当前文件，
+// 备份编号的调整和压缩由轮转线程完成
 class Logger {
 private:
-    static Logger* instance;          // 单例实例
-    static std::mutex instanceMutex;  // 单例互斥锁
-    LoggerConfig config;              // 日志配置
-    std::ofstream logFile;            // 日志文件流
-    std::mutex logMutex;              // 日志互斥锁
+    // 轮转任务
+    struct RotationTask {
+        std::string rotatedPath;  // 日志线程重命名后的文件
+        std::string logFile;      // 日志文件路径
+        int maxBackupFiles;       // 保留的备份文件数
+        bool compress;            // 是否压缩
+    };
+
+    // 延迟格式化日志参数编码后的最大长度，超过时立即格式化
+    static constexpr size_t MAX_DEFERRED_PAYLOAD = 1024;
+
+    LoggerConfig config;                              // 日志配置
+    mutable std::mutex configMutex;                   // 配置互斥锁
+    std::atomic<int> level;                           // 当前日志级别（业务线程无锁读取）
+    std::atomic<int> overflowPolicy;                  // 缓冲区写满时的处理策略
+    std::atomic<size_t> threadBufferSize;             // 新注册缓冲区的大小
+    std::atomic<int> rateLimitLevel;                  // 达到该级别的日志才限速
+    std::atomic<uint64_t> rateLimitIntervalTicks;     // 限速：每条日志消耗的时间刻度（0表示不限速）
+    std::atomic<uint64_t> rateLimitBurstTicks;        // 限速：允许预支的时间刻度（对应突发条数）
+    std::atomic<bool> configChanged;                  // 配置是否已修改（日志线程据此重新打开文件）
+
+    std::mutex registryMutex;                         // 缓冲区注册表互斥锁
+    std::vector<std::shared_ptr<LogBuffer>> buffers;  // 各线程的缓冲区
+    std::atomic<uint64_t> droppedCount;               // 因缓冲区写满丢弃的日志数
+
+    mutable std::mutex siteMutex;                     // 格式描述注册表互斥锁
+    std::vector<std::unique_ptr<LogSiteInfo>> sites;  // 格式描述（下标为ID-1）
+
+    std::mutex wakeMutex;                             // 唤醒日志线程用的互斥锁
+    std::condition_variable wakeCV;                   // 唤醒日志线程
+    std::condition_variable flushedCV;                // 刷新完成
+    std::atomic<bool> writerWaiting;                  // 日志线程是否正在等待
+    uint64_t flushRequested;                          // 已请求的刷新次数
+    uint64_t flushCompleted;                          // 已完成的刷新次数
+    bool truncateRequested;                           // 是否请求清空日志文件
+    bool truncateSucceeded;                           // 最近一次清空是否成功
+    std::atomic<bool> running;                        // 日志线程是否运行
+    std::thread logThread;                            // 日志线程
+
+    std::mutex rotationMutex;                         // 轮转任务队列互斥锁
+    std::condition_variable rotationCV;               // 通知轮转线程
+    std::deque<RotationTask> rotationTasks;           // 待处理的轮转任务
+    bool rotationStopping;                            // 轮转线程是否停止
+    std::thread rotationThread;                       // 轮转线程
+
+    // 以下成员只由日志线程访问
+    std::unique_ptr<LogFile> outputFile;              // 日志文件
+    std::string openedFile;                           // 当前打开的文件路径
+    size_t fileSize;                                  // 已写入当前文件的字节数
+    std::string fileOutput;                           // 尚未写出的文件输出
+    std::chrono::steady_clock::time_point fileOutputSince; // 文件输出缓冲区中最早内容的加入时间
+    uint64_t rotationSequence;                        // 轮转序号（用于生成临时文件名）
+    uint64_t baseTicks;                               // 初始校准点的时间刻度（用于计算刻度频率）
+    std::chrono::steady_clock::time_point baseSteady; // 初始校准点的单调时间
+    uint64_t clockTicks;                              // 最近校准点的时间刻度
+    long long clockWallNs;                            // 最近校准点的墙上时间（纳秒）
+    std::chrono::steady_clock::time_point clockSteady; // 最近校准点的单调时间
+    double ticksPerNs;                                // 每纳秒的时间刻度数
+    std::unique_ptr<LogLineFormat> consoleFormat;     // 预编译的控制台日志格式
+    std::unique_ptr<LogLineFormat> fileFormat;        // 预编译的文件日志格式
+    std::unique_ptr<LogTimeFormat> timeFormat;        // 预编译的时间格式（缓存当前秒的渲染结果）
+    std::string lineBuffer;                           // 格式化一批日志用的缓冲区（重复使用）
+    std::chrono::steady_clock::time_point suppressionReported; // 上次汇总限速丢弃数的时间
 
     // 私有构造函数
     Logger();
     // 析构函数
     ~Logger();
 
-    // 检查并切换日志文件
-    void checkAndRotateLogFile();
+    // 获取当前线程的缓冲区（首次调用时注册）
+    LogBuffer& threadBuffer();
+
+    // 在当前线程的缓冲区中预留一条日志的空间，返回负载的写入位置；缓冲区已满且不等待时返回nullptr
+    char* beginRecord(LogLevel messageLevel, uint32_t siteId, size_t payloadSize, uint64_t ticks);
+
+    // 提交beginRecord预留的日志
+    void endRecord();
+
+    // 将一条已格式化的日志写入当前线程的缓冲区
+    void enqueue(LogLevel messageLevel, const char* message, size_t length);
+
+    // 注册调用点的格式描述，返回ID
+    uint32_t registerSite(LogSite& site, LogLevel messageLevel, const char* format, const LogArgType* types,
+                          size_t count);
+
+    // 按调用点限速，超出速率时计数并返回false
+    // 只用普通的读写更新令牌桶（不加锁、不做原子读改写），多个线程同时写同一调用点时可能多放行几条
+    bool admit(LogLevel messageLevel, LogSite& site, uint64_t now) {
+        uint64_t interval = rateLimitIntervalTicks.load(std::memory_order_relaxed);
+        if (interval == 0 || messageLevel == LogLevel::FATAL ||
+            static_cast<int>(messageLevel) < rateLimitLevel.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        uint64_t next = std::max(site.nextAllowedTicks.load(std::memory_order_relaxed), now);
+        if (next - now > rateLimitBurstTicks.load(std::memory_order_relaxed)) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        site.nextAllowedTicks.store(next + interval, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 按配置和当前的刻度频率换算限速参数
+    void updateRateLimit(const LoggerConfig& currentConfig);
+
+    // 为被限速丢弃过日志的调用点生成汇总日志
+    void reportSuppressed(std::vector<LogRecord>& batch, const LoggerConfig& currentConfig);
+
+    // 按格式描述将参数的原始字节格式化为消息
+    void decodeMessage(uint32_t siteId, const std::string& payload, std::string& out) const;
+
+    // 参数过长放不进缓冲区时，立即格式化并截断后写入
+    void enqueueOversized(LogLevel messageLevel, uint32_t siteId, const std::string& payload);
 
-    // 将日志级别转换为字符串
-    std::string levelToString(LogLevel level);
+    // 将时间刻度换算为墙上时间（毫秒）
+    long long ticksToMs(uint64_t ticks) const;
+
+    // 用当前时间重新校准时钟
+    void calibrateClock(bool initial);
+
+    // 唤醒正在等待的日志线程
+    void wakeWriter();
+
+    // 日志线程主循环
+    void processLogQueue();
+
+    // 取出所有缓冲区中的日志，返回是否还有缓冲区未取空
+    bool drainBuffers(std::vector<LogRecord>& batch);
+
+    // 检查是否有缓冲区未取空
+    bool hasPendingRecords();
+
+    // 格式化并写出一批日志
+    void writeBatch(std::vector<LogRecord>& batch, const LoggerConfig& currentConfig);
+
+    // 按配置打开或关闭日志文件
+    void updateFileStream(const LoggerConfig& currentConfig);
+
+    // 写出文件输出缓冲区，超过最大文件大小时轮转
+    void flushFileOutput(const LoggerConfig& currentConfig);
+
+    // 轮转日志文件：重命名当前文件并重新打开，其余工作交给轮转线程
+    void rotateLogFile(const LoggerConfig& currentConfig);
+
+    // 轮转线程主循环
+    void processRotations();
+
+    // 调整备份文件编号并保存（或压缩）轮转出的文件
+    static void finishRotation(const RotationTask& task);
+
+    // 按配置预编译日志格式和时间格式
+    void compileFormats(const LoggerConfig& currentConfig);
+
+    // 按预编译的格式将一条日志追加到out
+    void appendLogLine(const LogRecord& record, const LogLineFormat& format, std::string& out);
+
+    // 按预编译的时间格式将时间戳追加到out（同一秒内只修改毫秒）
+    void appendTime(long long timestampMs, std::string& out);
 
 public:
-    // 获取单例实例
-    static Logger* getInstance();
+    // 获取单例实例（局部静态变量，初始化后无锁访问）
+    static Logger& getInstance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
 
     // 设置日志配置
     void setConfig(const LoggerConfig& newConfig);
@@ -66,37 +330,116 @@ public:
     // 获取当前日志配置
     LoggerConfig getConfig() const;
 
+    // 设置日志级别
+    void setLogLevel(LogLevel newLevel);
+
+    // 设置日志文件并启用文件输出
+    void setLogFile(const std::string& filePath);
+
+    // 检查日志级别是否需要输出
+    bool shouldLog(LogLevel messageLevel) const {
+        return static_cast<int>(messageLevel) >= level.load(std::memory_order_relaxed);
+    }
+
     // 记录日志
-    void log(LogLevel level, const std::string& tag, const std::string& message);
+    void log(LogLevel messageLevel, const std::string& message);
+
+    // 格式化日志（printf风格，在调用线程中格式化）
+    void logFormat(LogLevel messageLevel, const char* format, ...) LOGGER_PRINTF_FORMAT(3, 4);
+
+    // 延迟格式化日志（由LOG_*宏在检查日志级别后调用），参数须与格式串匹配
+    template <typename... Args>
+    void logDeferred(LogLevel messageLevel, LogSite& site, const char* format, const Args&... args);
+
+    // 仅用于编译期检查格式串（在sizeof中使用，不需要定义）
+    static int checkFormat(const char* format, ...) LOGGER_PRINTF_FORMAT(1, 2);
 
     // 记录调试日志
-    void debug(const std::string& tag, const std::string& message);
+    void debug(const std::string& message) { log(LogLevel::DEBUG, message); }
 
     // 记录信息日志
-    void info(const std::string& tag, const std::string& message);
+    void info(const std::string& message) { log(LogLevel::INFO, message); }
 
     // 记录警告日志
-    void warning(const std::string& tag, const std::string& message);
+    void warning(const std::string& message) { log(LogLevel::WARNING, message); }
 
     // 记录错误日志
-    void error(const std::string& tag, const std::string& message);
+    void error(const std::string& message) { log(LogLevel::ERROR, message); }
+
+    // 记录致命错误日志（写出后才返回）
+    void fatal(const std::string& message) { log(LogLevel::FATAL, message); }
+
+    // 等待此前提交的日志全部写出
+    void flush();
+
+    // 清空日志文件（仅适用于文件日志）
+    bool clearLogFile();
 
-    // 记录致命错误日志
-    void fatal(const std::string& tag, const std::string& message);
+    // 获取因缓冲区写满丢弃的日志数
+    uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
 
-    // 格式化日志（支持可变参数）
-    template<typename... Args>
-    void logFormat(LogLevel level, const std::string& tag, const char* format, Args... args);
+    // 获取日志级别字符串
+    static std::string getLogLevelString(LogLevel logLevel);
+
+    // 从字符串获取日志级别
+    static LogLevel getLogLevelFromString(const std::string& levelStr);
 };
 
-// 方便使用的日志宏定义
-#define LOG_DEBUG(tag, msg) Logger::getInstance()->debug(tag, msg)
-#define LOG_INFO(tag, msg) Logger::getInstance()->info(tag, msg)
-#define LOG_WARNING(tag, msg) Logger::getInstance()->warning(tag, msg)
-#define LOG_ERROR(tag, msg) Logger::getInstance()->error(tag, msg)
-#define LOG_FATAL(tag, msg) Logger::getInstance()->fatal(tag, msg)
+// 编译期最低日志级别（0=DEBUG，1=INFO，2=WARNING，3=ERROR，4=FATAL）
+// 低于该级别的LOG_*宏展开为空语句，参数不求值也不生成代码；默认发布版本（定义了NDEBUG）去掉DEBUG日志，
+// 可以用-DLOGGER_MIN_LEVEL=n覆盖
+#ifndef LOGGER_MIN_LEVEL
+#ifdef NDEBUG
+#define LOGGER_MIN_LEVEL 1
+#else
+#define LOGGER_MIN_LEVEL 0
+#endif
+#endif
+
+// 延迟格式化日志：先检查运行时日志级别再对参数求值，编译期检查格式串，每个展开处有自己的静态调用点
+#define LOGGER_LOG(logLevel, ...) \
+    do { \
+        if (Logger::getInstance().shouldLog(logLevel)) { \
+            (void)sizeof(Logger::checkFormat(__VA_ARGS__)); \
+            Logger::getInstance().logDeferred( \
+                logLevel, []() -> LogSite& { static LogSite site; return site; }(), __VA_ARGS__); \
+        } \
+    } while (0)
+
+// 编译期去掉的日志：只检查格式串（参数在sizeof中不求值）
+#define LOGGER_DISABLED(...) \
+    do { \
+        (void)sizeof(Logger::checkFormat(__VA_ARGS__)); \
+    } while (0)
+
+// 方便使用的日志宏定义（printf风格）
+#if LOGGER_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) LOGGER_LOG(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOGGER_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOGGER_MIN_LEVEL <= 1
+#define LOG_INFO(...) LOGGER_LOG(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOGGER_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOGGER_MIN_LEVEL <= 2
+#define LOG_WARNING(...) LOGGER_LOG(LogLevel::WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) LOGGER_DISABLED(__VA_ARGS__)
+#endif
+
+#if LOGGER_MIN_LEVEL <= 3
+#define LOG_ERROR(...) LOGGER_LOG(LogLevel::ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOGGER_DISABLED(__VA_ARGS__)
+#endif
+
+#define LOG_FATAL(...) LOGGER_LOG(LogLevel::FATAL, __VA_ARGS__)
 
 // 模板方法实现
 #include "Logger.tpp"
 
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
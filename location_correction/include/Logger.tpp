@@ -4,27 +4,189 @@
 #define LOGGER_TPP
 
 #include "Logger.h"
-#include <cstdio>
 
-// 模板方法实现：格式化日志
- template<typename... Args>
- void Logger::logFormat(LogLevel level, const std::string& tag, const char* format, Args... args) {
-    if (level < config.level) {
+// 延迟格式化参数的编码规则（按printf的默认实参提升记录，使日志线程能以相同的类型调用snprintf）
+template <typename T, typename Enable = void>
+struct LogArgTraits {
+    static_assert(sizeof(T) == 0, "Unsupported log argument type");
+};
+
+// 整数和非限定作用域枚举
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+    using Promoted = decltype(+std::declval<T>());
+
+    static constexpr LogArgType type =
+        std::is_same<Promoted, int>::value ? LogArgType::INT :
+        std::is_same<Promoted, unsigned int>::value ? LogArgType::UNSIGNED_INT :
+        std::is_same<Promoted, long>::value ? LogArgType::LONG :
+        std::is_same<Promoted, unsigned long>::value ? LogArgType::UNSIGNED_LONG :
+        std::is_same<Promoted, long long>::value ? LogArgType::LONG_LONG : LogArgType::UNSIGNED_LONG_LONG;
+
+    static_assert(std::is_same<Promoted, unsigned long long>::value || type != LogArgType::UNSIGNED_LONG_LONG,
+                  "Unsupported integer log argument type");
+
+    static size_t size(const T&) { return sizeof(Promoted); }
+
+    static char* encode(char* out, const T& value, size_t) {
+        Promoted promoted = value;
+        std::memcpy(out, &promoted, sizeof(promoted));
+        return out + sizeof(promoted);
+    }
+};
+
+// 浮点数
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    using Promoted = typename std::conditional<std::is_same<T, long double>::value, long double, double>::type;
+
+    static constexpr LogArgType type =
+        std::is_same<T, long double>::value ? LogArgType::LONG_DOUBLE : LogArgType::DOUBLE;
+
+    static size_t size(const T&) { return sizeof(Promoted); }
+
+    static char* encode(char* out, const T& value, size_t) {
+        Promoted promoted = value;
+        std::memcpy(out, &promoted, sizeof(promoted));
+        return out + sizeof(promoted);
+    }
+};
+
+// C字符串（含字符数组）：4字节长度加内容（空指针的长度记为0xFFFFFFFF）
+// 按调用点注册的记录方式：%.Ns和%.*s最多复制精度个字符（不要求以'\0'结尾），%p只记录地址
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_same<T, const char*>::value ||
+                                               std::is_same<T, char*>::value>::type> {
+    static constexpr LogArgType type = LogArgType::STRING;
+
+    static size_t size(const char* value, const LogStringCapture& capture, long long lastInteger) {
+        if (capture.mode == LogStringCapture::Mode::ADDRESS) {
+            return sizeof(const void*);
+        }
+        if (!value) {
+            return sizeof(uint32_t);
+        }
+        size_t limit = capture.mode == LogStringCapture::Mode::BOUNDED ? capture.precision :
+                       capture.mode == LogStringCapture::Mode::STAR_BOUNDED && lastInteger >= 0 ?
+                       static_cast<size_t>(lastInteger) : SIZE_MAX;
+        if (limit == SIZE_MAX) {
+            return sizeof(uint32_t) + std::strlen(value);
+        }
+        const void* terminator = std::memchr(value, '\0', limit);
+        return sizeof(uint32_t) + (terminator ? static_cast<const char*>(terminator) - value : limit);
+    }
+
+    static char* encode(char* out, const char* value, const LogStringCapture& capture, size_t encodedSize) {
+        if (capture.mode == LogStringCapture::Mode::ADDRESS) {
+            const void* address = value;
+            std::memcpy(out, &address, sizeof(address));
+            return out + sizeof(address);
+        }
+        uint32_t length = value ? static_cast<uint32_t>(encodedSize - sizeof(uint32_t)) : UINT32_MAX;
+        std::memcpy(out, &length, sizeof(length));
+        out += sizeof(length);
+        if (value) {
+            std::memcpy(out, value, encodedSize - sizeof(uint32_t));
+            out += encodedSize - sizeof(uint32_t);
+        }
+        return out;
+    }
+};
+
+// 其他指针和数组（%p）
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<(std::is_pointer<T>::value && !std::is_same<T, const char*>::value &&
+                                                !std::is_same<T, char*>::value) ||
+                                               std::is_same<T, std::nullptr_t>::value>::type> {
+    static constexpr LogArgType type = LogArgType::POINTER;
+
+    static size_t size(const void*) { return sizeof(const void*); }
+
+    static char* encode(char* out, const void* value, size_t) {
+        std::memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+};
+
+// 计算参数编码后的长度，并记录最近的整数参数（作为其后%.*s的精度）
+template <typename T>
+size_t logArgSize(const T& value, const LogStringCapture& capture, long long& lastInteger) {
+    using Traits = LogArgTraits<typename std::decay<T>::type>;
+    if constexpr (Traits::type == LogArgType::STRING) {
+        return Traits::size(value, capture, lastInteger);
+    } else {
+        (void)capture;
+        if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            lastInteger = static_cast<long long>(value);
+        }
+        return Traits::size(value);
+    }
+}
+
+// 编码参数
+template <typename T>
+char* logArgEncode(char* out, const T& value, const LogStringCapture& capture, size_t encodedSize) {
+    using Traits = LogArgTraits<typename std::decay<T>::type>;
+    if constexpr (Traits::type == LogArgType::STRING) {
+        return Traits::encode(out, value, capture, encodedSize);
+    } else {
+        (void)capture;
+        return Traits::encode(out, value, encodedSize);
+    }
+}
+
+// 模板方法实现：延迟格式化日志
+template <typename... Args>
+void Logger::logDeferred(LogLevel messageLevel, LogSite& site, const char* format, const Args&... args) {
+    if (!shouldLog(messageLevel)) {
         return;
     }
 
-    // 使用snprintf计算所需的字符串长度
-    int length = snprintf(nullptr, 0, format, args...);
-    if (length <= 0) {
+    // 首次执行时注册格式描述
+    uint32_t siteId = site.id.load(std::memory_order_acquire);
+    if (siteId == 0) {
+        static const LogArgType types[] = {LogArgTraits<typename std::decay<Args>::type>::type..., LogArgType::INT};
+        siteId = registerSite(site, messageLevel, format, types, sizeof...(Args));
+    }
+    // 时间刻度只读取一次，限速和日志记录共用
+    uint64_t ticks = logTicks();
+    if (!admit(messageLevel, site, ticks)) {
         return;
     }
 
-    // 分配足够的空间
-    std::string message(length + 1, '\0');
-    snprintf(&message[0], message.size(), format, args...);
+    // 计算参数编码后的长度（字符串长度只计算一次）
+    const LogStringCapture* captures = site.captures;
+    size_t sizes[sizeof...(Args) + 1] = {};
+    size_t payloadSize = 0;
+    size_t index = 0;
+    long long lastInteger = -1;
+    ((payloadSize += sizes[index] = logArgSize(args, captures[index], lastInteger),
+      ++index), ...);
+    (void)sizes;
+    (void)index;
+    (void)captures;
+    (void)lastInteger;
 
-    // 调用普通log方法
-    log(level, tag, message);
+    if (payloadSize > MAX_DEFERRED_PAYLOAD) {
+        std::string payload(payloadSize, '\0');
+        char* out = &payload[0];
+        index = 0;
+        ((out = logArgEncode(out, args, captures[index], sizes[index]), ++index), ...);
+        (void)out;
+        enqueueOversized(messageLevel, siteId, payload);
+    } else {
+        char* out = beginRecord(messageLevel, siteId, payloadSize, ticks);
+        if (!out) {
+            return;
+        }
+        index = 0;
+        ((out = logArgEncode(out, args, captures[index], sizes[index]), ++index), ...);
+        endRecord();
+    }
+
+    if (messageLevel == LogLevel::FATAL) {
+        flush();
+    }
 }
 
-#endif // LOGGER_TPP
\ No newline at end of file
+#endif // LOGGER_TPP
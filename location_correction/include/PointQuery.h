@@ -0,0 +1,127 @@
+// PointQuery.h - 时间点位置查询与设备时间索引
+
+#ifndef POINT_QUERY_H
+#define POINT_QUERY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SegmentFile.h"
+
+// 时间点位置的来源
+enum class PointLocationKind {
+    EXACT,        // 查询时刻恰有定位点
+    INTERPOLATED, // 由前后定位点插值
+    NEAREST       // 只有一侧可用定位点，取最近的定位点
+};
+
+// 时间点查询参数
+struct PointQueryOptions {
+    long long maxGapMs;           // 前后定位点间隔超过该值时不插值（毫秒）
+    long long maxExtrapolationMs; // 取最近定位点时允许的最大时间差（毫秒）
+    double driftSpeed;            // 定位点之间未观测运动的速度不确定度（米/秒），用于放大精度值
+
+    PointQueryOptions() :
+        maxGapMs(10 * 60 * 1000),
+        maxExtrapolationMs(60 * 1000),
+        driftSpeed(1.0) {}
+
+    // 需要查找的定位点与查询时刻的最大时间差
+    long long searchDistanceMs() const { return std::max(maxGapMs, maxExtrapolationMs); }
+};
+
+// 时间点查询
+struct PointQuery {
+    std::string deviceId; // 设备ID
+    long long timestamp;  // 查询时刻（毫秒）
+
+    PointQuery() : timestamp(0) {}
+    PointQuery(const std::string& device, long long time) : deviceId(device), timestamp(time) {}
+};
+
+// 时间点查询结果
+struct PointLocation {
+    LocationInfo location;     // 查询时刻的位置（时间戳为查询时刻，精度值为传播后的不确定度）
+    PointLocationKind kind;    // 位置来源
+    long long beforeTimestamp; // 使用的之前定位点时间戳（没有时等于查询时刻）
+    long long afterTimestamp;  // 使用的之后定位点时间戳（没有时等于查询时刻）
+
+    PointLocation() : kind(PointLocationKind::EXACT), beforeTimestamp(0), afterTimestamp(0) {}
+};
+
+// 计算查询时刻前后maxDistanceMs的时间窗口（溢出时取边界值）
+void searchWindow(long long timestamp, long long maxDistanceMs, long long& startTime, long long& endTime);
+
+// 用一个定位点更新查询时刻之前（含）和之后（含）最近的定位点
+void updateBracket(const LocationInfo& candidate, long long timestamp,
+                   std::optional<LocationInfo>& before, std::optional<LocationInfo>& after);
+
+// 根据前后定位点计算查询时刻的位置，没有可用定位点时返回空
+// 插值时精度值按两点精度加权合成，再加上与两点距离成比例的运动不确定度；取最近定位点时按时间差放大
+std::optional<PointLocation> interpolateLocation(const std::optional<LocationInfo>& before,
+                                                 const std::optional<LocationInfo>& after,
+                                                 long long timestamp, const PointQueryOptions& options);
+
+// 段文件的设备时间索引
+// 每个段文件首次查询时只解码时间戳和设备列，为每个设备建立按时间排序的（时间戳，块，行）列表，
+// 查找前后定位点为二分查找；命中的块按LRU缓存解码结果。段文件追加新块时只为新块补充索引
+class DeviceTimeIndex {
+private:
+    // 索引项
+    struct Entry {
+        long long timestamp; // 时间戳
+        uint32_t block;      // 块下标
+        uint32_t row;        // 块内行号
+    };
+
+    // 单个段文件的索引
+    struct SegmentIndex {
+        uint64_t fileSize;                                            // 建立索引时的文件大小
+        SegmentReader reader;                                         // 段文件读取器（保持打开以读取命中的块）
+        std::vector<SegmentBlockInfo> blocks;                         // 已建立索引的块
+        long long minTimestamp;                                       // 最小时间戳
+        long long maxTimestamp;                                       // 最大时间戳
+        std::unordered_map<std::string, std::vector<Entry>> devices; // 设备ID到索引项（按时间排序）
+    };
+
+    // 缓存的解码块
+    struct CachedBlock {
+        std::string path;        // 段文件路径
+        uint32_t block;          // 块下标
+        LocationColumns columns; // 解码后的数据
+    };
+
+    std::mutex mutex;                                                   // 互斥锁
+    std::map<std::string, std::unique_ptr<SegmentIndex>> segments;     // 段文件路径到索引
+    std::list<CachedBlock> blockCache;                                  // 解码块缓存（最近使用的在前）
+    size_t blockCacheCapacity;                                          // 最多缓存的块数
+
+    // 获取段文件的索引，文件有新块时补充索引（调用方需持有mutex）
+    SegmentIndex* indexFor(const std::string& path);
+
+    // 读取段文件中的一行（调用方需持有mutex）
+    bool fetch(const std::string& path, uint32_t block, uint32_t row, LocationInfo& location);
+
+public:
+    explicit DeviceTimeIndex(size_t cachedBlocks = 16);
+
+    // 在一组段文件中查找设备在查询时刻前后最近的定位点（只更新比现有结果更近的一侧），
+    // maxDistanceMs为定位点与查询时刻的最大时间差
+    void find(const std::vector<std::string>& segmentFiles, const std::string& deviceId, long long timestamp,
+              long long maxDistanceMs, std::optional<LocationInfo>& before, std::optional<LocationInfo>& after);
+
+    // 清空索引和缓存
+    void clear();
+
+    // 获取已建立索引的段文件数
+    size_t getSegmentCount();
+};
+
+#endif // POINT_QUERY_H
@@ -0,0 +1,153 @@
+// RetentionManager.h - 分级保留策略与后台降采样压实
+
+#ifndef RETENTION_MANAGER_H
+#define RETENTION_MANAGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SegmentFile.h"
+
+// 保留层级：早于minAgeMs的数据降采样到resolutionMs分辨率（0表示保留全分辨率）
+struct RetentionTier {
+    long long minAgeMs;     // 数据最小年龄（毫秒）
+    long long resolutionMs; // 该层级的时间分辨率（毫秒）
+
+    RetentionTier(long long age = 0, long long resolution = 0) :
+        minAgeMs(age),
+        resolutionMs(resolution) {}
+};
+
+// 保留策略配置
+struct RetentionConfig {
+    std::vector<RetentionTier> tiers;  // 保留层级（无需排序）
+    long long maxRetentionMs;          // 最长保留时间，超过后删除（0表示永久保留）
+    long long checkIntervalMs;         // 后台检查间隔（毫秒）
+    long long activeSegmentGraceMs;    // 未写入文件尾的段在此时间内视为正在写入
+    size_t ioBudgetBytesPerSecond;     // 后台I/O预算（字节/秒，0表示不限制）
+    size_t targetSegmentSize;          // 合并后段文件的目标大小（字节）
+    size_t blockRowCount;              // 合并后每个块的行数
+
+    // 默认：7天内全分辨率，7~90天10秒分辨率，90天以上1分钟分辨率
+    RetentionConfig() :
+        tiers({RetentionTier(0, 0),
+               RetentionTier(7LL * 24 * 3600 * 1000, 10 * 1000),
+               RetentionTier(90LL * 24 * 3600 * 1000, 60 * 1000)}),
+        maxRetentionMs(0),
+        checkIntervalMs(10 * 60 * 1000),       // 默认10分钟
+        activeSegmentGraceMs(2 * 3600 * 1000), // 默认2小时
+        ioBudgetBytesPerSecond(8 * 1024 * 1024), // 默认8MB/s
+        targetSegmentSize(64 * 1024 * 1024),   // 默认64MB
+        blockRowCount(4096) {}
+};
+
+// 保留策略执行统计
+struct RetentionStats {
+    size_t segmentsCompacted; // 被合并的段数
+    size_t segmentsWritten;   // 新写出的段数
+    size_t filesDeleted;      // 因超期删除的文件数
+    uint64_t rowsBefore;      // 降采样前行数
+    uint64_t rowsAfter;       // 降采样后行数
+    uint64_t bytesReclaimed;  // 回收的磁盘空间（字节）
+
+    RetentionStats() :
+        segmentsCompacted(0),
+        segmentsWritten(0),
+        filesDeleted(0),
+        rowsBefore(0),
+        rowsAfter(0),
+        bytesReclaimed(0) {}
+};
+
+// 保留策略管理器
+// 只处理已关闭的段文件：先写临时文件，完成后重命名替换，不阻塞写入和查询；
+// 替换旧段前写出清单，中途崩溃后下一轮按清单完成或放弃替换
+class RetentionManager {
+private:
+    std::string storagePath;            // 存储目录
+    RetentionConfig config;             // 保留策略配置
+    mutable std::mutex mutex;           // 互斥锁（保护配置和统计）
+    std::mutex runMutex;                // 保证同一时刻只有一轮整理
+    std::condition_variable stopCV;     // 用于可中断的等待
+    std::atomic<bool> running;          // 后台线程是否运行
+    std::atomic<bool> stopRequested;    // 是否已请求停止
+    std::thread workerThread;           // 后台线程
+    RetentionStats stats;               // 累计统计
+    std::function<std::string()> activeSegmentProvider; // 获取正在写入的段文件路径
+
+    // I/O限流状态
+    std::chrono::steady_clock::time_point throttleWindowStart;
+    uint64_t throttleWindowBytes;
+
+    // 待处理的段文件信息
+    struct SegmentCandidate {
+        std::string path;          // 文件路径
+        long long minTimestamp;    // 最小时间戳
+        long long maxTimestamp;    // 最大时间戳
+        long long resolutionMs;    // 当前分辨率
+        uint64_t fileSize;         // 文件大小
+    };
+
+    // 后台线程主循环
+    void workerLoop();
+
+    // 降低当前线程的调度优先级
+    static void lowerThreadPriority();
+
+    // 按I/O预算限流，返回false表示已请求停止
+    bool throttle(uint64_t bytes);
+
+    // 获取某个年龄对应的目标分辨率
+    long long targetResolutionFor(long long ageMs, const RetentionConfig& cfg) const;
+
+    // 处理上一轮遗留的压实文件（补删已发布新段对应的旧段，删除临时文件）
+    void recoverCompactions();
+
+    // 写出压实清单（列出被新段替换的旧段）
+    bool writeManifest(const std::string& manifestPath, const std::vector<SegmentCandidate>& group);
+
+    // 将一组段降采样并合并为一个新段
+    bool compactSegments(const std::vector<SegmentCandidate>& group, long long resolutionMs,
+                         const RetentionConfig& cfg, RetentionStats& roundStats);
+
+    // 删除过期的CSV日志文件
+    void deleteExpiredLogFiles(const RetentionConfig& cfg, RetentionStats& roundStats);
+
+public:
+    RetentionManager(const std::string& path, const RetentionConfig& retentionConfig = RetentionConfig());
+    ~RetentionManager();
+
+    RetentionManager(const RetentionManager&) = delete;
+    RetentionManager& operator=(const RetentionManager&) = delete;
+
+    // 启动后台线程
+    bool start();
+
+    // 停止后台线程
+    void stop();
+
+    // 立即执行一轮整理（now为当前时间，毫秒）
+    RetentionStats runOnce(long long now);
+
+    // 更新保留策略配置
+    void setConfig(const RetentionConfig& retentionConfig);
+
+    // 获取保留策略配置
+    RetentionConfig getConfig() const;
+
+    // 获取累计统计
+    RetentionStats getStats() const;
+
+    // 设置正在写入的段文件路径获取函数（该段不会被整理）
+    void setActiveSegmentProvider(const std::function<std::string()>& provider);
+
+    // 从段文件名中解析分辨率（未压实的段返回0）
+    static long long parseSegmentResolution(const std::string& fileName);
+};
+
+#endif // RETENTION_MANAGER_H
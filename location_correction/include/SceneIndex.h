@@ -0,0 +1,133 @@
+// SceneIndex.h - 场景区域空间索引（均匀网格）与按设备缓存的区域定位
+
+#ifndef SCENE_INDEX_H
+#define SCENE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 场景区域（以中心点和半径表示的圆）
+struct SceneRegion {
+    double latitude;   // 中心点纬度
+    double longitude;  // 中心点经度
+    double radius;     // 半径（米）
+    size_t scene;      // 在场景配置列表中的下标
+};
+
+// 场景区域空间索引
+// 配置加载时把每个区域的外接矩形登记到覆盖的网格（格子边长按区域半径的中位数选取），
+// 查询时只检查位置所在格子中的区域，与区域总数无关。覆盖格子过多的大区域单独存放，每次查询逐个检查。
+// 建立后只读，可被多个线程同时查询
+class SceneIndex {
+public:
+    // 单个区域最多登记的格子数（超过的作为大区域单独存放）
+    static constexpr size_t MAX_CELLS_PER_REGION = 64;
+
+private:
+    double cellSize;                       // 格子边长（度）
+    int64_t columns;                       // 经度方向的格子数
+    std::vector<SceneRegion> regions;      // 区域（按半径从小到大排列，下标即区域编号）
+    std::vector<uint8_t> exclusive;        // 区域是否与其他区域都不相交
+    std::unordered_map<int64_t, std::vector<uint32_t>> cells; // 格子编号到区域编号（从小到大）
+    std::vector<uint32_t> largeRegions;    // 大区域编号（从小到大）
+
+    // 区域外接矩形覆盖的格子范围，覆盖格子过多或跨越极点时返回false
+    bool cellRange(const SceneRegion& region, int64_t& rowMin, int64_t& rowMax,
+                   int64_t& colMin, int64_t& colMax) const;
+
+    // 获取格子中登记的区域编号，格子为空时返回nullptr
+    const std::vector<uint32_t>* cellRegions(int64_t cell) const;
+
+public:
+    SceneIndex();
+
+    // 由场景配置建立索引（Scene需有latitude、longitude、radius字段，半径不大于0的场景不参与索引）
+    template <typename Scene>
+    void build(const std::vector<Scene>& scenes);
+
+    // 由区域列表建立索引
+    void buildRegions(std::vector<SceneRegion> regionList);
+
+    // 查找包含该位置的最小区域，返回区域编号，不在任何区域内时返回-1
+    int64_t findRegion(double latitude, double longitude) const;
+
+    // 查询包含该位置的所有区域的场景下标（最小的区域在前）
+    void query(double latitude, double longitude, std::vector<size_t>& scenes) const;
+
+    // 位置是否在区域内
+    bool contains(size_t region, double latitude, double longitude) const;
+
+    // 获取区域
+    const SceneRegion& getRegion(size_t region) const { return regions[region]; }
+
+    // 区域是否与其他区域都不相交（设备留在这样的区域内时，所在区域不会变化）
+    bool isExclusive(size_t region) const { return exclusive[region] != 0; }
+
+    // 获取区域数
+    size_t size() const { return regions.size(); }
+
+    // 获取格子边长（度）
+    double getCellSize() const { return cellSize; }
+};
+
+// 场景区域定位器
+// 在索引之上按设备缓存上次所在的区域：设备仍在一个与其他区域都不相交的区域内时只检查这一个区域，
+// 离开该区域或所在区域与其他区域相交时再查询索引。按设备ID分片加锁
+class SceneLocator {
+private:
+    // 分片
+    struct Shard {
+        std::mutex mutex;                                     // 分片互斥锁
+        std::shared_ptr<const SceneIndex> index;              // 当前索引
+        std::unordered_map<std::string, size_t> devices;      // 设备ID到所在的独立区域编号
+        uint64_t hits;                                        // 缓存命中次数
+        uint64_t misses;                                      // 查询索引次数
+
+        Shard() : hits(0), misses(0) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards; // 分片
+
+    // 获取设备所在的分片
+    Shard& shardFor(const std::string& deviceId) const;
+
+    // 在索引中定位设备（调用方持有分片锁，分片缓存属于该索引）
+    static int64_t locateLocked(Shard& shard, const SceneIndex& index, const std::string& deviceId,
+                                double latitude, double longitude);
+
+public:
+    explicit SceneLocator(size_t shardCount = 64);
+
+    SceneLocator(const SceneLocator&) = delete;
+    SceneLocator& operator=(const SceneLocator&) = delete;
+
+    // 替换索引（清空所有设备的缓存）
+    void setIndex(std::shared_ptr<const SceneIndex> index);
+
+    // 定位设备所在的最小区域，返回场景下标，不在任何区域内或没有索引时返回-1
+    int64_t locate(const std::string& deviceId, double latitude, double longitude);
+
+    // 在指定索引中定位设备（调用方持有与场景配置一起发布的索引，结果下标属于同一份配置）
+    // 分片当前的索引不是该索引时先切换并清空分片缓存
+    int64_t locate(const std::shared_ptr<const SceneIndex>& index, const std::string& deviceId,
+                   double latitude, double longitude);
+
+    // 删除设备的缓存
+    void forget(const std::string& deviceId);
+
+    // 获取缓存命中次数
+    uint64_t getHitCount() const;
+
+    // 获取查询索引次数
+    uint64_t getMissCount() const;
+};
+
+// 模板方法实现
+#include "SceneIndex.tpp"
+
+#endif // SCENE_INDEX_H
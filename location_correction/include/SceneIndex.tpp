@@ -0,0 +1,21 @@
+// SceneIndex.tpp - SceneIndex类模板方法实现
+
+#ifndef SCENE_INDEX_TPP
+#define SCENE_INDEX_TPP
+
+#include "SceneIndex.h"
+
+// 由场景配置建立索引
+template <typename Scene>
+void SceneIndex::build(const std::vector<Scene>& scenes) {
+    std::vector<SceneRegion> regionList;
+    regionList.reserve(scenes.size());
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        if (scenes[i].radius > 0.0) {
+            regionList.push_back(SceneRegion{scenes[i].latitude, scenes[i].longitude, scenes[i].radius, i});
+        }
+    }
+    buildRegions(std::move(regionList));
+}
+
+#endif // SCENE_INDEX_TPP
@@ -0,0 +1,165 @@
+// SegmentFile.h - 压缩段文件读写
+
+#ifndef SEGMENT_FILE_H
+#define SEGMENT_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+#include "LocationCodec.h"
+
+// 段文件扩展名
+extern const char* const SEGMENT_FILE_EXTENSION;
+
+// 块内行位图（第i位对应块内第i行）
+using RowBitmap = std::vector<uint64_t>;
+
+// 取值掩码中表示"取值未知"的值（旧版本段文件或取值超出掩码范围）
+constexpr uint32_t SEGMENT_ANY_VALUE_MASK = 0xFFFFFFFFu;
+
+// 段内数据块的元信息
+struct SegmentBlockInfo {
+    uint64_t offset;         // 块数据在文件中的偏移（不含帧头）
+    uint32_t size;           // 块数据字节数
+    uint32_t rowCount;       // 块内行数
+    long long minTimestamp;  // 块内最小时间戳
+    long long maxTimestamp;  // 块内最大时间戳
+    uint32_t sourceTypeMask; // 块内出现的数据源类型（第i位对应取值i）
+    uint32_t statusMask;     // 块内出现的位置状态（第i位对应取值i）
+    uint64_t bitmapOffset;   // 行位图索引在文件中的偏移
+    uint32_t bitmapSize;     // 行位图索引字节数（0表示没有位图索引）
+
+    SegmentBlockInfo() :
+        offset(0),
+        size(0),
+        rowCount(0),
+        minTimestamp(0),
+        maxTimestamp(0),
+        sourceTypeMask(SEGMENT_ANY_VALUE_MASK),
+        statusMask(SEGMENT_ANY_VALUE_MASK),
+        bitmapOffset(0),
+        bitmapSize(0) {}
+
+    // 根据取值掩码检查块内是否可能包含指定数据源类型和位置状态的行
+    bool mayContain(const std::optional<DataSourceType>& sourceType, const std::optional<LocationStatus>& status) const;
+};
+
+// 段文件写入器
+// 文件格式：[帧头(长度) + 压缩块]* + 行位图索引 + 块索引 + 固定长度的文件尾
+// 行位图索引按块记录每个数据源类型和位置状态取值对应的行，写入期间暂存在内存中，在finish时落盘
+class SegmentWriter {
+private:
+    std::ofstream stream;                 // 文件输出流
+    std::string path;                     // 文件路径
+    std::vector<SegmentBlockInfo> blocks; // 已写入的块
+    uint64_t bytesWritten;                // 已写入字节数
+    std::vector<uint8_t> encodeBuffer;    // 编码缓冲区（复用）
+    std::vector<uint8_t> bitmapBuffer;    // 待写入的行位图索引
+    bool directorySynced;                 // 文件名是否已刷到磁盘
+
+public:
+    SegmentWriter();
+    ~SegmentWriter();
+
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+    // 创建并打开段文件
+    bool open(const std::string& filePath);
+
+    // 编码并追加一个数据块
+    bool appendBlock(const LocationColumns& columns);
+
+    // 将已追加的块刷到磁盘（首次调用时同时同步所在目录），记录引用这些块的检查点之前调用
+    bool sync();
+
+    // 写入块索引和文件尾，刷到磁盘并关闭文件
+    bool finish();
+
+    // 检查是否已打开
+    bool isOpen() const { return stream.is_open(); }
+
+    // 获取已写入的字节数
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+    // 获取已写入的块数
+    size_t getBlockCount() const { return blocks.size(); }
+
+    // 获取文件路径
+    const std::string& getPath() const { return path; }
+};
+
+// 段文件读取器
+class SegmentReader {
+private:
+    std::ifstream stream;                 // 文件输入流
+    std::string path;                     // 文件路径
+    std::vector<SegmentBlockInfo> blocks; // 块索引
+    uint64_t fileSize;                    // 文件大小
+    uint64_t bytesRead;                   // 已读取的字节数
+    bool complete;                        // 是否包含完整的文件尾
+    std::vector<uint8_t> readBuffer;      // 读取缓冲区（复用）
+
+    // 从文件尾加载块索引
+    bool loadFooter();
+
+    // 文件尾缺失时顺序扫描帧头重建索引（用于未正常关闭的段）
+    bool scanBlocks();
+
+public:
+    SegmentReader();
+
+    // 打开段文件并加载块索引
+    bool open(const std::string& filePath);
+
+    // 关闭文件
+    void close();
+
+    // 获取块索引
+    const std::vector<SegmentBlockInfo>& getBlocks() const { return blocks; }
+
+    // 读取原始块数据
+    bool readRawBlock(size_t index, std::vector<uint8_t>& data);
+
+    // 读取并解码指定块，追加到columns（columnMask指定需要解码的列）
+    bool readBlock(size_t index, LocationColumns& columns, uint32_t columnMask = ALL_CODEC_COLUMNS);
+
+    // 读取指定块中数据源类型和位置状态同时满足条件的行位图（条件为空表示不限）
+    // 块没有位图索引或两个条件都为空时返回false，调用方需逐行判断
+    bool readRowBitmap(size_t index, const std::optional<DataSourceType>& sourceType,
+                       const std::optional<LocationStatus>& status, RowBitmap& rows);
+
+    // 获取段内最小时间戳
+    long long getMinTimestamp() const;
+
+    // 获取段内最大时间戳
+    long long getMaxTimestamp() const;
+
+    // 获取段内总行数
+    uint64_t getRowCount() const;
+
+    // 根据块的取值掩码检查段内是否可能包含指定数据源类型和位置状态的行
+    bool mayContain(const std::optional<DataSourceType>& sourceType, const std::optional<LocationStatus>& status) const;
+
+    // 获取文件大小
+    uint64_t getFileSize() const { return fileSize; }
+
+    // 获取已读取的字节数
+    uint64_t getBytesRead() const { return bytesRead; }
+
+    // 检查段文件是否正常关闭
+    bool isComplete() const { return complete; }
+
+    // 获取文件路径
+    const std::string& getPath() const { return path; }
+};
+
+// 将文件内容刷到磁盘（重命名发布或删除旧文件之前调用）
+bool syncFile(const std::string& filePath);
+
+// 将目录项（新建、重命名、删除的文件名）刷到磁盘
+bool syncDirectory(const std::string& directoryPath);
+
+#endif // SEGMENT_FILE_H
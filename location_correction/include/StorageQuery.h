@@ -0,0 +1,197 @@
+// StorageQuery.h - 存储查询条件、并行查询执行器与流式游标
+
+#ifndef STORAGE_QUERY_H
+#define STORAGE_QUERY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LocationCodec.h"
+
+// 查询条件
+struct QueryPredicate {
+    long long startTime;                       // 起始时间（含，毫秒）
+    long long endTime;                         // 结束时间（含，毫秒）
+    std::optional<DataSourceType> sourceType;  // 数据源类型
+    std::optional<LocationStatus> status;      // 位置状态
+    std::optional<double> maxAccuracy;         // 最大精度值（米，越小越精确）
+    std::string deviceId;                      // 设备ID（空表示不限）
+    size_t limit;                              // 最多返回条数（0表示不限）
+    bool latestFirst;                          // 是否按时间倒序返回（配合limit即"最新N条"）
+
+    QueryPredicate() :
+        startTime(std::numeric_limits<long long>::min()),
+        endTime(std::numeric_limits<long long>::max()),
+        limit(0),
+        latestFirst(false) {}
+
+    // 检查位置数据是否满足条件
+    bool matches(const LocationInfo& location) const;
+
+    // 检查列式批次中的一行是否满足条件（不检查设备ID）
+    bool matchesRow(const LocationColumns& columns, size_t row) const;
+
+    // 检查时间范围是否可能包含满足条件的数据
+    bool overlaps(long long minTimestamp, long long maxTimestamp) const {
+        return maxTimestamp >= startTime && minTimestamp <= endTime;
+    }
+};
+
+// 查询统计
+struct QueryStats {
+    size_t segmentsTotal;    // 参与查询的文件数
+    size_t segmentsPruned;   // 根据索引跳过的文件数
+    size_t segmentsScanned;  // 实际扫描的文件数
+    size_t blocksPruned;     // 根据块索引跳过的块数
+    size_t blocksScanned;    // 实际解码的块数
+    uint64_t rowsScanned;    // 检查过的行数
+    uint64_t rowsMatched;    // 满足条件的行数
+    uint64_t bytesRead;      // 读取的字节数
+    long long elapsedMs;     // 查询耗时（毫秒）
+
+    QueryStats() :
+        segmentsTotal(0),
+        segmentsPruned(0),
+        segmentsScanned(0),
+        blocksPruned(0),
+        blocksScanned(0),
+        rowsScanned(0),
+        rowsMatched(0),
+        bytesRead(0),
+        elapsedMs(0) {}
+};
+
+// 并行查询执行器
+// 每个文件作为一个任务分发到线程池，各任务结果按时间排序后做k路归并；
+// 带limit的查询会根据已找到的第N条数据动态收紧时间下界（或上界），跳过无法入选的文件和块
+class QueryExecutor {
+public:
+    // CSV日志行解析函数，解析失败返回false
+    using LineParser = std::function<bool(const std::string&, LocationInfo&)>;
+
+private:
+    std::vector<std::thread> workers;             // 工作线程
+    std::deque<std::function<void()>> tasks;      // 待执行任务
+    std::mutex taskMutex;                         // 任务队列互斥锁
+    std::condition_variable taskAvailable;        // 有新任务
+    bool stopping;                                // 是否正在停止
+    LineParser lineParser;                        // CSV日志行解析函数
+
+    // 工作线程主循环
+    void workerLoop();
+
+    // 提交任务
+    void submit(std::function<void()> task);
+
+public:
+    explicit QueryExecutor(size_t threadCount = 0);
+    ~QueryExecutor();
+
+    QueryExecutor(const QueryExecutor&) = delete;
+    QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+    // 设置CSV日志行解析函数（未设置时跳过CSV日志文件）
+    void setLineParser(const LineParser& parser) { lineParser = parser; }
+
+    // 在一组段文件（.lcs）和日志文件（.log）上执行查询，memoryRows为尚未落盘的数据
+    std::vector<LocationInfo> execute(const std::vector<std::string>& files, const QueryPredicate& predicate,
+                                      QueryStats* stats = nullptr, const LocationColumns* memoryRows = nullptr);
+
+    // 获取工作线程数
+    size_t getThreadCount() const { return workers.size(); }
+};
+
+class SegmentReader;
+
+// 流式查询游标
+// 按需逐个打开文件、逐块解码，每次返回不超过batchSize行的列式批次，内存占用与结果总量无关。
+// 数据按来源的时间顺序返回（latestFirst时倒序），来源之间时间范围重叠时不保证全局有序，
+// 需要严格排序的结果请使用QueryExecutor
+class LocationCursor {
+private:
+    // 数据来源
+    struct Source {
+        std::string path;                          // 文件路径（内存数据为空）
+        bool segment;                              // 是否为压缩段文件
+        std::shared_ptr<const LocationColumns> rows; // 内存数据
+        long long minTimestamp;                    // 最小时间戳（CSV日志未知）
+        long long maxTimestamp;                    // 最大时间戳（CSV日志未知）
+    };
+
+    std::vector<std::string> files;                // 待查询的文件
+    QueryPredicate predicate;                      // 查询条件
+    uint32_t columnMask;                           // 返回的列
+    uint32_t decodeMask;                           // 需要解码的列（返回的列和过滤条件用到的列）
+    uint32_t bitmapDecodeMask;                     // 块有行位图时需要解码的列（不含只用于过滤的数据源类型和状态列）
+    QueryPredicate rowPredicate;                   // 块有行位图时逐行判断的条件（不含数据源类型和状态）
+    size_t batchSize;                              // 每批最多返回的行数
+    QueryExecutor::LineParser lineParser;          // CSV日志行解析函数
+    std::vector<Source> sources;                   // 查询计划中的数据来源
+    bool planned;                                  // 是否已生成查询计划
+    size_t sourceIndex;                            // 当前来源下标
+    bool sourceOpen;                               // 当前来源是否已打开
+    std::unique_ptr<SegmentReader> reader;         // 当前段文件读取器
+    std::vector<size_t> blockOrder;                // 当前段文件待访问的块
+    size_t blockIndex;                             // 下一个待访问的块在blockOrder中的下标
+    std::unique_ptr<std::ifstream> logStream;      // 当前CSV日志文件
+    LocationColumns current;                       // 当前已解码的数据
+    const LocationColumns* currentRows;            // 当前正在扫描的数据（解码块或内存数据）
+    size_t rowIndex;                               // 当前数据中已扫描的行数
+    bool reverseRows;                              // 是否倒序扫描当前数据
+    std::vector<uint64_t> rowSelection;            // 当前块中数据源类型和状态满足条件的行位图
+    bool selectionActive;                          // 当前数据是否按行位图筛选
+    uint32_t deviceCode;                           // 当前数据中设备ID的字典下标
+    bool deviceFound;                              // 当前数据中是否包含查询的设备
+    std::vector<uint32_t> deviceRemap;             // 当前数据到输出批次的设备字典下标映射
+    std::vector<uint32_t> extrasRemap;             // 当前数据到输出批次的额外信息字典下标映射
+    size_t returned;                               // 已返回的行数
+    QueryStats stats;                              // 查询统计
+
+    // 根据段文件索引生成查询计划
+    void plan();
+
+    // 加载下一批待扫描数据，没有更多数据时返回false
+    bool loadNext();
+
+    // 切换到当前数据（重置设备查找和字典映射）
+    void resetRows(const LocationColumns* rows, bool reverse);
+
+    // 将当前数据中的一行按投影复制到输出批次
+    void copyRow(size_t row, LocationColumns& batch);
+
+    // 关闭当前来源
+    void closeSource();
+
+public:
+    // columnMask为需要返回的列（时间戳始终返回，未选中的列填充默认值）
+    LocationCursor(const std::vector<std::string>& queryFiles, const QueryPredicate& queryPredicate,
+                   uint32_t queryColumnMask = ALL_CODEC_COLUMNS, size_t queryBatchSize = 4096);
+    ~LocationCursor();
+
+    LocationCursor(const LocationCursor&) = delete;
+    LocationCursor& operator=(const LocationCursor&) = delete;
+
+    // 设置CSV日志行解析函数（未设置时跳过CSV日志文件，需在首次读取前设置）
+    void setLineParser(const QueryExecutor::LineParser& parser) { lineParser = parser; }
+
+    // 添加内存中的数据作为查询来源（需在首次读取前设置）
+    void addMemoryRows(std::shared_ptr<const LocationColumns> rows);
+
+    // 读取下一批满足条件的数据到batch（先清空batch），没有更多数据时返回false
+    bool next(LocationColumns& batch);
+
+    // 获取查询统计
+    const QueryStats& getStats() const { return stats; }
+};
+
+#endif // STORAGE_QUERY_H
@@ -0,0 +1,117 @@
+// StorageTee.h - 多存储后端异步分发
+
+#ifndef STORAGE_TEE_H
+#define STORAGE_TEE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LocationModel.h"
+
+class DataStorage;
+
+// 后端队列满时的处理策略
+enum class TeeOverflowPolicy {
+    DROP_OLDEST, // 丢弃该后端最早未写入的数据，不影响生产者和其他后端
+    BLOCK        // 生产者等待该后端写入（用于不允许丢数据的后端）
+};
+
+// 单个后端的分发配置
+struct TeeBackendConfig {
+    size_t batchSize;              // 每批最多写入的数据条数
+    long long maxBatchDelayMs;     // 凑批的最长等待时间（毫秒）
+    TeeOverflowPolicy policy;      // 队列满时的处理策略
+
+    TeeBackendConfig() :
+        batchSize(256),
+        maxBatchDelayMs(20),
+        policy(TeeOverflowPolicy::DROP_OLDEST) {}
+};
+
+// 单个后端的分发统计
+struct TeeBackendStats {
+    uint64_t written;  // 成功写入的数据条数
+    uint64_t dropped;  // 因队列满丢弃的数据条数
+    uint64_t failed;   // 写入失败的数据条数
+    uint64_t batches;  // 写入批次数
+    uint64_t pending;  // 当前积压的数据条数
+
+    TeeBackendStats() :
+        written(0),
+        dropped(0),
+        failed(0),
+        batches(0),
+        pending(0) {}
+};
+
+// 多存储后端异步分发器
+// 所有后端共享一个有界环形缓冲区，每个后端持有自己的读位置和写入线程：
+// 生产者每条数据只入队一次，慢后端只会积压或丢弃自己的数据
+class StorageTee {
+private:
+    // 单个后端的状态
+    struct Backend {
+        std::string name;                       // 后端名称
+        std::shared_ptr<DataStorage> storage;   // 存储实现
+        TeeBackendConfig config;                // 分发配置
+        uint64_t cursor;                        // 下一条待读取数据的序号
+        size_t inFlight;                        // 已取出但尚未写完的数据条数
+        bool stopping;                          // 是否正在停止
+        TeeBackendStats stats;                  // 统计
+        std::thread worker;                     // 写入线程
+    };
+
+    std::vector<LocationInfo> ring;             // 环形缓冲区
+    uint64_t head;                              // 下一条写入数据的序号
+    std::map<std::string, std::unique_ptr<Backend>> backends; // 后端列表
+    mutable std::mutex mutex;                   // 互斥锁（保护缓冲区和后端状态）
+    std::condition_variable dataAvailable;      // 有新数据
+    std::condition_variable spaceAvailable;     // 有空闲位置（用于BLOCK策略）
+    std::atomic<bool> running;                  // 是否运行
+
+    // 后端写入线程主循环
+    void workerLoop(Backend* backend);
+
+    // 为新数据腾出位置，返回false表示已停止（调用方需持有锁）
+    bool reserveSlot(std::unique_lock<std::mutex>& lock);
+
+public:
+    explicit StorageTee(size_t capacity = 8192);
+    ~StorageTee();
+
+    StorageTee(const StorageTee&) = delete;
+    StorageTee& operator=(const StorageTee&) = delete;
+
+    // 添加后端，从当前位置开始接收数据
+    bool addBackend(const std::string& name, std::shared_ptr<DataStorage> storage,
+                    const TeeBackendConfig& config = TeeBackendConfig());
+
+    // 移除后端，等待其写完已入队的数据
+    bool removeBackend(const std::string& name);
+
+    // 分发一条位置数据（只入队一次）
+    bool publish(const LocationInfo& location);
+
+    // 分发一批位置数据
+    bool publish(const std::vector<LocationInfo>& locations);
+
+    // 等待所有后端写完已入队的数据
+    void flush();
+
+    // 停止所有后端（先写完已入队的数据）
+    void shutdown();
+
+    // 获取指定后端的统计
+    bool getStats(const std::string& name, TeeBackendStats& stats) const;
+
+    // 获取缓冲区容量
+    size_t getCapacity() const { return ring.size(); }
+};
+
+#endif // STORAGE_TEE_H
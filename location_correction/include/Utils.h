@@ -3,8 +3,11 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <string>
+#include <thread>
 #include <vector>
 #include <functional>
 #include <chrono>
@@ -74,7 +77,8 @@ namespace utils {
         dest.timestamp = src.timestamp;
         dest.speed = src.speed;
         dest.direction = src.direction;
-        dest.source = src.source;
+        dest.sourceType = src.sourceType;
+        dest.status = src.status;
         dest.sourceId = src.sourceId;
         return dest;
     }
@@ -144,6 +148,31 @@ namespace utils {
         std::string formatTimestamp(long long timestamp, const std::string& format = "%Y-%m-%d %H:%M:%S");
     }
 
+    // 并发工具函数
+    namespace concurrent {
+        // 用threadCount个线程（含调用线程）并行执行task(0)到task(count - 1)，全部完成后返回
+        // 任务按下标动态领取，各任务耗时不均时也能分配均匀；task会在多个线程中并发调用
+        template<typename Task>
+        void parallelFor(size_t count, size_t threadCount, Task&& task) {
+            std::atomic<size_t> next(0);
+            auto worker = [&]() {
+                for (size_t i = next++; i < count; i = next++) {
+                    task(i);
+                }
+            };
+
+            size_t workerCount = std::min(threadCount, count);
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < workerCount; ++i) {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : workers) {
+                thread.join();
+            }
+        }
+    }
+
     // 数学工具函数
     namespace math {
         // 限制值在指定范围内
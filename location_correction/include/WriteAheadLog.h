@@ -0,0 +1,122 @@
+// WriteAheadLog.h - 预写日志与检查点
+
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "LocationCodec.h"
+
+// 预写日志文件扩展名
+extern const char* const WAL_FILE_EXTENSION;
+
+// 预写日志的落盘方式
+enum class WalSyncMode {
+    NONE,  // 只写入用户态缓冲区
+    FLUSH, // 每条记录刷新到操作系统（进程崩溃不丢数据）
+    FSYNC  // 每条记录同步到磁盘（掉电不丢数据）
+};
+
+// 检查点信息
+struct WalCheckpoint {
+    uint64_t lsn;     // 检查点位置，此前的记录都已持久化到其他位置
+    std::string meta; // 使用方自定义的恢复信息（如快照文件名）
+
+    WalCheckpoint() : lsn(0) {}
+};
+
+// 预写日志
+// 记录格式：[长度 u32][CRC32C u32][类型 u8][载荷]，长度和校验覆盖类型与载荷
+// 日志序号（LSN）为记录在整个日志流中的字节偏移，日志文件以起始LSN命名
+class WriteAheadLog {
+private:
+    std::string directory;         // 日志目录
+    std::FILE* file;               // 当前日志文件
+    uint64_t fileStartLsn;         // 当前文件的起始LSN
+    uint64_t endLsn;               // 下一条记录的LSN
+    size_t maxFileSize;            // 单个日志文件的最大大小
+    WalSyncMode syncMode;          // 落盘方式
+    std::vector<uint8_t> buffer;   // 编码缓冲区（复用）
+
+    // 打开日志文件（truncate为true时清空同名文件，否则在末尾追加）
+    bool openFile(uint64_t startLsn, bool truncate = false);
+
+    // 写入失败后丢弃当前文件末尾残留的半条记录
+    bool discardTornTail();
+
+    // 校验日志文件，返回最后一条完整记录的结束偏移
+    uint64_t scanValidLength(const std::string& path) const;
+
+    // 写入一条记录
+    uint64_t appendRecord(uint8_t type, const std::vector<uint8_t>& payload);
+
+public:
+    // 记录类型
+    static constexpr uint8_t RECORD_LOCATIONS = 1;
+
+    WriteAheadLog();
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // 打开日志目录并读取检查点（可为nullptr），截断末尾不完整的记录
+    bool open(const std::string& directoryPath, WalCheckpoint* checkpoint = nullptr);
+
+    // 关闭日志
+    void close();
+
+    // 检查是否已打开
+    bool isOpen() const { return file != nullptr; }
+
+    // 追加一批位置数据，返回记录结束后的LSN（失败返回0）
+    uint64_t append(const LocationColumns& rows);
+
+    // 将缓冲区数据同步到磁盘
+    bool sync();
+
+    // 从指定LSN开始重放位置数据记录，遇到损坏的记录时停止
+    bool replay(uint64_t fromLsn, const std::function<void(uint64_t, const LocationColumns&)>& visitor) const;
+
+    // 删除完全位于指定LSN之前的日志文件
+    void truncateBefore(uint64_t lsn);
+
+    // 删除所有日志文件，从当前LSN开始新的日志
+    bool reset();
+
+    // 写入检查点（先写临时文件再重命名，保证原子性）
+    bool writeCheckpoint(const WalCheckpoint& checkpoint);
+
+    // 读取检查点，没有有效检查点时返回false
+    bool readCheckpoint(WalCheckpoint& checkpoint) const;
+
+    // 设置落盘方式
+    void setSyncMode(WalSyncMode mode) { syncMode = mode; }
+
+    // 设置单个日志文件的最大大小
+    void setMaxFileSize(size_t size) { maxFileSize = size; }
+
+    // 获取下一条记录的LSN
+    uint64_t getEndLsn() const { return endLsn; }
+
+    // 获取日志目录
+    const std::string& getDirectory() const { return directory; }
+
+    // 计算CRC32C校验值
+    static uint32_t crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+    // 获取日志目录中指定起始LSN的日志文件名
+    static std::string fileNameFor(const std::string& directory, uint64_t startLsn);
+
+    // 获取日志目录下所有日志文件的起始LSN（升序）
+    static std::vector<uint64_t> listFiles(const std::string& directory);
+
+    // 校验并解析内存中的一条记录，返回记录总长度（数据不完整或校验失败时返回0）
+    static size_t parseRecord(const uint8_t* data, size_t available, uint8_t& type,
+                              const uint8_t*& payload, size_t& payloadSize);
+};
+
+#endif // WRITE_AHEAD_LOG_H
@@ -1,6 +1,7 @@
 // AnomalyDetector.cpp - 异常点检测算法实现
 
 #include "AnomalyDetector.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <algorithm>
@@ -67,6 +68,8 @@ AnomalyResult AnomalyDetector::detectAnomaly(const LocationInfo& location, const
         
         // 记录检测结果
         if (result.isAnomaly) {
+            FlightRecorder::getInstance().record(FlightEventType::ANOMALY_DETECTED, location,
+                                                 static_cast<float>(result.confidence));
             LOG_DEBUG("Anomaly detected: %s, confidence: %.2f", 
                      location.toString().c_str(), result.confidence);
         } else {
@@ -1,6 +1,7 @@
 // DataFusion.cpp - 多源数据融合算法实现
 
 #include "DataFusion.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <algorithm>
@@ -93,6 +94,8 @@ std::shared_ptr<LocationInfo> DataFusion::fuse(const std::vector<LocationInfo>&
             fusedLocation->sourceType = DataSourceType::FUSED;
             fusedLocation->setExtra("fusionStrategy", fusionStrategyToString(fusionStrategy));
             fusedLocation->setExtra("sourceCount", sizeToString(validLocations.size()));
+            FlightRecorder::getInstance().record(FlightEventType::FUSED, *fusedLocation,
+                                                 static_cast<float>(validLocations.size()));
             
             LOG_DEBUG("Successfully fused %zu location sources", validLocations.size());
         }
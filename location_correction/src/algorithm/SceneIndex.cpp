@@ -0,0 +1,291 @@
+// SceneIndex.cpp - 场景区域空间索引实现
+
+#include "SceneIndex.h"
+#include "Logger.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 每度纬度对应的距离（米）
+const double METERS_PER_DEGREE = utils::EARTH_RADIUS * M_PI / 180.0;
+
+// 格子边长范围（度），约110米到110公里
+const double MIN_CELL_SIZE = 0.001;
+const double MAX_CELL_SIZE = 1.0;
+
+// 纬度所在的行
+int64_t rowOf(double latitude, double cellSize) {
+    latitude = std::max(-90.0, std::min(90.0, latitude));
+    return static_cast<int64_t>(std::floor((latitude + 90.0) / cellSize));
+}
+
+// 经度所在的列（不取模，可能超出[0, columns)）
+int64_t rawColumnOf(double longitude, double cellSize) {
+    return static_cast<int64_t>(std::floor((longitude + 180.0) / cellSize));
+}
+
+// 列号取模到[0, columns)，跨越180度经线的区域登记到两侧的格子
+int64_t wrapColumn(int64_t column, int64_t columns) {
+    column %= columns;
+    return column < 0 ? column + columns : column;
+}
+
+} // namespace
+
+// SceneIndex构造函数
+SceneIndex::SceneIndex() :
+    cellSize(MAX_CELL_SIZE),
+    columns(static_cast<int64_t>(360.0 / MAX_CELL_SIZE)) {
+}
+
+// 区域外接矩形覆盖的格子范围
+bool SceneIndex::cellRange(const SceneRegion& region, int64_t& rowMin, int64_t& rowMax,
+                           int64_t& colMin, int64_t& colMax) const {
+    double deltaLatitude = region.radius / METERS_PER_DEGREE;
+    double latitudeMin = region.latitude - deltaLatitude;
+    double latitudeMax = region.latitude + deltaLatitude;
+    if (latitudeMin < -90.0 || latitudeMax > 90.0) {
+        return false;
+    }
+
+    // 按离赤道最远处的纬度换算经度跨度，保证外接矩形覆盖整个圆
+    double cosLatitude = std::cos(utils::degToRad(std::max(std::fabs(latitudeMin), std::fabs(latitudeMax))));
+    if (cosLatitude <= 1e-6) {
+        return false;
+    }
+    double deltaLongitude = deltaLatitude / cosLatitude;
+    if (deltaLongitude >= 180.0) {
+        return false;
+    }
+
+    rowMin = rowOf(latitudeMin, cellSize);
+    rowMax = rowOf(latitudeMax, cellSize);
+    colMin = rawColumnOf(region.longitude - deltaLongitude, cellSize);
+    colMax = rawColumnOf(region.longitude + deltaLongitude, cellSize);
+    return static_cast<size_t>((rowMax - rowMin + 1) * (colMax - colMin + 1)) <= MAX_CELLS_PER_REGION;
+}
+
+// 由区域列表建立索引
+void SceneIndex::buildRegions(std::vector<SceneRegion> regionList) {
+    regions = std::move(regionList);
+    // 按半径排序后，编号较小的区域更具体，查询时第一个包含位置的区域即为最小区域
+    std::stable_sort(regions.begin(), regions.end(), [](const SceneRegion& a, const SceneRegion& b) {
+        return a.radius < b.radius;
+    });
+    cells.clear();
+    largeRegions.clear();
+    exclusive.assign(regions.size(), 1);
+    if (regions.empty()) {
+        return;
+    }
+
+    // 格子边长取半径中位数对应的直径，多数区域只登记到少量格子
+    double medianRadius = regions[regions.size() / 2].radius;
+    // 边长取整除360度的值，经度取模后格子边界首尾相接
+    double size = std::max(MIN_CELL_SIZE, std::min(MAX_CELL_SIZE, 2.0 * medianRadius / METERS_PER_DEGREE));
+    columns = static_cast<int64_t>(std::ceil(360.0 / size));
+    cellSize = 360.0 / static_cast<double>(columns);
+
+    for (size_t i = 0; i < regions.size(); ++i) {
+        int64_t rowMin = 0, rowMax = 0, colMin = 0, colMax = 0;
+        if (!cellRange(regions[i], rowMin, rowMax, colMin, colMax)) {
+            largeRegions.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+        for (int64_t row = rowMin; row <= rowMax; ++row) {
+            for (int64_t col = colMin; col <= colMax; ++col) {
+                cells[row * columns + wrapColumn(col, columns)].push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    // 标记与其他区域都不相交的区域（候选为同一格子中的区域和所有大区域）
+    std::vector<uint32_t> candidates;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        candidates.clear();
+        int64_t rowMin = 0, rowMax = 0, colMin = 0, colMax = 0;
+        if (cellRange(regions[i], rowMin, rowMax, colMin, colMax)) {
+            for (int64_t row = rowMin; row <= rowMax; ++row) {
+                for (int64_t col = colMin; col <= colMax; ++col) {
+                    const std::vector<uint32_t>* list = cellRegions(row * columns + wrapColumn(col, columns));
+                    candidates.insert(candidates.end(), list->begin(), list->end());
+                }
+            }
+            candidates.insert(candidates.end(), largeRegions.begin(), largeRegions.end());
+        } else {
+            for (size_t j = 0; j < regions.size(); ++j) {
+                candidates.push_back(static_cast<uint32_t>(j));
+            }
+        }
+        for (uint32_t j : candidates) {
+            if (j != i &&
+                utils::calculateDistance(regions[i].latitude, regions[i].longitude, regions[j].latitude,
+                                         regions[j].longitude) < regions[i].radius + regions[j].radius) {
+                exclusive[i] = 0;
+                break;
+            }
+        }
+    }
+
+    LOG_INFO("Scene index built: %zu regions, cell size %.4f degrees, %zu cells, %zu large regions",
+             regions.size(), cellSize, cells.size(), largeRegions.size());
+}
+
+// 获取格子中登记的区域编号
+const std::vector<uint32_t>* SceneIndex::cellRegions(int64_t cell) const {
+    auto it = cells.find(cell);
+    return it != cells.end() ? &it->second : nullptr;
+}
+
+// 查找包含该位置的最小区域
+int64_t SceneIndex::findRegion(double latitude, double longitude) const {
+    int64_t best = -1;
+    const std::vector<uint32_t>* list =
+        cellRegions(rowOf(latitude, cellSize) * columns + wrapColumn(rawColumnOf(longitude, cellSize), columns));
+    if (list) {
+        for (uint32_t region : *list) {
+            if (contains(region, latitude, longitude)) {
+                best = region;
+                break;
+            }
+        }
+    }
+    for (uint32_t region : largeRegions) {
+        if (best >= 0 && static_cast<int64_t>(region) > best) {
+            break;
+        }
+        if (contains(region, latitude, longitude)) {
+            best = region;
+            break;
+        }
+    }
+    return best;
+}
+
+// 查询包含该位置的所有区域的场景下标
+void SceneIndex::query(double latitude, double longitude, std::vector<size_t>& scenes) const {
+    std::vector<uint32_t> found;
+    const std::vector<uint32_t>* list =
+        cellRegions(rowOf(latitude, cellSize) * columns + wrapColumn(rawColumnOf(longitude, cellSize), columns));
+    if (list) {
+        for (uint32_t region : *list) {
+            if (contains(region, latitude, longitude)) {
+                found.push_back(region);
+            }
+        }
+    }
+    for (uint32_t region : largeRegions) {
+        if (contains(region, latitude, longitude)) {
+            found.push_back(region);
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    scenes.clear();
+    for (uint32_t region : found) {
+        scenes.push_back(regions[region].scene);
+    }
+}
+
+// 位置是否在区域内
+bool SceneIndex::contains(size_t region, double latitude, double longitude) const {
+    const SceneRegion& r = regions[region];
+    return utils::calculateDistance(latitude, longitude, r.latitude, r.longitude) <= r.radius;
+}
+
+// SceneLocator构造函数
+SceneLocator::SceneLocator(size_t shardCount) {
+    shardCount = std::max<size_t>(1, shardCount);
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+// 获取设备所在的分片
+SceneLocator::Shard& SceneLocator::shardFor(const std::string& deviceId) const {
+    return *shards[std::hash<std::string>{}(deviceId) % shards.size()];
+}
+
+// 替换索引
+void SceneLocator::setIndex(std::shared_ptr<const SceneIndex> index) {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index = index;
+        shard->devices.clear();
+    }
+}
+
+// 定位设备所在的最小区域
+int64_t SceneLocator::locate(const std::string& deviceId, double latitude, double longitude) {
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.index) {
+        return -1;
+    }
+    return locateLocked(shard, *shard.index, deviceId, latitude, longitude);
+}
+
+// 在指定索引中定位设备
+int64_t SceneLocator::locate(const std::shared_ptr<const SceneIndex>& index, const std::string& deviceId,
+                             double latitude, double longitude) {
+    if (!index) {
+        return -1;
+    }
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.index != index) {
+        shard.index = index;
+        shard.devices.clear();
+    }
+    return locateLocked(shard, *index, deviceId, latitude, longitude);
+}
+
+// 在索引中定位设备（调用方持有分片锁）
+int64_t SceneLocator::locateLocked(Shard& shard, const SceneIndex& index, const std::string& deviceId,
+                                   double latitude, double longitude) {
+    // 缓存的区域与其他区域都不相交，设备仍在其中时它就是所在的最小区域
+    auto it = shard.devices.find(deviceId);
+    if (it != shard.devices.end() && index.contains(it->second, latitude, longitude)) {
+        ++shard.hits;
+        return static_cast<int64_t>(index.getRegion(it->second).scene);
+    }
+
+    ++shard.misses;
+    int64_t region = index.findRegion(latitude, longitude);
+    if (region >= 0 && index.isExclusive(static_cast<size_t>(region))) {
+        shard.devices[deviceId] = static_cast<size_t>(region);
+    } else if (it != shard.devices.end()) {
+        shard.devices.erase(it);
+    }
+    return region >= 0 ? static_cast<int64_t>(index.getRegion(static_cast<size_t>(region)).scene) : -1;
+}
+
+// 删除设备的缓存
+void SceneLocator::forget(const std::string& deviceId) {
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.devices.erase(deviceId);
+}
+
+// 获取缓存命中次数
+uint64_t SceneLocator::getHitCount() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->hits;
+    }
+    return total;
+}
+
+// 获取查询索引次数
+uint64_t SceneLocator::getMissCount() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->misses;
+    }
+    return total;
+}
@@ -0,0 +1,748 @@
+// ArrowExporter.cpp - 位置历史数据导出为Arrow IPC文件实现
+
+#include "ArrowExporter.h"
+#include "SegmentFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// Arrow IPC文件扩展名
+const char* const ARROW_FILE_EXTENSION = ".arrow";
+
+namespace {
+
+// Arrow文件魔数
+const char ARROW_MAGIC[] = "ARROW1";
+
+// IPC消息的续接标记
+const uint32_t CONTINUATION_MARKER = 0xFFFFFFFFu;
+
+// 元数据版本（V5）
+const uint16_t METADATA_VERSION_V5 = 4;
+
+// MessageHeader联合体类型
+const uint8_t MESSAGE_HEADER_SCHEMA = 1;
+const uint8_t MESSAGE_HEADER_RECORD_BATCH = 3;
+
+// Type联合体类型
+const uint8_t TYPE_INT = 2;
+const uint8_t TYPE_FLOATING_POINT = 3;
+const uint8_t TYPE_UTF8 = 5;
+const uint8_t TYPE_TIMESTAMP = 10;
+
+// 导出列的类型
+enum class ArrowColumnKind {
+    TIMESTAMP_MS, // 毫秒时间戳（int64）
+    UTF8,         // 字符串（int32偏移量 + 数据）
+    FLOAT64,      // 双精度浮点
+    UINT8         // 无符号8位整数
+};
+
+// 导出列定义
+struct ArrowColumn {
+    const char* name;     // 列名
+    ArrowColumnKind kind; // 类型
+};
+
+// 导出列（顺序与记录批次中的缓冲区顺序一致）
+const ArrowColumn EXPORT_COLUMNS[] = {
+    {"timestamp", ArrowColumnKind::TIMESTAMP_MS},
+    {"device_id", ArrowColumnKind::UTF8},
+    {"latitude", ArrowColumnKind::FLOAT64},
+    {"longitude", ArrowColumnKind::FLOAT64},
+    {"altitude", ArrowColumnKind::FLOAT64},
+    {"accuracy", ArrowColumnKind::FLOAT64},
+    {"speed", ArrowColumnKind::FLOAT64},
+    {"direction", ArrowColumnKind::FLOAT64},
+    {"source_type", ArrowColumnKind::UINT8},
+    {"status", ArrowColumnKind::UINT8}
+};
+
+const size_t EXPORT_COLUMN_COUNT = sizeof(EXPORT_COLUMNS) / sizeof(EXPORT_COLUMNS[0]);
+
+// 浮点列在LocationColumns中的成员（顺序与EXPORT_COLUMNS中的浮点列一致，整数列依次为source_type、status）
+std::vector<double> LocationColumns::* const DOUBLE_COLUMNS[] = {
+    &LocationColumns::latitudes,
+    &LocationColumns::longitudes,
+    &LocationColumns::altitudes,
+    &LocationColumns::accuracies,
+    &LocationColumns::speeds,
+    &LocationColumns::directions
+};
+
+const size_t DOUBLE_COLUMN_COUNT = sizeof(DOUBLE_COLUMNS) / sizeof(DOUBLE_COLUMNS[0]);
+
+// 向上对齐
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// FlatBuffers写入器
+// 按"父对象在前、子对象在后"的顺序从前向后写入，偏移量字段先占位再回填
+// （FlatBuffers的uoffset只能指向更高的地址），写出的缓冲区可通过标准校验
+class FlatBufferWriter {
+public:
+    // 表字段：偏移量类型的字段value填0，写入子对象后再回填
+    struct Field {
+        uint16_t id;    // 字段编号
+        uint8_t size;   // 字节数
+        uint64_t value; // 标量值
+    };
+
+    std::vector<uint8_t> data; // 已写入的数据
+
+    FlatBufferWriter() {
+        put<uint32_t>(0); // 根表偏移量
+    }
+
+    // 填充到指定对齐
+    void align(size_t alignment) {
+        data.resize(alignUp(data.size(), alignment), 0);
+    }
+
+    // 追加标量（小端）
+    template <typename T>
+    void put(T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    // 回填偏移量字段，使其指向target
+    void link(size_t field, size_t target) {
+        uint32_t offset = static_cast<uint32_t>(target - field);
+        std::memcpy(&data[field], &offset, sizeof(offset));
+    }
+
+    // 设置根表
+    void setRoot(size_t table) {
+        link(0, table);
+    }
+
+    // 写入表，返回表的位置，positions返回各字段的绝对位置
+    size_t table(const std::vector<Field>& fields, std::vector<size_t>* positions = nullptr) {
+        uint16_t slotCount = 0;
+        for (const auto& field : fields) {
+            slotCount = std::max<uint16_t>(slotCount, field.id + 1);
+        }
+
+        // 大字段在前，保证每个字段按自身大小对齐
+        std::vector<size_t> order(fields.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return fields[a].size > fields[b].size;
+        });
+
+        std::vector<uint16_t> fieldOffsets(fields.size());
+        size_t tableSize = 4; // 指向vtable的soffset
+        for (size_t index : order) {
+            tableSize = alignUp(tableSize, fields[index].size);
+            fieldOffsets[index] = static_cast<uint16_t>(tableSize);
+            tableSize += fields[index].size;
+        }
+
+        std::vector<uint16_t> slots(slotCount, 0);
+        for (size_t i = 0; i < fields.size(); ++i) {
+            slots[fields[i].id] = fieldOffsets[i];
+        }
+
+        align(2);
+        size_t vtable = data.size();
+        put<uint16_t>(static_cast<uint16_t>(4 + 2 * slotCount));
+        put<uint16_t>(static_cast<uint16_t>(tableSize));
+        for (uint16_t slot : slots) {
+            put<uint16_t>(slot);
+        }
+
+        align(8);
+        size_t table = data.size();
+        put<int32_t>(static_cast<int32_t>(table - vtable));
+        data.resize(table + tableSize, 0);
+        if (positions) {
+            positions->resize(fields.size());
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            std::memcpy(&data[table + fieldOffsets[i]], &fields[i].value, fields[i].size);
+            if (positions) {
+                (*positions)[i] = table + fieldOffsets[i];
+            }
+        }
+        return table;
+    }
+
+    // 写入字符串
+    size_t string(const std::string& value) {
+        align(4);
+        size_t position = data.size();
+        put<uint32_t>(static_cast<uint32_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+        data.push_back(0);
+        return position;
+    }
+
+    // 写入结构体数组（元素按8字节对齐）
+    size_t structVector(const std::vector<uint8_t>& elements, size_t count) {
+        data.resize(alignUp(data.size() + 4, 8) - 4, 0);
+        size_t position = data.size();
+        put<uint32_t>(static_cast<uint32_t>(count));
+        data.insert(data.end(), elements.begin(), elements.end());
+        return position;
+    }
+
+    // 写入偏移量数组（元素待回填，第i个元素位于position + 4 + 4 * i）
+    size_t offsetVector(size_t count) {
+        align(4);
+        size_t position = data.size();
+        put<uint32_t>(static_cast<uint32_t>(count));
+        data.resize(data.size() + 4 * count, 0);
+        return position;
+    }
+};
+
+// 追加标量到结构体数组
+template <typename T>
+void appendStructField(std::vector<uint8_t>& out, T value) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// 写入列的类型表，返回表的位置
+size_t writeType(FlatBufferWriter& writer, ArrowColumnKind kind) {
+    switch (kind) {
+        case ArrowColumnKind::TIMESTAMP_MS: {
+            std::vector<size_t> positions;
+            size_t table = writer.table({{0, 2, 1}, {1, 4, 0}}, &positions); // unit=MILLISECOND, timezone
+            writer.link(positions[1], writer.string("UTC"));
+            return table;
+        }
+        case ArrowColumnKind::UTF8:
+            return writer.table({});
+        case ArrowColumnKind::FLOAT64:
+            return writer.table({{0, 2, 2}}); // precision=DOUBLE
+        case ArrowColumnKind::UINT8:
+        default:
+            return writer.table({{0, 4, 8}, {1, 1, 0}}); // bitWidth=8, is_signed=false
+    }
+}
+
+// 获取列类型对应的Type联合体类型
+uint8_t typeOf(ArrowColumnKind kind) {
+    switch (kind) {
+        case ArrowColumnKind::TIMESTAMP_MS:
+            return TYPE_TIMESTAMP;
+        case ArrowColumnKind::UTF8:
+            return TYPE_UTF8;
+        case ArrowColumnKind::FLOAT64:
+            return TYPE_FLOATING_POINT;
+        case ArrowColumnKind::UINT8:
+        default:
+            return TYPE_INT;
+    }
+}
+
+// 写入Schema表，返回表的位置
+size_t writeSchema(FlatBufferWriter& writer) {
+    std::vector<size_t> positions;
+    size_t schema = writer.table({{0, 2, 0}, {1, 4, 0}}, &positions); // endianness=Little, fields
+    size_t fields = writer.offsetVector(EXPORT_COLUMN_COUNT);
+    writer.link(positions[1], fields);
+
+    for (size_t i = 0; i < EXPORT_COLUMN_COUNT; ++i) {
+        const ArrowColumn& column = EXPORT_COLUMNS[i];
+        std::vector<size_t> fieldPositions;
+        // name, nullable=false, type_type, type, children
+        size_t field = writer.table({{0, 4, 0}, {1, 1, 0}, {2, 1, typeOf(column.kind)}, {3, 4, 0}, {5, 4, 0}},
+                                    &fieldPositions);
+        writer.link(fields + 4 + 4 * i, field);
+        writer.link(fieldPositions[0], writer.string(column.name));
+        writer.link(fieldPositions[3], writeType(writer, column.kind));
+        writer.link(fieldPositions[4], writer.offsetVector(0));
+    }
+    return schema;
+}
+
+// 将消息元数据封装为IPC消息帧（续接标记 + 元数据长度 + 8字节对齐的元数据），返回帧头和元数据的总长度
+size_t frameMessage(const std::vector<uint8_t>& metadata, std::vector<uint8_t>& out) {
+    size_t paddedSize = alignUp(metadata.size(), 8);
+    appendStructField<uint32_t>(out, CONTINUATION_MARKER);
+    appendStructField<int32_t>(out, static_cast<int32_t>(paddedSize));
+    out.insert(out.end(), metadata.begin(), metadata.end());
+    out.resize(out.size() + paddedSize - metadata.size(), 0);
+    return 8 + paddedSize;
+}
+
+// 一个记录批次的列数据
+struct ArrowBatch {
+    std::vector<long long> timestamps;                 // 时间戳
+    std::vector<int32_t> deviceOffsets;                // 设备ID偏移量
+    std::string deviceData;                            // 设备ID数据
+    std::vector<double> doubles[DOUBLE_COLUMN_COUNT];  // 浮点列
+    std::vector<uint8_t> sourceTypes;                  // 数据源类型
+    std::vector<uint8_t> statuses;                     // 位置状态
+
+    ArrowBatch() : deviceOffsets(1, 0) {}
+
+    size_t size() const { return timestamps.size(); }
+
+    void clear() {
+        timestamps.clear();
+        deviceOffsets.assign(1, 0);
+        deviceData.clear();
+        for (auto& column : doubles) {
+            column.clear();
+        }
+        sourceTypes.clear();
+        statuses.clear();
+    }
+
+    // 按列拷贝选中的行
+    void gather(const LocationColumns& columns, const uint32_t* rows, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            timestamps.push_back(columns.timestamps[rows[i]]);
+        }
+        for (size_t c = 0; c < DOUBLE_COLUMN_COUNT; ++c) {
+            const std::vector<double>& source = columns.*DOUBLE_COLUMNS[c];
+            for (size_t i = 0; i < count; ++i) {
+                doubles[c].push_back(source[rows[i]]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            sourceTypes.push_back(columns.sourceTypes[rows[i]]);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            statuses.push_back(columns.statuses[rows[i]]);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            deviceData += columns.deviceDictionary[columns.deviceIndexes[rows[i]]];
+            deviceOffsets.push_back(static_cast<int32_t>(deviceData.size()));
+        }
+    }
+};
+
+// 编码后的记录批次消息
+struct EncodedBatch {
+    std::vector<uint8_t> bytes;  // 完整的消息（帧头 + 元数据 + 消息体）
+    int32_t metadataLength;      // 帧头和元数据的长度
+    int64_t bodyLength;          // 消息体长度
+    size_t rowCount;             // 行数
+};
+
+// 将一个记录批次编码为IPC消息
+EncodedBatch encodeBatch(const ArrowBatch& batch) {
+    // 消息体：每列一个空的有效性缓冲区（没有空值）和数据缓冲区，各缓冲区按8字节对齐
+    std::vector<uint8_t> body;
+    std::vector<uint8_t> buffers;
+    size_t bufferCount = 0;
+    auto addBuffer = [&](const void* data, size_t size) {
+        appendStructField<int64_t>(buffers, static_cast<int64_t>(body.size()));
+        appendStructField<int64_t>(buffers, static_cast<int64_t>(size));
+        bufferCount++;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        body.insert(body.end(), bytes, bytes + size);
+        body.resize(alignUp(body.size(), 8), 0);
+    };
+
+    size_t rowCount = batch.size();
+    const std::vector<uint8_t>* byteColumns[] = {&batch.sourceTypes, &batch.statuses};
+    size_t doubleIndex = 0;
+    size_t byteIndex = 0;
+    for (size_t i = 0; i < EXPORT_COLUMN_COUNT; ++i) {
+        addBuffer(nullptr, 0);
+        switch (EXPORT_COLUMNS[i].kind) {
+            case ArrowColumnKind::TIMESTAMP_MS:
+                addBuffer(batch.timestamps.data(), rowCount * sizeof(long long));
+                break;
+            case ArrowColumnKind::UTF8:
+                addBuffer(batch.deviceOffsets.data(), batch.deviceOffsets.size() * sizeof(int32_t));
+                addBuffer(batch.deviceData.data(), batch.deviceData.size());
+                break;
+            case ArrowColumnKind::FLOAT64:
+                addBuffer(batch.doubles[doubleIndex++].data(), rowCount * sizeof(double));
+                break;
+            case ArrowColumnKind::UINT8:
+                addBuffer(byteColumns[byteIndex++]->data(), rowCount);
+                break;
+        }
+    }
+
+    std::vector<uint8_t> nodes;
+    for (size_t i = 0; i < EXPORT_COLUMN_COUNT; ++i) {
+        appendStructField<int64_t>(nodes, static_cast<int64_t>(rowCount)); // length
+        appendStructField<int64_t>(nodes, 0);                               // null_count
+    }
+
+    // Message { version, header_type, header: RecordBatch { length, nodes, buffers }, bodyLength }
+    FlatBufferWriter writer;
+    std::vector<size_t> messagePositions;
+    size_t message = writer.table({{0, 2, METADATA_VERSION_V5}, {1, 1, MESSAGE_HEADER_RECORD_BATCH},
+                                   {2, 4, 0}, {3, 8, body.size()}}, &messagePositions);
+    writer.setRoot(message);
+
+    std::vector<size_t> batchPositions;
+    size_t recordBatch = writer.table({{0, 8, rowCount}, {1, 4, 0}, {2, 4, 0}}, &batchPositions);
+    writer.link(messagePositions[2], recordBatch);
+    writer.link(batchPositions[1], writer.structVector(nodes, EXPORT_COLUMN_COUNT));
+    writer.link(batchPositions[2], writer.structVector(buffers, bufferCount));
+
+    EncodedBatch encoded;
+    encoded.metadataLength = static_cast<int32_t>(frameMessage(writer.data, encoded.bytes));
+    encoded.bodyLength = static_cast<int64_t>(body.size());
+    encoded.bytes.insert(encoded.bytes.end(), body.begin(), body.end());
+    encoded.rowCount = rowCount;
+    return encoded;
+}
+
+// 待导出的数据来源
+struct ExportSource {
+    std::string path;             // 文件路径（内存数据为空）
+    bool segment;                 // 是否为压缩段文件
+    const LocationColumns* rows;  // 内存数据
+    long long minTimestamp;       // 最小时间戳（CSV日志未知）
+};
+
+// 单个来源的导出结果
+struct ExportSlot {
+    bool done;                          // 是否已编码完成
+    bool failed;                        // 是否编码失败
+    std::vector<EncodedBatch> batches;  // 编码后的记录批次
+
+    ExportSlot() : done(false), failed(false) {}
+};
+
+// 将单个来源中满足条件的数据编码为记录批次
+class SourceEncoder {
+private:
+    const QueryPredicate& predicate;
+    size_t batchRowCount;
+    ArrowBatch batch;
+    std::vector<uint32_t> selection;
+    std::vector<EncodedBatch>& output;
+
+public:
+    SourceEncoder(const QueryPredicate& queryPredicate, size_t rowCount, std::vector<EncodedBatch>& batches) :
+        predicate(queryPredicate),
+        batchRowCount(rowCount),
+        output(batches) {}
+
+    // 筛选一个列式批次并追加到记录批次
+    void add(const LocationColumns& columns) {
+        uint32_t deviceCode = 0;
+        if (!predicate.deviceId.empty()) {
+            auto it = std::find(columns.deviceDictionary.begin(), columns.deviceDictionary.end(), predicate.deviceId);
+            if (it == columns.deviceDictionary.end()) {
+                return;
+            }
+            deviceCode = static_cast<uint32_t>(it - columns.deviceDictionary.begin());
+        }
+
+        selection.clear();
+        for (size_t row = 0; row < columns.size(); ++row) {
+            if (predicate.matchesRow(columns, row) &&
+                (predicate.deviceId.empty() || columns.deviceIndexes[row] == deviceCode)) {
+                selection.push_back(static_cast<uint32_t>(row));
+            }
+        }
+
+        size_t begin = 0;
+        while (begin < selection.size()) {
+            size_t count = std::min(selection.size() - begin, batchRowCount - batch.size());
+            batch.gather(columns, selection.data() + begin, count);
+            begin += count;
+            if (batch.size() >= batchRowCount) {
+                flush();
+            }
+        }
+    }
+
+    // 编码剩余数据
+    void flush() {
+        if (batch.size() > 0) {
+            output.push_back(encodeBatch(batch));
+            batch.clear();
+        }
+    }
+};
+
+// 编码单个来源
+void encodeSource(const ExportSource& source, const QueryPredicate& predicate, size_t batchRowCount,
+                  const QueryExecutor::LineParser& parser, std::vector<EncodedBatch>& output) {
+    SourceEncoder encoder(predicate, batchRowCount, output);
+
+    if (source.rows) {
+        encoder.add(*source.rows);
+    } else if (source.segment) {
+        SegmentReader reader;
+        if (!reader.open(source.path)) {
+            throw std::runtime_error("failed to open segment");
+        }
+
+        // 额外信息不导出，解码时直接跳过
+        const uint32_t columnMask = ALL_CODEC_COLUMNS & ~codecColumnBit(CodecColumn::EXTRAS);
+        const auto& blocks = reader.getBlocks();
+        LocationColumns columns;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!predicate.overlaps(blocks[i].minTimestamp, blocks[i].maxTimestamp) ||
+                !blocks[i].mayContain(predicate.sourceType, predicate.status)) {
+                continue;
+            }
+            columns.clear();
+            if (reader.readBlock(i, columns, columnMask)) {
+                encoder.add(columns);
+            }
+        }
+    } else {
+        std::ifstream file(source.path);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open log file");
+        }
+
+        LocationColumns columns;
+        std::string line;
+        LocationInfo location;
+        while (std::getline(file, line)) {
+            if (parser(line, location)) {
+                columns.append(location);
+            }
+            if (columns.size() >= batchRowCount) {
+                encoder.add(columns);
+                columns.clear();
+            }
+        }
+        encoder.add(columns);
+    }
+
+    encoder.flush();
+}
+
+} // namespace
+
+// ArrowExporter构造函数
+ArrowExporter::ArrowExporter(size_t threads) :
+    threadCount(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+    batchRowCount(64 * 1024) {
+}
+
+// 设置每个记录批次的最大行数
+void ArrowExporter::setBatchRowCount(size_t rowCount) {
+    if (rowCount > 0) {
+        batchRowCount = rowCount;
+    }
+}
+
+// 导出到Arrow IPC文件
+bool ArrowExporter::exportFiles(const std::vector<std::string>& files, const QueryPredicate& predicate,
+                                const std::string& outputPath, ArrowExportStats* stats,
+                                const LocationColumns* memoryRows) {
+    auto startTime = std::chrono::steady_clock::now();
+    ArrowExportStats result;
+
+    // 根据段文件索引剪枝，按时间顺序导出
+    std::vector<ExportSource> sources;
+    for (const auto& path : files) {
+        ExportSource source;
+        source.path = path;
+        source.segment = std::filesystem::path(path).extension() == SEGMENT_FILE_EXTENSION;
+        source.rows = nullptr;
+        source.minTimestamp = std::numeric_limits<long long>::min();
+
+        // 无法读取的来源使整个导出失败（与编码阶段一致），不静默地少导出数据
+        if (source.segment) {
+            SegmentReader reader;
+            if (!reader.open(path)) {
+                LOG_ERROR("Failed to export %s: failed to open segment", path.c_str());
+                return false;
+            }
+            if (reader.getBlocks().empty() ||
+                !predicate.overlaps(reader.getMinTimestamp(), reader.getMaxTimestamp()) ||
+                !reader.mayContain(predicate.sourceType, predicate.status)) {
+                result.sourcesPruned++;
+                continue;
+            }
+            source.minTimestamp = reader.getMinTimestamp();
+        } else if (!lineParser) {
+            LOG_ERROR("Failed to export %s: no line parser for log files", path.c_str());
+            return false;
+        }
+        sources.push_back(source);
+    }
+    std::stable_sort(sources.begin(), sources.end(), [](const ExportSource& a, const ExportSource& b) {
+        return a.minTimestamp < b.minTimestamp;
+    });
+    if (memoryRows && !memoryRows->empty()) {
+        ExportSource source;
+        source.segment = false;
+        source.rows = memoryRows;
+        source.minTimestamp = std::numeric_limits<long long>::max();
+        sources.push_back(source);
+    }
+
+    std::string tempPath = outputPath + ".tmp";
+    std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        LOG_ERROR("Failed to create arrow file: %s", tempPath.c_str());
+        return false;
+    }
+
+    // 文件头和Schema消息
+    std::vector<uint8_t> header(ARROW_MAGIC, ARROW_MAGIC + 6);
+    header.resize(8, 0);
+    FlatBufferWriter schemaWriter;
+    std::vector<size_t> messagePositions;
+    size_t message = schemaWriter.table({{0, 2, METADATA_VERSION_V5}, {1, 1, MESSAGE_HEADER_SCHEMA},
+                                         {2, 4, 0}, {3, 8, 0}}, &messagePositions);
+    schemaWriter.setRoot(message);
+    schemaWriter.link(messagePositions[2], writeSchema(schemaWriter));
+    frameMessage(schemaWriter.data, header);
+    output.write(reinterpret_cast<const char*>(header.data()), header.size());
+    uint64_t offset = header.size();
+
+    // 工作线程按顺序领取来源并编码，领先写入位置的来源数不超过window，限制在途数据量
+    std::vector<ExportSlot> slots(sources.size());
+    std::mutex slotMutex;
+    std::condition_variable slotCV;
+    size_t nextSource = 0;
+    size_t written = 0;
+    bool aborted = false;
+    const size_t window = threadCount * 2;
+
+    auto worker = [&]() {
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(slotMutex);
+                slotCV.wait(lock, [&] {
+                    return aborted || nextSource >= sources.size() || nextSource < written + window;
+                });
+                if (aborted || nextSource >= sources.size()) {
+                    return;
+                }
+                index = nextSource++;
+            }
+
+            std::vector<EncodedBatch> batches;
+            bool failed = false;
+            try {
+                encodeSource(sources[index], predicate, batchRowCount, lineParser, batches);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Failed to export %s: %s", sources[index].path.c_str(), e.what());
+                failed = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(slotMutex);
+                slots[index].batches = std::move(batches);
+                slots[index].failed = failed;
+                slots[index].done = true;
+            }
+            slotCV.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t workerCount = std::min(threadCount, sources.size());
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    std::vector<uint8_t> blocks; // Footer中的Block数组
+    bool ok = true;
+    for (size_t i = 0; i < sources.size() && ok; ++i) {
+        std::vector<EncodedBatch> batches;
+        {
+            std::unique_lock<std::mutex> lock(slotMutex);
+            slotCV.wait(lock, [&] { return slots[i].done; });
+            batches = std::move(slots[i].batches);
+            ok = !slots[i].failed;
+        }
+
+        for (const auto& batch : batches) {
+            if (!ok) {
+                break;
+            }
+            output.write(reinterpret_cast<const char*>(batch.bytes.data()), batch.bytes.size());
+            ok = output.good();
+
+            appendStructField<int64_t>(blocks, static_cast<int64_t>(offset)); // offset
+            appendStructField<int32_t>(blocks, batch.metadataLength);        // metaDataLength
+            appendStructField<int32_t>(blocks, 0);                           // 填充
+            appendStructField<int64_t>(blocks, batch.bodyLength);            // bodyLength
+            offset += batch.bytes.size();
+            result.rowsExported += batch.rowCount;
+            result.recordBatches++;
+        }
+        result.sourcesExported++;
+
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            written++;
+            aborted = !ok;
+        }
+        slotCV.notify_all();
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (ok) {
+        // 流结束标记和Footer
+        std::vector<uint8_t> trailer;
+        appendStructField<uint32_t>(trailer, CONTINUATION_MARKER);
+        appendStructField<int32_t>(trailer, 0);
+
+        FlatBufferWriter footerWriter;
+        std::vector<size_t> footerPositions;
+        size_t footer = footerWriter.table({{0, 2, METADATA_VERSION_V5}, {1, 4, 0}, {2, 4, 0}, {3, 4, 0}},
+                                           &footerPositions);
+        footerWriter.setRoot(footer);
+        footerWriter.link(footerPositions[1], writeSchema(footerWriter));
+        footerWriter.link(footerPositions[2], footerWriter.structVector({}, 0));
+        footerWriter.link(footerPositions[3], footerWriter.structVector(blocks, result.recordBatches));
+
+        trailer.insert(trailer.end(), footerWriter.data.begin(), footerWriter.data.end());
+        appendStructField<int32_t>(trailer, static_cast<int32_t>(footerWriter.data.size()));
+        trailer.insert(trailer.end(), ARROW_MAGIC, ARROW_MAGIC + 6);
+
+        output.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+        offset += trailer.size();
+        output.close();
+        ok = !output.fail();
+    } else {
+        output.close();
+    }
+
+    try {
+        if (!ok) {
+            std::filesystem::remove(tempPath);
+            LOG_ERROR("Failed to export arrow file: %s", outputPath.c_str());
+            return false;
+        }
+        std::filesystem::rename(tempPath, outputPath);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to finalize arrow file %s: %s", outputPath.c_str(), e.what());
+        return false;
+    }
+
+    result.bytesWritten = offset;
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    if (stats) {
+        *stats = result;
+    }
+
+    LOG_INFO("Exported %llu rows in %zu batches to %s (%lld ms)",
+             static_cast<unsigned long long>(result.rowsExported), result.recordBatches,
+             outputPath.c_str(), result.elapsedMs);
+    return true;
+}
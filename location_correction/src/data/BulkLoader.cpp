@@ -0,0 +1,305 @@
+// BulkLoader.cpp - 历史数据批量导入实现
+
+#include "BulkLoader.h"
+#include "SegmentFile.h"
+#include "Logger.h"
+#include "Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <numeric>
+#include <thread>
+
+namespace {
+
+// 批量导入的段文件名标记（locations_<最小时间戳>_bulk.lcs），与实时写入的段文件区分
+const char* const BULK_MARKER = "_bulk";
+
+// 临时文件后缀
+const char* const STAGING_SUFFIX = ".tmp";
+
+} // namespace
+
+// BulkLoader构造函数
+BulkLoader::BulkLoader(const std::string& storageDirectory, const BulkLoadOptions& loadOptions) :
+    storagePath(storageDirectory),
+    options(loadOptions),
+    startTime(std::chrono::steady_clock::now()),
+    failed(false),
+    finished(false) {
+    if (options.threadCount == 0) {
+        options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options.blockRowCount = std::max<size_t>(options.blockRowCount, 1);
+    options.segmentRowCount = std::max(options.segmentRowCount, options.blockRowCount);
+    options.runRowCount = std::max(options.runRowCount, options.segmentRowCount);
+}
+
+// BulkLoader析构函数
+BulkLoader::~BulkLoader() {
+    if (!finished) {
+        abort();
+    }
+}
+
+// 添加一批列式数据
+bool BulkLoader::add(const LocationColumns& rows) {
+    if (failed || finished) {
+        return false;
+    }
+
+    for (size_t row = 0; row < rows.size(); ++row) {
+        buffer.appendRow(rows, row);
+        if (buffer.size() >= options.runRowCount && !flushRun()) {
+            return false;
+        }
+    }
+    stats.rowsAdded += rows.size();
+    return true;
+}
+
+// 添加一批位置数据
+bool BulkLoader::add(const std::vector<LocationInfo>& locations) {
+    if (failed || finished) {
+        return false;
+    }
+
+    for (const auto& location : locations) {
+        buffer.append(location);
+        if (buffer.size() >= options.runRowCount && !flushRun()) {
+            return false;
+        }
+    }
+    stats.rowsAdded += locations.size();
+    return true;
+}
+
+// 按设备分组并行校正
+bool BulkLoader::correctRun(LocationColumns& run) {
+    // 设备字典下标到行号
+    std::vector<std::vector<uint32_t>> groups(run.deviceDictionary.size());
+    for (size_t row = 0; row < run.size(); ++row) {
+        groups[run.deviceIndexes[row]].push_back(static_cast<uint32_t>(row));
+    }
+
+    std::vector<std::vector<LocationInfo>> tracks(groups.size());
+    std::atomic<bool> ok(true);
+    utils::concurrent::parallelFor(groups.size(), options.threadCount, [&](size_t group) {
+        if (groups[group].empty() || !ok) {
+            return;
+        }
+
+        std::vector<LocationInfo>& track = tracks[group];
+        track.reserve(groups[group].size());
+        for (uint32_t row : groups[group]) {
+            track.push_back(run.toLocationInfo(row));
+        }
+        std::stable_sort(track.begin(), track.end(), [](const LocationInfo& a, const LocationInfo& b) {
+            return a.timestamp < b.timestamp;
+        });
+
+        try {
+            options.correction(run.deviceDictionary[group], track);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Bulk load correction failed for device %s: %s", run.deviceDictionary[group].c_str(), e.what());
+            ok = false;
+        }
+    });
+    if (!ok) {
+        return false;
+    }
+
+    LocationColumns corrected;
+    corrected.reserve(run.size());
+    for (size_t group = 0; group < tracks.size(); ++group) {
+        if (!groups[group].empty()) {
+            stats.devicesCorrected++;
+        }
+        for (const auto& location : tracks[group]) {
+            corrected.append(location);
+        }
+    }
+    run = std::move(corrected);
+    return true;
+}
+
+// 生成不冲突的段文件路径并加入待发布列表
+std::string BulkLoader::reservePath(long long minTimestamp) {
+    std::string baseName = storagePath + "/locations_" + std::to_string(minTimestamp) + BULK_MARKER;
+    std::string path = baseName + SEGMENT_FILE_EXTENSION;
+    for (int suffix = 1; std::filesystem::exists(path) || std::filesystem::exists(path + STAGING_SUFFIX) ||
+         std::find(stagedFiles.begin(), stagedFiles.end(), path) != stagedFiles.end(); ++suffix) {
+        path = baseName + "-" + std::to_string(suffix) + SEGMENT_FILE_EXTENSION;
+    }
+
+    stagedFiles.push_back(path);
+    return path;
+}
+
+// 将排序后的第begin到end行写入段文件的临时文件
+bool BulkLoader::writeSegment(const LocationColumns& run, const std::vector<uint32_t>& order,
+                              size_t begin, size_t end, const std::string& path, uint64_t& bytes) const {
+    SegmentWriter writer;
+    if (!writer.open(path + STAGING_SUFFIX)) {
+        return false;
+    }
+
+    bool ok = true;
+    LocationColumns block;
+    block.reserve(options.blockRowCount);
+    for (size_t i = begin; i < end && ok; ++i) {
+        block.appendRow(run, order[i]);
+        if (block.size() >= options.blockRowCount || i + 1 == end) {
+            ok = writer.appendBlock(block);
+            block.clear();
+        }
+    }
+
+    // 块索引和行位图索引在文件末尾一次写入
+    ok = writer.finish() && ok;
+    bytes = writer.getBytesWritten();
+    return ok;
+}
+
+// 校正、排序并写出缓存中的数据
+bool BulkLoader::flushRun() {
+    if (buffer.empty()) {
+        return true;
+    }
+
+    try {
+        LocationColumns run = std::move(buffer);
+        buffer.clear();
+
+        if (options.correction && !correctRun(run)) {
+            failed = true;
+            return false;
+        }
+        if (run.empty()) {
+            return true;
+        }
+
+        // 按时间排序（同一时刻保持添加顺序），每个段文件覆盖一段连续的时间范围
+        std::vector<uint32_t> order(run.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&run](uint32_t a, uint32_t b) {
+            return run.timestamps[a] < run.timestamps[b];
+        });
+
+        std::filesystem::create_directories(storagePath);
+        size_t segmentCount = (run.size() + options.segmentRowCount - 1) / options.segmentRowCount;
+        std::vector<std::string> paths(segmentCount);
+        for (size_t i = 0; i < segmentCount; ++i) {
+            paths[i] = reservePath(run.timestamps[order[i * options.segmentRowCount]]);
+        }
+
+        // 各段文件并行编码写入
+        std::vector<uint64_t> bytes(segmentCount, 0);
+        std::vector<char> written(segmentCount, 0);
+        utils::concurrent::parallelFor(segmentCount, options.threadCount, [&](size_t i) {
+            size_t begin = i * options.segmentRowCount;
+            size_t end = std::min(run.size(), begin + options.segmentRowCount);
+            written[i] = writeSegment(run, order, begin, end, paths[i], bytes[i]);
+        });
+
+        for (size_t i = 0; i < segmentCount; ++i) {
+            if (!written[i]) {
+                LOG_ERROR("Failed to write bulk load segment: %s", paths[i].c_str());
+                failed = true;
+                return false;
+            }
+            stats.bytesWritten += bytes[i];
+        }
+        stats.segmentsWritten += segmentCount;
+        stats.rowsWritten += run.size();
+
+        LOG_DEBUG("Bulk load staged %zu rows in %zu segments", run.size(), segmentCount);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to write bulk load run: %s", e.what());
+        failed = true;
+        return false;
+    }
+}
+
+// 写出剩余数据并发布所有段文件
+bool BulkLoader::finish(BulkLoadStats* loadStats) {
+    if (finished || failed || !flushRun()) {
+        abort();
+        return false;
+    }
+
+    // 所有临时文件落盘后才开始重命名，避免发布后崩溃留下内容不完整的段文件
+    for (const auto& path : stagedFiles) {
+        if (!syncFile(path + STAGING_SUFFIX)) {
+            LOG_ERROR("Failed to sync bulk load segment: %s", path.c_str());
+            abort();
+            return false;
+        }
+    }
+
+    // 临时文件逐个重命名为正式段文件，同步目录后重命名才持久；任一步失败时撤销已完成的重命名
+    size_t published = 0;
+    bool ok = true;
+    for (; published < stagedFiles.size(); ++published) {
+        std::error_code ec;
+        std::filesystem::rename(stagedFiles[published] + STAGING_SUFFIX, stagedFiles[published], ec);
+        if (ec) {
+            LOG_ERROR("Failed to publish bulk load segment %s: %s", stagedFiles[published].c_str(),
+                      ec.message().c_str());
+            ok = false;
+            break;
+        }
+    }
+    if (ok && !syncDirectory(storagePath)) {
+        LOG_ERROR("Failed to sync bulk load directory: %s", storagePath.c_str());
+        ok = false;
+    }
+    if (!ok) {
+        unpublish(published);
+        abort();
+        return false;
+    }
+    stagedFiles.clear();
+    finished = true;
+
+    stats.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    LOG_INFO("Bulk load finished: %llu rows in %zu segments (%llu bytes, %lld ms)",
+             static_cast<unsigned long long>(stats.rowsWritten), stats.segmentsWritten,
+             static_cast<unsigned long long>(stats.bytesWritten), stats.elapsedMs);
+    if (loadStats) {
+        *loadStats = stats;
+    }
+    return true;
+}
+
+// 撤销前count个段文件的发布：改回临时文件名，改名失败时直接删除，保证不留下部分导入的数据
+void BulkLoader::unpublish(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        std::error_code ec;
+        std::filesystem::rename(stagedFiles[i], stagedFiles[i] + STAGING_SUFFIX, ec);
+        if (ec) {
+            std::filesystem::remove(stagedFiles[i], ec);
+        }
+    }
+    if (count > 0) {
+        syncDirectory(storagePath);
+        LOG_WARNING("Bulk load publish rolled back, %zu published segments withdrawn", count);
+    }
+}
+
+// 放弃导入
+void BulkLoader::abort() {
+    if (!stagedFiles.empty()) {
+        LOG_WARNING("Bulk load aborted, discarding %zu staged segments", stagedFiles.size());
+    }
+
+    std::error_code ec;
+    for (const auto& path : stagedFiles) {
+        std::filesystem::remove(path + STAGING_SUFFIX, ec);
+    }
+    stagedFiles.clear();
+    buffer.clear();
+    finished = true;
+}
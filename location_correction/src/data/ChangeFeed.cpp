@@ -0,0 +1,348 @@
+// ChangeFeed.cpp - 存储变更订阅（CDC）实现
+
+#include "ChangeFeed.h"
+#include "WriteAheadLog.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 订阅者映射的日志文件
+// 只读共享映射，文件增长后重新映射；不支持mmap时按需读入新增的内容
+struct ChangeSubscription::Mapping {
+    uint64_t fileStart;         // 文件起始LSN
+    uint64_t nextFileStart;     // 下一个文件的起始LSN（映射时还没有下一个文件则为最大值）
+    const uint8_t* data;        // 文件内容
+    size_t size;                // 可读取的长度
+#if defined(__unix__) || defined(__APPLE__)
+    int fd;                     // 文件描述符
+#else
+    std::string path;           // 文件路径
+    std::vector<uint8_t> buffer; // 读入的文件内容
+#endif
+
+    Mapping() : fileStart(0), nextFileStart(std::numeric_limits<uint64_t>::max()), data(nullptr), size(0)
+#if defined(__unix__) || defined(__APPLE__)
+        , fd(-1)
+#endif
+    {}
+
+    ~Mapping() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+
+    // 打开日志文件
+    bool open(const std::string& filePath) {
+#if defined(__unix__) || defined(__APPLE__)
+        fd = ::open(filePath.c_str(), O_RDONLY);
+        return fd >= 0;
+#else
+        path = filePath;
+        return true;
+#endif
+    }
+
+    // 文件增长后扩大可读取的范围
+    bool refresh() {
+#if defined(__unix__) || defined(__APPLE__)
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            return false;
+        }
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        if (fileSize <= size) {
+            return true;
+        }
+        void* address = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        // 订阅者顺序读取
+        madvise(address, fileSize, MADV_SEQUENTIAL);
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+        data = static_cast<const uint8_t*>(address);
+        size = fileSize;
+        return true;
+#else
+        std::ifstream input(path, std::ios::binary | std::ios::ate);
+        if (!input.is_open()) {
+            return false;
+        }
+        size_t fileSize = static_cast<size_t>(input.tellg());
+        if (fileSize <= size) {
+            return true;
+        }
+        buffer.resize(fileSize);
+        input.seekg(static_cast<std::streamoff>(size));
+        if (!input.read(reinterpret_cast<char*>(buffer.data() + size), static_cast<std::streamsize>(fileSize - size))) {
+            return false;
+        }
+        data = buffer.data();
+        size = fileSize;
+        return true;
+#endif
+    }
+};
+
+// ChangeFeed构造函数
+ChangeFeed::ChangeFeed(const std::string& walDirectory, uint64_t endOffset) :
+    directory(walDirectory),
+    publishedOffset(endOffset),
+    retentionBytes(0),
+    nextSubscriptionId(1),
+    closed(false) {
+}
+
+// 发布新的日志末尾
+void ChangeFeed::publish(uint64_t endOffset) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (endOffset <= publishedOffset) {
+            return;
+        }
+        publishedOffset = endOffset;
+    }
+    appended.notify_all();
+}
+
+// 关闭订阅源
+void ChangeFeed::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    appended.notify_all();
+}
+
+// 清理检查点之前的日志
+void ChangeFeed::truncateLog(WriteAheadLog& wal, uint64_t checkpointOffset) {
+    // 持锁清理，避免与新订阅的偏移校验交错
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint64_t floor = checkpointOffset;
+    if (retentionBytes > 0) {
+        floor = std::min(floor, publishedOffset > retentionBytes ? publishedOffset - retentionBytes : 0);
+    }
+    for (const auto& subscription : positions) {
+        floor = std::min(floor, subscription.second);
+    }
+    wal.truncateBefore(floor);
+}
+
+// 从指定偏移开始订阅
+std::unique_ptr<ChangeSubscription> ChangeFeed::subscribe(uint64_t fromOffset) {
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (closed) {
+            LOG_WARNING("Cannot subscribe to a closed change feed");
+            return nullptr;
+        }
+        if (fromOffset > publishedOffset) {
+            LOG_ERROR("Change offset %" PRIu64 " is beyond the end of the log (%" PRIu64 ")",
+                      fromOffset, publishedOffset);
+            return nullptr;
+        }
+
+        std::vector<uint64_t> files = WriteAheadLog::listFiles(directory);
+        uint64_t startOffset = files.empty() ? publishedOffset : files.front();
+        if (fromOffset < startOffset) {
+            LOG_WARNING("Change offset %" PRIu64 " is no longer available, earliest offset is %" PRIu64,
+                        fromOffset, startOffset);
+            return nullptr;
+        }
+
+        id = nextSubscriptionId++;
+        positions[id] = fromOffset;
+    }
+
+    LOG_DEBUG("Change subscription %" PRIu64 " started at offset %" PRIu64, id, fromOffset);
+    return std::make_unique<ChangeSubscription>(shared_from_this(), id, fromOffset);
+}
+
+// 从最早仍保留的数据开始订阅
+std::unique_ptr<ChangeSubscription> ChangeFeed::subscribeFromStart() {
+    return subscribe(getStartOffset());
+}
+
+// 只订阅之后写入的数据
+std::unique_ptr<ChangeSubscription> ChangeFeed::subscribeFromEnd() {
+    return subscribe(getEndOffset());
+}
+
+// 获取最早仍保留的数据偏移
+uint64_t ChangeFeed::getStartOffset() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<uint64_t> files = WriteAheadLog::listFiles(directory);
+    return files.empty() ? publishedOffset : std::min(files.front(), publishedOffset);
+}
+
+// 获取已发布的日志末尾
+uint64_t ChangeFeed::getEndOffset() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return publishedOffset;
+}
+
+// 设置日志清理时额外保留的字节数
+void ChangeFeed::setRetentionBytes(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    retentionBytes = bytes;
+}
+
+// 获取当前订阅数
+size_t ChangeFeed::getSubscriptionCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return positions.size();
+}
+
+// 更新订阅的读取位置
+void ChangeFeed::updatePosition(uint64_t id, uint64_t position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    positions[id] = position;
+}
+
+// 注销订阅
+void ChangeFeed::unregister(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    positions.erase(id);
+}
+
+// ChangeSubscription构造函数
+ChangeSubscription::ChangeSubscription(std::shared_ptr<ChangeFeed> changeFeed, uint64_t subscriptionId,
+                                       uint64_t fromOffset) :
+    feed(std::move(changeFeed)),
+    id(subscriptionId),
+    position(fromOffset),
+    valid(true) {
+}
+
+// ChangeSubscription析构函数
+ChangeSubscription::~ChangeSubscription() {
+    feed->unregister(id);
+}
+
+// 映射包含指定偏移的日志文件
+bool ChangeSubscription::mapFileFor(uint64_t offset) {
+    std::vector<uint64_t> files = WriteAheadLog::listFiles(feed->directory);
+    auto it = std::upper_bound(files.begin(), files.end(), offset);
+    if (it == files.begin()) {
+        return false;
+    }
+
+    auto next = std::make_unique<Mapping>();
+    next->fileStart = *(it - 1);
+    next->nextFileStart = it != files.end() ? *it : std::numeric_limits<uint64_t>::max();
+    if (!next->open(WriteAheadLog::fileNameFor(feed->directory, next->fileStart)) || !next->refresh()) {
+        return false;
+    }
+    mapping = std::move(next);
+    return true;
+}
+
+// 读取position处的一条记录
+bool ChangeSubscription::readRecord(uint64_t endOffset, ChangeBatch& batch) {
+    // 最多切换一次文件：当前文件在此处结束时转到从此处开始的下一个文件
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!mapping || position < mapping->fileStart || position >= mapping->nextFileStart) {
+            if (!mapFileFor(position)) {
+                LOG_WARNING("Change offset %" PRIu64 " is no longer available", position);
+                valid = false;
+                return false;
+            }
+        }
+
+        uint64_t visible = std::min(endOffset, mapping->nextFileStart) - mapping->fileStart;
+        if (mapping->size < visible && !mapping->refresh()) {
+            LOG_ERROR("Failed to map WAL file starting at LSN %" PRIu64, mapping->fileStart);
+            valid = false;
+            return false;
+        }
+
+        size_t local = static_cast<size_t>(position - mapping->fileStart);
+        size_t limit = static_cast<size_t>(std::min<uint64_t>(visible, mapping->size));
+        uint8_t type = 0;
+        const uint8_t* payload = nullptr;
+        size_t payloadSize = 0;
+        size_t length = local < limit ?
+            WriteAheadLog::parseRecord(mapping->data + local, limit - local, type, payload, payloadSize) : 0;
+
+        if (length > 0) {
+            batch.offset = position;
+            batch.nextOffset = position + length;
+            batch.rows.clear();
+            if (type == WriteAheadLog::RECORD_LOCATIONS &&
+                !LocationCodec::decodeBlock(payload, payloadSize, batch.rows)) {
+                LOG_ERROR("Failed to decode change record at offset %" PRIu64, position);
+                valid = false;
+                return false;
+            }
+            position = batch.nextOffset;
+            return true;
+        }
+
+        // 文件在此处结束（正常切换或写入失败后留下的半条记录），之后的数据位于从此处开始的文件中
+        mapping.reset();
+    }
+
+    LOG_ERROR("Corrupted change record at offset %" PRIu64, position);
+    valid = false;
+    return false;
+}
+
+// 读取下一批变更
+bool ChangeSubscription::next(ChangeBatch& batch, long long timeoutMs) {
+    if (!valid) {
+        return false;
+    }
+
+    uint64_t endOffset = 0;
+    {
+        std::unique_lock<std::mutex> lock(feed->mutex);
+        auto ready = [this]() { return feed->closed || feed->publishedOffset > position; };
+        if (!ready()) {
+            if (timeoutMs == 0) {
+                return false;
+            }
+            if (timeoutMs < 0) {
+                feed->appended.wait(lock, ready);
+            } else if (!feed->appended.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) {
+                return false;
+            }
+        }
+        // 关闭后仍可读完已发布的数据
+        if (feed->publishedOffset <= position) {
+            return false;
+        }
+        endOffset = feed->publishedOffset;
+    }
+
+    do {
+        if (!readRecord(endOffset, batch)) {
+            return false;
+        }
+        // 其他类型的记录不含位置数据，继续读取下一条
+    } while (batch.rows.empty() && position < endOffset);
+
+    feed->updatePosition(id, position);
+    return !batch.rows.empty();
+}
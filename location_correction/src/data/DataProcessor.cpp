@@ -1,6 +1,7 @@
 // DataProcessor.cpp - 数据预处理实现
 
 #include "DataProcessor.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <algorithm>
@@ -120,6 +121,8 @@ bool AccuracyFilterProcessor::doProcess(LocationInfo& location) {
     if (location.accuracy < minAccuracy || location.accuracy > maxAccuracy) {
         // 如果精度不在范围内，标记为低精度
         location.status = LocationStatus::LOW_ACCURACY;
+        FlightRecorder::getInstance().record(FlightEventType::FIX_FILTERED, location,
+                                             static_cast<float>(location.accuracy));
         LOG_DEBUG("Location accuracy out of range: %f (min: %f, max: %f)", 
                  location.accuracy, minAccuracy, maxAccuracy);
     }
@@ -156,6 +159,7 @@ bool TimeFilterProcessor::doProcess(LocationInfo& location) {
     if (timeDiff > maxTimeDiff) {
         // 如果时间差太大，标记为无效
         location.status = LocationStatus::INVALID;
+        FlightRecorder::getInstance().record(FlightEventType::FIX_FILTERED, location, static_cast<float>(timeDiff));
         LOG_DEBUG("Location time difference too large: %lld ms (max: %lld ms)", 
                  timeDiff, maxTimeDiff);
     }
@@ -226,6 +230,7 @@ bool OutlierDetectionProcessor::doProcess(LocationInfo& location) {
         location.setExtra("isOutlier", "true");
         location.setExtra("outlierDistance", doubleToString(distance, 2));
         location.setExtra("threshold", doubleToString(thresholdFactor * stdDev, 2));
+        FlightRecorder::getInstance().record(FlightEventType::FIX_FILTERED, location, static_cast<float>(distance));
         
         LOG_DEBUG("Detected outlier: distance=%f > threshold=%f", 
                  distance, thresholdFactor * stdDev);
@@ -276,6 +281,18 @@ void OutlierDetectionProcessor::clearHistory() {
     history.clear();
 }
 
+// 用恢复的最近位置预填历史数据，重启后不必重新积累样本即可检测异常点
+void OutlierDetectionProcessor::seedHistory(const std::vector<LocationInfo>& locations) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    history.clear();
+    for (const auto& location : locations) {
+        if (location.isValid()) {
+            history.push_back(location);
+        }
+    }
+    trimHistory();
+}
+
 // CoordinateConverterProcessor构造函数
 CoordinateConverterProcessor::CoordinateConverterProcessor() : BaseDataProcessor() {
     // 设置默认参数
@@ -328,7 +345,42 @@ std::string CoordinateConverterProcessor::getName() const {
 }
 
 // ProcessorChain构造函数
-ProcessorChain::ProcessorChain() : processors(), mutex() {
+ProcessorChain::ProcessorChain() :
+    processors(),
+    mutex(),
+    appliedConfigVersion(0),
+    stopOnInvalid(false),
+    stopOnInvalidOverride() {
+    ConfigReader<CorrectionConfig> config = ConfigStore<CorrectionConfig>::getInstance().read();
+    appliedConfigVersion = config.version();
+    stopOnInvalid = config->algorithmParams.stopOnInvalid;
+}
+
+// 设置处理器链参数（stopOnInvalid在设置时解析为覆盖值，之后的配置版本不再改变它）
+void ProcessorChain::setParameter(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    DataProcessor::setParameter(key, value);
+    if (key == "stopOnInvalid") {
+        stopOnInvalidOverride = value == "true";
+        stopOnInvalid = *stopOnInvalidOverride;
+    }
+}
+
+// 全局配置有新版本时应用到各处理器
+// 每次处理前只读取一次版本号，版本变化时才无锁读取快照并复制配置，发布配置不需要获取处理器链的锁
+void ProcessorChain::refreshConfig() {
+    ConfigStore<CorrectionConfig>& store = ConfigStore<CorrectionConfig>::getInstance();
+    if (store.getVersion() == appliedConfigVersion) {
+        return;
+    }
+    ConfigReader<CorrectionConfig> config = store.read();
+    for (const auto& processor : processors) {
+        processor->setConfig(*config);
+    }
+    stopOnInvalid = stopOnInvalidOverride.value_or(config->algorithmParams.stopOnInvalid);
+    appliedConfigVersion = config.version();
+    LOG_INFO("Processor chain applied configuration version %llu",
+             static_cast<unsigned long long>(appliedConfigVersion));
 }
 
 // 添加处理器到链中
@@ -377,6 +429,7 @@ void ProcessorChain::sortProcessorsByPriority() {
 // 处理单个位置数据（按链顺序）
 std::shared_ptr<LocationInfo> ProcessorChain::process(const LocationInfo& location) {
     std::lock_guard<std::mutex> lock(mutex);
+    refreshConfig();
     
     // 如果没有处理器，直接返回原始位置的副本
     if (processors.empty()) {
@@ -394,8 +447,7 @@ std::shared_ptr<LocationInfo> ProcessorChain::process(const LocationInfo& locati
             }
             
             // 如果位置变为无效，可以选择提前终止处理链
-            if (!currentLocation->isValid() && 
-                getParameter("stopOnInvalid", "false") == "true") {
+            if (stopOnInvalid && !currentLocation->isValid()) {
                 break;
             }
         }
@@ -1,6 +1,7 @@
 // DataSource.cpp - 定位数据源实现
 
 #include "DataSource.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <algorithm>
@@ -176,6 +177,8 @@ void GNSSDataSource::dataCollectionTask() {
             // 如果位置有效，通知更新
             if (location.isValid()) {
                 notifyLocationUpdate(location);
+                FlightRecorder::getInstance().record(FlightEventType::FIX_INGESTED, location,
+                                                     static_cast<float>(location.accuracy));
                 LOG_DEBUG("GNSS location updated: %s", location.toString().c_str());
             }
             
@@ -253,6 +256,8 @@ void WifiDataSource::dataCollectionTask() {
             // 如果位置有效，通知更新
             if (location.isValid()) {
                 notifyLocationUpdate(location);
+                FlightRecorder::getInstance().record(FlightEventType::FIX_INGESTED, location,
+                                                     static_cast<float>(location.accuracy));
                 LOG_DEBUG("WiFi location updated: %s", location.toString().c_str());
             }
             
@@ -322,6 +327,8 @@ void BaseStationDataSource::dataCollectionTask() {
             // 如果位置有效，通知更新
             if (location.isValid()) {
                 notifyLocationUpdate(location);
+                FlightRecorder::getInstance().record(FlightEventType::FIX_INGESTED, location,
+                                                     static_cast<float>(location.accuracy));
                 LOG_DEBUG("Base station location updated: %s", location.toString().c_str());
             }
             
@@ -1,6 +1,8 @@
 // DataStorage.cpp - 数据存储实现
 
 #include "DataStorage.h"
+#include "FlightRecorder.h"
+#include "LegacyLogParser.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <fstream>
@@ -8,6 +10,31 @@
 #include <filesystem>
 #include <thread>
 #include <chrono>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <ctime>
+
+namespace {
+
+// 日志文件名中的时间（本地时间）
+std::string currentDateTimeString() {
+    std::time_t seconds = static_cast<std::time_t>(LocationInfo::getCurrentTimestampMs() / 1000);
+    std::tm localTime;
+#ifdef _WIN32
+    localtime_s(&localTime, &seconds);
+#else
+    localtime_r(&seconds, &localTime);
+#endif
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y%m%d_%H%M%S", &localTime);
+    return text;
+}
+
+} // namespace
 
 // DataStorage构造函数
 DataStorage::DataStorage() : 
@@ -93,23 +120,271 @@ size_t DataStorage::getStorageCapacity() const {
     return storageCapacity;
 }
 
+// 打开流式查询游标（默认实现先按时间范围查询，再以列式批次返回）
+std::unique_ptr<LocationCursor> DataStorage::openCursor(const QueryPredicate& predicate, uint32_t columnMask,
+                                                        size_t batchSize) {
+    auto rows = std::make_shared<LocationColumns>();
+    for (const auto& location : queryByTimeRange(predicate.startTime, predicate.endTime)) {
+        if (predicate.matches(location)) {
+            rows->append(location);
+        }
+    }
+    
+    auto cursor = std::make_unique<LocationCursor>(std::vector<std::string>(), predicate, columnMask, batchSize);
+    cursor->addMemoryRows(rows);
+    return cursor;
+}
+
+// 查找设备在指定时刻前后最近的定位点（默认实现按时间窗口查询后逐条比较）
+bool DataStorage::findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                                      std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) {
+    long long startTime = 0;
+    long long endTime = 0;
+    searchWindow(timestamp, maxDistanceMs, startTime, endTime);
+    
+    for (const auto& location : queryByTimeRange(startTime, endTime)) {
+        if (getDeviceIdOf(location) == deviceId) {
+            updateBracket(location, timestamp, before, after);
+        }
+    }
+    return true;
+}
+
+// 查询设备在指定时刻的位置
+std::optional<PointLocation> DataStorage::locateAt(const std::string& deviceId, long long timestamp,
+                                                   const PointQueryOptions& options) {
+    if (!isInitialized() || !isEnabled()) {
+        return std::nullopt;
+    }
+    
+    try {
+        std::optional<LocationInfo> before;
+        std::optional<LocationInfo> after;
+        if (!findBracketingFixes(deviceId, timestamp, options.searchDistanceMs(), before, after)) {
+            return std::nullopt;
+        }
+        return interpolateLocation(before, after, timestamp, options);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to locate device %s at %lld: %s", deviceId.c_str(), timestamp, e.what());
+        return std::nullopt;
+    }
+}
+
+// 批量查询设备在指定时刻的位置
+std::vector<std::optional<PointLocation>> DataStorage::locateAtBatch(const std::vector<PointQuery>& queries,
+                                                                     const PointQueryOptions& options) {
+    std::vector<std::optional<PointLocation>> results(queries.size());
+    
+    // 按时间（再按设备）排序后查找，相邻查询命中相同的段文件和块，块缓存命中率高
+    std::vector<size_t> order(queries.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&queries](size_t a, size_t b) {
+        if (queries[a].timestamp != queries[b].timestamp) {
+            return queries[a].timestamp < queries[b].timestamp;
+        }
+        return queries[a].deviceId < queries[b].deviceId;
+    });
+    
+    for (size_t i : order) {
+        results[i] = locateAt(queries[i].deviceId, queries[i].timestamp, options);
+    }
+    
+    LOG_DEBUG("Point-in-time batch query resolved %zu positions", queries.size());
+    return results;
+}
+
 // MemoryStorage构造函数
-MemoryStorage::MemoryStorage() : DataStorage(), locations() {
+MemoryStorage::MemoryStorage() : 
+    DataStorage(), 
+    locations(),
+    checkpointIntervalBytes(16 * 1024 * 1024), // 默认每16MB日志做一次检查点
+    lastCheckpointLsn(0)
+{
 }
 
 // 初始化内存存储
 bool MemoryStorage::initialize(const StorageConfig& config) {
     std::lock_guard<std::mutex> lock(mutex);
-    return DataStorage::initialize(config);
+    
+    if (!DataStorage::initialize(config)) {
+        return false;
+    }
+    
+    if (!walDirectory.empty() && !recoverFromWal()) {
+        DataStorage::close();
+        return false;
+    }
+    return true;
 }
 
 // 关闭内存存储
 bool MemoryStorage::close() {
     std::lock_guard<std::mutex> lock(mutex);
+    
+    // 关闭前写入检查点，下次启动时无需重放日志
+    if (wal) {
+        writeCheckpoint();
+        wal->close();
+        wal.reset();
+    }
+    
     locations.clear();
     return DataStorage::close();
 }
 
+// 设置预写日志目录
+void MemoryStorage::setWalDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (isInitialized()) {
+        LOG_WARNING("WAL directory can only be changed before initialization");
+        return;
+    }
+    
+    walDirectory = directory;
+}
+
+// 设置两次检查点之间允许的日志字节数
+void MemoryStorage::setCheckpointInterval(uint64_t bytes) {
+    if (bytes > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        checkpointIntervalBytes = bytes;
+    }
+}
+
+// 立即写入检查点
+bool MemoryStorage::checkpoint() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return wal && writeCheckpoint();
+}
+
+// 从检查点快照和预写日志恢复内存数据
+bool MemoryStorage::recoverFromWal() {
+    try {
+        wal = std::make_unique<WriteAheadLog>();
+        
+        WalCheckpoint lastCheckpoint;
+        if (!wal->open(walDirectory, &lastCheckpoint)) {
+            wal.reset();
+            return false;
+        }
+        
+        locations.clear();
+        auto appendLocation = [this](const LocationInfo& location) {
+            if (locations.size() >= storageCapacity) {
+                locations.pop_front();
+            }
+            locations.push_back(location);
+        };
+        
+        // 加载检查点时的内存快照
+        LocationColumns columns;
+        if (!lastCheckpoint.meta.empty()) {
+            SegmentReader reader;
+            if (!reader.open(walDirectory + "/" + lastCheckpoint.meta)) {
+                LOG_ERROR("Failed to open memory snapshot: %s", lastCheckpoint.meta.c_str());
+                wal.reset();
+                return false;
+            }
+            for (size_t i = 0; i < reader.getBlocks().size(); ++i) {
+                columns.clear();
+                if (reader.readBlock(i, columns)) {
+                    for (size_t row = 0; row < columns.size(); ++row) {
+                        appendLocation(columns.toLocationInfo(row));
+                    }
+                }
+            }
+        }
+        size_t snapshotCount = locations.size();
+        
+        // 只重放检查点之后的日志
+        size_t replayedCount = 0;
+        bool ok = wal->replay(lastCheckpoint.lsn, [&](uint64_t, const LocationColumns& rows) {
+            for (size_t row = 0; row < rows.size(); ++row) {
+                appendLocation(rows.toLocationInfo(row));
+            }
+            replayedCount += rows.size();
+        });
+        if (!ok) {
+            LOG_WARNING("WAL replay stopped early, some recent locations may be lost");
+        }
+        
+        lastCheckpointLsn = lastCheckpoint.lsn;
+        snapshotFile = lastCheckpoint.meta;
+        LOG_INFO("Memory storage recovered %zu locations from snapshot and %zu from WAL", 
+                snapshotCount, replayedCount);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to recover memory storage from WAL: %s", e.what());
+        wal.reset();
+        return false;
+    }
+}
+
+// 写入内存快照并记录检查点
+bool MemoryStorage::writeCheckpoint() {
+    try {
+        WalCheckpoint newCheckpoint;
+        newCheckpoint.lsn = wal->getEndLsn();
+        if (newCheckpoint.lsn == lastCheckpointLsn && !snapshotFile.empty()) {
+            return true;
+        }
+        
+        // 快照复用段文件格式
+        if (!locations.empty()) {
+            newCheckpoint.meta = "snapshot_" + std::to_string(newCheckpoint.lsn) + SEGMENT_FILE_EXTENSION;
+            std::string snapshotPath = walDirectory + "/" + newCheckpoint.meta;
+            SegmentWriter writer;
+            if (!writer.open(snapshotPath)) {
+                return false;
+            }
+            
+            // 快照不完整时不能记录检查点，否则检查点之前的日志会被删除
+            bool ok = true;
+            LocationColumns block;
+            for (const auto& location : locations) {
+                block.append(location);
+                if (block.size() >= 4096) {
+                    ok = ok && writer.appendBlock(block);
+                    block.clear();
+                }
+            }
+            if (!block.empty()) {
+                ok = ok && writer.appendBlock(block);
+            }
+            ok = writer.finish() && ok;
+            if (!ok) {
+                LOG_ERROR("Failed to write memory storage snapshot: %s", snapshotPath.c_str());
+                std::error_code ec;
+                std::filesystem::remove(snapshotPath, ec);
+                return false;
+            }
+        }
+        
+        if (!wal->writeCheckpoint(newCheckpoint)) {
+            return false;
+        }
+        
+        // 删除旧快照和已被检查点覆盖的日志
+        if (!snapshotFile.empty() && snapshotFile != newCheckpoint.meta) {
+            std::error_code ec;
+            std::filesystem::remove(walDirectory + "/" + snapshotFile, ec);
+        }
+        wal->truncateBefore(newCheckpoint.lsn);
+        
+        lastCheckpointLsn = newCheckpoint.lsn;
+        snapshotFile = newCheckpoint.meta;
+        LOG_DEBUG("Memory storage checkpoint written at LSN %llu", 
+                 static_cast<unsigned long long>(newCheckpoint.lsn));
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to write memory storage checkpoint: %s", e.what());
+        return false;
+    }
+}
+
 // 存储单个位置数据
 bool MemoryStorage::store(const LocationInfo& location) {
     if (!isInitialized() || !isEnabled()) {
@@ -119,6 +394,15 @@ bool MemoryStorage::store(const LocationInfo& location) {
     std::lock_guard<std::mutex> lock(mutex);
     
     try {
+        // 先写预写日志
+        if (wal) {
+            LocationColumns rows;
+            rows.append(location);
+            if (!wal->append(rows)) {
+                return false;
+            }
+        }
+        
         // 检查存储容量
         if (locations.size() >= storageCapacity) {
             // 删除最早的位置数据
@@ -128,6 +412,11 @@ bool MemoryStorage::store(const LocationInfo& location) {
         // 存储位置数据
         locations.push_back(location);
         
+        if (wal && wal->getEndLsn() - lastCheckpointLsn >= checkpointIntervalBytes) {
+            writeCheckpoint();
+        }
+        
+        FlightRecorder::getInstance().record(FlightEventType::STORED, location, 1.0f);
         LOG_DEBUG("Stored location in memory: %s", location.toString().c_str());
         return true;
     } catch (const std::exception& e) {
@@ -145,6 +434,18 @@ bool MemoryStorage::batchStore(const std::vector<LocationInfo>& locations) {
     std::lock_guard<std::mutex> lock(mutex);
     
     try {
+        // 整批数据作为一条日志记录写入
+        if (wal && !locations.empty()) {
+            LocationColumns rows;
+            rows.reserve(locations.size());
+            for (const auto& location : locations) {
+                rows.append(location);
+            }
+            if (!wal->append(rows)) {
+                return false;
+            }
+        }
+        
         for (const auto& location : locations) {
             // 检查存储容量
             if (this->locations.size() >= storageCapacity) {
@@ -156,6 +457,14 @@ bool MemoryStorage::batchStore(const std::vector<LocationInfo>& locations) {
             this->locations.push_back(location);
         }
         
+        if (wal && wal->getEndLsn() - lastCheckpointLsn >= checkpointIntervalBytes) {
+            writeCheckpoint();
+        }
+        
+        if (!locations.empty()) {
+            FlightRecorder::getInstance().record(FlightEventType::STORED, locations.back(),
+                                                 static_cast<float>(locations.size()));
+        }
         LOG_DEBUG("Batch stored %zu locations in memory", locations.size());
         return true;
     } catch (const std::exception& e) {
@@ -242,6 +551,18 @@ bool MemoryStorage::clearAll() {
     
     try {
         locations.clear();
+        
+        // 清空后旧日志和快照都不再需要
+        if (wal) {
+            if (!snapshotFile.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(walDirectory + "/" + snapshotFile, ec);
+                snapshotFile.clear();
+            }
+            wal->reset();
+            lastCheckpointLsn = wal->getEndLsn();
+        }
+        
         LOG_INFO("Memory storage cleared");
         return true;
     } catch (const std::exception& e) {
@@ -256,12 +577,22 @@ FileStorage::FileStorage() :
     fileStream(nullptr),
     fileSize(0),
     rotationInterval(3600000), // 默认1小时轮转一次
-    maxFileSize(10 * 1024 * 1024) // 默认最大文件大小10MB
+    maxFileSize(10 * 1024 * 1024), // 默认最大文件大小10MB
+    compressionEnabled(false),
+    blockRowCount(4096), // 默认每块4096行
+    segmentOpenTime(0),
+    queryThreadCount(0),
+    walEnabled(false),
+    changeRetentionBytes(0)
 {
 }
 
 // FileStorage析构函数
 FileStorage::~FileStorage() {
+    if (retentionManager) {
+        retentionManager->stop();
+    }
+    
     if (fileStream) {
         fileStream->close();
         delete fileStream;
@@ -287,8 +618,22 @@ bool FileStorage::initialize(const StorageConfig& config) {
             }
         }
         
-        // 打开文件流
-        openFileStream();
+        // 打开文件流（压缩模式下写入段文件）
+        if (compressionEnabled) {
+            openSegmentWriter();
+            
+            if (walEnabled && !recoverFromWal()) {
+                return false;
+            }
+        } else {
+            // 上次异常退出时最新的日志文件末尾可能有半行数据
+            std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath, true);
+            if (!logFiles.empty()) {
+                truncateTornLine(logFiles.front());
+            }
+            
+            openFileStream();
+        }
         
         LOG_INFO("File storage initialized successfully: %s", config.storagePath.c_str());
         return true;
@@ -326,7 +671,7 @@ void FileStorage::openFileStream() {
     fileStream->seekp(0, std::ios::beg);
     
     // 记录上次轮转时间
-    lastRotationTime = getCurrentTimestampMs();
+    lastRotationTime = LocationInfo::getCurrentTimestampMs();
     
     LOG_INFO("File stream opened: %s", fileName.c_str());
 }
@@ -334,7 +679,7 @@ void FileStorage::openFileStream() {
 // 检查并执行文件轮转
 void FileStorage::checkAndRotateFile() {
     // 检查是否需要轮转
-    long long currentTime = getCurrentTimestampMs();
+    long long currentTime = LocationInfo::getCurrentTimestampMs();
     
     if (currentTime - lastRotationTime >= rotationInterval || fileSize >= maxFileSize) {
         LOG_INFO("Rotating log file (time: %lld, size: %zu)", 
@@ -345,6 +690,11 @@ void FileStorage::checkAndRotateFile() {
 
 // 关闭文件存储
 bool FileStorage::close() {
+    // 先停止后台整理线程，避免持锁等待
+    if (retentionManager) {
+        retentionManager->stop();
+    }
+    
     std::lock_guard<std::mutex> lock(mutex);
     
     try {
@@ -354,6 +704,21 @@ bool FileStorage::close() {
             fileStream = nullptr;
         }
         
+        // 写出剩余数据并关闭段文件
+        if (compressionEnabled) {
+            flushPendingBlock();
+            segmentWriter.finish();
+        }
+        
+        if (changeFeed) {
+            changeFeed->close();
+            changeFeed.reset();
+        }
+        if (wal) {
+            wal->close();
+            wal.reset();
+        }
+        
         LOG_INFO("File storage closed successfully");
         return DataStorage::close();
     } catch (const std::exception& e) {
@@ -380,6 +745,14 @@ void FileStorage::setMaxFileSize(size_t sizeBytes) {
 
 // 存储单个位置数据
 bool FileStorage::store(const LocationInfo& location) {
+    if (compressionEnabled) {
+        if (!isInitialized() || !isEnabled()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return storeCompressed(location);
+    }
+    
     if (!isInitialized() || !isEnabled() || !fileStream) {
         return false;
     }
@@ -403,6 +776,7 @@ bool FileStorage::store(const LocationInfo& location) {
         // 更新文件大小
         fileSize += serializedData.size() + 1; // +1 for newline
         
+        FlightRecorder::getInstance().record(FlightEventType::STORED, location, 1.0f);
         LOG_DEBUG("Stored location to file");
         return true;
     } catch (const std::exception& e) {
@@ -413,6 +787,47 @@ bool FileStorage::store(const LocationInfo& location) {
 
 // 批量存储位置数据
 bool FileStorage::batchStore(const std::vector<LocationInfo>& locations) {
+    if (compressionEnabled) {
+        if (!isInitialized() || !isEnabled()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        try {
+            LocationColumns rows;
+            rows.reserve(locations.size());
+            for (const auto& location : locations) {
+                rows.append(location);
+            }
+            
+            // 整批数据作为一条日志记录写入，写满一块后再统一写入段文件
+            if (wal && !rows.empty()) {
+                uint64_t endLsn = wal->append(rows);
+                if (!endLsn) {
+                    return false;
+                }
+                changeFeed->publish(endLsn);
+            }
+            
+            for (size_t row = 0; row < rows.size(); ++row) {
+                pendingBlock.appendRow(rows, row);
+            }
+            if (pendingBlock.size() >= blockRowCount) {
+                flushPendingBlock();
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to batch store locations to segment: %s", e.what());
+            return false;
+        }
+        
+        if (!locations.empty()) {
+            FlightRecorder::getInstance().record(FlightEventType::STORED, locations.back(),
+                                                 static_cast<float>(locations.size()));
+        }
+        LOG_DEBUG("Batch stored %zu locations to segment", locations.size());
+        return true;
+    }
+    
     if (!isInitialized() || !isEnabled() || !fileStream) {
         return false;
     }
@@ -440,6 +855,10 @@ bool FileStorage::batchStore(const std::vector<LocationInfo>& locations) {
         // 批量写入后刷新流
         fileStream->flush();
         
+        if (!locations.empty()) {
+            FlightRecorder::getInstance().record(FlightEventType::STORED, locations.back(),
+                                                 static_cast<float>(locations.size()));
+        }
         LOG_DEBUG("Batch stored %zu locations to file", locations.size());
         return true;
     } catch (const std::exception& e) {
@@ -450,114 +869,252 @@ bool FileStorage::batchStore(const std::vector<LocationInfo>& locations) {
 
 // 根据时间范围查询位置数据
 std::vector<LocationInfo> FileStorage::queryByTimeRange(long long startTime, long long endTime) {
-    std::vector<LocationInfo> result;
+    QueryPredicate predicate;
+    predicate.startTime = startTime;
+    predicate.endTime = endTime;
+    
+    std::vector<LocationInfo> result = query(predicate);
+    LOG_DEBUG("Query by time range returned %zu results", result.size());
+    return result;
+}
+
+// 根据数据源类型查询位置数据
+std::vector<LocationInfo> FileStorage::queryByDataSource(DataSourceType sourceType) {
+    QueryPredicate predicate;
+    predicate.sourceType = sourceType;
     
+    std::vector<LocationInfo> result = query(predicate);
+    LOG_DEBUG("Query by data source returned %zu results", result.size());
+    return result;
+}
+
+// 按条件查询位置数据
+std::vector<LocationInfo> FileStorage::query(const QueryPredicate& predicate, QueryStats* stats) {
     if (!isInitialized() || !isEnabled()) {
-        return result;
+        return {};
     }
     
-    std::lock_guard<std::mutex> lock(mutex);
-    
     try {
-        // 获取目录下的所有日志文件
-        std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath);
-        
-        // 遍历所有日志文件
-        for (const auto& fileName : logFiles) {
-            // 打开文件进行读取
-            std::ifstream file(fileName);
-            if (!file.is_open()) {
-                LOG_WARNING("Failed to open log file for reading: %s", fileName.c_str());
-                continue;
-            }
+        // 持锁期间只获取文件列表和未落盘的数据，扫描时不阻塞写入
+        std::vector<std::string> files;
+        LocationColumns memoryRows;
+        QueryExecutor* executor = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
             
-            // 逐行读取并解析位置数据
-            std::string line;
-            while (std::getline(file, line)) {
-                try {
-                    LocationInfo location = deserializeLocation(line);
-                    
-                    // 检查是否在时间范围内
-                    if (location.timestamp >= startTime && location.timestamp <= endTime) {
-                        result.push_back(location);
-                    }
-                } catch (const std::exception& e) {
-                    LOG_WARNING("Failed to parse location data: %s", e.what());
-                }
-            }
+            files = getLogFilesInDirectory(config.storagePath);
+            std::vector<std::string> segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+            files.insert(files.end(), segmentFiles.begin(), segmentFiles.end());
+            memoryRows = pendingBlock;
             
-            file.close();
+            if (!queryExecutor) {
+                queryExecutor = std::make_unique<QueryExecutor>(queryThreadCount);
+                queryExecutor->setLineParser(&FileStorage::parseLogLine);
+            }
+            executor = queryExecutor.get();
         }
         
-        LOG_DEBUG("Query by time range returned %zu results", result.size());
+        return executor->execute(files, predicate, stats, memoryRows.empty() ? nullptr : &memoryRows);
     } catch (const std::exception& e) {
-        LOG_ERROR("Failed to query locations by time range: %s", e.what());
+        LOG_ERROR("Failed to query locations: %s", e.what());
+        return {};
     }
-    
-    return result;
 }
 
-// 根据数据源类型查询位置数据
-std::vector<LocationInfo> FileStorage::queryByDataSource(DataSourceType sourceType) {
-    std::vector<LocationInfo> result;
+// 打开流式查询游标
+std::unique_ptr<LocationCursor> FileStorage::openCursor(const QueryPredicate& predicate, uint32_t columnMask,
+                                                        size_t batchSize) {
+    if (!isInitialized() || !isEnabled()) {
+        return std::make_unique<LocationCursor>(std::vector<std::string>(), predicate, columnMask, batchSize);
+    }
+    
+    // 持锁期间只获取文件列表和未落盘的数据，文件在读取时才逐个打开
+    std::vector<std::string> files;
+    auto memoryRows = std::make_shared<LocationColumns>();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        files = getLogFilesInDirectory(config.storagePath);
+        std::vector<std::string> segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+        files.insert(files.end(), segmentFiles.begin(), segmentFiles.end());
+        *memoryRows = pendingBlock;
+    }
     
+    auto cursor = std::make_unique<LocationCursor>(files, predicate, columnMask, batchSize);
+    cursor->setLineParser(&FileStorage::parseLogLine);
+    cursor->addMemoryRows(memoryRows);
+    return cursor;
+}
+
+// 查找设备在指定时刻前后最近的定位点
+bool FileStorage::findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                                      std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) {
     if (!isInitialized() || !isEnabled()) {
-        return result;
+        return false;
     }
     
-    std::lock_guard<std::mutex> lock(mutex);
+    long long startTime = 0;
+    long long endTime = 0;
+    searchWindow(timestamp, maxDistanceMs, startTime, endTime);
     
     try {
-        // 获取目录下的所有日志文件
-        std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath);
-        
-        // 遍历所有日志文件
-        for (const auto& fileName : logFiles) {
-            // 打开文件进行读取
-            std::ifstream file(fileName);
-            if (!file.is_open()) {
-                LOG_WARNING("Failed to open log file for reading: %s", fileName.c_str());
-                continue;
-            }
+        // 持锁期间只获取文件列表并扫描未落盘的数据
+        std::vector<std::string> logFiles;
+        std::vector<std::string> segmentFiles;
+        DeviceTimeIndex* index = nullptr;
+        QueryExecutor* executor = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
             
-            // 逐行读取并解析位置数据
-            std::string line;
-            while (std::getline(file, line)) {
-                try {
-                    LocationInfo location = deserializeLocation(line);
-                    
-                    // 检查数据源类型
-                    if (location.sourceType == sourceType) {
-                        result.push_back(location);
+            logFiles = getLogFilesInDirectory(config.storagePath);
+            segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+            
+            const auto& dictionary = pendingBlock.deviceDictionary;
+            auto device = std::find(dictionary.begin(), dictionary.end(), deviceId);
+            if (device != dictionary.end()) {
+                uint32_t code = static_cast<uint32_t>(device - dictionary.begin());
+                for (size_t row = 0; row < pendingBlock.size(); ++row) {
+                    long long rowTime = pendingBlock.timestamps[row];
+                    if (pendingBlock.deviceIndexes[row] == code && rowTime >= startTime && rowTime <= endTime) {
+                        updateBracket(pendingBlock.toLocationInfo(row), timestamp, before, after);
                     }
-                } catch (const std::exception& e) {
-                    LOG_WARNING("Failed to parse location data: %s", e.what());
                 }
             }
             
-            file.close();
+            if (!timeIndex) {
+                timeIndex = std::make_unique<DeviceTimeIndex>();
+            }
+            if (!queryExecutor) {
+                queryExecutor = std::make_unique<QueryExecutor>(queryThreadCount);
+                queryExecutor->setLineParser(&FileStorage::parseLogLine);
+            }
+            index = timeIndex.get();
+            executor = queryExecutor.get();
         }
         
-        LOG_DEBUG("Query by data source returned %zu results", result.size());
+        // 段文件按设备时间索引二分查找
+        index->find(segmentFiles, deviceId, timestamp, maxDistanceMs, before, after);
+        
+        // 文本日志没有索引，分别查询查询时刻之前最新和之后最早的一条
+        if (!logFiles.empty()) {
+            QueryPredicate predicate;
+            predicate.deviceId = deviceId;
+            predicate.limit = 1;
+            
+            predicate.startTime = startTime;
+            predicate.endTime = timestamp;
+            predicate.latestFirst = true;
+            for (const auto& location : executor->execute(logFiles, predicate)) {
+                updateBracket(location, timestamp, before, after);
+            }
+            
+            predicate.startTime = timestamp;
+            predicate.endTime = endTime;
+            predicate.latestFirst = false;
+            for (const auto& location : executor->execute(logFiles, predicate)) {
+                updateBracket(location, timestamp, before, after);
+            }
+        }
+        return true;
     } catch (const std::exception& e) {
-        LOG_ERROR("Failed to query locations by data source: %s", e.what());
+        LOG_ERROR("Failed to find bracketing fixes for device %s: %s", deviceId.c_str(), e.what());
+        return false;
     }
-    
-    return result;
 }
 
-// 获取最新的位置数据
-std::optional<LocationInfo> FileStorage::getLatestLocation() {
+// 创建批量导入器
+std::unique_ptr<BulkLoader> FileStorage::createBulkLoader(const BulkLoadOptions& options) {
     if (!isInitialized() || !isEnabled()) {
-        return std::nullopt;
+        LOG_WARNING("Bulk loader requires an initialized file storage");
+        return nullptr;
     }
     
     std::lock_guard<std::mutex> lock(mutex);
+    return std::make_unique<BulkLoader>(config.storagePath, options);
+}
+
+// 设置查询线程数（0表示使用CPU核数，需在首次查询前设置）
+void FileStorage::setQueryThreadCount(size_t threadCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (queryExecutor) {
+        LOG_WARNING("Query thread count can only be changed before the first query");
+        return;
+    }
+    
+    queryThreadCount = threadCount;
+}
+
+// 导出为Arrow IPC文件
+bool FileStorage::exportToArrow(const std::string& outputPath, const QueryPredicate& predicate,
+                                ArrowExportStats* stats) {
+    if (!isInitialized() || !isEnabled()) {
+        return false;
+    }
     
     try {
-        // 获取目录下的所有日志文件（按修改时间排序）
-        std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath, true);
-        
+        // 持锁期间只获取文件列表和未落盘的数据，导出时不阻塞写入
+        std::vector<std::string> files;
+        LocationColumns memoryRows;
+        size_t threadCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            
+            files = getLogFilesInDirectory(config.storagePath);
+            std::vector<std::string> segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+            files.insert(files.end(), segmentFiles.begin(), segmentFiles.end());
+            memoryRows = pendingBlock;
+            threadCount = queryThreadCount;
+        }
+        
+        ArrowExporter exporter(threadCount);
+        exporter.setLineParser(&FileStorage::parseLogLine);
+        return exporter.exportFiles(files, predicate, outputPath, stats, &memoryRows);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to export locations: %s", e.what());
+        return false;
+    }
+}
+
+// 获取最新的位置数据
+std::optional<LocationInfo> FileStorage::getLatestLocation() {
+    if (!isInitialized() || !isEnabled()) {
+        return std::nullopt;
+    }
+    
+    // 压缩模式下只读取各段的文件尾比较最大时间戳，只解码最新段中最新的一个块
+    if (compressionEnabled) {
+        std::vector<std::string> segmentFiles;
+        LocationColumns memoryRows;
+        bool hasLogFiles = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            hasLogFiles = !getLogFilesInDirectory(config.storagePath).empty();
+            segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+            memoryRows = pendingBlock;
+        }
+        
+        // 启用压缩前写入的文本日志没有文件尾可以比较，仍按时间倒序查询
+        if (hasLogFiles) {
+            QueryPredicate predicate;
+            predicate.limit = 1;
+            predicate.latestFirst = true;
+            
+            std::vector<LocationInfo> result = query(predicate);
+            if (result.empty()) {
+                return std::nullopt;
+            }
+            return result.front();
+        }
+        return latestInSegments(segmentFiles, memoryRows);
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    try {
+        // 获取目录下的所有日志文件（按修改时间排序）
+        std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath, true);
+        
         if (logFiles.empty()) {
             return std::nullopt;
         }
@@ -595,6 +1152,63 @@ std::optional<LocationInfo> FileStorage::getLatestLocation() {
     return std::nullopt;
 }
 
+// 在段文件和未落盘的数据中查找最新的一条
+std::optional<LocationInfo> FileStorage::latestInSegments(const std::vector<std::string>& segmentFiles,
+                                                         const LocationColumns& memoryRows) {
+    std::optional<LocationInfo> latest;
+    auto takeLatestRow = [&latest](const LocationColumns& rows) {
+        size_t best = rows.size();
+        for (size_t row = 0; row < rows.size(); ++row) {
+            if (best == rows.size() || rows.timestamps[row] > rows.timestamps[best]) {
+                best = row;
+            }
+        }
+        if (best < rows.size() && (!latest || rows.timestamps[best] > latest->timestamp)) {
+            latest = rows.toLocationInfo(best);
+        }
+    };
+    takeLatestRow(memoryRows);
+    
+    // 打开段文件只读取文件尾中的块索引，找出最大时间戳最大的段
+    std::string newestFile;
+    long long newestTimestamp = latest ? latest->timestamp : std::numeric_limits<long long>::min();
+    for (const auto& fileName : segmentFiles) {
+        SegmentReader reader;
+        if (!reader.open(fileName)) {
+            LOG_WARNING("Failed to open segment file: %s", fileName.c_str());
+            continue;
+        }
+        if (!reader.getBlocks().empty() && reader.getMaxTimestamp() > newestTimestamp) {
+            newestTimestamp = reader.getMaxTimestamp();
+            newestFile = fileName;
+        }
+    }
+    if (newestFile.empty()) {
+        return latest;
+    }
+    
+    // 只解码该段中最大时间戳最大的块
+    SegmentReader reader;
+    if (!reader.open(newestFile)) {
+        LOG_WARNING("Failed to reopen segment file: %s", newestFile.c_str());
+        return latest;
+    }
+    const std::vector<SegmentBlockInfo>& blocks = reader.getBlocks();
+    size_t newestBlock = 0;
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        if (blocks[i].maxTimestamp > blocks[newestBlock].maxTimestamp) {
+            newestBlock = i;
+        }
+    }
+    LocationColumns rows;
+    if (!reader.readBlock(newestBlock, rows)) {
+        LOG_WARNING("Failed to decode block %zu of segment file: %s", newestBlock, newestFile.c_str());
+        return latest;
+    }
+    takeLatestRow(rows);
+    return latest;
+}
+
 // 获取存储的位置数据总数
 size_t FileStorage::getStoredCount() const {
     // 文件存储无法高效地获取总数量，这里返回-1表示不支持
@@ -617,8 +1231,20 @@ bool FileStorage::clearAll() {
             fileStream = nullptr;
         }
         
-        // 删除所有日志文件
+        // 关闭当前段文件并丢弃未写入的数据
+        segmentWriter.finish();
+        pendingBlock.clear();
+        if (wal) {
+            wal->reset();
+        }
+        if (timeIndex) {
+            timeIndex->clear();
+        }
+        
+        // 删除所有日志文件和段文件
         std::vector<std::string> logFiles = getLogFilesInDirectory(config.storagePath);
+        std::vector<std::string> segmentFiles = getSegmentFilesInDirectory(config.storagePath);
+        logFiles.insert(logFiles.end(), segmentFiles.begin(), segmentFiles.end());
         for (const auto& fileName : logFiles) {
             if (!std::filesystem::remove(fileName)) {
                 LOG_WARNING("Failed to delete log file: %s", fileName.c_str());
@@ -626,7 +1252,11 @@ bool FileStorage::clearAll() {
         }
         
         // 重新打开文件流
-        openFileStream();
+        if (compressionEnabled) {
+            openSegmentWriter();
+        } else {
+            openFileStream();
+        }
         
         LOG_INFO("File storage cleared");
         return true;
@@ -660,36 +1290,26 @@ std::string FileStorage::serializeLocation(const LocationInfo& location) {
 // 反序列化位置数据
 LocationInfo FileStorage::deserializeLocation(const std::string& data) {
     LocationInfo location;
-    
-    std::stringstream ss(data);
-    std::string token;
-    
-    // 解析基本字段
-    if (std::getline(ss, token, ',')) location.timestamp = std::stoll(token);
-    if (std::getline(ss, token, ',')) location.latitude = std::stod(token);
-    if (std::getline(ss, token, ',')) location.longitude = std::stod(token);
-    if (std::getline(ss, token, ',')) location.altitude = std::stod(token);
-    if (std::getline(ss, token, ',')) location.accuracy = std::stod(token);
-    if (std::getline(ss, token, ',')) location.sourceType = static_cast<DataSourceType>(std::stoi(token));
-    if (std::getline(ss, token, ',')) location.status = static_cast<LocationStatus>(std::stoi(token));
-    
-    // 解析额外信息
-    while (std::getline(ss, token, ',')) {
-        if (token.size() >= 3 && token[0] == '[' && token.back() == ']') {
-            // 提取键值对
-            std::string kv = token.substr(1, token.size() - 2);
-            size_t colonPos = kv.find(':');
-            if (colonPos != std::string::npos) {
-                std::string key = kv.substr(0, colonPos);
-                std::string value = kv.substr(colonPos + 1);
-                location.setExtra(key, value);
-            }
-        }
+    const char* reason = nullptr;
+    if (!LegacyLogParser::parseLine(data, location, &reason)) {
+        throw std::invalid_argument(reason);
     }
-    
     return location;
 }
 
+// 解析CSV日志中的一行
+bool FileStorage::parseLogLine(const std::string& line, LocationInfo& location) {
+    const char* reason = nullptr;
+    if (!LegacyLogParser::parseLine(line, location, &reason)) {
+        // 空行（如写入中断后留下的）直接跳过
+        if (!line.empty()) {
+            LOG_WARNING("Failed to parse location data: %s", reason);
+        }
+        return false;
+    }
+    return true;
+}
+
 // 获取目录下的所有日志文件
 std::vector<std::string> FileStorage::getLogFilesInDirectory(const std::string& directoryPath, bool sortByTime) {
     std::vector<std::string> logFiles;
@@ -728,6 +1348,815 @@ std::vector<std::string> FileStorage::getLogFilesInDirectory(const std::string&
     return logFiles;
 }
 
+// 设置是否以压缩段格式存储
+void FileStorage::setCompressionEnabled(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (isInitialized()) {
+        LOG_WARNING("Compression mode can only be changed before initialization");
+        return;
+    }
+    
+    compressionEnabled = enable;
+}
+
+// 设置每个压缩块的行数
+void FileStorage::setBlockRowCount(size_t rowCount) {
+    if (rowCount > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        blockRowCount = rowCount;
+        LOG_INFO("Segment block row count set to %zu", rowCount);
+    }
+}
+
+// 设置是否启用预写日志
+void FileStorage::setWalEnabled(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (isInitialized()) {
+        LOG_WARNING("WAL can only be enabled before initialization");
+        return;
+    }
+    
+    walEnabled = enable;
+}
+
+// 获取变更订阅源
+std::shared_ptr<ChangeFeed> FileStorage::getChangeFeed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return changeFeed;
+}
+
+// 设置为离线订阅者额外保留的预写日志字节数
+void FileStorage::setChangeRetentionBytes(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    changeRetentionBytes = bytes;
+    if (changeFeed) {
+        changeFeed->setRetentionBytes(bytes);
+    }
+}
+
+// 从预写日志恢复尚未写入段文件的数据
+bool FileStorage::recoverFromWal() {
+    try {
+        wal = std::make_unique<WriteAheadLog>();
+        
+        WalCheckpoint lastCheckpoint;
+        if (!wal->open(config.storagePath + "/wal", &lastCheckpoint)) {
+            wal.reset();
+            return false;
+        }
+        changeFeed = std::make_shared<ChangeFeed>(wal->getDirectory(), wal->getEndLsn());
+        changeFeed->setRetentionBytes(changeRetentionBytes);
+        
+        // 检查点记录了当时的段文件和块数，之后写入段文件的块在日志中也有，需要跳过
+        size_t skipRows = 0;
+        size_t separator = lastCheckpoint.meta.find('\n');
+        if (separator != std::string::npos) {
+            std::string checkpointSegment = lastCheckpoint.meta.substr(0, separator);
+            size_t checkpointBlocks = std::stoul(lastCheckpoint.meta.substr(separator + 1));
+            
+            bool afterCheckpoint = false;
+            for (const auto& fileName : getSegmentFilesInDirectory(config.storagePath)) {
+                // 只有实时写入的段文件（locations_<创建时间>）包含日志中的数据，压实和批量导入的段文件按数据时间命名，不参与计数
+                std::string stem = std::filesystem::path(fileName).stem().string().substr(std::strlen("locations_"));
+                if (stem.empty() || stem.find_first_not_of("0123456789") != std::string::npos) {
+                    continue;
+                }
+                
+                bool isCheckpointSegment = std::filesystem::path(fileName).filename() == checkpointSegment;
+                if (!isCheckpointSegment && !afterCheckpoint) {
+                    continue;
+                }
+                
+                SegmentReader reader;
+                if (reader.open(fileName)) {
+                    const auto& blocks = reader.getBlocks();
+                    for (size_t i = isCheckpointSegment ? checkpointBlocks : 0; i < blocks.size(); ++i) {
+                        skipRows += blocks[i].rowCount;
+                    }
+                }
+                afterCheckpoint = true;
+            }
+        }
+        
+        // 只重放检查点之后的日志
+        size_t replayedCount = 0;
+        bool ok = wal->replay(lastCheckpoint.lsn, [&](uint64_t, const LocationColumns& rows) {
+            for (size_t row = 0; row < rows.size(); ++row) {
+                if (skipRows > 0) {
+                    --skipRows;
+                    continue;
+                }
+                pendingBlock.appendRow(rows, row);
+                replayedCount++;
+            }
+        });
+        if (!ok) {
+            LOG_WARNING("WAL replay stopped early, some recent locations may be lost");
+        }
+        
+        // 恢复的数据立即写入段文件，并以当前日志末尾作为新的检查点
+        flushPendingBlock();
+        writeCheckpoint();
+        
+        LOG_INFO("File storage recovered %zu locations from WAL", replayedCount);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to recover file storage from WAL: %s", e.what());
+        changeFeed.reset();
+        wal.reset();
+        return false;
+    }
+}
+
+// 记录检查点
+void FileStorage::writeCheckpoint() {
+    if (!pendingBlock.empty()) {
+        return;
+    }
+    
+    WalCheckpoint newCheckpoint;
+    newCheckpoint.lsn = wal->getEndLsn();
+    newCheckpoint.meta = std::filesystem::path(segmentWriter.getPath()).filename().string() + "\n" +
+                         std::to_string(segmentWriter.getBlockCount());
+    
+    // 检查点之前的日志会被截断，段文件中的块（以及切换后新段文件的文件名）必须先落盘
+    if (segmentWriter.isOpen() && !segmentWriter.sync()) {
+        LOG_WARNING("Segment not synced, keeping WAL before LSN %llu",
+                    static_cast<unsigned long long>(newCheckpoint.lsn));
+        return;
+    }
+    
+    if (wal->writeCheckpoint(newCheckpoint)) {
+        // 变更订阅者尚未读取的日志继续保留
+        changeFeed->truncateLog(*wal, newCheckpoint.lsn);
+    }
+}
+
+// 截断CSV日志文件末尾不完整的行
+void FileStorage::truncateTornLine(const std::string& fileName) {
+    try {
+        std::ifstream file(fileName, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        
+        // 只读取文件末尾，查找最后一个换行符
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        std::streamoff position = size;
+        const std::streamoff chunkSize = 4096;
+        std::string chunk;
+        while (position > 0) {
+            std::streamoff readSize = std::min(chunkSize, position);
+            position -= readSize;
+            chunk.resize(static_cast<size_t>(readSize));
+            file.seekg(position);
+            file.read(&chunk[0], readSize);
+            
+            size_t newline = chunk.rfind('\n');
+            if (newline != std::string::npos) {
+                position += static_cast<std::streamoff>(newline) + 1;
+                break;
+            }
+        }
+        file.close();
+        
+        if (position < size) {
+            LOG_WARNING("Truncating torn line at end of %s (%lld bytes)", 
+                       fileName.c_str(), static_cast<long long>(size - position));
+            std::filesystem::resize_file(fileName, static_cast<uintmax_t>(position));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARNING("Failed to repair log file %s: %s", fileName.c_str(), e.what());
+    }
+}
+
+// 启用分级保留策略
+bool FileStorage::enableRetention(const RetentionConfig& retentionConfig) {
+    if (!isInitialized()) {
+        LOG_WARNING("Retention can only be enabled after initialization");
+        return false;
+    }
+    
+    if (!compressionEnabled) {
+        LOG_WARNING("Retention requires compressed segment storage");
+        return false;
+    }
+    
+    if (retentionManager) {
+        retentionManager->setConfig(retentionConfig);
+        return true;
+    }
+    
+    retentionManager = std::make_unique<RetentionManager>(config.storagePath, retentionConfig);
+    retentionManager->setActiveSegmentProvider([this]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segmentWriter.isOpen() ? segmentWriter.getPath() : std::string();
+    });
+    return retentionManager->start();
+}
+
+// 创建新的段文件
+void FileStorage::openSegmentWriter() {
+    segmentWriter.finish();
+    
+    long long currentTime = LocationInfo::getCurrentTimestampMs();
+    std::string fileName = config.storagePath + "/locations_" + std::to_string(currentTime) + SEGMENT_FILE_EXTENSION;
+    
+    if (!segmentWriter.open(fileName)) {
+        LOG_ERROR("Failed to open segment file: %s", fileName.c_str());
+        return;
+    }
+    
+    segmentOpenTime = currentTime;
+    LOG_INFO("Segment file opened: %s", fileName.c_str());
+}
+
+// 检查并切换段文件
+void FileStorage::checkAndRotateSegment() {
+    long long currentTime = LocationInfo::getCurrentTimestampMs();
+    
+    if (!segmentWriter.isOpen() ||
+        currentTime - segmentOpenTime >= rotationInterval ||
+        segmentWriter.getBytesWritten() >= maxFileSize) {
+        openSegmentWriter();
+    }
+}
+
+// 将待写入数据编码为一个块写入段文件
+void FileStorage::flushPendingBlock() {
+    if (pendingBlock.empty()) {
+        return;
+    }
+    
+    checkAndRotateSegment();
+    
+    if (!segmentWriter.appendBlock(pendingBlock)) {
+        LOG_ERROR("Failed to write %zu locations to segment", pendingBlock.size());
+        return;
+    }
+    
+    pendingBlock.clear();
+    
+    // 待写入数据已全部进入段文件，之前的日志不再需要
+    if (wal) {
+        writeCheckpoint();
+    }
+}
+
+// 以压缩格式存储单个位置数据
+bool FileStorage::storeCompressed(const LocationInfo& location) {
+    try {
+        if (wal) {
+            LocationColumns rows;
+            rows.append(location);
+            uint64_t endLsn = wal->append(rows);
+            if (!endLsn) {
+                return false;
+            }
+            changeFeed->publish(endLsn);
+        }
+        
+        if (pendingBlock.empty()) {
+            pendingBlock.reserve(blockRowCount);
+        }
+        pendingBlock.append(location);
+        
+        if (pendingBlock.size() >= blockRowCount) {
+            flushPendingBlock();
+        }
+        FlightRecorder::getInstance().record(FlightEventType::STORED, location, 1.0f);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to store location to segment: %s", e.what());
+        return false;
+    }
+}
+
+// 获取目录下的所有段文件
+std::vector<std::string> FileStorage::getSegmentFilesInDirectory(const std::string& directoryPath) {
+    std::vector<std::string> segmentFiles;
+    
+    try {
+        if (!std::filesystem::exists(directoryPath)) {
+            return segmentFiles;
+        }
+        
+        for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) {
+            if (entry.is_regular_file() &&
+                entry.path().filename().string().rfind("locations_", 0) == 0 &&
+                entry.path().extension() == SEGMENT_FILE_EXTENSION) {
+                segmentFiles.push_back(entry.path().string());
+            }
+        }
+        
+        // 文件名中的时间戳即创建时间，排序后按时间先后遍历
+        std::sort(segmentFiles.begin(), segmentFiles.end());
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to get segment files in directory: %s", e.what());
+    }
+    
+    return segmentFiles;
+}
+
+// TieredStorage构造函数
+TieredStorage::TieredStorage() : 
+    DataStorage(),
+    hotMemoryBudget(64 * 1024 * 1024), // 默认热层预算64MB
+    hotMemoryUsage(0),
+    coldMaxTimestamp(std::numeric_limits<long long>::min()),
+    coldStorage(std::make_shared<FileStorage>()),
+    demotingRows(0),
+    demotedSeq(0),
+    demoteGeneration(0),
+    demoteRunning(false)
+{
+    // 冷层使用压缩段格式，查询时可根据段索引剪枝
+    coldStorage->setCompressionEnabled(true);
+}
+
+// TieredStorage析构函数
+TieredStorage::~TieredStorage() {
+    if (isInitialized()) {
+        close();
+    }
+}
+
+// 初始化分层存储
+bool TieredStorage::initialize(const StorageConfig& config) {
+    if (!DataStorage::initialize(config)) {
+        return false;
+    }
+    
+    if (!coldStorage->initialize(config)) {
+        LOG_ERROR("Failed to initialize cold tier storage");
+        DataStorage::close();
+        return false;
+    }
+    
+    // 冷层中已有的最新数据决定哪些查询需要访问磁盘
+    std::optional<LocationInfo> latest = coldStorage->getLatestLocation();
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        coldMaxTimestamp = latest ? latest->timestamp : std::numeric_limits<long long>::min();
+        demoteRunning = true;
+    }
+    demoteThread = std::thread(&TieredStorage::demoteLoop, this);
+    
+    LOG_INFO("Tiered storage initialized, hot tier budget: %zu bytes", hotMemoryBudget);
+    return true;
+}
+
+// 关闭分层存储
+bool TieredStorage::close() {
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        demoteRunning = false;
+    }
+    demoteCondition.notify_all();
+    if (demoteThread.joinable()) {
+        demoteThread.join();
+    }
+    
+    // 热层数据全部写入冷层后再关闭
+    bool ok = !isInitialized() || demoteTo(0);
+    ok = coldStorage->close() && ok;
+    
+    LOG_INFO("Tiered storage closed");
+    return DataStorage::close() && ok;
+}
+
+// 估算单条位置数据的内存占用
+size_t TieredStorage::estimateMemoryUsage(const LocationInfo& location) {
+    // 额外信息按键值长度加上红黑树节点和两个字符串对象的开销估算
+    size_t bytes = sizeof(LocationInfo);
+    for (const auto& [key, value] : location.getExtras()) {
+        bytes += key.size() + value.size() + 2 * sizeof(std::string) + 32;
+    }
+    return bytes;
+}
+
+// 将单条数据追加到热层
+void TieredStorage::appendHot(const LocationInfo& location) {
+    hotLocations.push_back(location);
+    hotMemoryUsage += estimateMemoryUsage(location);
+}
+
+// 存储单个位置数据
+bool TieredStorage::store(const LocationInfo& location) {
+    if (!isInitialized() || !isEnabled()) {
+        return false;
+    }
+    
+    bool overBudget = false;
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        appendHot(location);
+        overBudget = hotMemoryUsage > hotMemoryBudget;
+    }
+    
+    if (overBudget) {
+        demoteCondition.notify_one();
+    }
+    return true;
+}
+
+// 批量存储位置数据
+bool TieredStorage::batchStore(const std::vector<LocationInfo>& locations) {
+    if (!isInitialized() || !isEnabled()) {
+        return false;
+    }
+    
+    bool overBudget = false;
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        for (const auto& location : locations) {
+            appendHot(location);
+        }
+        overBudget = hotMemoryUsage > hotMemoryBudget;
+    }
+    
+    if (overBudget) {
+        demoteCondition.notify_one();
+    }
+    return true;
+}
+
+// 后台降级线程主循环
+void TieredStorage::demoteLoop() {
+    while (true) {
+        size_t target = 0;
+        {
+            std::unique_lock<std::mutex> lock(hotMutex);
+            demoteCondition.wait(lock, [this] { return !demoteRunning || hotMemoryUsage > hotMemoryBudget; });
+            if (!demoteRunning) {
+                return;
+            }
+            // 降到预算的3/4，避免每条新数据都触发一次降级
+            target = hotMemoryBudget / 4 * 3;
+        }
+        
+        if (!demoteTo(target)) {
+            // 冷层写入失败时稍后重试，数据仍保留在热层
+            std::unique_lock<std::mutex> lock(hotMutex);
+            demoteCondition.wait_for(lock, std::chrono::seconds(1), [this] { return !demoteRunning; });
+        }
+    }
+}
+
+// 将最早的热层数据降级到冷层
+bool TieredStorage::demoteTo(size_t targetBytes) {
+    // 只与清空互斥；写入冷层期间不阻塞查询（同一时刻只有一个降级者：后台线程或close）
+    std::shared_lock<std::shared_mutex> tierLock(tierMutex);
+    
+    std::vector<LocationInfo> batch;
+    size_t batchBytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        size_t usage = hotMemoryUsage;
+        for (const auto& location : hotLocations) {
+            if (usage <= targetBytes) {
+                break;
+            }
+            size_t bytes = estimateMemoryUsage(location);
+            usage -= bytes;
+            batchBytes += bytes;
+            batch.push_back(location);
+        }
+        if (batch.empty()) {
+            return true;
+        }
+        demotingRows = batch.size();
+        demoteGeneration++;
+    }
+    
+    bool ok = coldStorage->batchStore(batch);
+    if (!ok) {
+        LOG_ERROR("Failed to demote %zu locations to cold tier", batch.size());
+    }
+    
+    // 降级期间只有本线程从头部移出数据，新数据只会追加到尾部
+    long long maxTimestamp = std::numeric_limits<long long>::min();
+    for (const auto& location : batch) {
+        maxTimestamp = std::max(maxTimestamp, location.timestamp);
+    }
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        demotingRows = 0;
+        if (ok) {
+            hotLocations.erase(hotLocations.begin(), hotLocations.begin() + batch.size());
+            hotMemoryUsage -= batchBytes;
+            demotedSeq += batch.size();
+            coldMaxTimestamp = std::max(coldMaxTimestamp, maxTimestamp);
+            stats.demotedRows += batch.size();
+        }
+    }
+    demoteFinished.notify_all();
+    
+    if (ok) {
+        LOG_DEBUG("Demoted %zu locations to cold tier", batch.size());
+    }
+    return ok;
+}
+
+// 从热层结果中去掉冷层结果里已有的数据
+// 查询开始后才写入冷层、或查询期间正在写入冷层的数据可能同时出现在两层的结果中，按（时间戳, 设备, 数据源）匹配后保留冷层的一份
+void TieredStorage::dropDemotedRows(std::vector<std::pair<uint64_t, LocationInfo>>& hotRows, uint64_t ambiguousEnd,
+                                    const std::vector<LocationInfo>& coldRows) {
+    long long minTimestamp = std::numeric_limits<long long>::max();
+    long long maxTimestamp = std::numeric_limits<long long>::min();
+    for (const auto& [seq, location] : hotRows) {
+        if (seq < ambiguousEnd) {
+            minTimestamp = std::min(minTimestamp, location.timestamp);
+            maxTimestamp = std::max(maxTimestamp, location.timestamp);
+        }
+    }
+    if (minTimestamp > maxTimestamp) {
+        return;
+    }
+    
+    std::map<std::tuple<long long, std::string, DataSourceType>, size_t> coldKeys;
+    for (const auto& location : coldRows) {
+        if (location.timestamp >= minTimestamp && location.timestamp <= maxTimestamp) {
+            coldKeys[std::make_tuple(location.timestamp, getDeviceIdOf(location), location.sourceType)]++;
+        }
+    }
+    
+    hotRows.erase(std::remove_if(hotRows.begin(), hotRows.end(), [&](const std::pair<uint64_t, LocationInfo>& row) {
+        if (row.first >= ambiguousEnd) {
+            return false;
+        }
+        auto it = coldKeys.find(std::make_tuple(row.second.timestamp, getDeviceIdOf(row.second), row.second.sourceType));
+        if (it == coldKeys.end() || it->second == 0) {
+            return false;
+        }
+        it->second--;
+        return true;
+    }), hotRows.end());
+}
+
+// 按条件查询两层数据
+std::vector<LocationInfo> TieredStorage::query(const QueryPredicate& predicate, QueryStats* queryStats) {
+    if (!isInitialized() || !isEnabled()) {
+        return {};
+    }
+    
+    try {
+        std::shared_lock<std::shared_mutex> tierLock(tierMutex);
+        
+        // 热层结果带序号，用于和冷层结果去重
+        std::vector<std::pair<uint64_t, LocationInfo>> hotRows;
+        long long coldMax = std::numeric_limits<long long>::min();
+        size_t hotScanned = 0;
+        {
+            std::lock_guard<std::mutex> lock(hotMutex);
+            hotScanned = hotLocations.size();
+            for (size_t i = 0; i < hotLocations.size(); ++i) {
+                if (predicate.matches(hotLocations[i])) {
+                    hotRows.emplace_back(demotedSeq + i, hotLocations[i]);
+                }
+            }
+            coldMax = coldMaxTimestamp;
+        }
+        
+        auto before = [&predicate](const LocationInfo& a, const LocationInfo& b) {
+            return predicate.latestFirst ? a.timestamp > b.timestamp : a.timestamp < b.timestamp;
+        };
+        std::stable_sort(hotRows.begin(), hotRows.end(),
+                         [&before](const std::pair<uint64_t, LocationInfo>& a, const std::pair<uint64_t, LocationInfo>& b) {
+                             return before(a.second, b.second);
+                         });
+        
+        // 查询范围晚于冷层最新数据，或热层已有足够多比冷层更新的数据时，不访问冷层
+        // （正在降级的数据仍在热层中，coldMax只包含已完成降级的数据）
+        bool needCold = coldMax != std::numeric_limits<long long>::min() && predicate.startTime <= coldMax;
+        if (needCold && predicate.limit > 0 && predicate.latestFirst && hotRows.size() >= predicate.limit &&
+            hotRows[predicate.limit - 1].second.timestamp > coldMax) {
+            needCold = false;
+        }
+        
+        std::vector<LocationInfo> coldRows;
+        if (needCold) {
+            coldRows = coldStorage->query(predicate, queryStats);
+            
+            // 读取热层之后开始或仍在进行的降级可能已把热层结果中的数据写入冷层
+            uint64_t ambiguousEnd = 0;
+            {
+                std::lock_guard<std::mutex> lock(hotMutex);
+                ambiguousEnd = demotedSeq + demotingRows;
+            }
+            dropDemotedRows(hotRows, ambiguousEnd, coldRows);
+        } else if (queryStats) {
+            *queryStats = QueryStats();
+            queryStats->rowsScanned = hotScanned;
+        }
+        
+        std::vector<LocationInfo> hotResult;
+        hotResult.reserve(hotRows.size());
+        for (auto& row : hotRows) {
+            hotResult.push_back(std::move(row.second));
+        }
+        std::vector<LocationInfo> result;
+        result.reserve(coldRows.size() + hotResult.size());
+        std::merge(std::make_move_iterator(coldRows.begin()), std::make_move_iterator(coldRows.end()),
+                   std::make_move_iterator(hotResult.begin()), std::make_move_iterator(hotResult.end()),
+                   std::back_inserter(result), before);
+        
+        if (predicate.limit > 0 && result.size() > predicate.limit) {
+            result.resize(predicate.limit);
+        }
+        if (queryStats) {
+            queryStats->rowsMatched = result.size();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(hotMutex);
+            if (needCold) {
+                stats.coldQueries++;
+            } else {
+                stats.hotOnlyQueries++;
+            }
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to query tiered storage: %s", e.what());
+        return {};
+    }
+}
+
+// 根据时间范围查询位置数据
+std::vector<LocationInfo> TieredStorage::queryByTimeRange(long long startTime, long long endTime) {
+    QueryPredicate predicate;
+    predicate.startTime = startTime;
+    predicate.endTime = endTime;
+    return query(predicate);
+}
+
+// 根据数据源类型查询位置数据
+std::vector<LocationInfo> TieredStorage::queryByDataSource(DataSourceType sourceType) {
+    QueryPredicate predicate;
+    predicate.sourceType = sourceType;
+    return query(predicate);
+}
+
+// 获取最新的位置数据
+std::optional<LocationInfo> TieredStorage::getLatestLocation() {
+    QueryPredicate predicate;
+    predicate.limit = 1;
+    predicate.latestFirst = true;
+    
+    std::vector<LocationInfo> result = query(predicate);
+    if (result.empty()) {
+        return std::nullopt;
+    }
+    return result.front();
+}
+
+// 获取存储的位置数据总数
+size_t TieredStorage::getStoredCount() const {
+    std::shared_lock<std::shared_mutex> tierLock(tierMutex);
+    size_t hotCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        hotCount = hotLocations.size();
+    }
+    
+    // 冷层不支持统计总数时同样返回-1
+    size_t coldCount = coldStorage->getStoredCount();
+    if (coldCount == static_cast<size_t>(-1)) {
+        return coldCount;
+    }
+    return hotCount + coldCount;
+}
+
+// 清空存储的数据
+bool TieredStorage::clearAll() {
+    if (!isInitialized() || !isEnabled()) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> tierLock(tierMutex);
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        hotLocations.clear();
+        hotMemoryUsage = 0;
+        coldMaxTimestamp = std::numeric_limits<long long>::min();
+    }
+    
+    LOG_INFO("Tiered storage cleared");
+    return coldStorage->clearAll();
+}
+
+// 打开流式查询游标
+std::unique_ptr<LocationCursor> TieredStorage::openCursor(const QueryPredicate& predicate, uint32_t columnMask,
+                                                          size_t batchSize) {
+    if (!isInitialized() || !isEnabled()) {
+        return std::make_unique<LocationCursor>(std::vector<std::string>(), predicate, columnMask, batchSize);
+    }
+    
+    std::shared_lock<std::shared_mutex> tierLock(tierMutex);
+    
+    // 游标按行流式读取，无法像query那样事后去重：读取热层到打开冷层游标之间若开始了新的降级，
+    // 等这批降级结束后重新读取（打开游标只读取段索引，很少与降级重叠）
+    while (true) {
+        // 热层中满足条件的数据作为内存来源加入冷层游标
+        auto hotRows = std::make_shared<LocationColumns>();
+        long long coldMax = std::numeric_limits<long long>::min();
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(hotMutex);
+            demoteFinished.wait(lock, [this] { return demotingRows == 0; });
+            for (const auto& location : hotLocations) {
+                if (predicate.matches(location)) {
+                    hotRows->append(location);
+                }
+            }
+            coldMax = coldMaxTimestamp;
+            generation = demoteGeneration;
+        }
+        
+        std::unique_ptr<LocationCursor> cursor;
+        if (coldMax != std::numeric_limits<long long>::min() && predicate.startTime <= coldMax) {
+            cursor = coldStorage->openCursor(predicate, columnMask, batchSize);
+        } else {
+            cursor = std::make_unique<LocationCursor>(std::vector<std::string>(), predicate, columnMask, batchSize);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(hotMutex);
+            if (demoteGeneration != generation) {
+                continue;
+            }
+        }
+        cursor->addMemoryRows(hotRows);
+        return cursor;
+    }
+}
+
+// 查找设备在指定时刻前后最近的定位点
+bool TieredStorage::findBracketingFixes(const std::string& deviceId, long long timestamp, long long maxDistanceMs,
+                                        std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) {
+    if (!isInitialized() || !isEnabled()) {
+        return false;
+    }
+    
+    long long startTime = 0;
+    long long endTime = 0;
+    searchWindow(timestamp, maxDistanceMs, startTime, endTime);
+    
+    std::shared_lock<std::shared_mutex> tierLock(tierMutex);
+    
+    long long coldMax = std::numeric_limits<long long>::min();
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        for (const auto& location : hotLocations) {
+            if (location.timestamp >= startTime && location.timestamp <= endTime &&
+                getDeviceIdOf(location) == deviceId) {
+                updateBracket(location, timestamp, before, after);
+            }
+        }
+        coldMax = coldMaxTimestamp;
+    }
+    
+    // 冷层中没有落在查询窗口内的数据时跳过（降级期间同一条数据可能在两层中各找到一次，不影响结果）
+    if (coldMax == std::numeric_limits<long long>::min() || startTime > coldMax) {
+        return true;
+    }
+    return coldStorage->findBracketingFixes(deviceId, timestamp, maxDistanceMs, before, after);
+}
+
+// 设置热层内存预算
+void TieredStorage::setHotMemoryBudget(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(hotMutex);
+        hotMemoryBudget = bytes;
+    }
+    demoteCondition.notify_one();
+    LOG_INFO("Tiered storage hot tier budget set to %zu bytes", bytes);
+}
+
+// 获取热层内存预算
+size_t TieredStorage::getHotMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(hotMutex);
+    return hotMemoryBudget;
+}
+
+// 获取统计
+TieredStorageStats TieredStorage::getStats() const {
+    std::lock_guard<std::mutex> lock(hotMutex);
+    TieredStorageStats result = stats;
+    result.hotRows = hotLocations.size();
+    result.hotMemoryBytes = hotMemoryUsage;
+    return result;
+}
+
 // StorageManager构造函数
 StorageManager::StorageManager() : 
     defaultStorage(nullptr),
@@ -762,13 +2191,19 @@ bool StorageManager::registerStorage(const std::string& name, std::shared_ptr<Da
         defaultStorage = storage;
     }
     
+    // 分发模式下新存储从当前位置开始接收数据
+    if (tee) {
+        auto configIt = teeConfigs.find(name);
+        tee->addBackend(name, storage, configIt != teeConfigs.end() ? configIt->second : TeeBackendConfig());
+    }
+    
     LOG_INFO("Storage '%s' registered successfully", name.c_str());
     return true;
 }
 
 // 注销存储实现
 bool StorageManager::unregisterStorage(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_lock<std::mutex> lock(mutex);
     
     auto it = namedStorages.find(name);
     if (it == namedStorages.end()) {
@@ -776,6 +2211,18 @@ bool StorageManager::unregisterStorage(const std::string& name) {
         return false;
     }
     
+    // 先停止该存储的写入线程（等待积压数据写完，期间不持有锁）
+    if (std::shared_ptr<StorageTee> currentTee = tee) {
+        lock.unlock();
+        currentTee->removeBackend(name);
+        lock.lock();
+        
+        it = namedStorages.find(name);
+        if (it == namedStorages.end()) {
+            return false;
+        }
+    }
+    
     // 如果是默认存储，取消默认设置
     if (it->second == defaultStorage) {
         defaultStorage = nullptr;
@@ -834,4 +2281,125 @@ std::vector<std::string> StorageManager::getRegisteredStorages() {
     }
     
     return names;
-}
\ No newline at end of file
+}
+
+// 保存位置数据到所有存储
+bool StorageManager::saveLocationToAll(const LocationInfo& location) {
+    std::vector<std::shared_ptr<DataStorage>> storages;
+    std::shared_ptr<StorageTee> currentTee;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTee = tee;
+        if (!currentTee) {
+            for (const auto& [name, storage] : namedStorages) {
+                storages.push_back(storage);
+            }
+        }
+    }
+    
+    // 分发模式下只入队一次，由各存储的写入线程异步写入
+    if (currentTee) {
+        return currentTee->publish(location);
+    }
+    
+    bool success = true;
+    for (const auto& storage : storages) {
+        success = storage->store(location) && success;
+    }
+    return success;
+}
+
+// 批量保存位置数据到所有存储
+bool StorageManager::saveLocationsToAll(const std::vector<LocationInfo>& locations) {
+    std::vector<std::shared_ptr<DataStorage>> storages;
+    std::shared_ptr<StorageTee> currentTee;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTee = tee;
+        if (!currentTee) {
+            for (const auto& [name, storage] : namedStorages) {
+                storages.push_back(storage);
+            }
+        }
+    }
+    
+    if (currentTee) {
+        return currentTee->publish(locations);
+    }
+    
+    bool success = true;
+    for (const auto& storage : storages) {
+        success = storage->batchStore(locations) && success;
+    }
+    return success;
+}
+
+// 启用分发模式
+bool StorageManager::enableTeeMode(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (tee) {
+        LOG_WARNING("Storage tee mode already enabled");
+        return true;
+    }
+    
+    try {
+        tee = std::make_shared<StorageTee>(capacity);
+        for (const auto& [name, storage] : namedStorages) {
+            auto configIt = teeConfigs.find(name);
+            tee->addBackend(name, storage, configIt != teeConfigs.end() ? configIt->second : TeeBackendConfig());
+        }
+        
+        LOG_INFO("Storage tee mode enabled with %zu backends (capacity %zu)", namedStorages.size(), capacity);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to enable storage tee mode: %s", e.what());
+        tee.reset();
+        return false;
+    }
+}
+
+// 关闭分发模式
+void StorageManager::disableTeeMode() {
+    std::shared_ptr<StorageTee> currentTee;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTee.swap(tee);
+    }
+    
+    if (currentTee) {
+        currentTee->shutdown();
+        LOG_INFO("Storage tee mode disabled");
+    }
+}
+
+// 检查是否已启用分发模式
+bool StorageManager::isTeeModeEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tee != nullptr;
+}
+
+// 设置存储的分发配置
+void StorageManager::setTeeBackendConfig(const std::string& storageName, const TeeBackendConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    teeConfigs[storageName] = config;
+}
+
+// 等待所有存储写完已入队的数据
+void StorageManager::flushTee() {
+    std::shared_ptr<StorageTee> currentTee;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTee = tee;
+    }
+    
+    if (currentTee) {
+        currentTee->flush();
+    }
+}
+
+// 获取存储的分发统计
+bool StorageManager::getTeeStats(const std::string& storageName, TeeBackendStats& stats) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tee && tee->getStats(storageName, stats);
+}
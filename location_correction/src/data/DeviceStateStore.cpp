@@ -0,0 +1,482 @@
+// DeviceStateStore.cpp - 设备算法状态存储与检查点实现
+
+#include "DeviceStateStore.h"
+#include "LocationCodec.h"
+#include "WriteAheadLog.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 设备状态检查点文件扩展名
+const char* const DEVICE_STATE_FILE_EXTENSION = ".state";
+
+namespace {
+
+// 检查点文件魔数
+const char CHECKPOINT_MAGIC[8] = {'L', 'C', 'S', 'T', 'A', 'T', 'E', '1'};
+
+// 检查点格式版本
+const uint32_t CHECKPOINT_VERSION = 1;
+
+// 检查点文件头（状态数组紧随其后）
+struct CheckpointHeader {
+    char magic[8];          // 魔数
+    uint32_t version;       // 格式版本
+    uint32_t recordSize;    // 单个状态的大小
+    uint64_t deviceCount;   // 设备数
+    int64_t createdTime;    // 写入时间（毫秒）
+    uint64_t indexOffset;   // 设备ID索引偏移
+    uint64_t stringsOffset; // 设备ID字符串区偏移
+    uint64_t stringsSize;   // 设备ID字符串区大小
+    uint32_t bodyCrc;       // 文件头之后所有内容的CRC32C
+    uint32_t headerCrc;     // 文件头（不含本字段）的CRC32C
+};
+
+static_assert(sizeof(CheckpointHeader) == 64, "unexpected checkpoint header size");
+static_assert(sizeof(CheckpointHeader) % alignof(DeviceState) == 0, "state array must stay aligned");
+
+// 设备ID索引项，与状态数组一一对应
+struct CheckpointIndexEntry {
+    uint64_t offset;   // 在字符串区中的偏移
+    uint32_t length;   // 设备ID长度
+    uint32_t reserved; // 保留
+};
+
+// 获取当前时间（毫秒）
+long long nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 写入数据并累计校验值
+bool writeChecked(std::FILE* file, const void* data, size_t size, uint32_t& crc) {
+    crc = WriteAheadLog::crc32c(static_cast<const uint8_t*>(data), size, crc);
+    return std::fwrite(data, 1, size, file) == size;
+}
+
+} // namespace
+
+// 已加载的检查点文件
+struct DeviceStateStore::Mapping {
+    uint8_t* data;                // 文件内容
+    size_t size;                  // 文件大小
+    std::vector<uint64_t> buffer; // 不支持mmap时读入的文件内容
+
+    Mapping() : data(nullptr), size(0) {}
+
+    ~Mapping() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data && buffer.empty()) {
+            munmap(data, size);
+        }
+#endif
+    }
+
+    // 以私有映射（写时复制）打开文件
+    bool open(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            size = 0;
+            return false;
+        }
+        // 加载时会顺序校验整个文件
+        madvise(address, size, MADV_WILLNEED);
+        data = static_cast<uint8_t*>(address);
+        return true;
+#else
+        std::ifstream input(path, std::ios::binary | std::ios::ate);
+        if (!input.is_open()) {
+            return false;
+        }
+        size = static_cast<size_t>(input.tellg());
+        buffer.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        input.seekg(0);
+        data = reinterpret_cast<uint8_t*>(buffer.data());
+        return size > 0 && input.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size)).good();
+#endif
+    }
+};
+
+// DeviceStateStore构造函数
+DeviceStateStore::DeviceStateStore(size_t shardCount) :
+    checkpointStopping(false),
+    checkpointIntervalMs(0) {
+    shardCount = std::max<size_t>(1, shardCount);
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+// DeviceStateStore析构函数
+DeviceStateStore::~DeviceStateStore() {
+    stopCheckpointing();
+}
+
+// 获取设备所在的分片
+DeviceStateStore::Shard& DeviceStateStore::shardFor(const std::string& deviceId) const {
+    return *shards[std::hash<std::string>{}(deviceId) % shards.size()];
+}
+
+// 查找或创建设备状态
+DeviceState& DeviceStateStore::findOrCreate(Shard& shard, const std::string& deviceId) {
+    auto result = shard.states.try_emplace(deviceId, nullptr);
+    if (result.second) {
+        shard.owned.emplace_back();
+        result.first->second = &shard.owned.back();
+    }
+    return *result.first->second;
+}
+
+// 位置转换为状态点
+StatePoint DeviceStateStore::toStatePoint(const LocationInfo& location) {
+    StatePoint point;
+    std::memset(&point, 0, sizeof(point));
+    point.timestamp = location.timestamp;
+    point.latitude = location.latitude;
+    point.longitude = location.longitude;
+    point.altitude = static_cast<float>(location.altitude);
+    point.accuracy = static_cast<float>(location.accuracy);
+    point.speed = static_cast<float>(location.speed);
+    point.direction = static_cast<float>(location.direction);
+    point.sourceType = static_cast<uint8_t>(location.sourceType);
+    point.status = static_cast<uint8_t>(location.status);
+    return point;
+}
+
+// 状态点转换为位置
+LocationInfo DeviceStateStore::fromStatePoint(const StatePoint& point, const std::string& deviceId) {
+    LocationInfo location;
+    location.timestamp = point.timestamp;
+    location.latitude = point.latitude;
+    location.longitude = point.longitude;
+    location.altitude = point.altitude;
+    location.accuracy = point.accuracy;
+    location.speed = point.speed;
+    location.direction = point.direction;
+    location.sourceType = static_cast<DataSourceType>(point.sourceType);
+    location.status = static_cast<LocationStatus>(point.status);
+    if (!deviceId.empty()) {
+        location.setExtra(DEVICE_ID_EXTRA_KEY, deviceId);
+    }
+    return location;
+}
+
+// 记录设备的输入位置
+void DeviceStateStore::recordInput(const std::string& deviceId, const LocationInfo& location) {
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    DeviceState& state = findOrCreate(shard, deviceId);
+
+    StatePoint point = toStatePoint(location);
+    if (state.windowCount < DEVICE_STATE_WINDOW_SIZE) {
+        state.window[(state.windowStart + state.windowCount) % DEVICE_STATE_WINDOW_SIZE] = point;
+        state.windowCount++;
+    } else {
+        state.window[state.windowStart] = point;
+        state.windowStart = static_cast<uint32_t>((state.windowStart + 1) % DEVICE_STATE_WINDOW_SIZE);
+    }
+    state.updateTime = location.timestamp;
+}
+
+// 记录设备的纠偏输出和当前场景
+void DeviceStateStore::recordOutput(const std::string& deviceId, const LocationInfo& corrected,
+                                    int32_t scene, long long sceneCheckTime) {
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    DeviceState& state = findOrCreate(shard, deviceId);
+
+    state.lastOutput = toStatePoint(corrected);
+    state.scene = scene;
+    state.sceneCheckTime = sceneCheckTime;
+    state.flags |= DEVICE_STATE_HAS_OUTPUT;
+    state.updateTime = std::max<int64_t>(state.updateTime, corrected.timestamp);
+}
+
+// 获取设备状态
+bool DeviceStateStore::getState(const std::string& deviceId, DeviceState& state) const {
+    Shard& shard = shardFor(deviceId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.states.find(deviceId);
+    if (it == shard.states.end()) {
+        return false;
+    }
+    state = *it->second;
+    return true;
+}
+
+// 获取最近更新的设备状态
+bool DeviceStateStore::getLatestState(std::string& deviceId, DeviceState& state) const {
+    bool found = false;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& entry : shard->states) {
+            if (!found || entry.second->updateTime > state.updateTime) {
+                deviceId = entry.first;
+                state = *entry.second;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+// 获取设备检测窗口中的位置
+std::vector<LocationInfo> DeviceStateStore::getWindow(const std::string& deviceId) const {
+    DeviceState state;
+    std::vector<LocationInfo> window;
+    if (!getState(deviceId, state)) {
+        return window;
+    }
+    window.reserve(state.windowCount);
+    for (uint32_t i = 0; i < state.windowCount && i < DEVICE_STATE_WINDOW_SIZE; ++i) {
+        window.push_back(fromStatePoint(state.window[(state.windowStart + i) % DEVICE_STATE_WINDOW_SIZE], deviceId));
+    }
+    return window;
+}
+
+// 获取设备数
+size_t DeviceStateStore::getDeviceCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->states.size();
+    }
+    return count;
+}
+
+// 清空所有状态
+void DeviceStateStore::clear() {
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->states.clear();
+        shard->owned.clear();
+    }
+    mapping.reset();
+}
+
+// 将所有设备状态写入检查点文件
+bool DeviceStateStore::saveCheckpoint(const std::string& path, DeviceCheckpointStats* stats) {
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+    long long startTime = nowMs();
+    std::string tempPath = path + ".tmp";
+
+    std::FILE* output = std::fopen(tempPath.c_str(), "wb");
+    if (!output) {
+        LOG_ERROR("Failed to create device state checkpoint: %s", tempPath.c_str());
+        return false;
+    }
+    std::vector<char> fileBuffer(1 << 20);
+    std::setvbuf(output, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    bool ok = std::fwrite(&header, 1, sizeof(header), output) == sizeof(header);
+
+    // 逐个分片写入状态数组，同时收集设备ID；分片锁只在复制该分片期间持有
+    uint32_t crc = 0;
+    std::vector<CheckpointIndexEntry> index;
+    std::string strings;
+    for (auto& shard : shards) {
+        if (!ok) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        index.reserve(index.size() + shard->states.size());
+        for (const auto& entry : shard->states) {
+            CheckpointIndexEntry indexEntry;
+            indexEntry.offset = strings.size();
+            indexEntry.length = static_cast<uint32_t>(entry.first.size());
+            indexEntry.reserved = 0;
+            index.push_back(indexEntry);
+            strings += entry.first;
+            if (!writeChecked(output, entry.second, sizeof(DeviceState), crc)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    header.indexOffset = sizeof(header) + index.size() * sizeof(DeviceState);
+    header.stringsOffset = header.indexOffset + index.size() * sizeof(CheckpointIndexEntry);
+    header.stringsSize = strings.size();
+    ok = ok && writeChecked(output, index.data(), index.size() * sizeof(CheckpointIndexEntry), crc);
+    ok = ok && writeChecked(output, strings.data(), strings.size(), crc);
+
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.recordSize = sizeof(DeviceState);
+    header.deviceCount = index.size();
+    header.createdTime = nowMs();
+    header.bodyCrc = crc;
+    header.headerCrc = WriteAheadLog::crc32c(reinterpret_cast<const uint8_t*>(&header), offsetof(CheckpointHeader, headerCrc));
+
+    ok = ok && std::fseek(output, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(&header, 1, sizeof(header), output) == sizeof(header);
+    ok = ok && std::fflush(output) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+    ok = ok && fsync(fileno(output)) == 0;
+#endif
+    ok = std::fclose(output) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+    }
+    if (!ok || ec) {
+        LOG_ERROR("Failed to write device state checkpoint: %s", path.c_str());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    if (stats) {
+        stats->deviceCount = index.size();
+        stats->bytes = header.stringsOffset + header.stringsSize;
+        stats->elapsedMs = nowMs() - startTime;
+    }
+    LOG_INFO("Device state checkpoint written: %zu devices in %lld ms", index.size(), nowMs() - startTime);
+    return true;
+}
+
+// 从检查点文件恢复状态
+bool DeviceStateStore::loadCheckpoint(const std::string& path, DeviceCheckpointStats* stats) {
+    std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+    long long startTime = nowMs();
+
+    auto loaded = std::make_shared<Mapping>();
+    if (!loaded->open(path)) {
+        LOG_ERROR("Failed to open device state checkpoint: %s", path.c_str());
+        return false;
+    }
+
+    // 校验文件头和各区边界
+    CheckpointHeader header;
+    if (loaded->size < sizeof(header)) {
+        LOG_ERROR("Device state checkpoint is truncated: %s", path.c_str());
+        return false;
+    }
+    std::memcpy(&header, loaded->data, sizeof(header));
+    uint64_t recordsSize = header.deviceCount * sizeof(DeviceState);
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.headerCrc != WriteAheadLog::crc32c(loaded->data, offsetof(CheckpointHeader, headerCrc)) ||
+        header.version != CHECKPOINT_VERSION || header.recordSize != sizeof(DeviceState) ||
+        header.deviceCount > loaded->size / sizeof(DeviceState) ||
+        header.indexOffset != sizeof(header) + recordsSize ||
+        header.stringsOffset != header.indexOffset + header.deviceCount * sizeof(CheckpointIndexEntry) ||
+        header.stringsOffset > loaded->size || header.stringsSize != loaded->size - header.stringsOffset) {
+        LOG_ERROR("Invalid device state checkpoint header: %s", path.c_str());
+        return false;
+    }
+    if (WriteAheadLog::crc32c(loaded->data + sizeof(header), loaded->size - sizeof(header)) != header.bodyCrc) {
+        LOG_ERROR("Device state checkpoint checksum mismatch: %s", path.c_str());
+        return false;
+    }
+
+    // 状态数组原地使用，只为每个设备建立索引
+    auto* records = reinterpret_cast<DeviceState*>(loaded->data + sizeof(header));
+    const auto* index = reinterpret_cast<const CheckpointIndexEntry*>(loaded->data + header.indexOffset);
+    const char* strings = reinterpret_cast<const char*>(loaded->data + header.stringsOffset);
+
+    std::vector<std::unordered_map<std::string, DeviceState*>> states(shards.size());
+    for (auto& shardStates : states) {
+        shardStates.reserve(header.deviceCount / shards.size() + 1);
+    }
+    for (uint64_t i = 0; i < header.deviceCount; ++i) {
+        if (index[i].offset > header.stringsSize || index[i].length > header.stringsSize - index[i].offset) {
+            LOG_ERROR("Invalid device id entry %llu in checkpoint: %s", static_cast<unsigned long long>(i), path.c_str());
+            return false;
+        }
+        std::string deviceId(strings + index[i].offset, index[i].length);
+        size_t shardIndex = std::hash<std::string>{}(deviceId) % shards.size();
+        states[shardIndex].emplace(std::move(deviceId), &records[i]);
+    }
+
+    for (size_t i = 0; i < shards.size(); ++i) {
+        std::lock_guard<std::mutex> lock(shards[i]->mutex);
+        shards[i]->states.swap(states[i]);
+        shards[i]->owned.clear();
+    }
+    // 旧映射在所有分片切换后释放
+    mapping = loaded;
+
+    if (stats) {
+        stats->deviceCount = header.deviceCount;
+        stats->bytes = loaded->size;
+        stats->elapsedMs = nowMs() - startTime;
+    }
+    LOG_INFO("Device state checkpoint loaded: %llu devices in %lld ms",
+             static_cast<unsigned long long>(header.deviceCount), nowMs() - startTime);
+    return true;
+}
+
+// 启动定期检查点
+bool DeviceStateStore::startCheckpointing(const std::string& path, long long intervalMs) {
+    if (checkpointThread.joinable() || path.empty() || intervalMs <= 0) {
+        return false;
+    }
+    checkpointPath = path;
+    checkpointIntervalMs = intervalMs;
+    checkpointStopping = false;
+    checkpointThread = std::thread(&DeviceStateStore::checkpointLoop, this);
+    LOG_INFO("Device state checkpointing started: %s every %lld ms", path.c_str(), intervalMs);
+    return true;
+}
+
+// 停止定期检查点
+void DeviceStateStore::stopCheckpointing() {
+    if (!checkpointThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        checkpointStopping = true;
+    }
+    timerCondition.notify_all();
+    checkpointThread.join();
+
+    // 退出前写入最后一次检查点
+    saveCheckpoint(checkpointPath);
+}
+
+// 检查点线程主循环
+void DeviceStateStore::checkpointLoop() {
+    std::unique_lock<std::mutex> lock(timerMutex);
+    while (!checkpointStopping) {
+        if (timerCondition.wait_for(lock, std::chrono::milliseconds(checkpointIntervalMs),
+                                    [this] { return checkpointStopping; })) {
+            break;
+        }
+        lock.unlock();
+        try {
+            saveCheckpoint(checkpointPath);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Device state checkpoint failed: %s", e.what());
+        }
+        lock.lock();
+    }
+}
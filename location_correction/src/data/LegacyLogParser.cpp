@@ -0,0 +1,509 @@
+// LegacyLogParser.cpp - CSV位置日志（locations_*.log）高速解析实现
+
+#include "LegacyLogParser.h"
+#include "Logger.h"
+#include "Utils.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 基本字段数（时间戳、纬度、经度、海拔、精度、数据源类型、状态）
+const size_t BASE_FIELD_COUNT = 7;
+
+// 错误报告中保留的行内容最大长度
+const size_t MAX_ERROR_TEXT = 120;
+
+// 各基本字段解析失败时的原因
+const char* const FIELD_ERRORS[BASE_FIELD_COUNT] = {
+    "invalid timestamp",
+    "invalid latitude",
+    "invalid longitude",
+    "invalid altitude",
+    "invalid accuracy",
+    "invalid source type",
+    "invalid status"
+};
+
+// 只读映射的日志文件，不支持mmap时整体读入内存
+class MappedFile {
+private:
+    const char* data;            // 文件内容
+    size_t size;                 // 文件长度
+#if defined(__unix__) || defined(__APPLE__)
+    int fd;                      // 文件描述符
+#else
+    std::vector<char> buffer;    // 读入的文件内容
+#endif
+
+public:
+    MappedFile() : data(nullptr), size(0)
+#if defined(__unix__) || defined(__APPLE__)
+        , fd(-1)
+#endif
+    {}
+
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data) {
+            munmap(const_cast<char*>(data), size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 打开并映射文件
+    bool open(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size == 0) {
+            return true;
+        }
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            size = 0;
+            return false;
+        }
+        // 各线程顺序读取自己的分片
+        madvise(address, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(address);
+        return true;
+#else
+        std::ifstream input(path, std::ios::binary | std::ios::ate);
+        if (!input.is_open()) {
+            return false;
+        }
+        buffer.resize(static_cast<size_t>(input.tellg()));
+        input.seekg(0);
+        if (!input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+            return false;
+        }
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+#endif
+    }
+
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
+
+// 求最低位1的位置（mask不为0）
+inline unsigned countTrailingZeros(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned count = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// 分隔符扫描器
+// 每次处理64字节，得到逗号和换行符的位掩码，之后在掩码上逐个取出分隔符位置
+class DelimiterScanner {
+private:
+    const char* data;     // 扫描的数据
+    size_t size;          // 数据长度
+    size_t blockStart;    // 当前64字节块的起始位置
+    uint64_t commas;      // 当前块中逗号的位掩码
+    uint64_t newlines;    // 当前块中换行符的位掩码
+
+    // 计算从start开始的64字节块的位掩码
+    void load(size_t start) {
+        blockStart = start;
+        commas = 0;
+        newlines = 0;
+        const char* block = data + start;
+        size_t length = std::min<size_t>(64, size - start);
+
+#if defined(__SSE2__)
+        if (length == 64) {
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i newline = _mm_set1_epi8('\n');
+            for (int i = 0; i < 4; ++i) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+                uint64_t commaBits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)));
+                uint64_t newlineBits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+                commas |= commaBits << (i * 16);
+                newlines |= newlineBits << (i * 16);
+            }
+            return;
+        }
+#endif
+        for (size_t i = 0; i < length; ++i) {
+            commas |= static_cast<uint64_t>(block[i] == ',') << i;
+            newlines |= static_cast<uint64_t>(block[i] == '\n') << i;
+        }
+    }
+
+public:
+    DelimiterScanner(const char* scanData, size_t scanSize) :
+        data(scanData),
+        size(scanSize),
+        blockStart(static_cast<size_t>(-1)),
+        commas(0),
+        newlines(0) {}
+
+    // 查找from及之后的第一个分隔符（newlineOnly时只找换行符），没有时返回数据长度
+    size_t next(size_t from, bool newlineOnly) {
+        while (from < size) {
+            size_t start = from & ~static_cast<size_t>(63);
+            if (start != blockStart) {
+                load(start);
+            }
+            uint64_t mask = (newlineOnly ? newlines : (commas | newlines)) & (~0ULL << (from - start));
+            if (mask != 0) {
+                return start + countTrailingZeros(mask);
+            }
+            from = start + 64;
+        }
+        return size;
+    }
+};
+
+// 一行的基本字段
+struct BaseFields {
+    long long timestamp;
+    double latitude;
+    double longitude;
+    double altitude;
+    double accuracy;
+    uint8_t sourceType;
+    uint8_t status;
+};
+
+// 解析整个字段为数值，字段必须完整解析
+template <typename T>
+bool parseNumber(std::string_view field, T& value) {
+    if (field.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+// 解析枚举字段（0-255）
+bool parseEnum(std::string_view field, uint8_t& value) {
+    int number = 0;
+    if (!parseNumber(field, number) || number < 0 || number > 255) {
+        return false;
+    }
+    value = static_cast<uint8_t>(number);
+    return true;
+}
+
+// 解析基本字段，失败时返回出错的字段原因
+const char* parseBaseFields(const std::string_view (&fields)[BASE_FIELD_COUNT], BaseFields& base) {
+    if (!parseNumber(fields[0], base.timestamp)) return FIELD_ERRORS[0];
+    if (!parseNumber(fields[1], base.latitude)) return FIELD_ERRORS[1];
+    if (!parseNumber(fields[2], base.longitude)) return FIELD_ERRORS[2];
+    if (!parseNumber(fields[3], base.altitude)) return FIELD_ERRORS[3];
+    if (!parseNumber(fields[4], base.accuracy)) return FIELD_ERRORS[4];
+    if (!parseEnum(fields[5], base.sourceType)) return FIELD_ERRORS[5];
+    if (!parseEnum(fields[6], base.status)) return FIELD_ERRORS[6];
+    return nullptr;
+}
+
+// 解析额外信息（以逗号分隔的[键:值]，不符合格式的项忽略）
+void parseExtras(std::string_view text, LocationInfo& location) {
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view token = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+
+        if (token.size() >= 3 && token.front() == '[' && token.back() == ']') {
+            std::string_view pair = token.substr(1, token.size() - 2);
+            size_t colon = pair.find(':');
+            if (colon != std::string_view::npos) {
+                location.setExtra(std::string(pair.substr(0, colon)), std::string(pair.substr(colon + 1)));
+            }
+        }
+    }
+}
+
+// 去掉行尾的回车符
+std::string_view trimLine(const char* data, size_t size) {
+    if (size > 0 && data[size - 1] == '\r') {
+        --size;
+    }
+    return std::string_view(data, size);
+}
+
+// 一个分片的解析结果
+struct ChunkResult {
+    LocationColumns rows;                 // 解析出的数据
+    uint64_t lines;                       // 行数（不含空行）
+    uint64_t newlines;                    // 换行符数（用于计算后续分片的行号）
+    uint64_t malformed;                   // 格式错误的行数
+    std::vector<LegacyParseError> errors; // 格式错误的行（行号为分片内行号）
+
+    ChunkResult() : lines(0), newlines(0), malformed(0) {}
+};
+
+// 解析文件中的一个分片[begin, end)，end为换行符之后或文件末尾
+void parseChunk(const char* data, size_t begin, size_t end, size_t maxErrors, ChunkResult& result) {
+    DelimiterScanner scanner(data, end);
+    LocationColumns& rows = result.rows;
+    rows.reserve((end - begin) / 64);
+
+    // 额外信息原始文本到设备ID和额外信息字典下标的缓存，键指向映射内存
+    std::unordered_map<std::string_view, std::pair<uint32_t, uint32_t>> extrasCache;
+
+    std::string_view fields[BASE_FIELD_COUNT];
+    size_t lineStart = begin;
+    while (lineStart < end) {
+        // 依次取出基本字段
+        size_t fieldStart = lineStart;
+        size_t fieldCount = 0;
+        size_t delimiter = lineStart;
+        while (fieldCount < BASE_FIELD_COUNT) {
+            delimiter = scanner.next(fieldStart, false);
+            fields[fieldCount++] = std::string_view(data + fieldStart, delimiter - fieldStart);
+            if (delimiter >= end || data[delimiter] == '\n') {
+                break;
+            }
+            fieldStart = delimiter + 1;
+        }
+
+        // 剩余部分为额外信息，只需找到行尾
+        size_t extrasStart = delimiter + 1;
+        size_t lineEnd = delimiter;
+        if (delimiter < end && data[delimiter] == ',') {
+            lineEnd = scanner.next(extrasStart, true);
+        }
+        size_t nextLine = lineEnd + 1;
+        if (lineEnd < end) {
+            result.newlines++;
+        }
+
+        std::string_view line = trimLine(data + lineStart, lineEnd - lineStart);
+        if (line.empty()) {
+            lineStart = nextLine;
+            continue;
+        }
+        result.lines++;
+
+        // 最后一个字段和额外信息去掉行尾的回车符
+        const char* lineLimit = line.data() + line.size();
+        std::string_view& last = fields[fieldCount - 1];
+        if (last.data() + last.size() > lineLimit) {
+            last = std::string_view(last.data(), static_cast<size_t>(lineLimit - last.data()));
+        }
+
+        BaseFields base;
+        const char* reason = fieldCount < BASE_FIELD_COUNT ? "too few fields" : parseBaseFields(fields, base);
+        if (reason) {
+            result.malformed++;
+            if (result.errors.size() < maxErrors) {
+                LegacyParseError error;
+                error.line = result.newlines - (lineEnd < end ? 1 : 0); // 分片内从0开始的行号
+                error.offset = lineStart;
+                error.reason = reason;
+                error.text = std::string(line.substr(0, MAX_ERROR_TEXT));
+                result.errors.push_back(std::move(error));
+            }
+            lineStart = nextLine;
+            continue;
+        }
+
+        std::string_view extras;
+        if (extrasStart < lineStart + line.size()) {
+            extras = std::string_view(data + extrasStart, lineStart + line.size() - extrasStart);
+        }
+        auto cached = extrasCache.find(extras);
+        if (cached == extrasCache.end()) {
+            LocationInfo location;
+            parseExtras(extras, location);
+            std::pair<uint32_t, uint32_t> indexes(rows.internDevice(getDeviceIdOf(location)),
+                                                  rows.internExtras(LocationCodec::encodeExtras(location)));
+            cached = extrasCache.emplace(extras, indexes).first;
+        }
+
+        rows.timestamps.push_back(base.timestamp);
+        rows.latitudes.push_back(base.latitude);
+        rows.longitudes.push_back(base.longitude);
+        rows.altitudes.push_back(base.altitude);
+        rows.accuracies.push_back(base.accuracy);
+        rows.speeds.push_back(0.0);
+        rows.directions.push_back(0.0);
+        rows.sourceTypes.push_back(base.sourceType);
+        rows.statuses.push_back(base.status);
+        rows.deviceIndexes.push_back(cached->second.first);
+        rows.extrasIndexes.push_back(cached->second.second);
+
+        lineStart = nextLine;
+    }
+}
+
+} // namespace
+
+// LegacyLogParser构造函数
+LegacyLogParser::LegacyLogParser(const LegacyParseOptions& parseOptions) : options(parseOptions) {
+    if (options.threadCount == 0) {
+        options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options.chunkSize = std::max<size_t>(options.chunkSize, 4096);
+}
+
+// 解析一行
+bool LegacyLogParser::parseLine(const char* data, size_t size, LocationInfo& location, const char** reason) {
+    std::string_view line = trimLine(data, size);
+    std::string_view fields[BASE_FIELD_COUNT];
+    size_t fieldCount = 0;
+    std::string_view rest = line;
+    bool more = !line.empty();
+    while (more && fieldCount < BASE_FIELD_COUNT) {
+        size_t comma = rest.find(',');
+        fields[fieldCount++] = rest.substr(0, comma);
+        more = comma != std::string_view::npos;
+        rest = more ? rest.substr(comma + 1) : std::string_view();
+    }
+
+    BaseFields base;
+    const char* error = line.empty() ? "empty line" :
+                        fieldCount < BASE_FIELD_COUNT ? "too few fields" : parseBaseFields(fields, base);
+    if (error) {
+        if (reason) {
+            *reason = error;
+        }
+        return false;
+    }
+
+    location = LocationInfo();
+    location.timestamp = base.timestamp;
+    location.latitude = base.latitude;
+    location.longitude = base.longitude;
+    location.altitude = base.altitude;
+    location.accuracy = base.accuracy;
+    location.sourceType = static_cast<DataSourceType>(base.sourceType);
+    location.status = static_cast<LocationStatus>(base.status);
+    if (more) {
+        parseExtras(rest, location);
+    }
+    return true;
+}
+
+// 并行解析文件，每个分片的结果按文件顺序交给回调
+bool LegacyLogParser::parseFile(const std::string& path, const ChunkCallback& callback,
+                                LegacyParseStats* stats) const {
+    auto startTime = std::chrono::steady_clock::now();
+    LegacyParseStats local;
+
+    MappedFile file;
+    if (!file.open(path)) {
+        LOG_ERROR("Failed to map log file: %s", path.c_str());
+        return false;
+    }
+    const char* data = file.getData();
+    size_t size = file.getSize();
+
+    // 按chunkSize切分，分片边界向后对齐到换行符之后
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < size;) {
+        size_t end = begin + options.chunkSize;
+        if (end >= size) {
+            end = size;
+        } else {
+            const void* newline = std::memchr(data + end, '\n', size - end);
+            end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+        }
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+
+    // 每轮并行解析threadCount个分片，再按顺序交给回调，内存占用与文件大小无关
+    bool stopped = false;
+    uint64_t lineBase = 0;
+    for (size_t first = 0; first < chunks.size() && !stopped; first += options.threadCount) {
+        size_t count = std::min(options.threadCount, chunks.size() - first);
+        std::vector<ChunkResult> results(count);
+        utils::concurrent::parallelFor(count, options.threadCount, [&](size_t i) {
+            parseChunk(data, chunks[first + i].first, chunks[first + i].second, options.maxErrors, results[i]);
+        });
+
+        for (auto& result : results) {
+            for (auto& error : result.errors) {
+                if (local.errors.size() >= options.maxErrors) {
+                    break;
+                }
+                error.line += lineBase + 1;
+                local.errors.push_back(std::move(error));
+            }
+            lineBase += result.newlines;
+            local.linesTotal += result.lines;
+            local.linesMalformed += result.malformed;
+            local.rowsParsed += result.rows.size();
+
+            if (!result.rows.empty() && !callback(result.rows)) {
+                stopped = true;
+                break;
+            }
+        }
+        local.bytesParsed += chunks[first + count - 1].second - chunks[first].first;
+        local.chunks += count;
+    }
+
+    local.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    if (local.linesMalformed > 0) {
+        LOG_WARNING("Skipped %llu malformed lines in %s",
+                    static_cast<unsigned long long>(local.linesMalformed), path.c_str());
+    }
+    LOG_DEBUG("Parsed %llu rows from %s in %lld ms",
+              static_cast<unsigned long long>(local.rowsParsed), path.c_str(), local.elapsedMs);
+
+    if (stats) {
+        *stats = std::move(local);
+    }
+    return !stopped;
+}
+
+// 并行解析文件，结果按文件顺序追加到rows
+bool LegacyLogParser::parseFile(const std::string& path, LocationColumns& rows, LegacyParseStats* stats) const {
+    return parseFile(path, [&rows](LocationColumns& chunk) {
+        if (rows.empty()) {
+            rows = std::move(chunk);
+            return true;
+        }
+        rows.reserve(rows.size() + chunk.size());
+        for (size_t row = 0; row < chunk.size(); ++row) {
+            rows.appendRow(chunk, row);
+        }
+        return true;
+    }, stats);
+}
@@ -0,0 +1,772 @@
+// LocationCodec.cpp - 位置时间序列压缩编码实现
+
+#include "LocationCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// 设备ID键名定义
+const char* const DEVICE_ID_EXTRA_KEY = "deviceId";
+
+// 获取位置数据所属的设备ID
+std::string getDeviceIdOf(const LocationInfo& location) {
+    return location.getExtra(DEVICE_ID_EXTRA_KEY, "");
+}
+
+namespace {
+
+// 各列的量化系数
+constexpr double COORDINATE_SCALE = 1e7;   // 经纬度：1e-7度（约1厘米）
+constexpr double CENTI_SCALE = 100.0;      // 海拔/精度/速度/方向：0.01单位
+
+// 每个块写入的列数
+constexpr uint64_t BLOCK_COLUMN_COUNT = 11;
+
+// 整数列编码方式
+constexpr uint8_t INT_MODE_VARINT = 0;     // 逐值变长编码
+constexpr uint8_t INT_MODE_BITPACKED = 1;  // 固定位宽打包
+
+// 将浮点数量化为整数，非有限值按0处理
+inline int64_t quantize(double value, double scale) {
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    return static_cast<int64_t>(std::llround(value * scale));
+}
+
+// 计算表示value所需的位数
+inline unsigned bitWidthOf(uint64_t value) {
+    unsigned width = 0;
+    while (value != 0) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+// 计算变长整数的字节数
+inline size_t varintLength(uint64_t value) {
+    size_t length = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++length;
+    }
+    return length;
+}
+
+// 以小端序读取最多8个字节（越界部分补0）
+inline uint64_t loadWord(const uint8_t* data, size_t size, size_t byteIndex) {
+    uint64_t word = 0;
+    if (byteIndex + 8 <= size) {
+        std::memcpy(&word, data + byteIndex, 8);
+    } else if (byteIndex < size) {
+        std::memcpy(&word, data + byteIndex, size - byteIndex);
+    }
+    return word;
+}
+
+// 按固定位宽打包
+void packBits(const std::vector<uint64_t>& values, unsigned width, std::vector<uint8_t>& out) {
+    if (width == 0) {
+        return;
+    }
+
+    uint64_t accumulator = 0;
+    unsigned accumulatedBits = 0;
+    for (uint64_t value : values) {
+        accumulator |= value << accumulatedBits;
+        if (accumulatedBits + width >= 64) {
+            for (int i = 0; i < 8; ++i) {
+                out.push_back(static_cast<uint8_t>(accumulator >> (8 * i)));
+            }
+            unsigned spill = accumulatedBits + width - 64;
+            accumulator = spill > 0 ? value >> (width - spill) : 0;
+            accumulatedBits = spill;
+        } else {
+            accumulatedBits += width;
+        }
+    }
+
+    for (unsigned i = 0; i * 8 < accumulatedBits; ++i) {
+        out.push_back(static_cast<uint8_t>(accumulator >> (8 * i)));
+    }
+}
+
+// 按固定位宽解包（固定位宽、无分支的循环便于编译器向量化）
+void unpackBits(const uint8_t* data, size_t size, unsigned width, size_t count, uint64_t* values) {
+    if (width == 0) {
+        std::fill(values, values + count, 0);
+        return;
+    }
+
+    const uint64_t mask = width == 64 ? std::numeric_limits<uint64_t>::max() : ((1ULL << width) - 1);
+    size_t bitPos = 0;
+    for (size_t i = 0; i < count; ++i, bitPos += width) {
+        size_t byteIndex = bitPos >> 3;
+        unsigned shift = static_cast<unsigned>(bitPos & 7);
+        uint64_t value = loadWord(data, size, byteIndex) >> shift;
+        if (shift + width > 64) {
+            value |= static_cast<uint64_t>(data[byteIndex + 8]) << (64 - shift);
+        }
+        values[i] = value & mask;
+    }
+}
+
+// 编码一列ZigZag后的整数，自动选择变长编码或位打包中较小者
+void encodeIntColumn(const std::vector<uint64_t>& values, std::vector<uint8_t>& out) {
+    uint64_t maxValue = 0;
+    size_t varintBytes = 0;
+    for (uint64_t value : values) {
+        maxValue = std::max(maxValue, value);
+        varintBytes += varintLength(value);
+    }
+
+    unsigned width = bitWidthOf(maxValue);
+    size_t packedBytes = (values.size() * width + 7) / 8;
+
+    if (packedBytes + 1 <= varintBytes) {
+        out.push_back(INT_MODE_BITPACKED);
+        out.push_back(static_cast<uint8_t>(width));
+        packBits(values, width, out);
+    } else {
+        out.push_back(INT_MODE_VARINT);
+        for (uint64_t value : values) {
+            LocationCodec::writeVarint(out, value);
+        }
+    }
+}
+
+// 解码一列ZigZag后的整数
+bool decodeIntColumn(const uint8_t*& ptr, const uint8_t* end, size_t count, uint64_t* values) {
+    if (ptr >= end) {
+        return count == 0;
+    }
+
+    uint8_t mode = *ptr++;
+    if (mode == INT_MODE_BITPACKED) {
+        if (ptr >= end) {
+            return false;
+        }
+        unsigned width = *ptr++;
+        if (width > 64) {
+            return false;
+        }
+        size_t packedBytes = (count * width + 7) / 8;
+        if (static_cast<size_t>(end - ptr) < packedBytes) {
+            return false;
+        }
+        unpackBits(ptr, packedBytes, width, count, values);
+        ptr += packedBytes;
+        return true;
+    }
+
+    if (mode == INT_MODE_VARINT) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!LocationCodec::readVarint(ptr, end, values[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+// 编码量化后差分的数值列
+void encodeDeltaColumn(const std::vector<int64_t>& quantized, std::vector<uint8_t>& out) {
+    if (quantized.empty()) {
+        return;
+    }
+
+    LocationCodec::writeVarint(out, LocationCodec::zigzagEncode(quantized[0]));
+
+    std::vector<uint64_t> deltas;
+    deltas.reserve(quantized.size() - 1);
+    for (size_t i = 1; i < quantized.size(); ++i) {
+        deltas.push_back(LocationCodec::zigzagEncode(quantized[i] - quantized[i - 1]));
+    }
+    encodeIntColumn(deltas, out);
+}
+
+// 解码量化后差分的数值列，并按比例还原为浮点数
+bool decodeDeltaColumn(const uint8_t* ptr, const uint8_t* end, size_t count, double scale, double* out) {
+    if (count == 0) {
+        return true;
+    }
+
+    uint64_t first = 0;
+    if (!LocationCodec::readVarint(ptr, end, first)) {
+        return false;
+    }
+
+    std::vector<uint64_t> deltas(count - 1);
+    if (!decodeIntColumn(ptr, end, count - 1, deltas.data())) {
+        return false;
+    }
+
+    // 前缀和还原量化值
+    std::vector<int64_t> quantized(count);
+    int64_t current = LocationCodec::zigzagDecode(first);
+    quantized[0] = current;
+    for (size_t i = 1; i < count; ++i) {
+        current += LocationCodec::zigzagDecode(deltas[i - 1]);
+        quantized[i] = current;
+    }
+
+    // 反量化（独立的无依赖循环，便于向量化）
+    const double inverse = 1.0 / scale;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<double>(quantized[i]) * inverse;
+    }
+    return true;
+}
+
+// 编码时间戳列（delta-of-delta）
+void encodeTimestampColumn(const std::vector<long long>& timestamps, std::vector<uint8_t>& out) {
+    if (timestamps.empty()) {
+        return;
+    }
+
+    LocationCodec::writeVarint(out, LocationCodec::zigzagEncode(timestamps[0]));
+
+    std::vector<uint64_t> deltaOfDeltas;
+    deltaOfDeltas.reserve(timestamps.size() - 1);
+    int64_t previousDelta = 0;
+    for (size_t i = 1; i < timestamps.size(); ++i) {
+        int64_t delta = timestamps[i] - timestamps[i - 1];
+        deltaOfDeltas.push_back(LocationCodec::zigzagEncode(delta - previousDelta));
+        previousDelta = delta;
+    }
+    encodeIntColumn(deltaOfDeltas, out);
+}
+
+// 解码时间戳列
+bool decodeTimestampColumn(const uint8_t* ptr, const uint8_t* end, size_t count, long long* out) {
+    if (count == 0) {
+        return true;
+    }
+
+    uint64_t first = 0;
+    if (!LocationCodec::readVarint(ptr, end, first)) {
+        return false;
+    }
+
+    std::vector<uint64_t> deltaOfDeltas(count - 1);
+    if (!decodeIntColumn(ptr, end, count - 1, deltaOfDeltas.data())) {
+        return false;
+    }
+
+    int64_t current = LocationCodec::zigzagDecode(first);
+    int64_t delta = 0;
+    out[0] = current;
+    for (size_t i = 1; i < count; ++i) {
+        delta += LocationCodec::zigzagDecode(deltaOfDeltas[i - 1]);
+        current += delta;
+        out[i] = current;
+    }
+    return true;
+}
+
+// 编码字节型字典列（数据源类型、状态）
+void encodeByteDictionaryColumn(const std::vector<uint8_t>& values, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> dictionary;
+    uint8_t codeOf[256];
+    bool seen[256] = {false};
+
+    std::vector<uint64_t> codes;
+    codes.reserve(values.size());
+    for (uint8_t value : values) {
+        if (!seen[value]) {
+            seen[value] = true;
+            codeOf[value] = static_cast<uint8_t>(dictionary.size());
+            dictionary.push_back(value);
+        }
+        codes.push_back(codeOf[value]);
+    }
+
+    LocationCodec::writeVarint(out, dictionary.size());
+    out.insert(out.end(), dictionary.begin(), dictionary.end());
+    unsigned width = dictionary.size() > 1 ? bitWidthOf(dictionary.size() - 1) : 0;
+    packBits(codes, width, out);
+}
+
+// 解码字节型字典列
+bool decodeByteDictionaryColumn(const uint8_t* ptr, const uint8_t* end, size_t count, uint8_t* out) {
+    uint64_t dictionarySize = 0;
+    if (!LocationCodec::readVarint(ptr, end, dictionarySize) || dictionarySize == 0 ||
+        dictionarySize > 256 || static_cast<size_t>(end - ptr) < dictionarySize) {
+        return count == 0;
+    }
+
+    const uint8_t* dictionary = ptr;
+    ptr += dictionarySize;
+
+    unsigned width = dictionarySize > 1 ? bitWidthOf(dictionarySize - 1) : 0;
+    size_t packedBytes = (count * width + 7) / 8;
+    if (static_cast<size_t>(end - ptr) < packedBytes) {
+        return false;
+    }
+
+    std::vector<uint64_t> codes(count);
+    unpackBits(ptr, packedBytes, width, count, codes.data());
+    for (size_t i = 0; i < count; ++i) {
+        if (codes[i] >= dictionarySize) {
+            return false;
+        }
+        out[i] = dictionary[codes[i]];
+    }
+    return true;
+}
+
+// 编码字符串字典列（设备ID、额外信息），indexes指向批次内的字典
+void encodeStringDictionaryColumn(const std::vector<uint32_t>& indexes,
+                                  const std::vector<std::string>& batchDictionary,
+                                  std::vector<uint8_t>& out) {
+    // 块内字典只包含本块出现过的字符串
+    std::unordered_map<uint32_t, uint32_t> remap;
+    std::vector<uint32_t> blockDictionary;
+    std::vector<uint64_t> codes;
+    codes.reserve(indexes.size());
+
+    for (uint32_t index : indexes) {
+        auto it = remap.find(index);
+        if (it == remap.end()) {
+            it = remap.emplace(index, static_cast<uint32_t>(blockDictionary.size())).first;
+            blockDictionary.push_back(index);
+        }
+        codes.push_back(it->second);
+    }
+
+    LocationCodec::writeVarint(out, blockDictionary.size());
+    for (uint32_t index : blockDictionary) {
+        const std::string& value = batchDictionary[index];
+        LocationCodec::writeVarint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+    unsigned width = blockDictionary.size() > 1 ? bitWidthOf(blockDictionary.size() - 1) : 0;
+    packBits(codes, width, out);
+}
+
+// 解码字符串字典列，结果映射到目标批次的字典
+bool decodeStringDictionaryColumn(const uint8_t* ptr, const uint8_t* end, size_t count,
+                                  LocationColumns& columns, bool isDevice, uint32_t* out) {
+    uint64_t dictionarySize = 0;
+    if (!LocationCodec::readVarint(ptr, end, dictionarySize)) {
+        return false;
+    }
+    if (dictionarySize == 0) {
+        return count == 0;
+    }
+
+    std::vector<uint32_t> mapped;
+    mapped.reserve(static_cast<size_t>(std::min<uint64_t>(dictionarySize, count)));
+    for (uint64_t i = 0; i < dictionarySize; ++i) {
+        uint64_t length = 0;
+        if (!LocationCodec::readVarint(ptr, end, length) || static_cast<uint64_t>(end - ptr) < length) {
+            return false;
+        }
+        std::string value(reinterpret_cast<const char*>(ptr), static_cast<size_t>(length));
+        ptr += length;
+        mapped.push_back(isDevice ? columns.internDevice(value) : columns.internExtras(value));
+    }
+
+    unsigned width = dictionarySize > 1 ? bitWidthOf(dictionarySize - 1) : 0;
+    size_t packedBytes = (count * width + 7) / 8;
+    if (static_cast<size_t>(end - ptr) < packedBytes) {
+        return false;
+    }
+
+    std::vector<uint64_t> codes(count);
+    unpackBits(ptr, packedBytes, width, count, codes.data());
+    for (size_t i = 0; i < count; ++i) {
+        if (codes[i] >= dictionarySize) {
+            return false;
+        }
+        out[i] = mapped[codes[i]];
+    }
+    return true;
+}
+
+// 量化一列浮点数
+std::vector<int64_t> quantizeColumn(const std::vector<double>& values, double scale) {
+    std::vector<int64_t> quantized;
+    quantized.reserve(values.size());
+    for (double value : values) {
+        quantized.push_back(quantize(value, scale));
+    }
+    return quantized;
+}
+
+// 写入一列：列编号 + 长度 + 内容
+void writeColumn(CodecColumn column, const std::vector<uint8_t>& payload, std::vector<uint8_t>& out) {
+    out.push_back(static_cast<uint8_t>(column));
+    LocationCodec::writeVarint(out, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+} // namespace
+
+// 预留空间
+void LocationColumns::reserve(size_t count) {
+    timestamps.reserve(count);
+    latitudes.reserve(count);
+    longitudes.reserve(count);
+    altitudes.reserve(count);
+    accuracies.reserve(count);
+    speeds.reserve(count);
+    directions.reserve(count);
+    sourceTypes.reserve(count);
+    statuses.reserve(count);
+    deviceIndexes.reserve(count);
+    extrasIndexes.reserve(count);
+}
+
+// 清空所有数据
+void LocationColumns::clear() {
+    timestamps.clear();
+    latitudes.clear();
+    longitudes.clear();
+    altitudes.clear();
+    accuracies.clear();
+    speeds.clear();
+    directions.clear();
+    sourceTypes.clear();
+    statuses.clear();
+    deviceIndexes.clear();
+    deviceDictionary.clear();
+    extrasIndexes.clear();
+    extrasDictionary.clear();
+    deviceLookup.clear();
+    extrasLookup.clear();
+}
+
+// 追加一条位置数据
+void LocationColumns::append(const LocationInfo& location) {
+    timestamps.push_back(location.timestamp);
+    latitudes.push_back(location.latitude);
+    longitudes.push_back(location.longitude);
+    altitudes.push_back(location.altitude);
+    accuracies.push_back(location.accuracy);
+    speeds.push_back(location.speed);
+    directions.push_back(location.direction);
+    sourceTypes.push_back(static_cast<uint8_t>(location.sourceType));
+    statuses.push_back(static_cast<uint8_t>(location.status));
+    deviceIndexes.push_back(internDevice(getDeviceIdOf(location)));
+    extrasIndexes.push_back(internExtras(LocationCodec::encodeExtras(location)));
+}
+
+// 追加另一批次中的一行
+void LocationColumns::appendRow(const LocationColumns& other, size_t row) {
+    timestamps.push_back(other.timestamps[row]);
+    latitudes.push_back(other.latitudes[row]);
+    longitudes.push_back(other.longitudes[row]);
+    altitudes.push_back(other.altitudes[row]);
+    accuracies.push_back(other.accuracies[row]);
+    speeds.push_back(other.speeds[row]);
+    directions.push_back(other.directions[row]);
+    sourceTypes.push_back(other.sourceTypes[row]);
+    statuses.push_back(other.statuses[row]);
+    deviceIndexes.push_back(internDevice(other.deviceDictionary[other.deviceIndexes[row]]));
+    extrasIndexes.push_back(internExtras(other.extrasDictionary[other.extrasIndexes[row]]));
+}
+
+// 将指定行还原为LocationInfo
+LocationInfo LocationColumns::toLocationInfo(size_t row) const {
+    LocationInfo location;
+    location.timestamp = timestamps[row];
+    location.latitude = latitudes[row];
+    location.longitude = longitudes[row];
+    location.altitude = altitudes[row];
+    location.accuracy = accuracies[row];
+    location.speed = speeds[row];
+    location.direction = directions[row];
+    location.sourceType = static_cast<DataSourceType>(sourceTypes[row]);
+    location.status = static_cast<LocationStatus>(statuses[row]);
+
+    LocationCodec::decodeExtras(extrasDictionary[extrasIndexes[row]], location);
+    const std::string& deviceId = deviceDictionary[deviceIndexes[row]];
+    if (!deviceId.empty()) {
+        location.setExtra(DEVICE_ID_EXTRA_KEY, deviceId);
+    }
+    return location;
+}
+
+// 获取指定行的设备ID
+const std::string& LocationColumns::getDeviceId(size_t row) const {
+    return deviceDictionary[deviceIndexes[row]];
+}
+
+// 将设备ID加入字典并返回下标
+uint32_t LocationColumns::internDevice(const std::string& deviceId) {
+    auto it = deviceLookup.find(deviceId);
+    if (it != deviceLookup.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(deviceDictionary.size());
+    deviceDictionary.push_back(deviceId);
+    deviceLookup.emplace(deviceId, index);
+    return index;
+}
+
+// 将已序列化的额外信息加入字典并返回下标
+uint32_t LocationColumns::internExtras(const std::string& encodedExtras) {
+    auto it = extrasLookup.find(encodedExtras);
+    if (it != extrasLookup.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(extrasDictionary.size());
+    extrasDictionary.push_back(encodedExtras);
+    extrasLookup.emplace(encodedExtras, index);
+    return index;
+}
+
+// 将两个字典截断到指定大小
+void LocationColumns::truncateDictionaries(size_t deviceCount, size_t extrasCount) {
+    for (size_t i = deviceCount; i < deviceDictionary.size(); ++i) {
+        deviceLookup.erase(deviceDictionary[i]);
+    }
+    if (deviceCount < deviceDictionary.size()) {
+        deviceDictionary.resize(deviceCount);
+    }
+    for (size_t i = extrasCount; i < extrasDictionary.size(); ++i) {
+        extrasLookup.erase(extrasDictionary[i]);
+    }
+    if (extrasCount < extrasDictionary.size()) {
+        extrasDictionary.resize(extrasCount);
+    }
+}
+
+// 变长整数写入
+void LocationCodec::writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// 变长整数读取
+bool LocationCodec::readVarint(const uint8_t*& ptr, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && ptr < end; shift += 7) {
+        uint8_t byte = *ptr++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 序列化额外信息（不包含设备ID）
+std::string LocationCodec::encodeExtras(const LocationInfo& location) {
+    std::vector<uint8_t> buffer;
+    for (const auto& [key, value] : location.getExtras()) {
+        if (key == DEVICE_ID_EXTRA_KEY) {
+            continue;
+        }
+        writeVarint(buffer, key.size());
+        buffer.insert(buffer.end(), key.begin(), key.end());
+        writeVarint(buffer, value.size());
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+    return std::string(buffer.begin(), buffer.end());
+}
+
+// 反序列化额外信息到位置数据
+void LocationCodec::decodeExtras(const std::string& encoded, LocationInfo& location) {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(encoded.data());
+    const uint8_t* end = ptr + encoded.size();
+
+    while (ptr < end) {
+        uint64_t keyLength = 0;
+        if (!readVarint(ptr, end, keyLength) || static_cast<uint64_t>(end - ptr) < keyLength) {
+            return;
+        }
+        std::string key(reinterpret_cast<const char*>(ptr), static_cast<size_t>(keyLength));
+        ptr += keyLength;
+
+        uint64_t valueLength = 0;
+        if (!readVarint(ptr, end, valueLength) || static_cast<uint64_t>(end - ptr) < valueLength) {
+            return;
+        }
+        std::string value(reinterpret_cast<const char*>(ptr), static_cast<size_t>(valueLength));
+        ptr += valueLength;
+
+        location.setExtra(key, value);
+    }
+}
+
+// 将一批位置数据编码为压缩块
+void LocationCodec::encodeBlock(const LocationColumns& columns, std::vector<uint8_t>& out) {
+    out.push_back(BLOCK_VERSION);
+    writeVarint(out, columns.size());
+    writeVarint(out, BLOCK_COLUMN_COUNT);
+
+    std::vector<uint8_t> payload;
+
+    encodeTimestampColumn(columns.timestamps, payload);
+    writeColumn(CodecColumn::TIMESTAMP, payload, out);
+
+    const struct {
+        CodecColumn column;
+        const std::vector<double>* values;
+        double scale;
+    } numericColumns[] = {
+        {CodecColumn::LATITUDE, &columns.latitudes, COORDINATE_SCALE},
+        {CodecColumn::LONGITUDE, &columns.longitudes, COORDINATE_SCALE},
+        {CodecColumn::ALTITUDE, &columns.altitudes, CENTI_SCALE},
+        {CodecColumn::ACCURACY, &columns.accuracies, CENTI_SCALE},
+        {CodecColumn::SPEED, &columns.speeds, CENTI_SCALE},
+        {CodecColumn::DIRECTION, &columns.directions, CENTI_SCALE},
+    };
+    for (const auto& numeric : numericColumns) {
+        payload.clear();
+        encodeDeltaColumn(quantizeColumn(*numeric.values, numeric.scale), payload);
+        writeColumn(numeric.column, payload, out);
+    }
+
+    payload.clear();
+    encodeByteDictionaryColumn(columns.sourceTypes, payload);
+    writeColumn(CodecColumn::SOURCE_TYPE, payload, out);
+
+    payload.clear();
+    encodeByteDictionaryColumn(columns.statuses, payload);
+    writeColumn(CodecColumn::STATUS, payload, out);
+
+    payload.clear();
+    encodeStringDictionaryColumn(columns.deviceIndexes, columns.deviceDictionary, payload);
+    writeColumn(CodecColumn::DEVICE, payload, out);
+
+    payload.clear();
+    encodeStringDictionaryColumn(columns.extrasIndexes, columns.extrasDictionary, payload);
+    writeColumn(CodecColumn::EXTRAS, payload, out);
+}
+
+// 仅读取块中的行数
+bool LocationCodec::peekRowCount(const uint8_t* data, size_t size, uint32_t& rowCount) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    if (ptr >= end || *ptr++ != BLOCK_VERSION) {
+        return false;
+    }
+
+    uint64_t count = 0;
+    if (!readVarint(ptr, end, count) || count > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    rowCount = static_cast<uint32_t>(count);
+    return true;
+}
+
+// 将压缩块解码并追加到columns
+bool LocationCodec::decodeBlock(const uint8_t* data, size_t size, LocationColumns& columns, uint32_t columnMask) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+
+    if (ptr >= end || *ptr++ != BLOCK_VERSION) {
+        return false;
+    }
+
+    uint64_t rowCount = 0;
+    uint64_t columnCount = 0;
+    if (!readVarint(ptr, end, rowCount) || rowCount > std::numeric_limits<uint32_t>::max() ||
+        !readVarint(ptr, end, columnCount)) {
+        return false;
+    }
+
+    // 先按默认值扩展各列，解码失败时把各列和字典都回滚到解码前的大小
+    const size_t base = columns.size();
+    const size_t deviceDictionarySize = columns.deviceDictionary.size();
+    const size_t extrasDictionarySize = columns.extrasDictionary.size();
+    const size_t total = base + static_cast<size_t>(rowCount);
+    columns.timestamps.resize(total, 0);
+    columns.latitudes.resize(total, 0.0);
+    columns.longitudes.resize(total, 0.0);
+    columns.altitudes.resize(total, 0.0);
+    columns.accuracies.resize(total, 0.0);
+    columns.speeds.resize(total, 0.0);
+    columns.directions.resize(total, 0.0);
+    columns.sourceTypes.resize(total, 0);
+    columns.statuses.resize(total, 0);
+    columns.deviceIndexes.resize(total, columns.internDevice(""));
+    columns.extrasIndexes.resize(total, columns.internExtras(""));
+
+    bool ok = true;
+    for (uint64_t c = 0; c < columnCount && ok; ++c) {
+        if (ptr >= end) {
+            ok = false;
+            break;
+        }
+        CodecColumn column = static_cast<CodecColumn>(*ptr++);
+        uint64_t length = 0;
+        if (!readVarint(ptr, end, length) || static_cast<uint64_t>(end - ptr) < length) {
+            ok = false;
+            break;
+        }
+        const uint8_t* columnEnd = ptr + length;
+        if (!(columnMask & codecColumnBit(column))) {
+            ptr = columnEnd;
+            continue;
+        }
+
+        switch (column) {
+            case CodecColumn::TIMESTAMP:
+                ok = decodeTimestampColumn(ptr, columnEnd, rowCount, columns.timestamps.data() + base);
+                break;
+            case CodecColumn::LATITUDE:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, COORDINATE_SCALE, columns.latitudes.data() + base);
+                break;
+            case CodecColumn::LONGITUDE:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, COORDINATE_SCALE, columns.longitudes.data() + base);
+                break;
+            case CodecColumn::ALTITUDE:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, CENTI_SCALE, columns.altitudes.data() + base);
+                break;
+            case CodecColumn::ACCURACY:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, CENTI_SCALE, columns.accuracies.data() + base);
+                break;
+            case CodecColumn::SPEED:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, CENTI_SCALE, columns.speeds.data() + base);
+                break;
+            case CodecColumn::DIRECTION:
+                ok = decodeDeltaColumn(ptr, columnEnd, rowCount, CENTI_SCALE, columns.directions.data() + base);
+                break;
+            case CodecColumn::SOURCE_TYPE:
+                ok = decodeByteDictionaryColumn(ptr, columnEnd, rowCount, columns.sourceTypes.data() + base);
+                break;
+            case CodecColumn::STATUS:
+                ok = decodeByteDictionaryColumn(ptr, columnEnd, rowCount, columns.statuses.data() + base);
+                break;
+            case CodecColumn::DEVICE:
+                ok = decodeStringDictionaryColumn(ptr, columnEnd, rowCount, columns, true,
+                                                  columns.deviceIndexes.data() + base);
+                break;
+            case CodecColumn::EXTRAS:
+                ok = decodeStringDictionaryColumn(ptr, columnEnd, rowCount, columns, false,
+                                                  columns.extrasIndexes.data() + base);
+                break;
+            default:
+                // 未知列（更高版本写入）直接跳过
+                break;
+        }
+        ptr = columnEnd;
+    }
+
+    if (!ok) {
+        columns.timestamps.resize(base);
+        columns.latitudes.resize(base);
+        columns.longitudes.resize(base);
+        columns.altitudes.resize(base);
+        columns.accuracies.resize(base);
+        columns.speeds.resize(base);
+        columns.directions.resize(base);
+        columns.sourceTypes.resize(base);
+        columns.statuses.resize(base);
+        columns.deviceIndexes.resize(base);
+        columns.extrasIndexes.resize(base);
+        columns.truncateDictionaries(deviceDictionarySize, extrasDictionarySize);
+    }
+    return ok;
+}
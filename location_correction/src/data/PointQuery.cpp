@@ -0,0 +1,324 @@
+// PointQuery.cpp - 时间点位置查询与设备时间索引实现
+
+#include "PointQuery.h"
+#include "Logger.h"
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+// 将角度差规整到[-range/2, range/2)
+double wrapDelta(double delta, double range) {
+    delta = std::fmod(delta + range / 2, range);
+    if (delta < 0) {
+        delta += range;
+    }
+    return delta - range / 2;
+}
+
+// 时间差（毫秒）
+long long distanceMs(long long a, long long b) {
+    return a > b ? a - b : b - a;
+}
+
+// 时间戳加上偏移量，溢出时取边界值
+long long addClamped(long long value, long long delta) {
+    if (delta > 0 && value > std::numeric_limits<long long>::max() - delta) {
+        return std::numeric_limits<long long>::max();
+    }
+    if (delta < 0 && value < std::numeric_limits<long long>::min() - delta) {
+        return std::numeric_limits<long long>::min();
+    }
+    return value + delta;
+}
+
+} // namespace
+
+// 计算查询时刻前后的时间窗口
+void searchWindow(long long timestamp, long long maxDistanceMs, long long& startTime, long long& endTime) {
+    startTime = addClamped(timestamp, -maxDistanceMs);
+    endTime = addClamped(timestamp, maxDistanceMs);
+}
+
+// 用一个定位点更新查询时刻前后最近的定位点
+void updateBracket(const LocationInfo& candidate, long long timestamp,
+                   std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) {
+    if (candidate.timestamp <= timestamp && (!before || candidate.timestamp > before->timestamp)) {
+        before = candidate;
+    }
+    if (candidate.timestamp >= timestamp && (!after || candidate.timestamp < after->timestamp)) {
+        after = candidate;
+    }
+}
+
+// 根据前后定位点计算查询时刻的位置
+std::optional<PointLocation> interpolateLocation(const std::optional<LocationInfo>& before,
+                                                 const std::optional<LocationInfo>& after,
+                                                 long long timestamp, const PointQueryOptions& options) {
+    PointLocation result;
+    result.beforeTimestamp = timestamp;
+    result.afterTimestamp = timestamp;
+
+    // 恰有定位点
+    const LocationInfo* exact = before && before->timestamp == timestamp ? &*before
+                              : after && after->timestamp == timestamp ? &*after : nullptr;
+    if (exact) {
+        result.location = *exact;
+        result.kind = PointLocationKind::EXACT;
+        return result;
+    }
+
+    // 前后定位点间隔不超过maxGapMs时线性插值
+    if (before && after && after->timestamp - before->timestamp <= options.maxGapMs) {
+        double span = static_cast<double>(after->timestamp - before->timestamp);
+        double ratio = static_cast<double>(timestamp - before->timestamp) / span;
+
+        LocationInfo& location = result.location;
+        location = *before;
+        location.timestamp = timestamp;
+        location.latitude = before->latitude + ratio * (after->latitude - before->latitude);
+        location.longitude = before->longitude + ratio * wrapDelta(after->longitude - before->longitude, 360.0);
+        location.longitude = wrapDelta(location.longitude, 360.0);
+        location.altitude = before->altitude + ratio * (after->altitude - before->altitude);
+        location.speed = before->speed + ratio * (after->speed - before->speed);
+        location.direction = before->direction + ratio * wrapDelta(after->direction - before->direction, 360.0);
+        location.direction = location.direction < 0 ? location.direction + 360.0 : std::fmod(location.direction, 360.0);
+
+        // 两点的误差按插值权重合成；两点之间的实际轨迹可能偏离连线，偏离量在中点最大
+        double combined = std::hypot((1 - ratio) * before->accuracy, ratio * after->accuracy);
+        double drift = ratio * (1 - ratio) * span / 1000.0 * options.driftSpeed;
+        location.accuracy = combined + drift;
+        if (before->sourceType != after->sourceType) {
+            location.sourceType = DataSourceType::FUSED;
+        }
+        if (before->status != after->status) {
+            location.status = LocationStatus::LOW_ACCURACY;
+        }
+
+        result.kind = PointLocationKind::INTERPOLATED;
+        result.beforeTimestamp = before->timestamp;
+        result.afterTimestamp = after->timestamp;
+        return result;
+    }
+
+    // 只有一侧可用时取最近的定位点，精度按时间差放大
+    const LocationInfo* nearest = nullptr;
+    if (before && distanceMs(timestamp, before->timestamp) <= options.maxExtrapolationMs) {
+        nearest = &*before;
+    }
+    if (after && distanceMs(after->timestamp, timestamp) <= options.maxExtrapolationMs &&
+        (!nearest || distanceMs(after->timestamp, timestamp) < distanceMs(timestamp, nearest->timestamp))) {
+        nearest = &*after;
+    }
+    if (!nearest) {
+        return std::nullopt;
+    }
+
+    long long elapsed = distanceMs(timestamp, nearest->timestamp);
+    result.location = *nearest;
+    result.location.timestamp = timestamp;
+    result.location.accuracy = nearest->accuracy + static_cast<double>(elapsed) / 1000.0 * options.driftSpeed;
+    result.kind = PointLocationKind::NEAREST;
+    if (before && nearest == &*before) {
+        result.beforeTimestamp = nearest->timestamp;
+    } else {
+        result.afterTimestamp = nearest->timestamp;
+    }
+    return result;
+}
+
+// DeviceTimeIndex构造函数
+DeviceTimeIndex::DeviceTimeIndex(size_t cachedBlocks) :
+    blockCacheCapacity(std::max<size_t>(cachedBlocks, 1)) {
+}
+
+// 获取段文件的索引
+DeviceTimeIndex::SegmentIndex* DeviceTimeIndex::indexFor(const std::string& path) {
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec) {
+        segments.erase(path);
+        return nullptr;
+    }
+
+    auto& index = segments[path];
+    if (index && index->fileSize == fileSize) {
+        return index.get();
+    }
+
+    // 文件有变化时重新打开；已建立索引的块没有变化（只追加了新块）时只为新块补充索引
+    auto updated = std::make_unique<SegmentIndex>();
+    if (!updated->reader.open(path)) {
+        segments.erase(path);
+        return nullptr;
+    }
+    const auto& blocks = updated->reader.getBlocks();
+    size_t reused = 0;
+    if (index && index->blocks.size() <= blocks.size()) {
+        reused = index->blocks.size();
+        for (size_t i = 0; i < reused; ++i) {
+            const SegmentBlockInfo& a = index->blocks[i];
+            const SegmentBlockInfo& b = blocks[i];
+            if (a.offset != b.offset || a.size != b.size || a.rowCount != b.rowCount) {
+                reused = 0;
+                break;
+            }
+        }
+    }
+
+    updated->fileSize = fileSize;
+    updated->minTimestamp = std::numeric_limits<long long>::max();
+    updated->maxTimestamp = std::numeric_limits<long long>::min();
+    if (reused > 0) {
+        updated->devices = std::move(index->devices);
+        updated->minTimestamp = index->minTimestamp;
+        updated->maxTimestamp = index->maxTimestamp;
+    }
+    blockCache.remove_if([&](const CachedBlock& cached) { return cached.path == path && cached.block >= reused; });
+
+    // 新块只解码时间戳和设备列
+    const uint32_t columnMask = codecColumnBit(CodecColumn::TIMESTAMP) | codecColumnBit(CodecColumn::DEVICE);
+    std::unordered_map<std::string, size_t> sortedPrefix;
+    LocationColumns columns;
+    for (size_t block = reused; block < blocks.size(); ++block) {
+        columns.clear();
+        if (!updated->reader.readBlock(block, columns, columnMask)) {
+            continue;
+        }
+
+        // 字典下标到设备索引列表的映射，每个字典项只查找一次
+        std::vector<std::vector<Entry>*> lists(columns.deviceDictionary.size(), nullptr);
+        for (size_t row = 0; row < columns.size(); ++row) {
+            uint32_t code = columns.deviceIndexes[row];
+            if (!lists[code]) {
+                auto inserted = updated->devices.try_emplace(columns.deviceDictionary[code]);
+                sortedPrefix.emplace(inserted.first->first, inserted.first->second.size());
+                lists[code] = &inserted.first->second;
+            }
+            lists[code]->push_back(Entry{columns.timestamps[row], static_cast<uint32_t>(block),
+                                         static_cast<uint32_t>(row)});
+        }
+        updated->minTimestamp = std::min(updated->minTimestamp, blocks[block].minTimestamp);
+        updated->maxTimestamp = std::max(updated->maxTimestamp, blocks[block].maxTimestamp);
+    }
+
+    // 新追加的索引项排序后与已有的有序部分归并
+    auto byTime = [](const Entry& a, const Entry& b) { return a.timestamp < b.timestamp; };
+    for (const auto& prefix : sortedPrefix) {
+        std::vector<Entry>& entries = updated->devices[prefix.first];
+        auto middle = entries.begin() + static_cast<std::ptrdiff_t>(prefix.second);
+        std::stable_sort(middle, entries.end(), byTime);
+        std::inplace_merge(entries.begin(), middle, entries.end(), byTime);
+    }
+
+    LOG_DEBUG("Device time index updated: %s (%zu new blocks, %zu devices)", path.c_str(),
+              blocks.size() - reused, updated->devices.size());
+    updated->blocks = blocks;
+    index = std::move(updated);
+    return index.get();
+}
+
+// 读取段文件中的一行
+bool DeviceTimeIndex::fetch(const std::string& path, uint32_t block, uint32_t row, LocationInfo& location) {
+    for (auto it = blockCache.begin(); it != blockCache.end(); ++it) {
+        if (it->block == block && it->path == path) {
+            blockCache.splice(blockCache.begin(), blockCache, it);
+            if (row >= blockCache.front().columns.size()) {
+                return false;
+            }
+            location = blockCache.front().columns.toLocationInfo(row);
+            return true;
+        }
+    }
+
+    auto segment = segments.find(path);
+    if (segment == segments.end()) {
+        return false;
+    }
+    CachedBlock cached;
+    cached.path = path;
+    cached.block = block;
+    if (!segment->second->reader.readBlock(block, cached.columns) || row >= cached.columns.size()) {
+        return false;
+    }
+
+    location = cached.columns.toLocationInfo(row);
+    blockCache.push_front(std::move(cached));
+    if (blockCache.size() > blockCacheCapacity) {
+        blockCache.pop_back();
+    }
+    return true;
+}
+
+// 查找设备在查询时刻前后最近的定位点
+void DeviceTimeIndex::find(const std::vector<std::string>& segmentFiles, const std::string& deviceId,
+                           long long timestamp, long long maxDistanceMs,
+                           std::optional<LocationInfo>& before, std::optional<LocationInfo>& after) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // 不在当前段文件列表中的段（已删除或被压实替换）不再保留索引；
+    // 压实会同时删除和新增段文件，不能只比较数量
+    std::unordered_set<std::string_view> current(segmentFiles.begin(), segmentFiles.end());
+    bool pruned = false;
+    for (auto it = segments.begin(); it != segments.end();) {
+        if (current.count(it->first)) {
+            ++it;
+        } else {
+            it = segments.erase(it);
+            pruned = true;
+        }
+    }
+    if (pruned) {
+        blockCache.remove_if([this](const CachedBlock& cached) { return !segments.count(cached.path); });
+    }
+
+    long long lowest = 0;
+    long long highest = 0;
+    searchWindow(timestamp, maxDistanceMs, lowest, highest);
+
+    for (const auto& path : segmentFiles) {
+        SegmentIndex* index = indexFor(path);
+        if (!index || index->maxTimestamp < lowest || index->minTimestamp > highest) {
+            continue;
+        }
+        auto device = index->devices.find(deviceId);
+        if (device == index->devices.end()) {
+            continue;
+        }
+
+        // 二分查找第一个不早于查询时刻的索引项，其前一项即为之前最近的定位点
+        const std::vector<Entry>& entries = device->second;
+        auto it = std::lower_bound(entries.begin(), entries.end(), timestamp,
+                                   [](const Entry& entry, long long time) { return entry.timestamp < time; });
+
+        LocationInfo location;
+        if (it != entries.end() && it->timestamp <= highest &&
+            (!after || it->timestamp < after->timestamp) && fetch(path, it->block, it->row, location)) {
+            updateBracket(location, timestamp, before, after);
+        }
+        // 恰在查询时刻的定位点已同时作为之前的定位点
+        if (it != entries.begin() && (it == entries.end() || it->timestamp != timestamp)) {
+            const Entry& previous = *(it - 1);
+            if (previous.timestamp >= lowest && (!before || previous.timestamp > before->timestamp) &&
+                fetch(path, previous.block, previous.row, location)) {
+                updateBracket(location, timestamp, before, after);
+            }
+        }
+    }
+}
+
+// 清空索引和缓存
+void DeviceTimeIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    segments.clear();
+    blockCache.clear();
+}
+
+// 获取已建立索引的段文件数
+size_t DeviceTimeIndex::getSegmentCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return segments.size();
+}
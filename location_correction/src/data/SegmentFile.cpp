@@ -0,0 +1,606 @@
+// SegmentFile.cpp - 压缩段文件读写实现
+
+#include "SegmentFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 段文件扩展名定义
+const char* const SEGMENT_FILE_EXTENSION = ".lcs";
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x4753434C;   // "LCSG"
+constexpr uint32_t SEGMENT_VERSION = 2;
+constexpr size_t FRAME_HEADER_SIZE = 4;          // 块帧头：块长度
+constexpr size_t FOOTER_SIZE = 24;               // 索引偏移(8) + 索引长度(4) + 块数(4) + 版本(4) + 魔数(4)
+constexpr size_t INDEX_ENTRY_SIZE_V1 = 32;       // 偏移(8) + 长度(4) + 行数(4) + 最小时间戳(8) + 最大时间戳(8)
+constexpr size_t INDEX_ENTRY_SIZE = 56;          // V1 + 数据源类型掩码(4) + 状态掩码(4) + 位图偏移(8) + 位图长度(4) + 保留(4)
+
+// 行位图索引由若干容器组成，每个容器对应一列中的一个取值：
+// [列(1) + 取值(1) + 编码(1) + 保留(1) + 载荷长度(4)] + 载荷
+constexpr size_t BITMAP_CONTAINER_HEADER_SIZE = 8;
+constexpr uint8_t BITMAP_COLUMN_SOURCE_TYPE = 0;
+constexpr uint8_t BITMAP_COLUMN_STATUS = 1;
+constexpr uint8_t BITMAP_ALL_ROWS = 0;           // 块内所有行都是该取值，无载荷
+constexpr uint8_t BITMAP_BITSET = 1;             // 载荷为按行的位图（u64数组）
+constexpr uint8_t BITMAP_ROW_LIST = 2;           // 载荷为升序行号（u32数组），用于稀疏取值
+
+// 以小端序写入整数
+template<typename T>
+void putLittleEndian(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+// 以小端序读取整数
+template<typename T>
+T getLittleEndian(const uint8_t* data) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+// 计算一列取值的掩码
+uint32_t valueMaskOf(const std::vector<uint8_t>& values) {
+    uint32_t mask = 0;
+    for (uint8_t value : values) {
+        if (value >= 32) {
+            return SEGMENT_ANY_VALUE_MASK;
+        }
+        mask |= 1u << value;
+    }
+    return mask;
+}
+
+// 为一列的每个取值编码行位图容器，行数较少的取值用行号列表，否则用位图
+void encodeRowBitmaps(const std::vector<uint8_t>& values, uint8_t column, std::vector<uint8_t>& out) {
+    size_t counts[256] = {};
+    size_t distinct = 0;
+    for (uint8_t value : values) {
+        distinct += counts[value]++ == 0 ? 1 : 0;
+    }
+
+    const size_t wordCount = (values.size() + 63) / 64;
+    for (size_t value = 0; value < 256; ++value) {
+        if (counts[value] == 0) {
+            continue;
+        }
+        uint8_t encoding = distinct == 1 ? BITMAP_ALL_ROWS
+                         : counts[value] * sizeof(uint32_t) < wordCount * sizeof(uint64_t) ? BITMAP_ROW_LIST
+                         : BITMAP_BITSET;
+        out.push_back(column);
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(encoding);
+        out.push_back(0);
+
+        if (encoding == BITMAP_ALL_ROWS) {
+            putLittleEndian<uint32_t>(out, 0);
+        } else if (encoding == BITMAP_ROW_LIST) {
+            putLittleEndian<uint32_t>(out, static_cast<uint32_t>(counts[value] * sizeof(uint32_t)));
+            for (size_t row = 0; row < values.size(); ++row) {
+                if (values[row] == value) {
+                    putLittleEndian<uint32_t>(out, static_cast<uint32_t>(row));
+                }
+            }
+        } else {
+            RowBitmap bitmap(wordCount, 0);
+            for (size_t row = 0; row < values.size(); ++row) {
+                if (values[row] == value) {
+                    bitmap[row / 64] |= uint64_t(1) << (row % 64);
+                }
+            }
+            putLittleEndian<uint32_t>(out, static_cast<uint32_t>(wordCount * sizeof(uint64_t)));
+            for (uint64_t word : bitmap) {
+                putLittleEndian<uint64_t>(out, word);
+            }
+        }
+    }
+}
+
+// 将指定列取值的行位图与rows求交，数据损坏时返回false
+bool intersectRowBitmap(const uint8_t* data, size_t size, uint8_t column, uint8_t value,
+                        uint32_t rowCount, RowBitmap& rows) {
+    const uint8_t* ptr = data;
+    const uint8_t* end = data + size;
+    while (static_cast<size_t>(end - ptr) >= BITMAP_CONTAINER_HEADER_SIZE) {
+        uint8_t containerColumn = ptr[0];
+        uint8_t containerValue = ptr[1];
+        uint8_t encoding = ptr[2];
+        uint32_t length = getLittleEndian<uint32_t>(ptr + 4);
+        ptr += BITMAP_CONTAINER_HEADER_SIZE;
+        if (static_cast<size_t>(end - ptr) < length) {
+            return false;
+        }
+        if (containerColumn != column || containerValue != value) {
+            ptr += length;
+            continue;
+        }
+
+        if (encoding == BITMAP_ALL_ROWS) {
+            return true;
+        }
+        if (encoding == BITMAP_BITSET) {
+            if (length != rows.size() * sizeof(uint64_t)) {
+                return false;
+            }
+            for (size_t i = 0; i < rows.size(); ++i) {
+                rows[i] &= getLittleEndian<uint64_t>(ptr + i * sizeof(uint64_t));
+            }
+            return true;
+        }
+        if (encoding == BITMAP_ROW_LIST && length % sizeof(uint32_t) == 0) {
+            RowBitmap selected(rows.size(), 0);
+            for (size_t i = 0; i < length / sizeof(uint32_t); ++i) {
+                uint32_t row = getLittleEndian<uint32_t>(ptr + i * sizeof(uint32_t));
+                if (row >= rowCount) {
+                    return false;
+                }
+                selected[row / 64] |= uint64_t(1) << (row % 64);
+            }
+            for (size_t i = 0; i < rows.size(); ++i) {
+                rows[i] &= selected[i];
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // 块内没有该取值
+    std::fill(rows.begin(), rows.end(), 0);
+    return ptr == end;
+}
+
+} // namespace
+
+// 根据取值掩码检查块内是否可能包含指定的数据源类型和位置状态
+bool SegmentBlockInfo::mayContain(const std::optional<DataSourceType>& sourceType,
+                                  const std::optional<LocationStatus>& status) const {
+    auto contains = [](uint32_t mask, uint8_t value) {
+        return mask == SEGMENT_ANY_VALUE_MASK || value >= 32 || (mask & (1u << value)) != 0;
+    };
+    return (!sourceType || contains(sourceTypeMask, static_cast<uint8_t>(*sourceType))) &&
+           (!status || contains(statusMask, static_cast<uint8_t>(*status)));
+}
+
+// SegmentWriter构造函数
+SegmentWriter::SegmentWriter() : bytesWritten(0), directorySynced(false) {
+}
+
+// SegmentWriter析构函数
+SegmentWriter::~SegmentWriter() {
+    if (stream.is_open()) {
+        finish();
+    }
+}
+
+// 创建并打开段文件
+bool SegmentWriter::open(const std::string& filePath) {
+    if (stream.is_open()) {
+        finish();
+    }
+
+    stream.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        LOG_ERROR("Failed to open segment file: %s", filePath.c_str());
+        return false;
+    }
+
+    path = filePath;
+    blocks.clear();
+    bitmapBuffer.clear();
+    bytesWritten = 0;
+    directorySynced = false;
+    return true;
+}
+
+// 编码并追加一个数据块
+bool SegmentWriter::appendBlock(const LocationColumns& columns) {
+    if (!stream.is_open() || columns.empty()) {
+        return false;
+    }
+
+    encodeBuffer.clear();
+    putLittleEndian<uint32_t>(encodeBuffer, 0); // 帧头占位
+    LocationCodec::encodeBlock(columns, encodeBuffer);
+
+    uint32_t blockSize = static_cast<uint32_t>(encodeBuffer.size() - FRAME_HEADER_SIZE);
+    for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+        encodeBuffer[i] = static_cast<uint8_t>(blockSize >> (8 * i));
+    }
+
+    SegmentBlockInfo info;
+    info.offset = bytesWritten + FRAME_HEADER_SIZE;
+    info.size = blockSize;
+    info.rowCount = static_cast<uint32_t>(columns.size());
+    auto [minIt, maxIt] = std::minmax_element(columns.timestamps.begin(), columns.timestamps.end());
+    info.minTimestamp = *minIt;
+    info.maxTimestamp = *maxIt;
+    info.sourceTypeMask = valueMaskOf(columns.sourceTypes);
+    info.statusMask = valueMaskOf(columns.statuses);
+
+    // 行位图偏移先记录为在位图区内的偏移，finish时加上位图区的起始位置
+    size_t bitmapStart = bitmapBuffer.size();
+    encodeRowBitmaps(columns.sourceTypes, BITMAP_COLUMN_SOURCE_TYPE, bitmapBuffer);
+    encodeRowBitmaps(columns.statuses, BITMAP_COLUMN_STATUS, bitmapBuffer);
+    info.bitmapOffset = bitmapStart;
+    info.bitmapSize = static_cast<uint32_t>(bitmapBuffer.size() - bitmapStart);
+
+    stream.write(reinterpret_cast<const char*>(encodeBuffer.data()), encodeBuffer.size());
+    stream.flush();
+    if (!stream.good()) {
+        bitmapBuffer.resize(bitmapStart);
+        LOG_ERROR("Failed to write block to segment file: %s", path.c_str());
+        return false;
+    }
+
+    bytesWritten += encodeBuffer.size();
+    blocks.push_back(info);
+    return true;
+}
+
+// 将已追加的块刷到磁盘
+bool SegmentWriter::sync() {
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    stream.flush();
+    if (!stream.good() || !syncFile(path)) {
+        LOG_ERROR("Failed to sync segment file: %s", path.c_str());
+        return false;
+    }
+    if (!directorySynced) {
+        directorySynced = syncDirectory(std::filesystem::path(path).parent_path().string());
+    }
+    return directorySynced;
+}
+
+// 写入块索引和文件尾，刷到磁盘并关闭文件
+bool SegmentWriter::finish() {
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    // 行位图索引位于最后一个块之后
+    uint64_t bitmapAreaOffset = bytesWritten;
+    uint64_t indexOffset = bitmapAreaOffset + bitmapBuffer.size();
+
+    std::vector<uint8_t> trailer(bitmapBuffer.begin(), bitmapBuffer.end());
+    trailer.reserve(trailer.size() + blocks.size() * INDEX_ENTRY_SIZE + FOOTER_SIZE);
+    for (const auto& block : blocks) {
+        putLittleEndian<uint64_t>(trailer, block.offset);
+        putLittleEndian<uint32_t>(trailer, block.size);
+        putLittleEndian<uint32_t>(trailer, block.rowCount);
+        putLittleEndian<int64_t>(trailer, block.minTimestamp);
+        putLittleEndian<int64_t>(trailer, block.maxTimestamp);
+        putLittleEndian<uint32_t>(trailer, block.sourceTypeMask);
+        putLittleEndian<uint32_t>(trailer, block.statusMask);
+        putLittleEndian<uint64_t>(trailer, bitmapAreaOffset + block.bitmapOffset);
+        putLittleEndian<uint32_t>(trailer, block.bitmapSize);
+        putLittleEndian<uint32_t>(trailer, 0);
+    }
+
+    putLittleEndian<uint64_t>(trailer, indexOffset);
+    putLittleEndian<uint32_t>(trailer, static_cast<uint32_t>(blocks.size() * INDEX_ENTRY_SIZE));
+    putLittleEndian<uint32_t>(trailer, static_cast<uint32_t>(blocks.size()));
+    putLittleEndian<uint32_t>(trailer, SEGMENT_VERSION);
+    putLittleEndian<uint32_t>(trailer, SEGMENT_MAGIC);
+
+    stream.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+    bool ok = stream.good();
+    stream.close();
+    bitmapBuffer.clear();
+
+    ok = ok && syncFile(path);
+    if (ok && !directorySynced) {
+        directorySynced = syncDirectory(std::filesystem::path(path).parent_path().string());
+        ok = directorySynced;
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to finish segment file: %s", path.c_str());
+        return false;
+    }
+
+    bytesWritten += trailer.size();
+    LOG_DEBUG("Segment file finished: %s (%zu blocks)", path.c_str(), blocks.size());
+    return true;
+}
+
+// SegmentReader构造函数
+SegmentReader::SegmentReader() :
+    fileSize(0),
+    bytesRead(0),
+    complete(false) {
+}
+
+// 打开段文件并加载块索引
+bool SegmentReader::open(const std::string& filePath) {
+    close();
+
+    stream.open(filePath, std::ios::in | std::ios::binary);
+    if (!stream.is_open()) {
+        LOG_WARNING("Failed to open segment file for reading: %s", filePath.c_str());
+        return false;
+    }
+
+    path = filePath;
+    stream.seekg(0, std::ios::end);
+    fileSize = static_cast<uint64_t>(stream.tellg());
+
+    complete = loadFooter();
+    if (!complete && !scanBlocks()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// 关闭文件
+void SegmentReader::close() {
+    if (stream.is_open()) {
+        stream.close();
+    }
+    stream.clear();
+    blocks.clear();
+    fileSize = 0;
+    complete = false;
+}
+
+// 从文件尾加载块索引
+bool SegmentReader::loadFooter() {
+    if (fileSize < FOOTER_SIZE) {
+        return false;
+    }
+
+    uint8_t footer[FOOTER_SIZE];
+    stream.seekg(static_cast<std::streamoff>(fileSize - FOOTER_SIZE));
+    if (!stream.read(reinterpret_cast<char*>(footer), FOOTER_SIZE)) {
+        stream.clear();
+        return false;
+    }
+
+    uint64_t indexOffset = getLittleEndian<uint64_t>(footer);
+    uint32_t indexSize = getLittleEndian<uint32_t>(footer + 8);
+    uint32_t blockCount = getLittleEndian<uint32_t>(footer + 12);
+    uint32_t version = getLittleEndian<uint32_t>(footer + 16);
+    uint32_t magic = getLittleEndian<uint32_t>(footer + 20);
+
+    // 版本1的块索引没有取值掩码和行位图索引
+    size_t entrySize = version == 1 ? INDEX_ENTRY_SIZE_V1 : INDEX_ENTRY_SIZE;
+    if (magic != SEGMENT_MAGIC || version == 0 || version > SEGMENT_VERSION ||
+        indexSize != static_cast<uint64_t>(blockCount) * entrySize ||
+        indexOffset + indexSize + FOOTER_SIZE != fileSize) {
+        return false;
+    }
+
+    std::vector<uint8_t> index(indexSize);
+    stream.seekg(static_cast<std::streamoff>(indexOffset));
+    if (indexSize > 0 && !stream.read(reinterpret_cast<char*>(index.data()), indexSize)) {
+        stream.clear();
+        return false;
+    }
+    bytesRead += indexSize + FOOTER_SIZE;
+
+    blocks.clear();
+    blocks.reserve(blockCount);
+    for (uint32_t i = 0; i < blockCount; ++i) {
+        const uint8_t* entry = index.data() + static_cast<size_t>(i) * entrySize;
+        SegmentBlockInfo info;
+        info.offset = getLittleEndian<uint64_t>(entry);
+        info.size = getLittleEndian<uint32_t>(entry + 8);
+        info.rowCount = getLittleEndian<uint32_t>(entry + 12);
+        info.minTimestamp = getLittleEndian<int64_t>(entry + 16);
+        info.maxTimestamp = getLittleEndian<int64_t>(entry + 24);
+        if (entrySize == INDEX_ENTRY_SIZE) {
+            info.sourceTypeMask = getLittleEndian<uint32_t>(entry + 32);
+            info.statusMask = getLittleEndian<uint32_t>(entry + 36);
+            info.bitmapOffset = getLittleEndian<uint64_t>(entry + 40);
+            info.bitmapSize = getLittleEndian<uint32_t>(entry + 48);
+        }
+        if (info.offset + info.size > indexOffset || info.bitmapOffset + info.bitmapSize > indexOffset) {
+            return false;
+        }
+        blocks.push_back(info);
+    }
+    return true;
+}
+
+// 顺序扫描帧头重建索引
+bool SegmentReader::scanBlocks() {
+    blocks.clear();
+
+    uint64_t offset = 0;
+    std::vector<uint8_t> data;
+    while (offset + FRAME_HEADER_SIZE <= fileSize) {
+        uint8_t header[FRAME_HEADER_SIZE];
+        stream.seekg(static_cast<std::streamoff>(offset));
+        if (!stream.read(reinterpret_cast<char*>(header), FRAME_HEADER_SIZE)) {
+            break;
+        }
+
+        uint32_t blockSize = getLittleEndian<uint32_t>(header);
+        if (blockSize == 0 || offset + FRAME_HEADER_SIZE + blockSize > fileSize) {
+            // 末尾的不完整块（写入中途崩溃）
+            break;
+        }
+
+        data.resize(blockSize);
+        if (!stream.read(reinterpret_cast<char*>(data.data()), blockSize)) {
+            break;
+        }
+        bytesRead += FRAME_HEADER_SIZE + blockSize;
+
+        LocationColumns columns;
+        if (!LocationCodec::decodeBlock(data.data(), data.size(), columns) || columns.empty()) {
+            break;
+        }
+
+        SegmentBlockInfo info;
+        info.offset = offset + FRAME_HEADER_SIZE;
+        info.size = blockSize;
+        info.rowCount = static_cast<uint32_t>(columns.size());
+        auto [minIt, maxIt] = std::minmax_element(columns.timestamps.begin(), columns.timestamps.end());
+        info.minTimestamp = *minIt;
+        info.maxTimestamp = *maxIt;
+        info.sourceTypeMask = valueMaskOf(columns.sourceTypes);
+        info.statusMask = valueMaskOf(columns.statuses);
+        blocks.push_back(info);
+
+        offset += FRAME_HEADER_SIZE + blockSize;
+    }
+    stream.clear();
+
+    if (!blocks.empty()) {
+        LOG_WARNING("Segment file without footer, recovered %zu blocks: %s", blocks.size(), path.c_str());
+    }
+    return true;
+}
+
+// 读取原始块数据
+bool SegmentReader::readRawBlock(size_t index, std::vector<uint8_t>& data) {
+    if (!stream.is_open() || index >= blocks.size()) {
+        return false;
+    }
+
+    const SegmentBlockInfo& info = blocks[index];
+    data.resize(info.size);
+    stream.seekg(static_cast<std::streamoff>(info.offset));
+    if (!stream.read(reinterpret_cast<char*>(data.data()), info.size)) {
+        stream.clear();
+        LOG_WARNING("Failed to read block %zu from segment: %s", index, path.c_str());
+        return false;
+    }
+
+    bytesRead += info.size;
+    return true;
+}
+
+// 读取并解码指定块
+bool SegmentReader::readBlock(size_t index, LocationColumns& columns, uint32_t columnMask) {
+    if (!readRawBlock(index, readBuffer)) {
+        return false;
+    }
+
+    if (!LocationCodec::decodeBlock(readBuffer.data(), readBuffer.size(), columns, columnMask)) {
+        LOG_WARNING("Failed to decode block %zu from segment: %s", index, path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 读取满足条件的行位图
+bool SegmentReader::readRowBitmap(size_t index, const std::optional<DataSourceType>& sourceType,
+                                  const std::optional<LocationStatus>& status, RowBitmap& rows) {
+    if (!stream.is_open() || index >= blocks.size() || (!sourceType && !status)) {
+        return false;
+    }
+
+    const SegmentBlockInfo& info = blocks[index];
+    if (info.bitmapSize == 0) {
+        return false;
+    }
+
+    readBuffer.resize(info.bitmapSize);
+    stream.seekg(static_cast<std::streamoff>(info.bitmapOffset));
+    if (!stream.read(reinterpret_cast<char*>(readBuffer.data()), info.bitmapSize)) {
+        stream.clear();
+        return false;
+    }
+    bytesRead += info.bitmapSize;
+
+    // 从全选开始依次与各条件的位图求交
+    rows.assign((info.rowCount + 63) / 64, ~uint64_t(0));
+    if (info.rowCount % 64 != 0) {
+        rows.back() = (uint64_t(1) << (info.rowCount % 64)) - 1;
+    }
+    bool ok = (!sourceType || intersectRowBitmap(readBuffer.data(), readBuffer.size(), BITMAP_COLUMN_SOURCE_TYPE,
+                                                 static_cast<uint8_t>(*sourceType), info.rowCount, rows)) &&
+              (!status || intersectRowBitmap(readBuffer.data(), readBuffer.size(), BITMAP_COLUMN_STATUS,
+                                             static_cast<uint8_t>(*status), info.rowCount, rows));
+    if (!ok) {
+        LOG_WARNING("Corrupted row bitmap index for block %zu in segment: %s", index, path.c_str());
+    }
+    return ok;
+}
+
+// 获取段内最小时间戳
+long long SegmentReader::getMinTimestamp() const {
+    long long minTimestamp = std::numeric_limits<long long>::max();
+    for (const auto& block : blocks) {
+        minTimestamp = std::min(minTimestamp, block.minTimestamp);
+    }
+    return minTimestamp;
+}
+
+// 获取段内最大时间戳
+long long SegmentReader::getMaxTimestamp() const {
+    long long maxTimestamp = std::numeric_limits<long long>::min();
+    for (const auto& block : blocks) {
+        maxTimestamp = std::max(maxTimestamp, block.maxTimestamp);
+    }
+    return maxTimestamp;
+}
+
+// 获取段内总行数
+uint64_t SegmentReader::getRowCount() const {
+    uint64_t rowCount = 0;
+    for (const auto& block : blocks) {
+        rowCount += block.rowCount;
+    }
+    return rowCount;
+}
+
+// 检查段内是否可能包含指定数据源类型和位置状态的行
+bool SegmentReader::mayContain(const std::optional<DataSourceType>& sourceType,
+                               const std::optional<LocationStatus>& status) const {
+    return std::any_of(blocks.begin(), blocks.end(), [&](const SegmentBlockInfo& block) {
+        return block.mayContain(sourceType, status);
+    });
+}
+
+namespace {
+
+// 以只读方式打开路径并fsync（目录也可以这样同步）
+bool syncPath(const std::string& path, bool directory) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY | (directory ? O_DIRECTORY : 0));
+    if (fd < 0) {
+        LOG_ERROR("Failed to open %s for sync: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    if (!ok) {
+        LOG_ERROR("Failed to sync %s: %s", path.c_str(), std::strerror(errno));
+    }
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    (void)directory;
+    return true;
+#endif
+}
+
+} // namespace
+
+// 将文件内容刷到磁盘
+bool syncFile(const std::string& filePath) {
+    return syncPath(filePath, false);
+}
+
+// 将目录项刷到磁盘
+bool syncDirectory(const std::string& directoryPath) {
+    return syncPath(directoryPath.empty() ? "." : directoryPath, true);
+}
@@ -0,0 +1,766 @@
+// StorageQuery.cpp - 存储查询条件、并行查询执行器与流式游标实现
+
+#include "StorageQuery.h"
+#include "SegmentFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <queue>
+
+namespace {
+
+// 待查询的数据来源
+struct QuerySource {
+    std::string path;        // 文件路径
+    bool segment;            // 是否为压缩段文件
+    long long minTimestamp;  // 最小时间戳（CSV日志未知）
+    long long maxTimestamp;  // 最大时间戳（CSV日志未知）
+};
+
+// 单次查询的共享状态
+struct QueryState {
+    const QueryPredicate& predicate;
+    std::atomic<long long> bound;   // 带limit时的动态时间界限
+    std::vector<std::vector<LocationInfo>> results; // 各来源的有序结果
+
+    std::atomic<size_t> segmentsPruned;
+    std::atomic<size_t> segmentsScanned;
+    std::atomic<size_t> blocksPruned;
+    std::atomic<size_t> blocksScanned;
+    std::atomic<uint64_t> rowsScanned;
+    std::atomic<uint64_t> bytesRead;
+
+    std::mutex doneMutex;
+    std::condition_variable doneCV;
+    size_t remaining;
+
+    explicit QueryState(const QueryPredicate& queryPredicate) :
+        predicate(queryPredicate),
+        bound(queryPredicate.latestFirst ? std::numeric_limits<long long>::min()
+                                         : std::numeric_limits<long long>::max()),
+        segmentsPruned(0),
+        segmentsScanned(0),
+        blocksPruned(0),
+        blocksScanned(0),
+        rowsScanned(0),
+        bytesRead(0),
+        remaining(0) {}
+
+    // 时间戳a是否排在b之前
+    bool before(long long a, long long b) const {
+        return predicate.latestFirst ? a > b : a < b;
+    }
+
+    // 时间戳是否仍可能进入前limit条
+    bool canQualify(long long timestamp) const {
+        long long current = bound.load(std::memory_order_relaxed);
+        return predicate.latestFirst ? timestamp >= current : timestamp <= current;
+    }
+
+    // 时间范围是否仍可能包含前limit条中的数据
+    bool canQualifyRange(long long minTimestamp, long long maxTimestamp) const {
+        return canQualify(predicate.latestFirst ? maxTimestamp : minTimestamp);
+    }
+
+    // 用某个来源的第limit条数据收紧全局界限
+    void tightenBound(long long timestamp) {
+        long long current = bound.load(std::memory_order_relaxed);
+        while (before(timestamp, current) &&
+               !bound.compare_exchange_weak(current, timestamp, std::memory_order_relaxed)) {
+        }
+    }
+
+    // 保留局部结果中最靠前的limit条，并据此收紧界限
+    void trim(std::vector<LocationInfo>& local) {
+        size_t limit = predicate.limit;
+        if (limit == 0 || local.size() < limit) {
+            return;
+        }
+
+        auto compare = [this](const LocationInfo& a, const LocationInfo& b) {
+            return before(a.timestamp, b.timestamp);
+        };
+        std::nth_element(local.begin(), local.begin() + (limit - 1), local.end(), compare);
+        local.resize(limit);
+        tightenBound(local.back().timestamp);
+    }
+
+    // 标记一个来源已完成
+    void finish(size_t index, std::vector<LocationInfo>&& local) {
+        std::stable_sort(local.begin(), local.end(), [this](const LocationInfo& a, const LocationInfo& b) {
+            return before(a.timestamp, b.timestamp);
+        });
+
+        std::lock_guard<std::mutex> lock(doneMutex);
+        results[index] = std::move(local);
+        if (--remaining == 0) {
+            doneCV.notify_all();
+        }
+    }
+};
+
+// 扫描一个列式批次，selection为行位图筛选出的候选行（为空时扫描所有行）
+void scanColumns(QueryState& state, const LocationColumns& columns, std::vector<LocationInfo>& local,
+                 const RowBitmap* selection = nullptr) {
+    const QueryPredicate& predicate = state.predicate;
+
+    // 设备ID先在块字典中查找，块内没有该设备时整块跳过
+    uint32_t deviceCode = 0;
+    if (!predicate.deviceId.empty()) {
+        auto it = std::find(columns.deviceDictionary.begin(), columns.deviceDictionary.end(), predicate.deviceId);
+        if (it == columns.deviceDictionary.end()) {
+            state.rowsScanned += columns.size();
+            return;
+        }
+        deviceCode = static_cast<uint32_t>(it - columns.deviceDictionary.begin());
+    }
+
+    bool limited = predicate.limit > 0;
+    for (size_t row = 0; row < columns.size(); ++row) {
+        if (selection) {
+            uint64_t word = (*selection)[row / 64];
+            if (word == 0) {
+                row |= 63; // 跳过整个字
+                continue;
+            }
+            if (!((word >> (row % 64)) & 1)) {
+                continue;
+            }
+        }
+        if (!predicate.matchesRow(columns, row) ||
+            (!predicate.deviceId.empty() && columns.deviceIndexes[row] != deviceCode) ||
+            (limited && !state.canQualify(columns.timestamps[row]))) {
+            continue;
+        }
+
+        local.push_back(columns.toLocationInfo(row));
+        if (limited && local.size() >= predicate.limit * 2) {
+            state.trim(local);
+        }
+    }
+    state.rowsScanned += columns.size();
+}
+
+// 扫描一个压缩段文件
+void scanSegment(QueryState& state, const QuerySource& source, std::vector<LocationInfo>& local) {
+    SegmentReader reader;
+    if (!reader.open(source.path)) {
+        return;
+    }
+
+    // 按查询顺序访问块，尽早收紧界限
+    const auto& blocks = reader.getBlocks();
+    std::vector<size_t> order(blocks.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    if (state.predicate.limit > 0) {
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return state.predicate.latestFirst ? blocks[a].maxTimestamp > blocks[b].maxTimestamp
+                                               : blocks[a].minTimestamp < blocks[b].minTimestamp;
+        });
+    }
+
+    const QueryPredicate& predicate = state.predicate;
+    LocationColumns columns;
+    RowBitmap selection;
+    for (size_t index : order) {
+        const SegmentBlockInfo& block = blocks[index];
+        if (!predicate.overlaps(block.minTimestamp, block.maxTimestamp) ||
+            !block.mayContain(predicate.sourceType, predicate.status) ||
+            (predicate.limit > 0 && !state.canQualifyRange(block.minTimestamp, block.maxTimestamp))) {
+            state.blocksPruned++;
+            continue;
+        }
+
+        // 先根据行位图求出数据源类型和状态都满足条件的行，没有候选行时不解码
+        bool selected = reader.readRowBitmap(index, predicate.sourceType, predicate.status, selection);
+        if (selected && std::all_of(selection.begin(), selection.end(), [](uint64_t word) { return word == 0; })) {
+            state.blocksPruned++;
+            continue;
+        }
+
+        columns.clear();
+        if (!reader.readBlock(index, columns)) {
+            continue;
+        }
+        state.blocksScanned++;
+        scanColumns(state, columns, local, selected ? &selection : nullptr);
+    }
+
+    state.bytesRead += reader.getBytesRead();
+}
+
+// 扫描一个CSV日志文件
+void scanLogFile(QueryState& state, const QuerySource& source, const QueryExecutor::LineParser& parser,
+                 std::vector<LocationInfo>& local) {
+    std::ifstream file(source.path);
+    if (!file.is_open()) {
+        LOG_WARNING("Failed to open log file for reading: %s", source.path.c_str());
+        return;
+    }
+
+    const QueryPredicate& predicate = state.predicate;
+    bool limited = predicate.limit > 0;
+    uint64_t bytesRead = 0;
+    uint64_t rowsScanned = 0;
+    std::string line;
+    LocationInfo location;
+    while (std::getline(file, line)) {
+        bytesRead += line.size() + 1;
+        rowsScanned++;
+        if (!parser(line, location) || !predicate.matches(location) ||
+            (limited && !state.canQualify(location.timestamp))) {
+            continue;
+        }
+
+        local.push_back(location);
+        if (limited && local.size() >= predicate.limit * 2) {
+            state.trim(local);
+        }
+    }
+
+    state.bytesRead += bytesRead;
+    state.rowsScanned += rowsScanned;
+}
+
+} // namespace
+
+// 检查位置数据是否满足条件
+bool QueryPredicate::matches(const LocationInfo& location) const {
+    return location.timestamp >= startTime && location.timestamp <= endTime &&
+           (!sourceType || location.sourceType == *sourceType) &&
+           (!status || location.status == *status) &&
+           (!maxAccuracy || location.accuracy <= *maxAccuracy) &&
+           (deviceId.empty() || getDeviceIdOf(location) == deviceId);
+}
+
+// 检查列式批次中的一行是否满足条件
+bool QueryPredicate::matchesRow(const LocationColumns& columns, size_t row) const {
+    return columns.timestamps[row] >= startTime && columns.timestamps[row] <= endTime &&
+           (!sourceType || columns.sourceTypes[row] == static_cast<uint8_t>(*sourceType)) &&
+           (!status || columns.statuses[row] == static_cast<uint8_t>(*status)) &&
+           (!maxAccuracy || columns.accuracies[row] <= *maxAccuracy);
+}
+
+// QueryExecutor构造函数
+QueryExecutor::QueryExecutor(size_t threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&QueryExecutor::workerLoop, this);
+    }
+}
+
+// QueryExecutor析构函数
+QueryExecutor::~QueryExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+// 工作线程主循环
+void QueryExecutor::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(taskMutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+// 提交任务
+void QueryExecutor::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+// 执行查询
+std::vector<LocationInfo> QueryExecutor::execute(const std::vector<std::string>& files,
+                                                 const QueryPredicate& predicate,
+                                                 QueryStats* stats,
+                                                 const LocationColumns* memoryRows) {
+    auto startTime = std::chrono::steady_clock::now();
+    QueryState state(predicate);
+
+    // 根据段文件尾部的块索引剪枝，CSV日志的时间范围未知，必须扫描
+    std::vector<QuerySource> sources;
+    sources.reserve(files.size());
+    for (const auto& path : files) {
+        QuerySource source;
+        source.path = path;
+        source.segment = std::filesystem::path(path).extension() == SEGMENT_FILE_EXTENSION;
+        source.minTimestamp = std::numeric_limits<long long>::min();
+        source.maxTimestamp = std::numeric_limits<long long>::max();
+
+        if (source.segment) {
+            SegmentReader reader;
+            if (!reader.open(path)) {
+                continue;
+            }
+            state.bytesRead += reader.getBytesRead();
+            if (reader.getBlocks().empty() ||
+                !predicate.overlaps(reader.getMinTimestamp(), reader.getMaxTimestamp()) ||
+                !reader.mayContain(predicate.sourceType, predicate.status)) {
+                state.segmentsPruned++;
+                continue;
+            }
+            source.minTimestamp = reader.getMinTimestamp();
+            source.maxTimestamp = reader.getMaxTimestamp();
+        } else if (!lineParser) {
+            continue;
+        }
+        sources.push_back(source);
+    }
+
+    // 带limit时先扫描最可能入选的文件
+    if (predicate.limit > 0) {
+        std::stable_sort(sources.begin(), sources.end(), [&](const QuerySource& a, const QuerySource& b) {
+            return predicate.latestFirst ? a.maxTimestamp > b.maxTimestamp : a.minTimestamp < b.minTimestamp;
+        });
+    }
+
+    size_t memoryIndex = sources.size();
+    state.results.resize(sources.size() + (memoryRows ? 1 : 0));
+    state.remaining = sources.size();
+
+    auto scanSource = [this, &state, &sources](size_t i) {
+        std::vector<LocationInfo> local;
+        const QuerySource& source = sources[i];
+        try {
+            if (!state.canQualifyRange(source.minTimestamp, source.maxTimestamp)) {
+                state.segmentsPruned++;
+            } else {
+                state.segmentsScanned++;
+                if (source.segment) {
+                    scanSegment(state, source, local);
+                } else {
+                    scanLogFile(state, source, lineParser, local);
+                }
+                state.trim(local);
+            }
+        } catch (const std::exception& e) {
+            LOG_WARNING("Failed to scan %s: %s", source.path.c_str(), e.what());
+        }
+        state.finish(i, std::move(local));
+    };
+
+    // 带limit时在调用线程中先扫描最可能入选的文件，收紧界限后其余文件再并行扫描，
+    // 否则各线程同时开始扫描时界限尚未收紧，剪枝不生效
+    size_t first = 0;
+    if (predicate.limit > 0 && !sources.empty()) {
+        scanSource(0);
+        first = 1;
+    }
+    for (size_t i = first; i < sources.size(); ++i) {
+        submit([&scanSource, i]() { scanSource(i); });
+    }
+
+    // 尚未落盘的数据在调用线程中扫描
+    if (memoryRows) {
+        std::vector<LocationInfo> local;
+        scanColumns(state, *memoryRows, local);
+        state.trim(local);
+        std::stable_sort(local.begin(), local.end(), [&](const LocationInfo& a, const LocationInfo& b) {
+            return state.before(a.timestamp, b.timestamp);
+        });
+        std::lock_guard<std::mutex> lock(state.doneMutex);
+        state.results[memoryIndex] = std::move(local);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state.doneMutex);
+        state.doneCV.wait(lock, [&] { return state.remaining == 0; });
+    }
+
+    // k路归并各来源的有序结果
+    using Cursor = std::pair<size_t, size_t>; // (来源下标, 行下标)
+    auto compare = [&](const Cursor& a, const Cursor& b) {
+        return state.before(state.results[b.first][b.second].timestamp,
+                            state.results[a.first][a.second].timestamp);
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(compare)> heap(compare);
+    size_t total = 0;
+    for (size_t i = 0; i < state.results.size(); ++i) {
+        total += state.results[i].size();
+        if (!state.results[i].empty()) {
+            heap.push({i, 0});
+        }
+    }
+
+    size_t limit = predicate.limit > 0 ? std::min(predicate.limit, total) : total;
+    std::vector<LocationInfo> result;
+    result.reserve(limit);
+    while (!heap.empty() && result.size() < limit) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        result.push_back(std::move(state.results[cursor.first][cursor.second]));
+        if (cursor.second + 1 < state.results[cursor.first].size()) {
+            heap.push({cursor.first, cursor.second + 1});
+        }
+    }
+
+    if (stats) {
+        stats->segmentsTotal = files.size();
+        stats->segmentsPruned = state.segmentsPruned;
+        stats->segmentsScanned = state.segmentsScanned;
+        stats->blocksPruned = state.blocksPruned;
+        stats->blocksScanned = state.blocksScanned;
+        stats->rowsScanned = state.rowsScanned;
+        stats->rowsMatched = result.size();
+        stats->bytesRead = state.bytesRead;
+        stats->elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    LOG_DEBUG("Query scanned %zu of %zu files, returned %zu rows",
+              static_cast<size_t>(state.segmentsScanned), files.size(), result.size());
+    return result;
+}
+
+// LocationCursor构造函数
+LocationCursor::LocationCursor(const std::vector<std::string>& queryFiles, const QueryPredicate& queryPredicate,
+                               uint32_t queryColumnMask, size_t queryBatchSize) :
+    files(queryFiles),
+    predicate(queryPredicate),
+    columnMask(queryColumnMask | codecColumnBit(CodecColumn::TIMESTAMP)),
+    decodeMask(0),
+    bitmapDecodeMask(0),
+    rowPredicate(queryPredicate),
+    batchSize(std::max<size_t>(queryBatchSize, 1)),
+    planned(false),
+    sourceIndex(0),
+    sourceOpen(false),
+    blockIndex(0),
+    currentRows(nullptr),
+    rowIndex(0),
+    reverseRows(false),
+    selectionActive(false),
+    deviceCode(0),
+    deviceFound(true),
+    returned(0) {
+    // 过滤条件用到的列即使不返回也需要解码
+    decodeMask = columnMask;
+    if (predicate.sourceType) {
+        decodeMask |= codecColumnBit(CodecColumn::SOURCE_TYPE);
+    }
+    if (predicate.status) {
+        decodeMask |= codecColumnBit(CodecColumn::STATUS);
+    }
+    if (predicate.maxAccuracy) {
+        decodeMask |= codecColumnBit(CodecColumn::ACCURACY);
+    }
+    if (!predicate.deviceId.empty()) {
+        decodeMask |= codecColumnBit(CodecColumn::DEVICE);
+    }
+
+    // 数据源类型和状态条件由行位图判断时，未返回的这两列无需解码
+    bitmapDecodeMask = decodeMask & ~((codecColumnBit(CodecColumn::SOURCE_TYPE) | codecColumnBit(CodecColumn::STATUS)) &
+                                      ~columnMask);
+    rowPredicate.sourceType.reset();
+    rowPredicate.status.reset();
+}
+
+// LocationCursor析构函数
+LocationCursor::~LocationCursor() = default;
+
+// 添加内存中的数据作为查询来源
+void LocationCursor::addMemoryRows(std::shared_ptr<const LocationColumns> rows) {
+    if (planned || !rows || rows->empty()) {
+        return;
+    }
+
+    Source source;
+    source.segment = false;
+    source.rows = rows;
+    auto range = std::minmax_element(rows->timestamps.begin(), rows->timestamps.end());
+    source.minTimestamp = *range.first;
+    source.maxTimestamp = *range.second;
+    sources.push_back(source);
+}
+
+// 根据段文件索引生成查询计划
+void LocationCursor::plan() {
+    planned = true;
+    stats.segmentsTotal = files.size();
+
+    for (const auto& path : files) {
+        Source source;
+        source.path = path;
+        source.segment = std::filesystem::path(path).extension() == SEGMENT_FILE_EXTENSION;
+        source.minTimestamp = std::numeric_limits<long long>::min();
+        source.maxTimestamp = std::numeric_limits<long long>::max();
+
+        if (source.segment) {
+            SegmentReader footerReader;
+            if (!footerReader.open(path)) {
+                continue;
+            }
+            stats.bytesRead += footerReader.getBytesRead();
+            if (footerReader.getBlocks().empty() ||
+                !footerReader.mayContain(predicate.sourceType, predicate.status)) {
+                stats.segmentsPruned++;
+                continue;
+            }
+            source.minTimestamp = footerReader.getMinTimestamp();
+            source.maxTimestamp = footerReader.getMaxTimestamp();
+        } else if (!lineParser) {
+            continue;
+        }
+        sources.push_back(source);
+    }
+
+    // 按时间范围剪枝后按查询方向排序
+    auto end = std::remove_if(sources.begin(), sources.end(), [this](const Source& source) {
+        if (predicate.overlaps(source.minTimestamp, source.maxTimestamp)) {
+            return false;
+        }
+        if (!source.rows) {
+            stats.segmentsPruned++;
+        }
+        return true;
+    });
+    sources.erase(end, sources.end());
+
+    std::stable_sort(sources.begin(), sources.end(), [this](const Source& a, const Source& b) {
+        return predicate.latestFirst ? a.maxTimestamp > b.maxTimestamp : a.minTimestamp < b.minTimestamp;
+    });
+}
+
+// 关闭当前来源
+void LocationCursor::closeSource() {
+    if (reader) {
+        stats.bytesRead += reader->getBytesRead();
+        reader.reset();
+    }
+    logStream.reset();
+    blockOrder.clear();
+    blockIndex = 0;
+    currentRows = nullptr;
+    rowIndex = 0;
+    sourceOpen = false;
+    sourceIndex++;
+}
+
+// 切换到当前数据
+void LocationCursor::resetRows(const LocationColumns* rows, bool reverse) {
+    currentRows = rows;
+    rowIndex = 0;
+    reverseRows = reverse;
+    selectionActive = false;
+    deviceRemap.clear();
+    extrasRemap.clear();
+
+    // 设备ID先在字典中查找，没有该设备时整批跳过
+    deviceFound = true;
+    if (!predicate.deviceId.empty()) {
+        auto it = std::find(rows->deviceDictionary.begin(), rows->deviceDictionary.end(), predicate.deviceId);
+        deviceFound = it != rows->deviceDictionary.end();
+        deviceCode = static_cast<uint32_t>(it - rows->deviceDictionary.begin());
+    }
+}
+
+// 加载下一批待扫描数据
+bool LocationCursor::loadNext() {
+    while (sourceIndex < sources.size()) {
+        const Source& source = sources[sourceIndex];
+
+        if (!sourceOpen) {
+            sourceOpen = true;
+            stats.segmentsScanned += source.rows ? 0 : 1;
+
+            if (source.rows) {
+                resetRows(source.rows.get(), predicate.latestFirst);
+                return true;
+            }
+
+            if (source.segment) {
+                reader = std::make_unique<SegmentReader>();
+                if (!reader->open(source.path)) {
+                    closeSource();
+                    continue;
+                }
+
+                const auto& blocks = reader->getBlocks();
+                for (size_t i = 0; i < blocks.size(); ++i) {
+                    if (predicate.overlaps(blocks[i].minTimestamp, blocks[i].maxTimestamp) &&
+                        blocks[i].mayContain(predicate.sourceType, predicate.status)) {
+                        blockOrder.push_back(i);
+                    } else {
+                        stats.blocksPruned++;
+                    }
+                }
+                std::stable_sort(blockOrder.begin(), blockOrder.end(), [&](size_t a, size_t b) {
+                    return predicate.latestFirst ? blocks[a].maxTimestamp > blocks[b].maxTimestamp
+                                                 : blocks[a].minTimestamp < blocks[b].minTimestamp;
+                });
+            } else {
+                logStream = std::make_unique<std::ifstream>(source.path);
+                if (!logStream->is_open()) {
+                    LOG_WARNING("Failed to open log file for reading: %s", source.path.c_str());
+                    closeSource();
+                    continue;
+                }
+            }
+        }
+
+        if (reader) {
+            while (blockIndex < blockOrder.size()) {
+                // 有行位图时先求出候选行，没有候选行的块不解码
+                size_t block = blockOrder[blockIndex++];
+                bool selected = reader->readRowBitmap(block, predicate.sourceType, predicate.status, rowSelection);
+                if (selected && std::all_of(rowSelection.begin(), rowSelection.end(),
+                                            [](uint64_t word) { return word == 0; })) {
+                    stats.blocksPruned++;
+                    continue;
+                }
+
+                current.clear();
+                if (!reader->readBlock(block, current, selected ? bitmapDecodeMask : decodeMask)) {
+                    continue;
+                }
+                stats.blocksScanned++;
+                resetRows(&current, predicate.latestFirst);
+                selectionActive = selected;
+                return true;
+            }
+        } else if (logStream) {
+            // CSV日志每次解析一批行，行的顺序保持文件中的顺序
+            current.clear();
+            std::string line;
+            LocationInfo location;
+            while (current.size() < batchSize && std::getline(*logStream, line)) {
+                stats.bytesRead += line.size() + 1;
+                if (lineParser(line, location)) {
+                    current.append(location);
+                }
+            }
+            if (!current.empty()) {
+                resetRows(&current, false);
+                return true;
+            }
+        }
+
+        closeSource();
+    }
+
+    return false;
+}
+
+// 将当前数据中的一行按投影复制到输出批次
+void LocationCursor::copyRow(size_t row, LocationColumns& batch) {
+    const LocationColumns& rows = *currentRows;
+    auto selected = [this](CodecColumn column) { return (columnMask & codecColumnBit(column)) != 0; };
+
+    batch.timestamps.push_back(rows.timestamps[row]);
+    batch.latitudes.push_back(selected(CodecColumn::LATITUDE) ? rows.latitudes[row] : 0.0);
+    batch.longitudes.push_back(selected(CodecColumn::LONGITUDE) ? rows.longitudes[row] : 0.0);
+    batch.altitudes.push_back(selected(CodecColumn::ALTITUDE) ? rows.altitudes[row] : 0.0);
+    batch.accuracies.push_back(selected(CodecColumn::ACCURACY) ? rows.accuracies[row] : 0.0);
+    batch.speeds.push_back(selected(CodecColumn::SPEED) ? rows.speeds[row] : 0.0);
+    batch.directions.push_back(selected(CodecColumn::DIRECTION) ? rows.directions[row] : 0.0);
+    batch.sourceTypes.push_back(selected(CodecColumn::SOURCE_TYPE) ? rows.sourceTypes[row] : 0);
+    batch.statuses.push_back(selected(CodecColumn::STATUS) ? rows.statuses[row] : 0);
+
+    // 字典下标通过映射表转换，每个字典项只需查找一次
+    uint32_t deviceIndex = selected(CodecColumn::DEVICE) ? rows.deviceIndexes[row] : 0;
+    if (deviceRemap.size() <= deviceIndex) {
+        deviceRemap.resize(rows.deviceDictionary.size() + 1, std::numeric_limits<uint32_t>::max());
+    }
+    if (deviceRemap[deviceIndex] == std::numeric_limits<uint32_t>::max()) {
+        deviceRemap[deviceIndex] = batch.internDevice(
+            selected(CodecColumn::DEVICE) ? rows.deviceDictionary[deviceIndex] : std::string());
+    }
+    batch.deviceIndexes.push_back(deviceRemap[deviceIndex]);
+
+    uint32_t extrasIndex = selected(CodecColumn::EXTRAS) ? rows.extrasIndexes[row] : 0;
+    if (extrasRemap.size() <= extrasIndex) {
+        extrasRemap.resize(rows.extrasDictionary.size() + 1, std::numeric_limits<uint32_t>::max());
+    }
+    if (extrasRemap[extrasIndex] == std::numeric_limits<uint32_t>::max()) {
+        extrasRemap[extrasIndex] = batch.internExtras(
+            selected(CodecColumn::EXTRAS) ? rows.extrasDictionary[extrasIndex] : std::string());
+    }
+    batch.extrasIndexes.push_back(extrasRemap[extrasIndex]);
+}
+
+// 读取下一批满足条件的数据
+bool LocationCursor::next(LocationColumns& batch) {
+    auto startTime = std::chrono::steady_clock::now();
+    batch.clear();
+    deviceRemap.clear();
+    extrasRemap.clear();
+
+    if (!planned) {
+        plan();
+    }
+
+    bool limited = predicate.limit > 0;
+    while (batch.size() < batchSize && !(limited && returned >= predicate.limit)) {
+        if (!currentRows || rowIndex >= currentRows->size()) {
+            if (!loadNext()) {
+                break;
+            }
+            continue;
+        }
+
+        const LocationColumns& rows = *currentRows;
+        if (!deviceFound) {
+            stats.rowsScanned += rows.size() - rowIndex;
+            rowIndex = rows.size();
+            continue;
+        }
+
+        while (rowIndex < rows.size() && batch.size() < batchSize && !(limited && returned >= predicate.limit)) {
+            size_t row = reverseRows ? rows.size() - 1 - rowIndex : rowIndex;
+            rowIndex++;
+            stats.rowsScanned++;
+
+            if (selectionActive && !((rowSelection[row / 64] >> (row % 64)) & 1)) {
+                continue;
+            }
+            if (!(selectionActive ? rowPredicate : predicate).matchesRow(rows, row) ||
+                (!predicate.deviceId.empty() && rows.deviceIndexes[row] != deviceCode)) {
+                continue;
+            }
+            copyRow(row, batch);
+            returned++;
+        }
+    }
+
+    // 达到limit后立即释放打开的文件
+    if (limited && returned >= predicate.limit) {
+        while (sourceIndex < sources.size()) {
+            closeSource();
+        }
+    }
+
+    stats.rowsMatched = returned;
+    stats.elapsedMs += std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return !batch.empty();
+}
@@ -0,0 +1,248 @@
+// StorageTee.cpp - 多存储后端异步分发实现
+
+#include "StorageTee.h"
+#include "DataStorage.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+
+// StorageTee构造函数
+StorageTee::StorageTee(size_t capacity) :
+    ring(std::max<size_t>(capacity, 1)),
+    head(0),
+    running(true) {
+}
+
+// StorageTee析构函数
+StorageTee::~StorageTee() {
+    shutdown();
+}
+
+// 添加后端
+bool StorageTee::addBackend(const std::string& name, std::shared_ptr<DataStorage> storage,
+                            const TeeBackendConfig& config) {
+    if (!storage) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!running || backends.find(name) != backends.end()) {
+        return false;
+    }
+
+    auto backend = std::make_unique<Backend>();
+    backend->name = name;
+    backend->storage = storage;
+    backend->config = config;
+    // 批大小不超过缓冲区的一半，保证凑批等待期间不会因队列满而丢数据
+    backend->config.batchSize = std::max<size_t>(std::min(config.batchSize, ring.size() / 2), 1);
+    backend->cursor = head;
+    backend->inFlight = 0;
+    backend->stopping = false;
+    backend->worker = std::thread(&StorageTee::workerLoop, this, backend.get());
+    backends[name] = std::move(backend);
+
+    LOG_INFO("Storage tee backend added: %s", name.c_str());
+    return true;
+}
+
+// 移除后端
+bool StorageTee::removeBackend(const std::string& name) {
+    Backend* backend = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = backends.find(name);
+        if (it == backends.end() || it->second->stopping) {
+            return false;
+        }
+        backend = it->second.get();
+        backend->stopping = true;
+    }
+    dataAvailable.notify_all();
+
+    // 写入线程写完积压数据后退出，期间仍保留在列表中以免缓冲区被覆盖
+    backend->worker.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        backends.erase(name);
+    }
+    spaceAvailable.notify_all();
+
+    LOG_INFO("Storage tee backend removed: %s", name.c_str());
+    return true;
+}
+
+// 为新数据腾出位置
+bool StorageTee::reserveSlot(std::unique_lock<std::mutex>& lock) {
+    const uint64_t capacity = ring.size();
+
+    while (running) {
+        bool blocked = false;
+        for (auto& [name, backend] : backends) {
+            if (head - backend->cursor < capacity) {
+                continue;
+            }
+            if (backend->config.policy == TeeOverflowPolicy::BLOCK && !backend->stopping) {
+                blocked = true;
+            } else {
+                // 跳过该后端最早的一条数据
+                backend->cursor++;
+                backend->stats.dropped++;
+            }
+        }
+
+        if (!blocked) {
+            return true;
+        }
+        spaceAvailable.wait(lock);
+    }
+
+    return false;
+}
+
+// 分发一条位置数据
+bool StorageTee::publish(const LocationInfo& location) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!reserveSlot(lock)) {
+            return false;
+        }
+        ring[head % ring.size()] = location;
+        head++;
+    }
+    dataAvailable.notify_all();
+    return true;
+}
+
+// 分发一批位置数据
+bool StorageTee::publish(const std::vector<LocationInfo>& locations) {
+    bool ok = true;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (const auto& location : locations) {
+            if (!reserveSlot(lock)) {
+                ok = false;
+                break;
+            }
+            ring[head % ring.size()] = location;
+            head++;
+        }
+    }
+    dataAvailable.notify_all();
+    return ok;
+}
+
+// 后端写入线程主循环
+void StorageTee::workerLoop(Backend* backend) {
+    std::vector<LocationInfo> batch;
+    batch.reserve(backend->config.batchSize);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            dataAvailable.wait(lock, [&] { return backend->cursor < head || backend->stopping; });
+            if (backend->cursor >= head) {
+                break; // 已停止且没有积压数据
+            }
+
+            // 数据不足一批时短暂等待凑批
+            if (!backend->stopping && head - backend->cursor < backend->config.batchSize) {
+                dataAvailable.wait_for(lock, std::chrono::milliseconds(backend->config.maxBatchDelayMs), [&] {
+                    return head - backend->cursor >= backend->config.batchSize || backend->stopping;
+                });
+            }
+
+            size_t count = static_cast<size_t>(
+                std::min<uint64_t>(head - backend->cursor, backend->config.batchSize));
+            batch.clear();
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(ring[(backend->cursor + i) % ring.size()]);
+            }
+            backend->cursor += count;
+            backend->inFlight = count;
+        }
+        spaceAvailable.notify_all();
+
+        bool ok = false;
+        try {
+            ok = batch.size() == 1 ? backend->storage->store(batch.front())
+                                   : backend->storage->batchStore(batch);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Storage tee backend %s failed: %s", backend->name.c_str(), e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) {
+                backend->stats.written += batch.size();
+            } else {
+                backend->stats.failed += batch.size();
+            }
+            backend->stats.batches++;
+            backend->inFlight = 0;
+        }
+        spaceAvailable.notify_all();
+    }
+}
+
+// 等待所有后端写完已入队的数据
+void StorageTee::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceAvailable.wait(lock, [&] {
+        for (const auto& [name, backend] : backends) {
+            if (backend->cursor < head || backend->inFlight > 0) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+// 停止所有后端
+void StorageTee::shutdown() {
+    std::vector<Backend*> stopping;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+        for (auto& [name, backend] : backends) {
+            // 正在移除的后端由removeBackend负责回收
+            if (!backend->stopping) {
+                backend->stopping = true;
+                stopping.push_back(backend.get());
+            }
+        }
+    }
+    dataAvailable.notify_all();
+    spaceAvailable.notify_all();
+
+    // 已停止接收新数据，缓冲区不会再被覆盖
+    for (Backend* backend : stopping) {
+        backend->worker.join();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (Backend* backend : stopping) {
+        std::string name = backend->name;
+        backends.erase(name);
+    }
+    spaceAvailable.wait(lock, [&] { return backends.empty(); });
+}
+
+// 获取指定后端的统计
+bool StorageTee::getStats(const std::string& name, TeeBackendStats& stats) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = backends.find(name);
+    if (it == backends.end()) {
+        return false;
+    }
+
+    stats = it->second->stats;
+    stats.pending = head - it->second->cursor + it->second->inFlight;
+    return true;
+}
@@ -0,0 +1,522 @@
+// WriteAheadLog.cpp - 预写日志与检查点实现
+
+#include "WriteAheadLog.h"
+#include "Logger.h"
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// 预写日志文件扩展名定义
+const char* const WAL_FILE_EXTENSION = ".wal";
+
+namespace {
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x4B43574C;   // "LWCK"
+constexpr size_t RECORD_HEADER_SIZE = 9;            // 长度(4) + 校验(4) + 类型(1)
+constexpr uint32_t MAX_RECORD_SIZE = 256u << 20;    // 单条记录上限，用于识别损坏的长度
+const char* const CHECKPOINT_FILE_NAME = "CHECKPOINT";
+
+// 以小端序写入32位整数
+void putUint32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+// 以小端序读取32位整数
+uint32_t getUint32(const uint8_t* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+#if !defined(__SSE4_2__)
+// CRC32C查找表（slicing-by-8）
+struct Crc32cTable {
+    std::array<std::array<uint32_t, 256>, 8> table;
+
+    Crc32cTable() : table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32cTable& crc32cTable() {
+    static const Crc32cTable instance;
+    return instance;
+}
+#endif
+
+} // namespace
+
+// 计算CRC32C校验值
+uint32_t WriteAheadLog::crc32c(const uint8_t* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+
+#if defined(__SSE4_2__)
+    // 使用SSE4.2的CRC32指令，每次处理8字节
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (size > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+        --size;
+    }
+#else
+    const auto& table = crc32cTable().table;
+    while (size >= 8) {
+        uint32_t low = crc ^ getUint32(data);
+        uint32_t high = getUint32(data + 4);
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^
+              table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+              table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+              table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+        --size;
+    }
+#endif
+
+    return ~crc;
+}
+
+// WriteAheadLog构造函数
+WriteAheadLog::WriteAheadLog() :
+    file(nullptr),
+    fileStartLsn(0),
+    endLsn(0),
+    maxFileSize(64 * 1024 * 1024), // 默认64MB
+    syncMode(WalSyncMode::FLUSH) {
+}
+
+// WriteAheadLog析构函数
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+// 获取指定LSN对应的日志文件名（固定宽度，字典序即LSN顺序）
+std::string WriteAheadLog::fileNameFor(const std::string& directory, uint64_t startLsn) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020" PRIu64, startLsn);
+    return directory + "/" + name + WAL_FILE_EXTENSION;
+}
+
+// 获取目录下所有日志文件的起始LSN（升序）
+std::vector<uint64_t> WriteAheadLog::listFiles(const std::string& directory) {
+    std::vector<uint64_t> files;
+
+    if (!std::filesystem::exists(directory)) {
+        return files;
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != WAL_FILE_EXTENSION) {
+            continue;
+        }
+        try {
+            files.push_back(std::stoull(entry.path().stem().string()));
+        } catch (const std::exception&) {
+            LOG_WARNING("Ignoring unexpected file in WAL directory: %s", entry.path().string().c_str());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// 打开日志文件
+bool WriteAheadLog::openFile(uint64_t startLsn, bool truncate) {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    std::string path = fileNameFor(directory, startLsn);
+    file = std::fopen(path.c_str(), truncate ? "wb" : "ab");
+    if (!file) {
+        LOG_ERROR("Failed to open WAL file: %s", path.c_str());
+        return false;
+    }
+
+    fileStartLsn = startLsn;
+    return true;
+}
+
+// 校验日志文件，返回最后一条完整记录的结束偏移
+uint64_t WriteAheadLog::scanValidLength(const std::string& path) const {
+    std::ifstream input(path, std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        return 0;
+    }
+
+    uint64_t offset = 0;
+    uint8_t header[RECORD_HEADER_SIZE];
+    std::vector<uint8_t> payload;
+    while (input.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE)) {
+        uint32_t length = getUint32(header);
+        uint32_t checksum = getUint32(header + 4);
+        if (length == 0 || length > MAX_RECORD_SIZE) {
+            break;
+        }
+
+        payload.resize(length - 1);
+        if (!input.read(reinterpret_cast<char*>(payload.data()), payload.size())) {
+            break;
+        }
+        uint32_t actual = crc32c(header + 8, 1);
+        actual = crc32c(payload.data(), payload.size(), actual);
+        if (actual != checksum) {
+            break;
+        }
+
+        offset += 8 + length;
+    }
+    return offset;
+}
+
+// 打开日志目录
+bool WriteAheadLog::open(const std::string& directoryPath, WalCheckpoint* checkpoint) {
+    close();
+    directory = directoryPath;
+
+    try {
+        std::filesystem::create_directories(directory);
+
+        // 新记录至少从检查点之后开始
+        WalCheckpoint lastCheckpoint;
+        readCheckpoint(lastCheckpoint);
+        uint64_t startLsn = lastCheckpoint.lsn;
+        if (checkpoint) {
+            *checkpoint = lastCheckpoint;
+        }
+
+        std::vector<uint64_t> files = listFiles(directory);
+        if (files.empty()) {
+            endLsn = startLsn;
+            return openFile(startLsn);
+        }
+
+        // 只需校验最后一个文件：之前的文件在切换时已完整写入
+        std::string lastPath = fileNameFor(directory, files.back());
+        uint64_t fileSize = std::filesystem::file_size(lastPath);
+        uint64_t validLength = scanValidLength(lastPath);
+        if (validLength < fileSize) {
+            LOG_WARNING("Truncating torn WAL tail: %s (%" PRIu64 " -> %" PRIu64 " bytes)",
+                        lastPath.c_str(), fileSize, validLength);
+            std::filesystem::resize_file(lastPath, validLength);
+        }
+
+        endLsn = files.back() + validLength;
+        if (endLsn < startLsn) {
+            // 检查点已经超过日志末尾（日志被清理过），从检查点处开始新文件
+            LOG_WARNING("WAL ends before checkpoint, starting new log at %" PRIu64, startLsn);
+            endLsn = startLsn;
+            return openFile(startLsn);
+        }
+        return openFile(files.back());
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to open WAL directory %s: %s", directory.c_str(), e.what());
+        return false;
+    }
+}
+
+// 关闭日志
+void WriteAheadLog::close() {
+    if (file) {
+        sync();
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+// 追加一批位置数据
+uint64_t WriteAheadLog::append(const LocationColumns& rows) {
+    if (!file || rows.empty()) {
+        return 0;
+    }
+
+    std::vector<uint8_t> payload;
+    LocationCodec::encodeBlock(rows, payload);
+    return appendRecord(RECORD_LOCATIONS, payload);
+}
+
+// 写入一条记录
+uint64_t WriteAheadLog::appendRecord(uint8_t type, const std::vector<uint8_t>& payload) {
+    if (endLsn - fileStartLsn >= maxFileSize && !openFile(endLsn, true)) {
+        return 0;
+    }
+
+    uint32_t checksum = crc32c(&type, 1);
+    checksum = crc32c(payload.data(), payload.size(), checksum);
+
+    buffer.clear();
+    buffer.reserve(RECORD_HEADER_SIZE + payload.size());
+    putUint32(buffer, static_cast<uint32_t>(payload.size() + 1));
+    putUint32(buffer, checksum);
+    buffer.push_back(type);
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    if (ok && syncMode == WalSyncMode::FLUSH) {
+        ok = std::fflush(file) == 0;
+    } else if (ok && syncMode == WalSyncMode::FSYNC) {
+        ok = sync();
+    }
+
+    if (!ok) {
+        LOG_ERROR("Failed to append WAL record at LSN %" PRIu64, endLsn);
+        discardTornTail();
+        return 0;
+    }
+
+    endLsn += buffer.size();
+    return endLsn;
+}
+
+// 写入失败后丢弃当前文件末尾残留的半条记录
+// 先关闭文件（丢弃缓冲区中未写出的数据），再截断到最后一条完整记录的末尾后继续追加；
+// 截断失败时后续记录写入以当前LSN命名的新文件（同名文件清空），重放时从断点处衔接
+bool WriteAheadLog::discardTornTail() {
+    std::string path = fileNameFor(directory, fileStartLsn);
+    std::fclose(file);
+    file = nullptr;
+
+    std::error_code ec;
+    std::filesystem::resize_file(path, endLsn - fileStartLsn, ec);
+    if (!ec) {
+        return openFile(fileStartLsn);
+    }
+
+    LOG_WARNING("Failed to truncate WAL file %s: %s", path.c_str(), ec.message().c_str());
+    return openFile(endLsn, true);
+}
+
+// 将缓冲区数据同步到磁盘
+bool WriteAheadLog::sync() {
+    if (!file) {
+        return false;
+    }
+
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    return fsync(fileno(file)) == 0;
+#else
+    return true;
+#endif
+}
+
+// 校验并解析内存中的一条记录
+size_t WriteAheadLog::parseRecord(const uint8_t* data, size_t available, uint8_t& type,
+                                  const uint8_t*& payload, size_t& payloadSize) {
+    if (available < RECORD_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint32_t length = getUint32(data);
+    uint32_t checksum = getUint32(data + 4);
+    if (length == 0 || length > MAX_RECORD_SIZE || available - 8 < length) {
+        return 0;
+    }
+    if (crc32c(data + 8, length) != checksum) {
+        return 0;
+    }
+
+    type = data[8];
+    payload = data + RECORD_HEADER_SIZE;
+    payloadSize = length - 1;
+    return 8 + static_cast<size_t>(length);
+}
+
+// 从指定LSN开始重放位置数据记录
+bool WriteAheadLog::replay(uint64_t fromLsn,
+                           const std::function<void(uint64_t, const LocationColumns&)>& visitor) const {
+    std::vector<uint64_t> files = listFiles(directory);
+    uint64_t position = fromLsn;
+    uint8_t header[RECORD_HEADER_SIZE];
+    std::vector<uint8_t> payload;
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint64_t nextStart = i + 1 < files.size() ? files[i + 1] : UINT64_MAX;
+        if (nextStart <= position) {
+            continue;
+        }
+        if (files[i] > position) {
+            LOG_ERROR("WAL gap detected: expected LSN %" PRIu64 ", next file starts at %" PRIu64,
+                      position, files[i]);
+            return false;
+        }
+
+        std::ifstream input(fileNameFor(directory, files[i]), std::ios::in | std::ios::binary);
+        if (!input.is_open()) {
+            LOG_ERROR("Failed to open WAL file for replay: %s", fileNameFor(directory, files[i]).c_str());
+            return false;
+        }
+        input.seekg(static_cast<std::streamoff>(position - files[i]));
+
+        while (position < nextStart && input.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE)) {
+            uint32_t length = getUint32(header);
+            uint32_t checksum = getUint32(header + 4);
+            if (length == 0 || length > MAX_RECORD_SIZE) {
+                break;
+            }
+
+            payload.resize(length - 1);
+            if (!input.read(reinterpret_cast<char*>(payload.data()), payload.size())) {
+                break;
+            }
+            uint32_t actual = crc32c(header + 8, 1);
+            actual = crc32c(payload.data(), payload.size(), actual);
+            if (actual != checksum) {
+                break;
+            }
+
+            position += 8 + length;
+            if (header[8] == RECORD_LOCATIONS) {
+                LocationColumns rows;
+                if (!LocationCodec::decodeBlock(payload.data(), payload.size(), rows)) {
+                    LOG_ERROR("Failed to decode WAL record ending at LSN %" PRIu64, position);
+                    return false;
+                }
+                visitor(position, rows);
+            }
+        }
+
+        // 文件中断处必须与下一个文件衔接，否则之后的数据不可信
+        if (position != nextStart && i + 1 < files.size()) {
+            LOG_ERROR("Corrupted WAL record at LSN %" PRIu64, position);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 删除完全位于指定LSN之前的日志文件
+void WriteAheadLog::truncateBefore(uint64_t lsn) {
+    std::vector<uint64_t> files = listFiles(directory);
+
+    for (size_t i = 0; i + 1 < files.size(); ++i) {
+        if (files[i + 1] > lsn || files[i] == fileStartLsn) {
+            break;
+        }
+        std::error_code ec;
+        if (!std::filesystem::remove(fileNameFor(directory, files[i]), ec)) {
+            LOG_WARNING("Failed to remove WAL file: %s", fileNameFor(directory, files[i]).c_str());
+        }
+    }
+}
+
+// 删除所有日志文件和检查点
+bool WriteAheadLog::reset() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    std::error_code ec;
+    for (uint64_t start : listFiles(directory)) {
+        std::filesystem::remove(fileNameFor(directory, start), ec);
+    }
+    std::filesystem::remove(directory + "/" + CHECKPOINT_FILE_NAME, ec);
+
+    // LSN从当前末尾继续编号，保证单调递增（变更订阅的偏移不会回退）；检查点指向新的起点，重放时不会误判为缺失
+    if (!openFile(endLsn)) {
+        return false;
+    }
+    WalCheckpoint checkpoint;
+    checkpoint.lsn = endLsn;
+    return writeCheckpoint(checkpoint);
+}
+
+// 写入检查点
+bool WriteAheadLog::writeCheckpoint(const WalCheckpoint& checkpoint) {
+    std::vector<uint8_t> data;
+    putUint32(data, CHECKPOINT_MAGIC);
+    putUint32(data, static_cast<uint32_t>(checkpoint.lsn));
+    putUint32(data, static_cast<uint32_t>(checkpoint.lsn >> 32));
+    putUint32(data, static_cast<uint32_t>(checkpoint.meta.size()));
+    data.insert(data.end(), checkpoint.meta.begin(), checkpoint.meta.end());
+    putUint32(data, crc32c(data.data(), data.size()));
+
+    std::string path = directory + "/" + CHECKPOINT_FILE_NAME;
+    std::string tempPath = path + ".tmp";
+
+    std::FILE* output = std::fopen(tempPath.c_str(), "wb");
+    if (!output) {
+        LOG_ERROR("Failed to create WAL checkpoint: %s", tempPath.c_str());
+        return false;
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), output) == data.size() && std::fflush(output) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+    ok = ok && (syncMode != WalSyncMode::FSYNC || fsync(fileno(output)) == 0);
+#endif
+    ok = std::fclose(output) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+    }
+    if (!ok || ec) {
+        LOG_ERROR("Failed to write WAL checkpoint: %s", path.c_str());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+// 读取检查点
+bool WriteAheadLog::readCheckpoint(WalCheckpoint& checkpoint) const {
+    std::ifstream input(directory + "/" + CHECKPOINT_FILE_NAME, std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+        return false;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (data.size() < 20 || getUint32(data.data()) != CHECKPOINT_MAGIC) {
+        LOG_WARNING("Invalid WAL checkpoint in %s", directory.c_str());
+        return false;
+    }
+
+    uint32_t metaSize = getUint32(data.data() + 12);
+    if (data.size() != 20 + static_cast<size_t>(metaSize) ||
+        crc32c(data.data(), data.size() - 4) != getUint32(data.data() + data.size() - 4)) {
+        LOG_WARNING("Corrupted WAL checkpoint in %s", directory.c_str());
+        return false;
+    }
+
+    checkpoint.lsn = static_cast<uint64_t>(getUint32(data.data() + 4)) |
+                     (static_cast<uint64_t>(getUint32(data.data() + 8)) << 32);
+    checkpoint.meta.assign(data.begin() + 16, data.begin() + 16 + metaSize);
+    return true;
+}
@@ -1,3 +1,6 @@
+#include "ConfigStore.h"
+#include "ConfigWatcher.h"
+#include "FlightRecorder.h"
 #include "LocationService.h"
 #include "Logger.h"
 #include <iostream>
@@ -99,6 +102,9 @@ int main() {
     Logger::getInstance().setLogLevel(LogLevel::INFO);
     Logger::getInstance().info("位置纠偏系统启动");
     
+    // 崩溃时转储飞行记录器中最近的流水线事件
+    FlightRecorder::getInstance().installCrashHandler();
+    
     // 创建位置服务
     std::cout << "正在初始化位置服务..." << std::endl;
     auto serviceFactory = LocationServiceFactory::getInstance();
@@ -114,12 +120,38 @@ int main() {
     config.cacheSize = 100;
     config.batchProcessingSize = 10;
     
+    // 设备算法状态定期写入检查点，重启后恢复
+    if (auto baseService = std::dynamic_pointer_cast<BaseLocationService>(locationService)) {
+        baseService->setStateCheckpoint(std::string("device_state") + DEVICE_STATE_FILE_EXTENSION);
+    }
+    
     // 初始化位置服务
     if (!locationService->initialize(config)) {
         std::cerr << "位置服务初始化失败！" << std::endl;
         return 1;
     }
     
+    // 从本地缓存预加载纠偏配置，之后缓存文件被同步程序更新时只应用有变化的分节；
+    // 同一次更新的所有分节作为一个版本发布，处理器链和纠偏器不会看到只应用了一部分的配置
+    ConfigWatcher configWatcher("config_cache/correction.conf");
+    configWatcher.addReloadHandler([](const std::vector<ConfigSectionDiff>& changes) {
+        uint64_t version = ConfigStore<CorrectionConfig>::getInstance().update([&changes](CorrectionConfig& config) {
+            for (const auto& diff : changes) {
+                for (const auto& entry : diff.changed) {
+                    config.applyEntry(entry.first, entry.second);
+                }
+                for (const auto& key : diff.removed) {
+                    config.removeEntry(key);
+                }
+            }
+        });
+        LOG_INFO("Config reload with %zu changed sections applied as version %llu", changes.size(),
+                 static_cast<unsigned long long>(version));
+    });
+    if (!configWatcher.start()) {
+        std::cout << "未找到本地配置缓存，使用默认纠偏配置" << std::endl;
+    }
+    
     // 设置位置更新监听器
     locationService->setLocationUpdateListener(onLocationUpdated);
     
@@ -0,0 +1,120 @@
+// AlgorithmParams.cpp - 类型化的算法参数实现
+
+#include "AlgorithmParams.h"
+#include <cmath>
+#include <sstream>
+
+// AlgorithmParams构造函数
+AlgorithmParams::AlgorithmParams() {
+    for (const ParamSpec& spec : schema()) {
+        reset(spec.name);
+    }
+}
+
+// 获取参数表（新增参数时在此声明，并在结构体中加对应字段）
+const std::vector<ParamSpec>& AlgorithmParams::schema() {
+    static const std::vector<ParamSpec> specs = {
+        {"smoothingFactor", ParamType::DOUBLE, 0.0, 1.0, 0.7,
+         nullptr, &AlgorithmParams::smoothingFactor, "平滑系数"},
+        {"confidenceThreshold", ParamType::DOUBLE, 0.0, 1.0, 0.6,
+         nullptr, &AlgorithmParams::confidenceThreshold, "置信度阈值"},
+        {"stopOnInvalid", ParamType::BOOL, 0.0, 1.0, 0.0,
+         &AlgorithmParams::stopOnInvalid, nullptr, "位置无效时提前终止处理器链"},
+    };
+    return specs;
+}
+
+// 查找参数声明
+const ParamSpec* AlgorithmParams::find(const std::string& name) {
+    for (const ParamSpec& spec : schema()) {
+        if (name == spec.name) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+// 设置一个参数
+bool AlgorithmParams::set(const std::string& name, const std::string& value, std::string& error) {
+    const ParamSpec* spec = find(name);
+    if (!spec) {
+        error = "unknown parameter '" + name + "'";
+        return false;
+    }
+
+    if (spec->type == ParamType::BOOL) {
+        if (value == "true" || value == "1") {
+            this->*(spec->boolField) = true;
+        } else if (value == "false" || value == "0") {
+            this->*(spec->boolField) = false;
+        } else {
+            error = "parameter '" + name + "' expects true/false, got '" + value + "'";
+            return false;
+        }
+        return true;
+    }
+
+    // 整个值都必须是数字，"0.5x"之类的值视为无效
+    double number = 0.0;
+    size_t parsed = 0;
+    try {
+        number = std::stod(value, &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != value.size() || !std::isfinite(number)) {
+        error = "parameter '" + name + "' expects a number, got '" + value + "'";
+        return false;
+    }
+    if (number < spec->minValue || number > spec->maxValue) {
+        std::ostringstream message;
+        message << "parameter '" << name << "' = " << number << " out of range [" << spec->minValue << ", "
+                << spec->maxValue << "]";
+        error = message.str();
+        return false;
+    }
+    this->*(spec->doubleField) = number;
+    return true;
+}
+
+// 将一个参数恢复为默认值
+bool AlgorithmParams::reset(const std::string& name) {
+    const ParamSpec* spec = find(name);
+    if (!spec) {
+        return false;
+    }
+    if (spec->type == ParamType::BOOL) {
+        this->*(spec->boolField) = spec->defaultValue != 0.0;
+    } else {
+        this->*(spec->doubleField) = spec->defaultValue;
+    }
+    return true;
+}
+
+// 按参数表转换为"参数名 -> 值"
+std::map<std::string, std::string> AlgorithmParams::toMap() const {
+    std::map<std::string, std::string> result;
+    for (const ParamSpec& spec : schema()) {
+        if (spec.type == ParamType::BOOL) {
+            result[spec.name] = (this->*(spec.boolField)) ? "true" : "false";
+        } else {
+            std::ostringstream value;
+            value << this->*(spec.doubleField);
+            result[spec.name] = value.str();
+        }
+    }
+    return result;
+}
+
+// 从"参数名 -> 值"解析
+AlgorithmParams AlgorithmParams::resolve(const std::map<std::string, std::string>& raw,
+                                         std::vector<std::string>& errors) {
+    AlgorithmParams params;
+    for (const auto& entry : raw) {
+        std::string error;
+        if (!params.set(entry.first, entry.second, error)) {
+            errors.push_back(error);
+        }
+    }
+    return params;
+}
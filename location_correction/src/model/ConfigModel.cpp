@@ -1,10 +1,100 @@
 // ConfigModel.cpp - 配置数据模型实现
 
 #include "ConfigModel.h"
+#include "ConfigWatcher.h"
+#include "Logger.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// 把整个字符串解析为浮点数，有多余字符（如"12abc"）时抛出std::invalid_argument
+double toDouble(const std::string& text) {
+    size_t consumed = 0;
+    double result = std::stod(text, &consumed);
+    if (consumed != text.size()) {
+        throw std::invalid_argument("trailing characters");
+    }
+    return result;
+}
+
+// 把整个字符串解析为整数，有多余字符时抛出std::invalid_argument
+int toInt(const std::string& text) {
+    size_t consumed = 0;
+    int result = std::stoi(text, &consumed);
+    if (consumed != text.size()) {
+        throw std::invalid_argument("trailing characters");
+    }
+    return result;
+}
+
+// 解析开关值（true/false/1/0），其他值抛出std::invalid_argument
+bool toFlag(const std::string& text) {
+    if (text == "true" || text == "1") {
+        return true;
+    }
+    if (text == "false" || text == "0") {
+        return false;
+    }
+    throw std::invalid_argument("not a flag");
+}
+
+// 拆分场景区域配置项的键名scene.<场景ID>.<字段>，不是场景区域的键返回false
+bool splitSceneKey(const std::string& key, std::string& sceneId, std::string& field) {
+    if (key.compare(0, 6, "scene.") != 0) {
+        return false;
+    }
+    size_t dot = key.find('.', 6);
+    if (dot == std::string::npos || dot == 6 || dot + 1 == key.size()) {
+        return false;
+    }
+    sceneId = key.substr(6, dot - 6);
+    field = key.substr(dot + 1);
+    return true;
+}
+
+// 设置场景区域的一个字段，不认识的字段返回false
+bool setSceneField(SceneConfig& scene, const std::string& field, const std::string& value) {
+    if (field == "name") {
+        scene.sceneName = value;
+    } else if (field == "latitude") {
+        scene.latitude = toDouble(value);
+    } else if (field == "longitude") {
+        scene.longitude = toDouble(value);
+    } else if (field == "radius") {
+        scene.radius = toDouble(value);
+    } else if (field == "enableCorrection") {
+        scene.enableCorrection = toFlag(value);
+    } else if (field.compare(0, 6, "param.") == 0 && field.size() > 6) {
+        scene.correctionParams[field.substr(6)] = toDouble(value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 把场景区域的一个字段恢复为默认值
+void resetSceneField(SceneConfig& scene, const std::string& field) {
+    const SceneConfig defaults;
+    if (field == "name") {
+        scene.sceneName = defaults.sceneName;
+    } else if (field == "latitude") {
+        scene.latitude = defaults.latitude;
+    } else if (field == "longitude") {
+        scene.longitude = defaults.longitude;
+    } else if (field == "radius") {
+        scene.radius = defaults.radius;
+    } else if (field == "enableCorrection") {
+        scene.enableCorrection = defaults.enableCorrection;
+    } else if (field.compare(0, 6, "param.") == 0) {
+        scene.correctionParams.erase(field.substr(6));
+    }
+}
+
+} // namespace
 
 // 构造函数实现
 SceneConfig::SceneConfig() : 
@@ -142,6 +232,7 @@ CorrectionConfig::CorrectionConfig() :
     encryptionKey(""),
     enableAutoSave(true),
     saveInterval(60000), // 1分钟
+    algorithmParams(),
     customParameters() {
     // 初始化默认数据源权重
     dataSourceWeights[DataSourceType::GPS] = 0.8;
@@ -169,6 +260,7 @@ CorrectionConfig::CorrectionConfig(const CorrectionConfig& other) :
     encryptionKey(other.encryptionKey),
     enableAutoSave(other.enableAutoSave),
     saveInterval(other.saveInterval),
+    algorithmParams(other.algorithmParams),
     customParameters(other.customParameters) {
 }
 
@@ -188,6 +280,7 @@ CorrectionConfig& CorrectionConfig::operator=(const CorrectionConfig& other) {
         encryptionKey = other.encryptionKey;
         enableAutoSave = other.enableAutoSave;
         saveInterval = other.saveInterval;
+        algorithmParams = other.algorithmParams;
         customParameters = other.customParameters;
     }
     return *this;
@@ -241,38 +334,131 @@ bool CorrectionConfig::hasCustomParameter(const std::string& key) const {
     return customParameters.find(key) != customParameters.end();
 }
 
+// 应用一个配置项（键名与saveToFile写出的一致），不认识的键报告后作为自定义参数保存，
+// 值格式错误（包括只有前缀是数值的值）时报告后保留原值
+void CorrectionConfig::applyEntry(const std::string& key, const std::string& value) {
+    if (key.compare(0, 10, "algorithm.") == 0) {
+        std::string error;
+        if (!algorithmParams.set(key.substr(10), value, error)) {
+            LOG_WARNING("Invalid config entry %s: %s", key.c_str(), error.c_str());
+        }
+        return;
+    }
+
+    std::string sceneId;
+    std::string field;
+    try {
+        if (key == "scene.enableAnomalyDetection") {
+            sceneConfig.enableAnomalyDetection = toFlag(value);
+        } else if (key == "scene.enableDataFusion") {
+            sceneConfig.enableDataFusion = toFlag(value);
+        } else if (key == "scene.enableSmoothing") {
+            sceneConfig.enableSmoothing = toFlag(value);
+        } else if (key == "scene.enableTrajectoryAnalysis") {
+            sceneConfig.enableTrajectoryAnalysis = toFlag(value);
+        } else if (key == "scene.fusionStrategy") {
+            sceneConfig.fusionStrategy = static_cast<FusionStrategy>(toInt(value));
+        } else if (key == "scene.maxHistorySize") {
+            sceneConfig.maxHistorySize = toInt(value);
+        } else if (key == "scene.minAccuracyThreshold") {
+            sceneConfig.minAccuracyThreshold = toDouble(value);
+        } else if (key == "scene.maxSpeedThreshold") {
+            sceneConfig.maxSpeedThreshold = toDouble(value);
+        } else if (splitSceneKey(key, sceneId, field)) {
+            // 场景区域配置（scene.<场景ID>.<字段>），场景ID第一次出现时添加区域；先在副本上解析，格式错误时不留下空区域
+            auto it = std::find_if(sceneConfigs.begin(), sceneConfigs.end(),
+                [&sceneId](const SceneConfig& existing) { return existing.sceneId == sceneId; });
+            SceneConfig scene = it != sceneConfigs.end() ? *it : SceneConfig();
+            scene.sceneId = sceneId;
+            if (!setSceneField(scene, field, value)) {
+                LOG_WARNING("Unknown scene field in config key '%s', ignored", key.c_str());
+                return;
+            }
+            if (it != sceneConfigs.end()) {
+                *it = scene;
+            } else {
+                sceneConfigs.push_back(scene);
+            }
+        } else if (key == "anomaly.maxTimeDifference") {
+            anomalyThresholds.maxTimeDifference = toDouble(value);
+        } else if (key == "anomaly.maxDistanceDifference") {
+            anomalyThresholds.maxDistanceDifference = toDouble(value);
+        } else if (key == "anomaly.maxAcceleration") {
+            anomalyThresholds.maxAcceleration = toDouble(value);
+        } else if (key == "anomaly.minConfidenceScore") {
+            anomalyThresholds.minConfidenceScore = toDouble(value);
+        } else if (key.compare(0, 14, "source.weight.") == 0) {
+            setDataSourceWeight(static_cast<DataSourceType>(toInt(key.substr(14))), toDouble(value));
+        } else {
+            LOG_WARNING("Unknown config key '%s', kept as custom parameter", key.c_str());
+            setCustomParameter(key, value);
+        }
+    } catch (const std::exception&) {
+        LOG_WARNING("Invalid value '%s' for config key '%s', keeping previous value", value.c_str(), key.c_str());
+    }
+}
+
+// 移除一个配置项：已知的键恢复为默认值，自定义参数直接删除
+void CorrectionConfig::removeEntry(const std::string& key) {
+    if (customParameters.erase(key) > 0) {
+        return;
+    }
+    if (key.compare(0, 10, "algorithm.") == 0) {
+        algorithmParams.reset(key.substr(10));
+        return;
+    }
+    const CorrectionConfig defaults;
+    std::string sceneId;
+    std::string field;
+    if (key == "scene.enableAnomalyDetection") {
+        sceneConfig.enableAnomalyDetection = defaults.sceneConfig.enableAnomalyDetection;
+    } else if (key == "scene.enableDataFusion") {
+        sceneConfig.enableDataFusion = defaults.sceneConfig.enableDataFusion;
+    } else if (key == "scene.enableSmoothing") {
+        sceneConfig.enableSmoothing = defaults.sceneConfig.enableSmoothing;
+    } else if (key == "scene.enableTrajectoryAnalysis") {
+        sceneConfig.enableTrajectoryAnalysis = defaults.sceneConfig.enableTrajectoryAnalysis;
+    } else if (key == "scene.fusionStrategy") {
+        sceneConfig.fusionStrategy = defaults.sceneConfig.fusionStrategy;
+    } else if (key == "scene.maxHistorySize") {
+        sceneConfig.maxHistorySize = defaults.sceneConfig.maxHistorySize;
+    } else if (key == "scene.minAccuracyThreshold") {
+        sceneConfig.minAccuracyThreshold = defaults.sceneConfig.minAccuracyThreshold;
+    } else if (key == "scene.maxSpeedThreshold") {
+        sceneConfig.maxSpeedThreshold = defaults.sceneConfig.maxSpeedThreshold;
+    } else if (splitSceneKey(key, sceneId, field)) {
+        // 场景区域的字段恢复为默认值（半径恢复为0后区域不再参与索引）
+        auto it = std::find_if(sceneConfigs.begin(), sceneConfigs.end(),
+            [&sceneId](const SceneConfig& scene) { return scene.sceneId == sceneId; });
+        if (it != sceneConfigs.end()) {
+            resetSceneField(*it, field);
+        }
+    } else if (key == "anomaly.maxTimeDifference") {
+        anomalyThresholds.maxTimeDifference = defaults.anomalyThresholds.maxTimeDifference;
+    } else if (key == "anomaly.maxDistanceDifference") {
+        anomalyThresholds.maxDistanceDifference = defaults.anomalyThresholds.maxDistanceDifference;
+    } else if (key == "anomaly.maxAcceleration") {
+        anomalyThresholds.maxAcceleration = defaults.anomalyThresholds.maxAcceleration;
+    } else if (key == "anomaly.minConfidenceScore") {
+        anomalyThresholds.minConfidenceScore = defaults.anomalyThresholds.minConfidenceScore;
+    } else if (key.compare(0, 14, "source.weight.") == 0) {
+        try {
+            DataSourceType type = static_cast<DataSourceType>(std::stoi(key.substr(14)));
+            setDataSourceWeight(type, defaults.getDataSourceWeight(type));
+        } catch (const std::exception&) {
+        }
+    }
+}
+
 // 从文件加载配置
 bool CorrectionConfig::loadFromFile(const std::string& filePath) {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
+    ConfigEntries entries;
+    if (!ConfigWatcher::parseFile(filePath, entries)) {
         return false;
     }
-    
-    std::string line;
-    while (std::getline(file, line)) {
-        // 跳过注释和空行
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        
-        // 解析配置项
-        size_t pos = line.find('=');
-        if (pos != std::string::npos) {
-            std::string key = line.substr(0, pos);
-            std::string value = line.substr(pos + 1);
-            
-            // 去除首尾空格
-            key.erase(0, key.find_first_not_of(" \t"));
-            key.erase(key.find_last_not_of(" \t") + 1);
-            value.erase(0, value.find_first_not_of(" \t"));
-            value.erase(value.find_last_not_of(" \t") + 1);
-            
-            // 这里简化处理，实际应用中应该根据配置项名称进行更详细的解析
-            setCustomParameter(key, value);
-        }
+    for (const auto& entry : entries) {
+        applyEntry(entry.first, entry.second);
     }
-    
-    file.close();
     return true;
 }
 
@@ -298,6 +484,23 @@ bool CorrectionConfig::saveToFile(const std::string& filePath) const {
     file << "scene.minAccuracyThreshold=" << sceneConfig.minAccuracyThreshold << "\n";
     file << "scene.maxSpeedThreshold=" << sceneConfig.maxSpeedThreshold << "\n\n";
     
+    // 写入场景区域配置（每个区域一个分节，修改一个区域时只有该分节变化）
+    file << "# Scene Regions\n";
+    std::streamsize precision = file.precision(10);
+    for (const auto& scene : sceneConfigs) {
+        const std::string prefix = "scene." + scene.sceneId + ".";
+        file << prefix << "name=" << scene.sceneName << "\n";
+        file << prefix << "latitude=" << scene.latitude << "\n";
+        file << prefix << "longitude=" << scene.longitude << "\n";
+        file << prefix << "radius=" << scene.radius << "\n";
+        file << prefix << "enableCorrection=" << (scene.enableCorrection ? "true" : "false") << "\n";
+        for (const auto& param : scene.correctionParams) {
+            file << prefix << "param." << param.first << "=" << param.second << "\n";
+        }
+    }
+    file.precision(precision);
+    file << "\n";
+    
     // 写入异常阈值配置
     file << "# Anomaly Detection Thresholds\n";
     file << "anomaly.maxTimeDifference=" << anomalyThresholds.maxTimeDifference << "\n";
@@ -312,6 +515,13 @@ bool CorrectionConfig::saveToFile(const std::string& filePath) const {
     }
     file << "\n";
     
+    // 写入算法参数
+    file << "# Algorithm Parameters\n";
+    for (const auto& pair : algorithmParams.toMap()) {
+        file << "algorithm." << pair.first << "=" << pair.second << "\n";
+    }
+    file << "\n";
+    
     // 写入自定义参数
     file << "# Custom Parameters\n";
     for (const auto& pair : customParameters) {
@@ -1,6 +1,8 @@
 // LocationModel.cpp - 位置数据模型实现
 
 #include "LocationModel.h"
+#include <chrono>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 
@@ -13,12 +15,13 @@ LocationInfo::LocationInfo() :
     speed(0.0),
     direction(0.0),
     timestamp(0),
-    dataSource(DataSourceType::UNKNOWN),
+    sourceType(DataSourceType::OTHER),
     status(LocationStatus::INVALID),
     satelliteCount(0),
     signalStrength(0),
     locationType(""),
     provider(""),
+    sourceId(""),
     extras() {
 }
 
@@ -30,12 +33,13 @@ LocationInfo::LocationInfo(double lat, double lng, double acc, DataSourceType so
     speed(0.0),
     direction(0.0),
     timestamp(getCurrentTimestampMs()),
-    dataSource(source),
+    sourceType(source),
     status(LocationStatus::VALID),
     satelliteCount(0),
     signalStrength(0),
     locationType(""),
     provider(""),
+    sourceId(""),
     extras() {
 }
 
@@ -48,12 +52,13 @@ LocationInfo::LocationInfo(const LocationInfo& other) :
     speed(other.speed),
     direction(other.direction),
     timestamp(other.timestamp),
-    dataSource(other.dataSource),
+    sourceType(other.sourceType),
     status(other.status),
     satelliteCount(other.satelliteCount),
     signalStrength(other.signalStrength),
     locationType(other.locationType),
     provider(other.provider),
+    sourceId(other.sourceId),
     extras(other.extras) {
 }
 
@@ -67,12 +72,13 @@ LocationInfo& LocationInfo::operator=(const LocationInfo& other) {
         speed = other.speed;
         direction = other.direction;
         timestamp = other.timestamp;
-        dataSource = other.dataSource;
+        sourceType = other.sourceType;
         status = other.status;
         satelliteCount = other.satelliteCount;
         signalStrength = other.signalStrength;
         locationType = other.locationType;
         provider = other.provider;
+        sourceId = other.sourceId;
         extras = other.extras;
     }
     return *this;
@@ -104,7 +110,7 @@ std::string LocationInfo::toString() const {
        << "spd=" << speed << ", "
        << "dir=" << direction << ", "
        << "ts=" << timestamp << ", "
-       << "src=" << static_cast<int>(dataSource) << ", "
+       << "src=" << static_cast<int>(sourceType) << ", "
        << "status=" << static_cast<int>(status) << ", "
        << "satellites=" << satelliteCount << ", "
        << "signal=" << signalStrength
@@ -1,4 +1,5 @@
 #include "LocationCorrector.h"
+#include "LocationCodec.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <algorithm>
@@ -7,12 +8,24 @@
 
 namespace location_correction {
 
+namespace {
+
+// 两组场景的区域（顺序、中心点和半径）是否相同，相同时可以沿用已建立的索引
+bool sameSceneRegions(const std::vector<SceneConfig>& a, const std::vector<SceneConfig>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const SceneConfig& x, const SceneConfig& y) {
+        return x.latitude == y.latitude && x.longitude == y.longitude && x.radius == y.radius;
+    });
+}
+
+} // namespace
+
 // BaseLocationCorrector实现
 BaseLocationCorrector::BaseLocationCorrector() {
-    config_ = std::make_shared<CorrectionConfig>();
+    snapshot_ = std::make_shared<const AppliedConfig>();
     anomalyDetector_ = nullptr;
     dataFusion_ = nullptr;
     lastCorrectionTime_ = 0;
+    appliedConfigVersion_ = 0;
     Logger::getInstance().info("BaseLocationCorrector initialized");
 }
 
@@ -21,10 +34,74 @@ BaseLocationCorrector::~BaseLocationCorrector() {
 }
 
 void BaseLocationCorrector::initialize(const CorrectionConfig& config) {
-    config_ = std::make_shared<CorrectionConfig>(config);
+    std::lock_guard<std::mutex> lock(configMutex_);
+    applyConfig(config);
+    
+    // 服务初始化时传入的即是当前发布的配置，之后发布的版本在纠偏前应用
+    appliedConfigVersion_.store(ConfigStore<CorrectionConfig>::getInstance().getVersion(), std::memory_order_release);
     Logger::getInstance().info("BaseLocationCorrector configured");
 }
 
+// 全局配置有新版本时应用（与处理器链相同：版本号未变化时不读取快照，发布配置不需要暂停纠偏）
+void BaseLocationCorrector::refreshConfig() {
+    ConfigStore<CorrectionConfig>& store = ConfigStore<CorrectionConfig>::getInstance();
+    if (store.getVersion() == appliedConfigVersion_.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(configMutex_);
+    ConfigReader<CorrectionConfig> config = store.read();
+    if (config.version() == appliedConfigVersion_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    applyConfig(*config);
+    appliedConfigVersion_.store(config.version(), std::memory_order_release);
+    LOG_INFO("Location corrector applied configuration version %llu",
+             static_cast<unsigned long long>(config.version()));
+}
+
+// 场景区域的空间索引与配置放在同一快照中发布，纠偏时读取的配置和索引总是同一代。
+// 索引只记录区域几何和场景下标，区域不变时（如只修改了阈值或场景参数）沿用上一快照的索引
+void BaseLocationCorrector::applyConfig(const CorrectionConfig& config) {
+    auto applied = std::make_shared<AppliedConfig>();
+    applied->config = config;
+    std::shared_ptr<const AppliedConfig> previous = std::atomic_load(&snapshot_);
+    if (previous->sceneIndex && sameSceneRegions(previous->config.sceneConfigs, config.sceneConfigs)) {
+        applied->sceneIndex = previous->sceneIndex;
+    } else {
+        auto sceneIndex = std::make_shared<SceneIndex>();
+        sceneIndex->build(config.sceneConfigs);
+        applied->sceneIndex = sceneIndex;
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const AppliedConfig>(std::move(applied)));
+}
+
+// 在当前配置的副本上添加或替换场景配置，重建索引后替换配置（只替换基础部分，派生类的场景表由调用方维护）
+void BaseLocationCorrector::updateSceneConfig(const SceneConfig& sceneConfig) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    CorrectionConfig config = std::atomic_load(&snapshot_)->config;
+    auto it = std::find_if(config.sceneConfigs.begin(), config.sceneConfigs.end(),
+        [&sceneConfig](const SceneConfig& existing) {
+            return !sceneConfig.sceneId.empty() && existing.sceneId == sceneConfig.sceneId;
+        });
+    if (it != config.sceneConfigs.end()) {
+        *it = sceneConfig;
+    } else {
+        config.sceneConfigs.push_back(sceneConfig);
+    }
+    BaseLocationCorrector::applyConfig(config);
+}
+
+// 查找位置所在的场景区域（在快照自带的索引中查找，返回的下标属于同一份配置；按设备缓存所在区域）
+const SceneConfig* BaseLocationCorrector::findSceneRegion(const LocationInfo& location, const AppliedConfig& applied) {
+    int64_t scene = sceneLocator.locate(applied.sceneIndex, getDeviceIdOf(location),
+                                        location.latitude, location.longitude);
+    if (scene < 0) {
+        return nullptr;
+    }
+    return &applied.config.sceneConfigs[static_cast<size_t>(scene)];
+}
+
 void BaseLocationCorrector::setAnomalyDetector(std::shared_ptr<AnomalyDetector> detector) {
     anomalyDetector_ = detector;
 }
@@ -34,16 +111,34 @@ void BaseLocationCorrector::setDataFusion(std::shared_ptr<DataFusion> fusion) {
 }
 
 std::shared_ptr<CorrectedLocation> BaseLocationCorrector::correctLocation(const LocationInfo& location) {
+    refreshConfig();
+    return correctLocation(location, std::atomic_load(&snapshot_)->config.minCorrectionInterval);
+}
+
+// 按指定的最小纠偏间隔纠偏（各模式据此调整间隔，不修改共享的配置）
+std::shared_ptr<CorrectedLocation> BaseLocationCorrector::correctLocation(const LocationInfo& location,
+                                                                         long long minCorrectionInterval) {
+    refreshConfig();
+    std::shared_ptr<const AppliedConfig> applied = std::atomic_load(&snapshot_);
+    
     auto startTime = std::chrono::system_clock::now();
     auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         startTime.time_since_epoch()).count();
     
     // 检查是否需要进行位置纠偏（基于时间阈值）
-    if (timestamp - lastCorrectionTime_ < config_->minCorrectionInterval) {
+    if (timestamp - lastCorrectionTime_ < minCorrectionInterval) {
         Logger::getInstance().debug("Location correction skipped due to time interval");
         return nullptr;
     }
     
+    // 查找位置所在的场景区域，区域关闭纠偏时输出原始位置并标记为未处理
+    bool correctionEnabled = true;
+    const SceneConfig* region = findSceneRegion(location, *applied);
+    if (region && !region->enableCorrection) {
+        LOG_DEBUG("Location correction disabled in scene region %s", region->sceneId.c_str());
+        correctionEnabled = false;
+    }
+    
     // 创建待返回的纠偏位置对象
     auto correctedLocation = std::make_shared<CorrectedLocation>();
     correctedLocation->originalLocation = location;
@@ -59,8 +154,8 @@ std::shared_ptr<CorrectedLocation> BaseLocationCorrector::correctLocation(const
     correctedLocation->sourceType = location.sourceType;
     correctedLocation->timestamp = location.timestamp;
     
-    // 标记为已处理
-    correctedLocation->processed = true;
+    // 标记是否已处理
+    correctedLocation->processed = correctionEnabled;
     
     // 更新最后纠偏时间
     lastCorrectionTime_ = timestamp;
@@ -82,7 +177,14 @@ AdaptiveLocationCorrector::~AdaptiveLocationCorrector() {
 }
 
 void AdaptiveLocationCorrector::initialize(const CorrectionConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
     BaseLocationCorrector::initialize(config);
+}
+
+// 初始化和配置更新时按场景类型重建场景配置表（调用方持有mutex_）
+void AdaptiveLocationCorrector::applyConfig(const CorrectionConfig& config) {
+    BaseLocationCorrector::applyConfig(config);
+    sceneConfigs_.clear();
     
     // 初始化场景配置
     if (config.sceneConfigs.empty()) {
@@ -119,6 +221,7 @@ void AdaptiveLocationCorrector::initialize(const CorrectionConfig& config) {
 void AdaptiveLocationCorrector::addSceneConfig(const SceneConfig& sceneConfig) {
     std::lock_guard<std::mutex> lock(mutex_);
     sceneConfigs_[sceneConfig.sceneType] = sceneConfig;
+    updateSceneConfig(sceneConfig);
     Logger::getInstance().info("Scene configuration added for type: " + std::to_string(static_cast<int>(sceneConfig.sceneType)));
 }
 
@@ -161,6 +264,19 @@ LocationScene AdaptiveLocationCorrector::detectScene(const LocationInfo& locatio
     return detectedScene;
 }
 
+// 恢复重启前的场景和场景检测时间，避免重启后立即按单个位置重新判断场景
+void AdaptiveLocationCorrector::restoreScene(LocationScene scene, long long sceneCheckTime) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    currentScene_ = scene;
+    lastSceneCheckTime_ = sceneCheckTime;
+    Logger::getInstance().info("Scene restored to: " + getSceneName(scene));
+}
+
+long long AdaptiveLocationCorrector::getLastSceneCheckTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastSceneCheckTime_;
+}
+
 std::string AdaptiveLocationCorrector::getSceneName(LocationScene scene) {
     switch (scene) {
         case LocationScene::INDOOR:
@@ -180,18 +296,33 @@ std::string AdaptiveLocationCorrector::getSceneName(LocationScene scene) {
 
 std::shared_ptr<CorrectedLocation> AdaptiveLocationCorrector::correctLocation(const LocationInfo& location) {
     std::lock_guard<std::mutex> lock(mutex_);
+    refreshConfig();
     
     // 检测当前场景
     LocationScene currentScene = detectScene(location);
     
-    // 检查是否有该场景的配置
-    auto sceneConfigIt = sceneConfigs_.find(currentScene);
-    if (sceneConfigIt == sceneConfigs_.end()) {
-        Logger::getInstance().warning("No configuration found for current scene, using base correction");
+    // 位置在配置的场景区域内时按该区域的场景配置纠偏（比按速度判断的场景类型更具体），
+    // 区域关闭纠偏时由基础纠偏输出原始位置并标记为未处理
+    std::shared_ptr<const AppliedConfig> applied = std::atomic_load(&snapshot_);
+    const SceneConfig* region = findSceneRegion(location, *applied);
+    if (region && !region->enableCorrection) {
         return BaseLocationCorrector::correctLocation(location);
     }
+    if (region && region->sceneType != LocationScene::UNKNOWN) {
+        currentScene = region->sceneType;
+    }
     
-    const SceneConfig& sceneConfig = sceneConfigIt->second;
+    // 不在任何区域内时按场景类型选取配置
+    if (!region) {
+        auto sceneConfigIt = sceneConfigs_.find(currentScene);
+        if (sceneConfigIt == sceneConfigs_.end()) {
+            Logger::getInstance().warning("No configuration found for current scene, using base correction");
+            return BaseLocationCorrector::correctLocation(location);
+        }
+        region = &sceneConfigIt->second;
+    }
+    
+    const SceneConfig& sceneConfig = *region;
     
     // 创建纠偏位置对象
     auto correctedLocation = std::make_shared<CorrectedLocation>();
@@ -322,6 +453,7 @@ std::string MultiModeLocationCorrector::getModeName(CorrectionMode mode) {
 
 std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::correctLocation(const LocationInfo& location) {
     std::lock_guard<std::mutex> lock(mutex_);
+    refreshConfig();
     
     // 根据当前模式应用不同的纠偏策略
     switch (currentMode_) {
@@ -352,15 +484,8 @@ std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyHighAccuracy
     Logger::getInstance().debug("Applying high accuracy mode correction");
     
     // 高精度模式下，降低时间间隔要求，增加处理强度
-    auto originalInterval = config_->minCorrectionInterval;
-    config_->minCorrectionInterval = std::max(100LL, originalInterval / 2); // 至少100ms
-    
-    auto result = BaseLocationCorrector::correctLocation(location);
-    
-    // 恢复原始配置
-    config_->minCorrectionInterval = originalInterval;
-    
-    return result;
+    return BaseLocationCorrector::correctLocation(location,
+                                                  std::max(100LL, std::atomic_load(&snapshot_)->config.minCorrectionInterval / 2)); // 至少100ms
 }
 
 std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyLowPowerModeCorrection(const LocationInfo& location) {
@@ -368,15 +493,8 @@ std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyLowPowerMode
     Logger::getInstance().debug("Applying low power mode correction");
     
     // 低功耗模式下，增加时间间隔要求，减少处理强度
-    auto originalInterval = config_->minCorrectionInterval;
-    config_->minCorrectionInterval = std::max(1000LL, originalInterval * 2); // 至少1秒
-    
-    auto result = BaseLocationCorrector::correctLocation(location);
-    
-    // 恢复原始配置
-    config_->minCorrectionInterval = originalInterval;
-    
-    return result;
+    return BaseLocationCorrector::correctLocation(location,
+                                                  std::max(1000LL, std::atomic_load(&snapshot_)->config.minCorrectionInterval * 2)); // 至少1秒
 }
 
 std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyFastUpdateModeCorrection(const LocationInfo& location) {
@@ -384,15 +502,8 @@ std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyFastUpdateMo
     Logger::getInstance().debug("Applying fast update mode correction");
     
     // 快速更新模式下，大幅降低时间间隔要求
-    auto originalInterval = config_->minCorrectionInterval;
-    config_->minCorrectionInterval = std::max(50LL, originalInterval / 4); // 至少50ms
-    
-    auto result = BaseLocationCorrector::correctLocation(location);
-    
-    // 恢复原始配置
-    config_->minCorrectionInterval = originalInterval;
-    
-    return result;
+    return BaseLocationCorrector::correctLocation(location,
+                                                  std::max(50LL, std::atomic_load(&snapshot_)->config.minCorrectionInterval / 4)); // 至少50ms
 }
 
 std::shared_ptr<CorrectedLocation> MultiModeLocationCorrector::applyOfflineModeCorrection(const LocationInfo& location) {
@@ -1,4 +1,5 @@
 #include "LocationService.h"
+#include "LocationCodec.h"
 #include "Logger.h"
 #include "Utils.h"
 #include <chrono>
@@ -13,6 +14,8 @@ BaseLocationService::BaseLocationService() {
     processorChain_ = std::make_shared<ProcessorChain>();
     locationCorrector_ = std::make_shared<AdaptiveLocationCorrector>();
     storageManager_ = StorageManager::getInstance();
+    deviceStateStore_ = std::make_shared<DeviceStateStore>();
+    stateCheckpointIntervalMs_ = 30000;
     Logger::getInstance().info("BaseLocationService initialized");
 }
 
@@ -57,6 +60,9 @@ bool BaseLocationService::initialize(const LocationServiceConfig& config) {
         return false;
     }
     
+    // 恢复重启前的设备状态
+    restoreDeviceState();
+    
     Logger::getInstance().info("BaseLocationService initialized successfully");
     return true;
 }
@@ -132,6 +138,9 @@ bool BaseLocationService::initializeLocationCorrector() {
     indoorConfig.weightForBaseStation = 0.2;
     correctionConfig.sceneConfigs.push_back(indoorConfig);
     
+    // 发布为全局配置，处理器链在下一次处理时应用
+    ConfigStore<CorrectionConfig>::getInstance().publish(correctionConfig);
+    
     // 初始化位置纠偏器
     locationCorrector_->initialize(correctionConfig);
     
@@ -139,6 +148,12 @@ bool BaseLocationService::initializeLocationCorrector() {
     return true;
 }
 
+// 更新纠偏配置：只发布新的配置快照，各组件在下一批处理开始时读取并应用，不暂停处理流程
+void BaseLocationService::updateConfig(const CorrectionConfig& config) {
+    uint64_t version = ConfigStore<CorrectionConfig>::getInstance().publish(config);
+    LOG_INFO("Correction config version %llu published", static_cast<unsigned long long>(version));
+}
+
 bool BaseLocationService::initializeStorage() {
     // 初始化存储管理器
     if (!storageManager_->initialize()) {
@@ -150,6 +165,60 @@ bool BaseLocationService::initializeStorage() {
     return true;
 }
 
+void BaseLocationService::setStateCheckpoint(const std::string& path, long long intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stateCheckpointPath_ = path;
+    stateCheckpointIntervalMs_ = intervalMs;
+}
+
+// 检查点不存在或损坏时从空状态开始，不影响服务初始化
+void BaseLocationService::restoreDeviceState() {
+    if (stateCheckpointPath_.empty()) {
+        return;
+    }
+    DeviceCheckpointStats stats;
+    if (!deviceStateStore_->loadCheckpoint(stateCheckpointPath_, &stats)) {
+        LOG_WARNING("No usable device state checkpoint at %s, starting cold", stateCheckpointPath_.c_str());
+        return;
+    }
+    LOG_INFO("Restored state of %zu devices in %lld ms", stats.deviceCount, stats.elapsedMs);
+    
+    // 处理器链、纠偏器和最新位置只有一份，使用最近更新的设备状态
+    std::string deviceId;
+    DeviceState state;
+    if (!deviceStateStore_->getLatestState(deviceId, state)) {
+        return;
+    }
+    
+    // 检测窗口预填异常点检测的历史数据
+    auto outlierDetector = std::dynamic_pointer_cast<OutlierDetectionProcessor>(
+        processorChain_->getProcessorByName("OutlierDetectionProcessor"));
+    if (outlierDetector) {
+        outlierDetector->seedHistory(deviceStateStore_->getWindow(deviceId));
+    }
+    
+    if (!(state.flags & DEVICE_STATE_HAS_OUTPUT)) {
+        return;
+    }
+    if (auto adaptiveCorrector = std::dynamic_pointer_cast<AdaptiveLocationCorrector>(locationCorrector_)) {
+        adaptiveCorrector->restoreScene(static_cast<LocationScene>(state.scene), state.sceneCheckTime);
+    }
+    std::lock_guard<std::mutex> locationLock(locationMutex_);
+    lastLocation_ = std::make_shared<LocationInfo>(DeviceStateStore::fromStatePoint(state.lastOutput, deviceId));
+}
+
+// 按设备ID区分设备，记录纠偏的输入窗口、输出和当前场景
+void BaseLocationService::recordDeviceState(const LocationInfo& input, const CorrectedLocation& corrected) {
+    long long sceneCheckTime = corrected.correctionTime;
+    if (auto adaptiveCorrector = std::dynamic_pointer_cast<AdaptiveLocationCorrector>(locationCorrector_)) {
+        sceneCheckTime = adaptiveCorrector->getLastSceneCheckTime();
+    }
+    std::string deviceId = getDeviceIdOf(input);
+    deviceStateStore_->recordInput(deviceId, input);
+    deviceStateStore_->recordOutput(deviceId, corrected.toLocationInfo(),
+                                    static_cast<int32_t>(corrected.sceneType), sceneCheckTime);
+}
+
 bool BaseLocationService::start() {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -168,6 +237,12 @@ bool BaseLocationService::start() {
     isRunning_ = true;
     processingThread_ = std::thread(&BaseLocationService::processingLoop, this);
     
+    // 定期保存设备状态检查点
+    if (!stateCheckpointPath_.empty() &&
+        !deviceStateStore_->startCheckpointing(stateCheckpointPath_, stateCheckpointIntervalMs_)) {
+        Logger::getInstance().warning("Failed to start device state checkpointing");
+    }
+    
     Logger::getInstance().info("BaseLocationService started successfully");
     return true;
 }
@@ -189,6 +264,9 @@ bool BaseLocationService::stop() {
     // 停止所有数据源
     dataSourceManager_->stopAllDataSources();
     
+    // 停止定期检查点并保存最后一次设备状态，下次启动时恢复
+    deviceStateStore_->stopCheckpointing();
+    
     // 清空位置数据队列
     {}
     std::lock_guard<std::mutex> queueLock(queueMutex_);
@@ -272,7 +350,8 @@ void BaseLocationService::processLocationData(const LocationInfo& location) {
         return;
     }
     
-    // 3. 存储纠偏后的数据
+    // 3. 记录设备状态，存储纠偏后的数据
+    recordDeviceState(*processedLocation, *correctedLocation);
     if (config_.enableHistoryStorage) {
         storageManager_->storeLocation(correctedLocation->toLocationInfo());
     }
@@ -289,10 +368,8 @@ void BaseLocationService::processLocationData(const LocationInfo& location) {
         locationUpdateListener_(*lastLocation_);
     }
     
-    Logger::getInstance().debug("Location data processed successfully: " + 
-        std::to_string(correctedLocation->latitude) + ", " + 
-        std::to_string(correctedLocation->longitude) + ", accuracy: " + 
-        std::to_string(correctedLocation->accuracy));
+    LOG_DEBUG("Location data processed successfully: %f, %f, accuracy: %f",
+              correctedLocation->latitude, correctedLocation->longitude, correctedLocation->accuracy);
 }
 
 // HighPerformanceLocationService实现
@@ -365,6 +442,9 @@ void HighPerformanceLocationService::processBatchData(const std::vector<Location
         for (const auto& processedLocation : processedLocations) {
             auto correctedLocation = locationCorrector_->correctLocation(*processedLocation);
             if (correctedLocation) {
+                // 记录设备状态
+                recordDeviceState(*processedLocation, *correctedLocation);
+                
                 // 更新缓存
                 updateLocationCache(correctedLocation->toLocationInfo());
                 
@@ -0,0 +1,142 @@
+// ConfigStore.cpp - 纪元回收域实现
+
+#include "ConfigStore.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace {
+
+// 线程退出时释放槽位，供之后的线程复用
+struct ReaderHandle {
+    std::atomic<uint64_t>* epoch = nullptr; // 当前线程槽位登记的纪元
+    std::atomic<bool>* inUse = nullptr;     // 当前线程槽位的占用标志
+    bool exhausted = false;                 // 是否已无空闲槽位
+    size_t depth = 0;                       // 读取区嵌套深度
+    bool overflow = false;                  // 本次读取是否记在溢出计数器上
+
+    ~ReaderHandle() {
+        if (inUse) {
+            inUse->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ReaderHandle readerHandle;
+
+} // namespace
+
+// EpochDomain构造函数
+EpochDomain::EpochDomain() :
+    globalEpoch(1),
+    overflowReaders(0) {
+    for (auto& slot : slots) {
+        slot.epoch.store(0, std::memory_order_relaxed);
+        slot.inUse.store(false, std::memory_order_relaxed);
+    }
+}
+
+// EpochDomain析构函数：进程退出时释放剩余的待回收对象
+EpochDomain::~EpochDomain() {
+    std::lock_guard<std::mutex> lock(retireMutex);
+    for (const auto& item : retired) {
+        item.deleter(item.object);
+    }
+    retired.clear();
+}
+
+// 获取单例实例
+EpochDomain& EpochDomain::getInstance() {
+    static EpochDomain instance;
+    return instance;
+}
+
+// 获取当前线程的槽位
+std::atomic<uint64_t>* EpochDomain::threadSlot() {
+    if (readerHandle.epoch || readerHandle.exhausted) {
+        return readerHandle.epoch;
+    }
+
+    std::lock_guard<std::mutex> lock(slotMutex);
+    for (auto& slot : slots) {
+        if (!slot.inUse.load(std::memory_order_acquire)) {
+            slot.inUse.store(true, std::memory_order_relaxed);
+            readerHandle.epoch = &slot.epoch;
+            readerHandle.inUse = &slot.inUse;
+            return &slot.epoch;
+        }
+    }
+    readerHandle.exhausted = true;
+    LOG_WARNING("Epoch domain reader slots exhausted (%zu), reclamation pauses while extra readers are active",
+                MAX_READERS);
+    return nullptr;
+}
+
+// 进入读取区（只有最外层登记纪元）
+void EpochDomain::enter() {
+    if (readerHandle.depth++ > 0) {
+        return;
+    }
+    std::atomic<uint64_t>* slot = threadSlot();
+    if (slot) {
+        slot->store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        readerHandle.overflow = false;
+    } else {
+        overflowReaders.fetch_add(1, std::memory_order_seq_cst);
+        readerHandle.overflow = true;
+    }
+}
+
+// 退出读取区
+void EpochDomain::exit() {
+    if (--readerHandle.depth > 0) {
+        return;
+    }
+    if (readerHandle.overflow) {
+        overflowReaders.fetch_sub(1, std::memory_order_release);
+    } else {
+        readerHandle.epoch->store(0, std::memory_order_release);
+    }
+}
+
+// 将对象加入待回收列表并推进纪元
+void EpochDomain::retire(void* object, void (*deleter)(void*)) {
+    std::lock_guard<std::mutex> lock(retireMutex);
+    retired.push_back(Retired{object, deleter, globalEpoch.fetch_add(1, std::memory_order_seq_cst)});
+}
+
+// 释放已没有读取方能访问的对象
+size_t EpochDomain::reclaim() {
+    // 有读取方没有分到槽位时无法判断它登记的纪元，暂不回收
+    if (overflowReaders.load(std::memory_order_seq_cst) > 0) {
+        return 0;
+    }
+    // 只回收扫描前已退役的对象：扫描之后退役的对象可能被扫描后才进入的读取方持有
+    uint64_t oldestActive = globalEpoch.load(std::memory_order_seq_cst);
+    for (const auto& slot : slots) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0) {
+            oldestActive = std::min(oldestActive, epoch);
+        }
+    }
+
+    std::vector<Retired> expired;
+    {
+        std::lock_guard<std::mutex> lock(retireMutex);
+        auto keep = std::stable_partition(retired.begin(), retired.end(), [oldestActive](const Retired& item) {
+            return item.epoch >= oldestActive;
+        });
+        expired.assign(keep, retired.end());
+        retired.erase(keep, retired.end());
+    }
+    // 在锁外释放，析构较重的对象不阻塞其他发布方
+    for (const auto& item : expired) {
+        item.deleter(item.object);
+    }
+    return expired.size();
+}
+
+// 获取待回收的对象数
+size_t EpochDomain::getRetiredCount() const {
+    std::lock_guard<std::mutex> lock(retireMutex);
+    return retired.size();
+}
@@ -0,0 +1,306 @@
+// ConfigWatcher.cpp - 配置文件监视器实现
+
+#include "ConfigWatcher.h"
+#include "Logger.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 收到第一个文件事件后再等待的时间，合并同一次更新产生的多个事件（毫秒）
+const int EVENT_SETTLE_MS = 5;
+
+// 不支持inotify时检查修改时间的间隔
+const auto POLL_INTERVAL = std::chrono::milliseconds(500);
+
+// 去除首尾空白
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+// ConfigWatcher构造函数
+ConfigWatcher::ConfigWatcher(const std::string& filePath) :
+    filePath(filePath),
+    running(false),
+    reloadCount(0),
+    inotifyFd(-1) {
+    stopPipe[0] = -1;
+    stopPipe[1] = -1;
+}
+
+// ConfigWatcher析构函数
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+// 添加分节处理函数
+void ConfigWatcher::addSectionHandler(const std::string& prefix, ConfigSectionHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    handlers.push_back(SectionHandler{prefix, std::move(handler)});
+}
+
+// 添加重新加载处理函数
+void ConfigWatcher::addReloadHandler(ConfigReloadHandler handler) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reloadHandlers.push_back(std::move(handler));
+}
+
+// 同步加载配置并启动监视线程
+bool ConfigWatcher::start() {
+    if (running.exchange(true)) {
+        return true;
+    }
+
+#if defined(__linux__)
+    // 先开始监视再加载，加载期间发生的更新也会收到事件；监视目录而不是文件本身（重命名替换后inode会变化）
+    std::filesystem::path path(filePath);
+    std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 &&
+        inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+    }
+    if (inotifyFd < 0) {
+        LOG_WARNING("inotify unavailable for %s, falling back to polling", directory.c_str());
+    }
+    if (pipe2(stopPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        stopPipe[0] = -1;
+        stopPipe[1] = -1;
+    }
+#endif
+
+    bool loaded = reload();
+    if (!loaded) {
+        LOG_WARNING("Config file not loaded yet, waiting for it to appear: %s", filePath.c_str());
+    }
+    watchThread = std::thread(&ConfigWatcher::watchLoop, this);
+    return loaded;
+}
+
+// 停止监视线程
+void ConfigWatcher::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+#if defined(__linux__)
+    if (stopPipe[1] >= 0) {
+        char signal = 1;
+        ssize_t written = ::write(stopPipe[1], &signal, 1);
+        (void)written;
+    }
+#endif
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+#if defined(__linux__)
+    for (int* fd : {&inotifyFd, &stopPipe[0], &stopPipe[1]}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+#endif
+}
+
+// 重新加载配置并通知有变化的分节
+bool ConfigWatcher::reload() {
+    std::lock_guard<std::mutex> reloadLock(reloadMutex);
+
+    ConfigEntries current;
+    if (!parseFile(filePath, current)) {
+        return false;
+    }
+
+    std::vector<ConfigSectionDiff> changes;
+    std::vector<SectionHandler> currentHandlers;
+    std::vector<ConfigReloadHandler> currentReloadHandlers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        changes = diff(entries, current);
+        entries = current;
+        currentHandlers = handlers;
+        currentReloadHandlers = reloadHandlers;
+    }
+    reloadCount.fetch_add(1, std::memory_order_relaxed);
+    if (changes.empty()) {
+        LOG_DEBUG("Config file reloaded without changes: %s", filePath.c_str());
+        return true;
+    }
+
+    // 处理函数在锁外调用，可以在其中读取配置项
+    for (const auto& change : changes) {
+        for (const auto& handler : currentHandlers) {
+            if (!sectionMatches(change.section, handler.prefix)) {
+                continue;
+            }
+            try {
+                handler.handler(change);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Config handler for section '%s' failed: %s", change.section.c_str(), e.what());
+            }
+        }
+    }
+    for (const auto& handler : currentReloadHandlers) {
+        try {
+            handler(changes);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Config reload handler failed: %s", e.what());
+        }
+    }
+    LOG_INFO("Config reloaded from %s: %zu sections changed", filePath.c_str(), changes.size());
+    return true;
+}
+
+// 获取上次加载的配置项
+ConfigEntries ConfigWatcher::getEntries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries;
+}
+
+// 监视线程主循环
+void ConfigWatcher::watchLoop() {
+    std::filesystem::path path(filePath);
+    std::string fileName = path.filename().string();
+
+#if defined(__linux__)
+    if (inotifyFd >= 0) {
+        LOG_INFO("Watching config file with inotify: %s", filePath.c_str());
+        alignas(struct inotify_event) char buffer[4096];
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+
+        while (running.load()) {
+            if (poll(fds, stopPipe[0] >= 0 ? 2 : 1, stopPipe[0] >= 0 ? -1 : 100) <= 0 || !running.load()) {
+                continue;
+            }
+
+            // 读出所有事件，同一次更新产生的后续事件在短暂等待后一并读出
+            bool relevant = false;
+            int waitMs = 0;
+            while (poll(fds, 1, waitMs) > 0) {
+                ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+                if (length <= 0) {
+                    break;
+                }
+                for (ssize_t offset = 0; offset < length;) {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+                    if (event->len > 0 && fileName == event->name) {
+                        relevant = true;
+                    }
+                    offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+                }
+                waitMs = relevant ? EVENT_SETTLE_MS : 0;
+            }
+            if (relevant && !reload()) {
+                LOG_WARNING("Config file changed but could not be loaded, keeping previous config: %s",
+                            filePath.c_str());
+            }
+        }
+        return;
+    }
+#endif
+
+    // 定期检查修改时间
+    std::error_code error;
+    std::filesystem::file_time_type lastWrite = std::filesystem::last_write_time(path, error);
+    while (running.load()) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+        if (!error && writeTime != lastWrite) {
+            lastWrite = writeTime;
+            reload();
+        }
+    }
+}
+
+// 分节名是否匹配处理函数的前缀
+bool ConfigWatcher::sectionMatches(const std::string& section, const std::string& prefix) {
+    if (prefix.empty() || section == prefix) {
+        return true;
+    }
+    return section.size() > prefix.size() && section.compare(0, prefix.size(), prefix) == 0 &&
+           section[prefix.size()] == '.';
+}
+
+// 解析"键=值"格式的配置文件
+bool ConfigWatcher::parseFile(const std::string& path, ConfigEntries& result) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        // 跳过注释和空行
+        std::string content = trim(line);
+        if (content.empty() || content[0] == '#') {
+            continue;
+        }
+        size_t pos = content.find('=');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(content.substr(0, pos));
+        if (!key.empty()) {
+            result[key] = trim(content.substr(pos + 1));
+        }
+    }
+    return !file.bad();
+}
+
+// 获取配置项所属的分节
+std::string ConfigWatcher::sectionOf(const std::string& key) {
+    size_t pos = key.rfind('.');
+    return pos == std::string::npos ? std::string() : key.substr(0, pos);
+}
+
+// 比较两次加载的配置项（两个有序映射同时遍历）
+std::vector<ConfigSectionDiff> ConfigWatcher::diff(const ConfigEntries& previous, const ConfigEntries& current) {
+    std::map<std::string, ConfigSectionDiff> sections;
+    auto sectionFor = [&sections](const std::string& key) -> ConfigSectionDiff& {
+        std::string section = sectionOf(key);
+        ConfigSectionDiff& change = sections[section];
+        change.section = section;
+        return change;
+    };
+
+    auto before = previous.begin();
+    auto after = current.begin();
+    while (before != previous.end() || after != current.end()) {
+        if (after == current.end() || (before != previous.end() && before->first < after->first)) {
+            sectionFor(before->first).removed.push_back(before->first);
+            ++before;
+        } else if (before == previous.end() || after->first < before->first) {
+            sectionFor(after->first).changed.insert(*after);
+            ++after;
+        } else {
+            if (before->second != after->second) {
+                sectionFor(after->first).changed.insert(*after);
+            }
+            ++before;
+            ++after;
+        }
+    }
+
+    std::vector<ConfigSectionDiff> result;
+    result.reserve(sections.size());
+    for (auto& section : sections) {
+        result.push_back(std::move(section.second));
+    }
+    return result;
+}
@@ -0,0 +1,622 @@
+// FlightRecorder.cpp - 飞行记录器实现
+
+#include "FlightRecorder.h"
+#include "LocationModel.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+// 单个线程的事件缓冲区（只由所属线程写入）
+struct FlightRing {
+    FlightEvent* events;          // 事件数组（进程退出前不释放）
+    size_t capacity;              // 容量（2的幂）
+    std::atomic<uint64_t> next;   // 下一条事件的序号
+    std::atomic<bool> inUse;      // 是否被存活的线程占用
+    uint16_t slot;                // 缓冲区编号
+
+    FlightRing(size_t eventCapacity, uint16_t ringSlot) :
+        events(new FlightEvent[eventCapacity]()),
+        capacity(eventCapacity),
+        next(0),
+        inUse(true),
+        slot(ringSlot) {}
+};
+
+namespace {
+
+// 缓冲区最小容量
+const size_t MIN_RING_CAPACITY = 64;
+
+// 单行事件文本的最大长度
+const size_t MAX_EVENT_LINE = 160;
+
+// 转储文件的列说明
+const char* const DUMP_COLUMNS = "# wall_time_ms thread event source fix_timestamp latitude longitude value\n";
+
+// 各事件类型的名称
+const char* const EVENT_NAMES[] = {"FIX_INGESTED", "FIX_FILTERED", "ANOMALY_DETECTED", "FUSED", "STORED", "MARK"};
+
+// 致命信号
+const int FATAL_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+// 信号处理函数使用的记录器、转储文件路径（安装时预先生成）和格式化缓冲区
+// 缓冲区放在静态存储中，信号处理函数只在备用信号栈上使用很小的栈空间
+std::atomic<FlightRecorder*> crashRecorder(nullptr);
+char crashDumpPath[4096];
+char crashBuffer[8192];
+
+// 备用信号栈大小
+const size_t ALT_STACK_SIZE = 64 * 1024;
+
+// 线程的备用信号栈，线程退出时停用并释放
+struct AltStackHandle {
+    char* memory = nullptr; // 栈内存
+
+    ~AltStackHandle() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (memory) {
+            stack_t disabled;
+            std::memset(&disabled, 0, sizeof(disabled));
+            disabled.ss_flags = SS_DISABLE;
+            sigaltstack(&disabled, nullptr);
+            delete[] memory;
+        }
+#endif
+    }
+};
+
+thread_local AltStackHandle altStackHandle;
+
+// 为当前线程分配备用信号栈（线程已有备用栈时不替换）
+void ensureAltStack() {
+#if defined(__unix__) || defined(__APPLE__)
+    stack_t current;
+    if (altStackHandle.memory || sigaltstack(nullptr, &current) != 0 || !(current.ss_flags & SS_DISABLE)) {
+        return;
+    }
+    size_t size = std::max<size_t>(ALT_STACK_SIZE, SIGSTKSZ);
+    stack_t stack;
+    std::memset(&stack, 0, sizeof(stack));
+    stack.ss_sp = new char[size];
+    stack.ss_size = size;
+    if (sigaltstack(&stack, nullptr) != 0) {
+        delete[] static_cast<char*>(stack.ss_sp);
+        return;
+    }
+    altStackHandle.memory = static_cast<char*>(stack.ss_sp);
+#endif
+}
+
+// 线程退出时释放缓冲区，供之后的线程复用
+struct FlightRingHandle {
+    FlightRing* ring = nullptr;   // 当前线程的缓冲区
+    bool exhausted = false;       // 是否已无空闲槽位
+
+    ~FlightRingHandle() {
+        if (ring) {
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local FlightRingHandle ringHandle;
+
+// 获取当前时间（毫秒），Linux上使用粗粒度时钟（精度约数毫秒，开销远低于普通时钟）
+long long coarseTimeMs() {
+#if defined(CLOCK_REALTIME_COARSE)
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return static_cast<long long>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+#else
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// 将容量调整为2的幂
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = MIN_RING_CAPACITY;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 将经纬度转换为1e-7度的整数，无效值记为INT32_MIN
+int32_t toE7(double degrees) {
+    if (!(std::fabs(degrees) <= 180.0)) {
+        return INT32_MIN;
+    }
+    return static_cast<int32_t>(degrees * 1e7 + (degrees >= 0 ? 0.5 : -0.5));
+}
+
+// 以下格式化函数只使用异步信号安全的操作，供信号处理函数和普通转储共用
+
+// 追加字符串
+void appendText(char* out, size_t& length, const char* text) {
+    while (*text) {
+        out[length++] = *text++;
+    }
+}
+
+// 追加十进制整数
+void appendInteger(char* out, size_t& length, long long value) {
+    char digits[24];
+    size_t count = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        out[length++] = '-';
+    }
+    while (count > 0) {
+        out[length++] = digits[--count];
+    }
+}
+
+// 追加定点小数（scaled为放大10^decimals倍后的整数）
+void appendFixed(char* out, size_t& length, long long scaled, int decimals) {
+    long long divisor = 1;
+    for (int i = 0; i < decimals; ++i) {
+        divisor *= 10;
+    }
+    if (scaled < 0) {
+        out[length++] = '-';
+        scaled = -scaled;
+    }
+    appendInteger(out, length, scaled / divisor);
+    out[length++] = '.';
+    long long fraction = scaled % divisor;
+    for (long long place = divisor / 10; place > 0; place /= 10) {
+        out[length++] = static_cast<char>('0' + fraction / place % 10);
+    }
+}
+
+// 格式化一条事件，返回长度（不超过MAX_EVENT_LINE）
+size_t formatEvent(const FlightEvent& event, char* out) {
+    size_t length = 0;
+    appendInteger(out, length, event.wallTimeMs);
+    out[length++] = ' ';
+    appendInteger(out, length, event.threadSlot);
+    out[length++] = ' ';
+    appendText(out, length, event.type < sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]) ? EVENT_NAMES[event.type]
+                                                                                       : "UNKNOWN");
+    out[length++] = ' ';
+    appendInteger(out, length, event.source);
+    out[length++] = ' ';
+    appendInteger(out, length, event.fixTimestamp);
+    for (int32_t coordinate : {event.latitudeE7, event.longitudeE7}) {
+        out[length++] = ' ';
+        if (coordinate == INT32_MIN) {
+            appendText(out, length, "nan");
+        } else {
+            appendFixed(out, length, coordinate, 7);
+        }
+    }
+    out[length++] = ' ';
+    if (std::fabs(event.value) < 1e12f) {
+        appendFixed(out, length, static_cast<long long>(event.value * 1000.0f + (event.value >= 0 ? 0.5f : -0.5f)), 3);
+    } else {
+        appendText(out, length, "nan");
+    }
+    out[length++] = '\n';
+    return length;
+}
+
+// 写出全部数据（信号处理函数中使用）
+void writeAll(int fd, const char* data, size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#else
+    (void)fd;
+    (void)data;
+    (void)size;
+#endif
+}
+
+// 转储文件名中的时间（本地时间）
+std::string fileTimeString(long long timestampMs) {
+    std::time_t seconds = static_cast<std::time_t>(timestampMs / 1000);
+    std::tm localTime;
+#ifdef _WIN32
+    localtime_s(&localTime, &seconds);
+#else
+    localtime_r(&seconds, &localTime);
+#endif
+    char text[32];
+    size_t length = std::strftime(text, sizeof(text), "%Y%m%d_%H%M%S", &localTime);
+    std::snprintf(text + length, sizeof(text) - length, "_%03d", static_cast<int>(timestampMs % 1000));
+    return text;
+}
+
+} // namespace
+
+// FlightRecorder构造函数
+FlightRecorder::FlightRecorder() :
+    configVersion(1),
+    enabled(config.enabled),
+    eventsPerThread(config.eventsPerThread),
+    droppedCount(0),
+    lastAutoDumpMs(LLONG_MIN / 2),
+    burstConfigVersion(0),
+    burstCount(0),
+    burstWindowMs(0),
+    burstCooldownMs(0),
+    dumpsInProgress(0),
+    dumpStopping(false) {
+    for (auto& ring : rings) {
+        ring.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// FlightRecorder析构函数：等待正在写出的转储完成后停止后台线程
+FlightRecorder::~FlightRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        dumpStopping = true;
+    }
+    dumpCondition.notify_all();
+    if (dumpThread.joinable()) {
+        dumpThread.join();
+    }
+}
+
+// 获取单例实例
+FlightRecorder& FlightRecorder::getInstance() {
+    static FlightRecorder instance;
+    return instance;
+}
+
+// 设置配置
+void FlightRecorder::setConfig(const FlightRecorderConfig& newConfig) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    config = newConfig;
+    enabled.store(config.enabled, std::memory_order_relaxed);
+    eventsPerThread.store(config.eventsPerThread, std::memory_order_relaxed);
+    configVersion.fetch_add(1, std::memory_order_release);
+}
+
+// 获取配置
+FlightRecorderConfig FlightRecorder::getConfig() const {
+    std::lock_guard<std::mutex> lock(configMutex);
+    return config;
+}
+
+// 获取当前线程的缓冲区
+FlightRing* FlightRecorder::threadRing() {
+    if (ringHandle.ring || ringHandle.exhausted) {
+        return ringHandle.ring;
+    }
+
+    // 安装了崩溃处理函数时，记录事件的线程也需要备用信号栈
+    if (crashRecorder.load(std::memory_order_acquire)) {
+        ensureAltStack();
+    }
+
+    std::lock_guard<std::mutex> lock(ringMutex);
+    size_t capacity = roundUpPowerOfTwo(eventsPerThread.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < MAX_THREADS; ++i) {
+        FlightRing* ring = rings[i].load(std::memory_order_acquire);
+        if (!ring) {
+            ring = new FlightRing(capacity, static_cast<uint16_t>(i));
+            rings[i].store(ring, std::memory_order_release);
+            ringHandle.ring = ring;
+            return ring;
+        }
+        // 复用已退出线程的同容量缓冲区（旧事件随之清除）
+        if (ring->capacity == capacity && !ring->inUse.load(std::memory_order_acquire)) {
+            ring->next.store(0, std::memory_order_release);
+            ring->inUse.store(true, std::memory_order_relaxed);
+            ringHandle.ring = ring;
+            return ring;
+        }
+    }
+    ringHandle.exhausted = true;
+    return nullptr;
+}
+
+// 记录一个与定位相关的事件
+void FlightRecorder::record(FlightEventType type, const LocationInfo& location, float value) {
+    record(type, location.timestamp, location.latitude, location.longitude,
+           static_cast<int>(location.sourceType), value);
+}
+
+// 记录一个事件
+void FlightRecorder::record(FlightEventType type, long long fixTimestamp, double latitude, double longitude,
+                            int source, float value) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    FlightRing* ring = threadRing();
+    if (!ring) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t index = ring->next.load(std::memory_order_relaxed);
+    FlightEvent& event = ring->events[index & (ring->capacity - 1)];
+    event.wallTimeMs = coarseTimeMs();
+    event.fixTimestamp = fixTimestamp;
+    event.latitudeE7 = toE7(latitude);
+    event.longitudeE7 = toE7(longitude);
+    event.value = value;
+    event.type = static_cast<uint8_t>(type);
+    event.source = static_cast<uint8_t>(source);
+    event.threadSlot = ring->slot;
+    ring->next.store(index + 1, std::memory_order_release);
+
+    if (type == FlightEventType::ANOMALY_DETECTED) {
+        noteAnomaly(event.wallTimeMs);
+    }
+}
+
+// 统计异常事件，达到突发阈值时请求后台转储
+// 突发参数在配置版本变化时才从配置中复制一次，每个异常事件只加一次突发统计锁
+void FlightRecorder::noteAnomaly(long long nowMs) {
+    int count = 0;
+    int windowMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(burstMutex);
+        uint64_t version = configVersion.load(std::memory_order_acquire);
+        if (version != burstConfigVersion) {
+            std::lock_guard<std::mutex> configLock(configMutex);
+            burstCount = config.anomalyBurstCount;
+            burstWindowMs = config.anomalyBurstWindowMs;
+            burstCooldownMs = config.dumpCooldownMs;
+            burstConfigVersion = version;
+        }
+        if (burstCount <= 0) {
+            return;
+        }
+
+        anomalyTimes.push_back(nowMs);
+        while (!anomalyTimes.empty() && anomalyTimes.front() <= nowMs - burstWindowMs) {
+            anomalyTimes.pop_front();
+        }
+        if (anomalyTimes.size() < static_cast<size_t>(burstCount) || nowMs - lastAutoDumpMs < burstCooldownMs) {
+            return;
+        }
+        lastAutoDumpMs = nowMs;
+        anomalyTimes.clear();
+        count = burstCount;
+        windowMs = burstWindowMs;
+    }
+
+    LOG_WARNING("Anomaly burst detected (%d anomalies within %d ms), dumping flight recorder", count, windowMs);
+    requestDump("anomaly_burst");
+}
+
+// 请求由后台线程转储
+// 快照在后台线程中获取，与请求之间只相隔线程唤醒的时间，每线程保留的事件足以覆盖突发前后的上下文
+void FlightRecorder::requestDump(const std::string& reason) {
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        if (dumpStopping) {
+            return;
+        }
+        dumpRequests.push_back(reason);
+        if (!dumpThread.joinable()) {
+            dumpThread = std::thread(&FlightRecorder::dumpLoop, this);
+        }
+    }
+    dumpCondition.notify_all();
+}
+
+// 等待已请求的后台转储全部写出
+void FlightRecorder::waitForDumps() {
+    std::unique_lock<std::mutex> lock(dumpMutex);
+    dumpCondition.wait(lock, [this] { return dumpRequests.empty() && dumpsInProgress == 0; });
+}
+
+// 后台转储线程主循环
+void FlightRecorder::dumpLoop() {
+    std::unique_lock<std::mutex> lock(dumpMutex);
+    while (true) {
+        dumpCondition.wait(lock, [this] { return dumpStopping || !dumpRequests.empty(); });
+        if (dumpStopping) {
+            // 进程退出时日志等单例可能已析构，放弃尚未开始的转储
+            dumpRequests.clear();
+            dumpCondition.notify_all();
+            return;
+        }
+        std::string reason = std::move(dumpRequests.front());
+        dumpRequests.pop_front();
+        dumpsInProgress++;
+        lock.unlock();
+        dump(reason);
+        lock.lock();
+        dumpsInProgress--;
+        dumpCondition.notify_all();
+    }
+}
+
+// 复制所有线程缓冲区中的事件
+std::vector<FlightEvent> FlightRecorder::snapshot() const {
+    std::vector<FlightEvent> events;
+    std::vector<FlightEvent> copied;
+    for (const auto& slot : rings) {
+        const FlightRing* ring = slot.load(std::memory_order_acquire);
+        if (!ring) {
+            continue;
+        }
+
+        uint64_t end = ring->next.load(std::memory_order_acquire);
+        uint64_t begin = end > ring->capacity ? end - ring->capacity : 0;
+        copied.clear();
+        for (uint64_t index = begin; index < end; ++index) {
+            copied.push_back(ring->events[index & (ring->capacity - 1)]);
+        }
+
+        // 复制期间记录线程可能覆盖了最旧的事件（或缓冲区被新线程复用），只保留确定未被覆盖的部分；
+        // 线程仍在记录时，序号为endAfter的事件可能正在写入其槽位
+        bool writing = ring->inUse.load(std::memory_order_acquire);
+        uint64_t endAfter = ring->next.load(std::memory_order_acquire);
+        if (endAfter < end) {
+            continue;
+        }
+        uint64_t limit = endAfter + (writing ? 1 : 0);
+        uint64_t firstIntact = limit > ring->capacity ? limit - ring->capacity : 0;
+        for (uint64_t index = std::max(begin, firstIntact); index < end; ++index) {
+            events.push_back(copied[index - begin]);
+        }
+    }
+
+    // 同一线程的事件已按顺序排列，稳定排序保持线程内的记录顺序
+    std::stable_sort(events.begin(), events.end(), [](const FlightEvent& a, const FlightEvent& b) {
+        return a.wallTimeMs < b.wallTimeMs;
+    });
+    return events;
+}
+
+// 将所有事件转储到文件
+std::string FlightRecorder::dump(const std::string& reason) {
+    static std::atomic<uint64_t> dumpSequence(0);
+
+    std::vector<FlightEvent> events = snapshot();
+    std::string directory = getConfig().dumpDirectory;
+
+    // 文件名只保留原因中的字母、数字和下划线
+    std::string safeReason;
+    for (char c : reason) {
+        safeReason.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+    long long nowMs = coarseTimeMs();
+    std::string path = (std::filesystem::path(directory) /
+                        ("flight_" + fileTimeString(nowMs) + "_" + std::to_string(++dumpSequence) + "_" +
+                         safeReason + ".log")).string();
+
+    try {
+        std::filesystem::create_directories(directory);
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file) {
+            LOG_ERROR("Failed to create flight recorder dump: %s", path.c_str());
+            return std::string();
+        }
+
+        file << "# flight recorder dump: reason=" << reason << " time_ms=" << nowMs << " events=" << events.size()
+             << " dropped=" << getDroppedCount() << "\n" << DUMP_COLUMNS;
+        std::string text;
+        char line[MAX_EVENT_LINE];
+        for (const auto& event : events) {
+            text.append(line, formatEvent(event, line));
+        }
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            LOG_ERROR("Failed to write flight recorder dump: %s", path.c_str());
+            return std::string();
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Failed to dump flight recorder to %s: %s", path.c_str(), e.what());
+        return std::string();
+    }
+
+    LOG_WARNING("Flight recorder dumped %zu events to %s (reason: %s)", events.size(), path.c_str(), reason.c_str());
+    return path;
+}
+
+// 安装致命信号处理函数
+bool FlightRecorder::installCrashHandler() {
+#if defined(__unix__) || defined(__APPLE__)
+    // 转储文件路径在安装时生成，信号处理函数中不分配内存
+    std::string directory = getConfig().dumpDirectory;
+    std::string path = (std::filesystem::path(directory) /
+                        ("flight_crash_" + std::to_string(getpid()) + ".log")).string();
+    if (path.size() >= sizeof(crashDumpPath)) {
+        LOG_ERROR("Flight recorder crash dump path too long: %s", path.c_str());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::memcpy(crashDumpPath, path.c_str(), path.size() + 1);
+    crashRecorder.store(this, std::memory_order_release);
+
+    // 栈溢出引发的SIGSEGV无法在原栈上处理，处理函数在备用信号栈上运行
+    ensureAltStack();
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &FlightRecorder::onFatalSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    for (int signalNumber : FATAL_SIGNALS) {
+        if (sigaction(signalNumber, &action, nullptr) != 0) {
+            LOG_ERROR("Failed to install flight recorder handler for signal %d", signalNumber);
+            return false;
+        }
+    }
+    LOG_INFO("Flight recorder crash handler installed, dump file: %s", crashDumpPath);
+    return true;
+#else
+    LOG_WARNING("Flight recorder crash handler is not supported on this platform");
+    return false;
+#endif
+}
+
+// 致命信号处理函数：按线程依次写出缓冲区中的事件，然后按默认方式重新触发信号
+void FlightRecorder::onFatalSignal(int signalNumber) {
+#if defined(__unix__) || defined(__APPLE__)
+    static std::atomic<bool> handling(false);
+    FlightRecorder* recorder = crashRecorder.load(std::memory_order_acquire);
+    if (recorder && !handling.exchange(true)) {
+        int fd = ::open(crashDumpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            char* buffer = crashBuffer;
+            size_t length = 0;
+            appendText(buffer, length, "# flight recorder crash dump: signal=");
+            appendInteger(buffer, length, signalNumber);
+            appendText(buffer, length, " (events grouped by thread)\n");
+            appendText(buffer, length, DUMP_COLUMNS);
+
+            for (const auto& slot : recorder->rings) {
+                const FlightRing* ring = slot.load(std::memory_order_acquire);
+                if (!ring) {
+                    continue;
+                }
+                uint64_t end = ring->next.load(std::memory_order_acquire);
+                uint64_t begin = end > ring->capacity ? end - ring->capacity : 0;
+                for (uint64_t index = begin; index < end; ++index) {
+                    if (length + MAX_EVENT_LINE > sizeof(crashBuffer)) {
+                        writeAll(fd, buffer, length);
+                        length = 0;
+                    }
+                    length += formatEvent(ring->events[index & (ring->capacity - 1)], buffer + length);
+                }
+            }
+            writeAll(fd, buffer, length);
+            ::close(fd);
+        }
+    }
+#endif
+    // SA_RESETHAND已恢复默认处理，重新触发信号使进程按原方式终止（生成core文件等）
+    std::raise(signalNumber);
+}
+
+// 获取事件类型字符串
+const char* FlightRecorder::getEventTypeString(FlightEventType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]) ? EVENT_NAMES[index] : "UNKNOWN";
+}
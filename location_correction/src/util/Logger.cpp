@@ -1,58 +1,758 @@
 // Logger.cpp - 日志工具实现
 
 #include "Logger.h"
-#include "Logger.tpp"
-#include <iostream>
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <chrono>
-#include <thread>
+#include <climits>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(LOGGER_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace {
+
+// 栈上格式化缓冲区大小，更长的消息才在堆上分配
+const size_t STACK_MESSAGE_SIZE = 512;
+
+// 日志线程格式化单个参数时的栈上缓冲区大小
+const size_t STACK_ARG_SIZE = 256;
+
+// 缓冲区最小大小
+const size_t MIN_BUFFER_SIZE = 4096;
+
+// 日志线程空闲时的最长等待时间
+const auto IDLE_WAIT = std::chrono::milliseconds(100);
+
+// 压缩轮转文件时每次读取的大小
+const size_t COMPRESS_CHUNK_SIZE = 64 * 1024;
+
+// 初始时钟校准的测量时长
+const auto CALIBRATION_SPIN = std::chrono::milliseconds(2);
+
+// 重新校准时钟的间隔
+const auto CALIBRATION_INTERVAL = std::chrono::seconds(1);
+
+// 填充记录的级别标记（缓冲区末尾放不下整条日志时跳到开头）
+const uint8_t PADDING_LEVEL = 0xFF;
+
+// 缓冲区中每条日志的头部（负载紧随其后，整条日志按8字节对齐且不跨越缓冲区末尾）
+struct RecordHeader {
+    uint64_t ticks;   // 时间刻度
+    uint32_t siteId;  // 格式描述ID（0表示负载是已格式化的消息）
+    uint32_t length;  // 负载长度
+    uint8_t level;    // 日志级别
+};
+
+// 整条日志占用的字节数
+size_t recordSize(size_t payloadSize) {
+    return (sizeof(RecordHeader) + payloadSize + 7) & ~static_cast<size_t>(7);
+}
+
+// 将容量调整为2的幂
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = MIN_BUFFER_SIZE;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 获取当前墙上时间（纳秒）
+long long currentTimeNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 按单个转换说明格式化参数并追加到out
+void appendFormatted(std::string& out, const char* spec, ...) {
+    char stackBuffer[STACK_ARG_SIZE];
+    va_list args;
+    va_start(args, spec);
+    va_list retry;
+    va_copy(retry, args);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), spec, args);
+    va_end(args);
+
+    if (length >= 0 && static_cast<size_t>(length) < sizeof(stackBuffer)) {
+        out.append(stackBuffer, static_cast<size_t>(length));
+    } else if (length >= 0) {
+        size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(length) + 1);
+        vsnprintf(&out[offset], static_cast<size_t>(length) + 1, spec, retry);
+        out.resize(offset + static_cast<size_t>(length));
+    }
+    va_end(retry);
+}
+
+// 从负载中读取一个定长值，越界时返回false
+template <typename T>
+bool readValue(const char*& cursor, const char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+// 读取一个定长参数并交给visitor
+template <typename T, typename Visitor>
+bool visitValue(const char*& cursor, const char* end, Visitor& visitor) {
+    T value;
+    if (!readValue(cursor, end, value)) {
+        return false;
+    }
+    visitor(value);
+    return true;
+}
+
+// 按参数类型从负载中读取一个参数并交给visitor，越界时返回false
+// 字符串复制到scratch后以std::string传给visitor（空指针传入"(null)"）
+template <typename Visitor>
+bool visitArg(LogArgType type, const char*& cursor, const char* end, std::string& scratch, Visitor&& visitor) {
+    switch (type) {
+        case LogArgType::INT: return visitValue<int>(cursor, end, visitor);
+        case LogArgType::UNSIGNED_INT: return visitValue<unsigned int>(cursor, end, visitor);
+        case LogArgType::LONG: return visitValue<long>(cursor, end, visitor);
+        case LogArgType::UNSIGNED_LONG: return visitValue<unsigned long>(cursor, end, visitor);
+        case LogArgType::LONG_LONG: return visitValue<long long>(cursor, end, visitor);
+        case LogArgType::UNSIGNED_LONG_LONG: return visitValue<unsigned long long>(cursor, end, visitor);
+        case LogArgType::DOUBLE: return visitValue<double>(cursor, end, visitor);
+        case LogArgType::LONG_DOUBLE: return visitValue<long double>(cursor, end, visitor);
+        case LogArgType::POINTER: return visitValue<const void*>(cursor, end, visitor);
+        case LogArgType::STRING: {
+            uint32_t length;
+            if (!readValue(cursor, end, length)) {
+                return false;
+            }
+            if (length == UINT32_MAX) {
+                scratch = "(null)";
+            } else {
+                if (static_cast<size_t>(end - cursor) < length) {
+                    return false;
+                }
+                scratch.assign(cursor, length);
+                cursor += length;
+            }
+            visitor(scratch);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// 日志线程取出的一条日志
+struct LogRecord {
+    uint64_t ticks;       // 时间刻度
+    long long timestamp;  // 时间戳（毫秒，由日志线程换算）
+    LogLevel level;       // 日志级别
+    uint32_t siteId;      // 格式描述ID（0表示message已格式化）
+    uint64_t threadId;    // 线程ID
+    std::string message;  // 消息内容（或参数的原始字节）
+};
+
+// 调用点的格式描述：格式串拆分为文本片段和转换说明
+struct LogSiteInfo {
+    // 格式串片段
+    struct Segment {
+        std::string text;  // 文本内容，或单个转换说明（如"%-8.3f"）
+        bool conversion;   // 是否为转换说明
+        bool skip;         // 是否不输出（%n）
+        int stars;         // 宽度和精度中'*'的个数（各占一个int参数）
+        char plain;        // 不带标志、宽度和精度的%d、%i、%u、%s（可不经snprintf直接输出），否则为0
+    };
+
+    std::vector<LogArgType> types;              // 参数类型（%p对应的C字符串参数记为POINTER）
+    std::vector<LogStringCapture> captures;     // 各参数的字符串记录方式（比参数多一项，供调用点读取）
+    std::vector<Segment> segments;              // 格式串片段
+    std::string format;             // 原始格式串（用于限速汇总）
+    LogLevel level;                 // 调用点的日志级别
+    LogSite* site;                  // 调用点（静态实例，进程退出前一直有效）
+};
+
+// 预编译的日志格式（如"[%TIME%] [%LEVEL%] %MESSAGE%"）
+struct LogLineFormat {
+    // 格式字段
+    enum class Field { TEXT, TIME, LEVEL, THREAD, MESSAGE };
+
+    // 格式操作
+    struct Op {
+        Field field;       // 字段类型
+        std::string text;  // 文本内容（仅TEXT）
+    };
 
-// 静态成员初始化
-std::shared_ptr<Logger> Logger::instance = nullptr;
-std::mutex Logger::instanceMutex;
+    std::vector<Op> ops;   // 按顺序执行的格式操作
+};
+
+// 预编译的时间格式（如"%Y-%m-%d %H:%M:%S.%MS"），缓存当前秒的渲染结果
+struct LogTimeFormat {
+    // 格式字段
+    enum class Field { TEXT, YEAR, MONTH, DAY, HOUR, MINUTE, SECOND, MILLISECOND };
+
+    // 格式操作
+    struct Op {
+        Field field;       // 字段类型
+        std::string text;  // 文本内容（仅TEXT）
+    };
+
+    std::vector<Op> ops;                      // 按顺序执行的格式操作
+    long long cachedSecond;                   // 已渲染的秒（LLONG_MIN表示尚未渲染）
+    std::string cachedText;                   // 已渲染的时间（毫秒位置填0）
+    std::vector<size_t> millisecondOffsets;   // cachedText中毫秒字段的位置
+
+    LogTimeFormat() : cachedSecond(LLONG_MIN) {}
+};
+
+// 单个线程的日志缓冲区（单生产者单消费者环形缓冲区）
+// 业务线程只修改head，日志线程只修改tail，两者位于不同缓存行
+class LogBuffer {
+private:
+    std::vector<char> data;           // 环形缓冲区
+    size_t mask;                      // 容量-1（容量为2的幂）
+    size_t pendingHead;               // 已预留但尚未提交的写入位置（业务线程）
+    alignas(64) std::atomic<size_t> head; // 写入位置（业务线程）
+    alignas(64) std::atomic<size_t> tail; // 读取位置（日志线程）
+
+    // 写入一条日志头部
+    void writeHeader(size_t position, const RecordHeader& header) {
+        std::memcpy(data.data() + (position & mask), &header, sizeof(RecordHeader));
+    }
+
+public:
+    const uint64_t threadId;          // 所属线程ID
+    std::atomic<bool> closed;         // 所属线程是否已退出
+
+    LogBuffer(size_t capacity, uint64_t ownerThreadId) :
+        data(roundUpPowerOfTwo(capacity)),
+        mask(data.size() - 1),
+        pendingHead(0),
+        head(0),
+        tail(0),
+        threadId(ownerThreadId),
+        closed(false) {}
+
+    // 单条日志负载的最大长度（保证总能放入空的缓冲区）
+    size_t maxPayloadSize() const {
+        return data.size() / 2 - sizeof(RecordHeader);
+    }
+
+    // 预留一条日志的空间并写入头部，返回负载的写入位置；空间不足时返回nullptr
+    char* reserve(LogLevel messageLevel, uint32_t siteId, size_t payloadSize, uint64_t ticks) {
+        size_t need = recordSize(payloadSize);
+        size_t position = head.load(std::memory_order_relaxed);
+        size_t remaining = data.size() - (position & mask);
+        size_t skip = remaining < need ? remaining : 0;
+        if (data.size() - (position - tail.load(std::memory_order_acquire)) < skip + need) {
+            return nullptr;
+        }
+
+        // 末尾放不下：能放下头部时写入填充记录，否则日志线程按同样规则直接跳到开头
+        if (skip >= sizeof(RecordHeader)) {
+            RecordHeader padding = {};
+            padding.length = static_cast<uint32_t>(skip - sizeof(RecordHeader));
+            padding.level = PADDING_LEVEL;
+            writeHeader(position, padding);
+        }
+        position += skip;
+
+        RecordHeader header;
+        header.ticks = ticks;
+        header.siteId = siteId;
+        header.length = static_cast<uint32_t>(payloadSize);
+        header.level = static_cast<uint8_t>(messageLevel);
+        writeHeader(position, header);
+        pendingHead = position + need;
+        return data.data() + (position & mask) + sizeof(RecordHeader);
+    }
+
+    // 提交reserve预留的日志
+    void commit() {
+        head.store(pendingHead, std::memory_order_release);
+    }
+
+    // 取出所有已写入的日志，返回取出的条数
+    size_t drain(std::vector<LogRecord>& batch) {
+        size_t end = head.load(std::memory_order_acquire);
+        size_t position = tail.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (position != end) {
+            size_t remaining = data.size() - (position & mask);
+            if (remaining < sizeof(RecordHeader)) {
+                position += remaining;
+                continue;
+            }
+
+            RecordHeader header;
+            std::memcpy(&header, data.data() + (position & mask), sizeof(RecordHeader));
+            if (header.level != PADDING_LEVEL) {
+                LogRecord record;
+                record.ticks = header.ticks;
+                record.timestamp = 0;
+                record.level = static_cast<LogLevel>(header.level);
+                record.siteId = header.siteId;
+                record.threadId = threadId;
+                record.message.assign(data.data() + (position & mask) + sizeof(RecordHeader), header.length);
+                batch.push_back(std::move(record));
+                ++count;
+            }
+            position += recordSize(header.length);
+        }
+        tail.store(position, std::memory_order_release);
+        return count;
+    }
+
+    // 检查是否已取空
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+};
+
+// 日志文件（只由日志线程访问），每次写出一整块缓冲区
+class LogFile {
+private:
+#if defined(__unix__) || defined(__APPLE__)
+    int fd;                 // 文件描述符
+#else
+    std::FILE* stream;      // 文件流
+#endif
+    size_t initialSize;     // 打开时的文件大小
+
+public:
+#if defined(__unix__) || defined(__APPLE__)
+    LogFile() : fd(-1), initialSize(0) {}
+#else
+    LogFile() : stream(nullptr), initialSize(0) {}
+#endif
+
+    ~LogFile() {
+        close();
+    }
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // 以追加方式打开（truncate为true时清空）
+    bool open(const std::string& path, bool truncate) {
+        close();
+#if defined(__unix__) || defined(__APPLE__)
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        initialSize = fstat(fd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+#else
+        stream = std::fopen(path.c_str(), truncate ? "wb" : "ab");
+        if (!stream) {
+            return false;
+        }
+        std::fseek(stream, 0, SEEK_END);
+        long position = std::ftell(stream);
+        initialSize = position > 0 ? static_cast<size_t>(position) : 0;
+#endif
+        return true;
+    }
+
+    // 是否已打开
+    bool isOpen() const {
+#if defined(__unix__) || defined(__APPLE__)
+        return fd >= 0;
+#else
+        return stream != nullptr;
+#endif
+    }
+
+    // 打开时的文件大小
+    size_t size() const {
+        return initialSize;
+    }
+
+    // 写出全部数据（处理部分写入和信号中断）
+    bool write(const char* data, size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+#else
+        bool succeeded = std::fwrite(data, 1, size, stream) == size;
+        return std::fflush(stream) == 0 && succeeded;
+#endif
+    }
+
+    // 关闭文件
+    void close() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+#else
+        if (stream) {
+            std::fclose(stream);
+            stream = nullptr;
+        }
+#endif
+    }
+};
+
+namespace {
+
+// 线程退出时标记缓冲区，由日志线程取空后移除
+struct ThreadBufferHandle {
+    std::shared_ptr<LogBuffer> buffer;
+
+    ~ThreadBufferHandle() {
+        if (buffer) {
+            buffer->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadBufferHandle threadBufferHandle;
+
+// 解析格式串（转换说明保留原样，由snprintf逐个格式化）
+std::vector<LogSiteInfo::Segment> parseFormat(const char* format) {
+    std::vector<LogSiteInfo::Segment> segments;
+    std::string text;
+    const char* cursor = format;
+    while (*cursor) {
+        if (*cursor != '%') {
+            text.push_back(*cursor++);
+            continue;
+        }
+        if (cursor[1] == '%') {
+            text.push_back('%');
+            cursor += 2;
+            continue;
+        }
+
+        const char* start = cursor++;
+        int stars = 0;
+        // 标志
+        while (*cursor && std::strchr("-+ #0'", *cursor)) {
+            ++cursor;
+        }
+        // 宽度
+        if (*cursor == '*') {
+            ++stars;
+            ++cursor;
+        } else {
+            while (std::isdigit(static_cast<unsigned char>(*cursor))) {
+                ++cursor;
+            }
+        }
+        // 精度
+        if (*cursor == '.') {
+            ++cursor;
+            if (*cursor == '*') {
+                ++stars;
+                ++cursor;
+            } else {
+                while (std::isdigit(static_cast<unsigned char>(*cursor))) {
+                    ++cursor;
+                }
+            }
+        }
+        // 长度修饰符
+        const char* modifiers = cursor;
+        while (*cursor && std::strchr("hlLqjzt", *cursor)) {
+            ++cursor;
+        }
+        if (!*cursor) {
+            // 不完整的转换说明按文本输出
+            text.append(start);
+            break;
+        }
+        ++cursor;
+
+        if (!text.empty()) {
+            segments.push_back({text, false, false, 0, 0});
+            text.clear();
+        }
+        char conversion = cursor[-1];
+        char plain = modifiers == start + 1 && std::strchr("dius", conversion) ? conversion : 0;
+        segments.push_back({std::string(start, cursor), true, conversion == 'n', stars, plain});
+    }
+    if (!text.empty()) {
+        segments.push_back({text, false, false, 0, 0});
+    }
+    return segments;
+}
+
+// 按转换说明确定C字符串参数的记录方式：%p只记录地址，带精度的%s最多复制精度个字符
+void assignStringCaptures(LogSiteInfo& info) {
+    info.captures.assign(info.types.size() + 1, LogStringCapture());
+    size_t argIndex = 0;
+    for (const auto& segment : info.segments) {
+        if (!segment.conversion) {
+            continue;
+        }
+        argIndex += static_cast<size_t>(segment.stars);
+        if (argIndex >= info.types.size()) {
+            break;
+        }
+        size_t index = argIndex++;
+        if (info.types[index] != LogArgType::STRING) {
+            continue;
+        }
+
+        LogStringCapture& capture = info.captures[index];
+        char conversion = segment.text.back();
+        if (conversion == 'p') {
+            capture.mode = LogStringCapture::Mode::ADDRESS;
+            info.types[index] = LogArgType::POINTER;
+            continue;
+        }
+        size_t dot = segment.text.find('.');
+        if (conversion != 's' || dot == std::string::npos) {
+            continue;
+        }
+        if (segment.text[dot + 1] == '*') {
+            capture.mode = LogStringCapture::Mode::STAR_BOUNDED;
+        } else {
+            capture.mode = LogStringCapture::Mode::BOUNDED;
+            capture.precision = static_cast<uint32_t>(std::strtoul(segment.text.c_str() + dot + 1, nullptr, 10));
+        }
+    }
+}
+
+// 检查参数类型与转换说明是否匹配，不匹配时不交给snprintf，避免按错误类型读取参数
+bool argumentMatches(char conversion, LogArgType type) {
+    bool isString = type == LogArgType::STRING;
+    bool isPointer = type == LogArgType::POINTER;
+    bool isFloating = type == LogArgType::DOUBLE || type == LogArgType::LONG_DOUBLE;
+    switch (conversion) {
+        case 's': return isString;
+        case 'p': return isPointer;
+        case 'n': return true;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': return isFloating;
+        default: return !isString && !isPointer && !isFloating;
+    }
+}
+
+// 将文件压缩为gzip格式，没有zlib时返回false
+bool compressFile(const std::string& source, const std::string& target) {
+#if defined(LOGGER_HAS_ZLIB)
+    std::ifstream input(source, std::ios::binary);
+    gzFile output = gzopen(target.c_str(), "wb");
+    if (!input || !output) {
+        if (output) {
+            gzclose(output);
+        }
+        return false;
+    }
+
+    std::vector<char> chunk(COMPRESS_CHUNK_SIZE);
+    bool succeeded = true;
+    while (succeeded && input) {
+        input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        std::streamsize count = input.gcount();
+        if (count > 0) {
+            succeeded = gzwrite(output, chunk.data(), static_cast<unsigned>(count)) == count;
+        }
+    }
+    succeeded = gzclose(output) == Z_OK && succeeded && input.eof();
+    if (!succeeded) {
+        std::error_code error;
+        std::filesystem::remove(target, error);
+    }
+    return succeeded;
+#else
+    (void)source;
+    (void)target;
+    return false;
+#endif
+}
+
+// 日志级别名称
+const char* levelName(LogLevel logLevel) {
+    switch (logLevel) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+        default: return "UNKNOWN";
+    }
+}
+
+// 追加十进制整数，不足width位时左侧补0
+template <typename T>
+void appendNumber(std::string& out, T value, int width = 0) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    for (int length = static_cast<int>(end - digits); length < width; ++length) {
+        out.push_back('0');
+    }
+    out.append(digits, end);
+}
+
+// 预编译日志格式
+void compileLineFormat(const std::string& format, LogLineFormat& compiled) {
+    static const struct {
+        const char* token;
+        LogLineFormat::Field field;
+    } tokens[] = {
+        {"%TIME%", LogLineFormat::Field::TIME},
+        {"%LEVEL%", LogLineFormat::Field::LEVEL},
+        {"%THREAD%", LogLineFormat::Field::THREAD},
+        {"%MESSAGE%", LogLineFormat::Field::MESSAGE},
+    };
+
+    compiled.ops.clear();
+    std::string text;
+    size_t position = 0;
+    while (position < format.size()) {
+        bool matched = false;
+        if (format[position] == '%') {
+            for (const auto& token : tokens) {
+                size_t length = std::strlen(token.token);
+                if (format.compare(position, length, token.token) == 0) {
+                    if (!text.empty()) {
+                        compiled.ops.push_back({LogLineFormat::Field::TEXT, text});
+                        text.clear();
+                    }
+                    compiled.ops.push_back({token.field, std::string()});
+                    position += length;
+                    matched = true;
+                    break;
+                }
+            }
+        }
+        if (!matched) {
+            text.push_back(format[position++]);
+        }
+    }
+    if (!text.empty()) {
+        compiled.ops.push_back({LogLineFormat::Field::TEXT, text});
+    }
+}
+
+// 预编译时间格式（%MS和%f为毫秒，其他未知的%x输出x）
+void compileTimeFormat(const std::string& format, LogTimeFormat& compiled) {
+    compiled.ops.clear();
+    compiled.cachedSecond = LLONG_MIN;
+    std::string text;
+    auto addField = [&compiled, &text](LogTimeFormat::Field field) {
+        if (!text.empty()) {
+            compiled.ops.push_back({LogTimeFormat::Field::TEXT, text});
+            text.clear();
+        }
+        compiled.ops.push_back({field, std::string()});
+    };
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%' || i + 1 >= format.size()) {
+            text.push_back(format[i]);
+            continue;
+        }
+        ++i;
+        switch (format[i]) {
+            case 'Y': addField(LogTimeFormat::Field::YEAR); break;
+            case 'm': addField(LogTimeFormat::Field::MONTH); break;
+            case 'd': addField(LogTimeFormat::Field::DAY); break;
+            case 'H': addField(LogTimeFormat::Field::HOUR); break;
+            case 'M':
+                if (i + 1 < format.size() && format[i + 1] == 'S') {
+                    addField(LogTimeFormat::Field::MILLISECOND);
+                    ++i;
+                } else {
+                    addField(LogTimeFormat::Field::MINUTE);
+                }
+                break;
+            case 'S': addField(LogTimeFormat::Field::SECOND); break;
+            case 'f': addField(LogTimeFormat::Field::MILLISECOND); break;
+            default: text.push_back(format[i]); break;
+        }
+    }
+    if (!text.empty()) {
+        compiled.ops.push_back({LogTimeFormat::Field::TEXT, text});
+    }
+}
+
+} // namespace
 
 // Logger构造函数
-Logger::Logger() : config(LoggerConfig()), 
-                   fileStream(nullptr), 
-                   running(true), 
-                   logThread(nullptr), 
-                   logQueue() {
-    // 默认配置
-    config.logLevel = LogLevel::INFO;
-    config.enableConsoleOutput = true;
-    config.enableFileOutput = false;
-    config.logFile = "application.log";
-    config.maxLogFileSize = 10 * 1024 * 1024; // 10MB
-    config.maxBackupFiles = 5;
-    config.consoleLogFormat = "[%TIME%] [%LEVEL%] %MESSAGE%";
-    config.fileLogFormat = "[%TIME%] [%LEVEL%] [%THREAD%] %MESSAGE%";
-    config.dateFormat = "%Y-%m-%d %H:%M:%S.%MS";
-    
-    // 启动日志线程
-    startLogThread();
+Logger::Logger() :
+    level(static_cast<int>(config.logLevel)),
+    overflowPolicy(static_cast<int>(config.overflowPolicy)),
+    threadBufferSize(config.threadBufferSize),
+    rateLimitLevel(static_cast<int>(config.rateLimitLevel)),
+    rateLimitIntervalTicks(0),
+    rateLimitBurstTicks(0),
+    configChanged(true),
+    droppedCount(0),
+    writerWaiting(false),
+    flushRequested(0),
+    flushCompleted(0),
+    truncateRequested(false),
+    truncateSucceeded(false),
+    running(true),
+    rotationStopping(false),
+    outputFile(new LogFile()),
+    fileSize(0),
+    rotationSequence(0),
+    baseTicks(0),
+    clockTicks(0),
+    clockWallNs(0),
+    ticksPerNs(1.0) {
+    // 启动日志线程和轮转线程
+    logThread = std::thread(&Logger::processLogQueue, this);
+    rotationThread = std::thread(&Logger::processRotations, this);
 }
 
 // Logger析构函数
 Logger::~Logger() {
-    // 停止日志线程
-    stopLogThread();
-    
-    // 关闭文件流
-    if (fileStream != nullptr && fileStream->is_open()) {
-        fileStream->close();
-        delete fileStream;
-        fileStream = nullptr;
+    // 停止日志线程，剩余的日志由日志线程写出后退出
+    running.store(false);
+    wakeWriter();
+    if (logThread.joinable()) {
+        logThread.join();
+    }
+
+    // 日志线程退出后再停止轮转线程，剩余的轮转任务处理完后退出
+    {
+        std::lock_guard<std::mutex> lock(rotationMutex);
+        rotationStopping = true;
+    }
+    rotationCV.notify_one();
+    if (rotationThread.joinable()) {
+        rotationThread.join();
     }
 }
 
 // 获取Logger单例实例
-std::shared_ptr<Logger> Logger::getInstance() {
-    std::lock_guard<std::mutex> lock(instanceMutex);
-    if (instance == nullptr) {
-        instance = std::shared_ptr<Logger>(new Logger());
-    }
+Logger& Logger::getInstance() {
+    static Logger instance;
     return instance;
 }
 
@@ -60,16 +760,11 @@ std::shared_ptr<Logger> Logger::getInstance() {
 void Logger::setConfig(const LoggerConfig& newConfig) {
     std::lock_guard<std::mutex> lock(configMutex);
     config = newConfig;
-    
-    // 如果启用了文件输出，初始化文件流
-    if (config.enableFileOutput && fileStream == nullptr) {
-        initializeFileStream();
-    } else if (!config.enableFileOutput && fileStream != nullptr) {
-        // 如果禁用了文件输出，关闭文件流
-        fileStream->close();
-        delete fileStream;
-        fileStream = nullptr;
-    }
+    level.store(static_cast<int>(config.logLevel), std::memory_order_relaxed);
+    overflowPolicy.store(static_cast<int>(config.overflowPolicy), std::memory_order_relaxed);
+    threadBufferSize.store(config.threadBufferSize, std::memory_order_relaxed);
+    rateLimitLevel.store(static_cast<int>(config.rateLimitLevel), std::memory_order_relaxed);
+    configChanged.store(true, std::memory_order_release);
 }
 
 // 获取当前日志配置
@@ -78,213 +773,728 @@ LoggerConfig Logger::getConfig() const {
     return config;
 }
 
-// 初始化文件流
-bool Logger::initializeFileStream() {
-    std::lock_guard<std::mutex> lock(fileMutex);
-    
-    try {
-        // 检查文件大小，如果超过最大大小，进行日志轮转
-        checkLogFileSize();
-        
-        // 打开文件流（追加模式）
-        fileStream = new std::ofstream(config.logFile, std::ios::out | std::ios::app);
-        
-        if (!fileStream->is_open()) {
-            std::cerr << "Failed to open log file: " << config.logFile << std::endl;
-            delete fileStream;
-            fileStream = nullptr;
-            return false;
+// 设置日志级别
+void Logger::setLogLevel(LogLevel newLevel) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    config.logLevel = newLevel;
+    level.store(static_cast<int>(newLevel), std::memory_order_relaxed);
+}
+
+// 设置日志文件并启用文件输出
+void Logger::setLogFile(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    config.logFile = filePath;
+    config.enableFileOutput = true;
+    configChanged.store(true, std::memory_order_release);
+}
+
+// 获取当前线程的缓冲区
+LogBuffer& Logger::threadBuffer() {
+    std::shared_ptr<LogBuffer>& buffer = threadBufferHandle.buffer;
+    if (!buffer) {
+        uint64_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+        buffer = std::make_shared<LogBuffer>(threadBufferSize.load(std::memory_order_relaxed), threadId);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// 唤醒正在等待的日志线程（只由第一个看到等待标志的线程加锁通知）
+void Logger::wakeWriter() {
+    if ((writerWaiting.load(std::memory_order_relaxed) && writerWaiting.exchange(false)) ||
+        !running.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCV.notify_one();
+    }
+}
+
+// 在当前线程的缓冲区中预留一条日志的空间
+char* Logger::beginRecord(LogLevel messageLevel, uint32_t siteId, size_t payloadSize, uint64_t ticks) {
+    LogBuffer& buffer = threadBuffer();
+    char* payload = buffer.reserve(messageLevel, siteId, payloadSize, ticks);
+    while (!payload) {
+        // 缓冲区已满：丢弃，或等待日志线程取走数据（日志线程已停止时只能丢弃）
+        if (overflowPolicy.load(std::memory_order_relaxed) == static_cast<int>(LogOverflowPolicy::DROP) ||
+            !running.load(std::memory_order_relaxed) ||
+            std::this_thread::get_id() == logThread.get_id()) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
         }
-        
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Exception when initializing log file: " << e.what() << std::endl;
-        if (fileStream != nullptr) {
-            delete fileStream;
-            fileStream = nullptr;
+        wakeWriter();
+        std::this_thread::yield();
+        payload = buffer.reserve(messageLevel, siteId, payloadSize, ticks);
+    }
+    return payload;
+}
+
+// 提交beginRecord预留的日志
+void Logger::endRecord() {
+    threadBufferHandle.buffer->commit();
+    wakeWriter();
+}
+
+// 将一条已格式化的日志写入当前线程的缓冲区
+void Logger::enqueue(LogLevel messageLevel, const char* message, size_t length) {
+    length = std::min(length, threadBuffer().maxPayloadSize());
+    char* payload = beginRecord(messageLevel, 0, length, logTicks());
+    if (!payload) {
+        return;
+    }
+    std::memcpy(payload, message, length);
+    endRecord();
+}
+
+// 注册调用点的格式描述
+uint32_t Logger::registerSite(LogSite& site, LogLevel messageLevel, const char* format, const LogArgType* types,
+                              size_t count) {
+    std::lock_guard<std::mutex> lock(siteMutex);
+    // 多个线程同时首次执行同一调用点时只注册一次
+    uint32_t siteId = site.id.load(std::memory_order_relaxed);
+    if (siteId != 0) {
+        return siteId;
+    }
+
+    std::unique_ptr<LogSiteInfo> info(new LogSiteInfo());
+    info->types.assign(types, types + count);
+    info->segments = parseFormat(format);
+    assignStringCaptures(*info);
+    info->format = format;
+    info->level = messageLevel;
+    info->site = &site;
+    // 记录方式在发布ID之前写入，读到ID的线程都能看到
+    site.captures = info->captures.data();
+    sites.push_back(std::move(info));
+    siteId = static_cast<uint32_t>(sites.size());
+    site.id.store(siteId, std::memory_order_release);
+    return siteId;
+}
+
+// 按格式描述将参数的原始字节格式化为消息
+void Logger::decodeMessage(uint32_t siteId, const std::string& payload, std::string& out) const {
+    const LogSiteInfo* info = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(siteMutex);
+        if (siteId == 0 || siteId > sites.size()) {
+            out = "<unknown log site>";
+            return;
         }
-        return false;
+        info = sites[siteId - 1].get();
     }
+
+    out.clear();
+    const char* cursor = payload.data();
+    const char* end = cursor + payload.size();
+    size_t argIndex = 0;
+    std::string scratch;
+    for (const auto& segment : info->segments) {
+        if (!segment.conversion) {
+            out += segment.text;
+            continue;
+        }
+
+        // 先读取宽度和精度参数，参数不足或类型不符时原样输出转换说明
+        int starValues[2] = {0, 0};
+        bool valid = argIndex + segment.stars < info->types.size();
+        for (int i = 0; valid && i < segment.stars; ++i) {
+            valid = visitArg(info->types[argIndex++], cursor, end, scratch, [&starValues, i](const auto& value) {
+                using T = typename std::decay<decltype(value)>::type;
+                if constexpr (std::is_arithmetic<T>::value) {
+                    starValues[i] = static_cast<int>(value);
+                }
+            });
+        }
+        if (!valid) {
+            out += segment.text;
+            break;
+        }
+
+        LogArgType type = info->types[argIndex++];
+        if (!argumentMatches(segment.text.back(), type)) {
+            out += segment.text;
+            continue;
+        }
+
+        const char* spec = segment.text.c_str();
+        int stars = segment.stars;
+        bool skip = segment.skip;
+        char plain = segment.plain;
+        valid = visitArg(type, cursor, end, scratch, [&](const auto& value) {
+            using T = typename std::decay<decltype(value)>::type;
+            if (skip) {
+                return;
+            }
+            // 最常见的%d、%u、%s直接输出（%u按无符号、%d按有符号解释，与printf一致）
+            if constexpr (std::is_integral<T>::value) {
+                if (plain == 'u') {
+                    appendNumber(out, static_cast<typename std::make_unsigned<T>::type>(value));
+                    return;
+                }
+                if (plain == 'd' || plain == 'i') {
+                    appendNumber(out, static_cast<typename std::make_signed<T>::type>(value));
+                    return;
+                }
+            }
+            if constexpr (std::is_same<T, std::string>::value) {
+                if (plain == 's') {
+                    out += value;
+                    return;
+                }
+                if (stars == 0) {
+                    appendFormatted(out, spec, value.c_str());
+                } else if (stars == 1) {
+                    appendFormatted(out, spec, starValues[0], value.c_str());
+                } else {
+                    appendFormatted(out, spec, starValues[0], starValues[1], value.c_str());
+                }
+            } else {
+                if (stars == 0) {
+                    appendFormatted(out, spec, value);
+                } else if (stars == 1) {
+                    appendFormatted(out, spec, starValues[0], value);
+                } else {
+                    appendFormatted(out, spec, starValues[0], starValues[1], value);
+                }
+            }
+        });
+        if (!valid) {
+            out += segment.text;
+            break;
+        }
+    }
+}
+
+// 参数过长时立即格式化并截断后写入
+void Logger::enqueueOversized(LogLevel messageLevel, uint32_t siteId, const std::string& payload) {
+    std::string message;
+    decodeMessage(siteId, payload, message);
+    enqueue(messageLevel, message.data(), message.size());
+}
+
+// 将时间刻度换算为墙上时间（毫秒）
+long long Logger::ticksToMs(uint64_t ticks) const {
+    double elapsedNs = static_cast<double>(static_cast<int64_t>(ticks - clockTicks)) / ticksPerNs;
+    return (clockWallNs + static_cast<long long>(elapsedNs)) / 1000000;
 }
 
-// 检查日志文件大小
-void Logger::checkLogFileSize() {
-    std::ifstream file(config.logFile, std::ios::ate | std::ios::binary);
-    if (file.is_open()) {
-        std::streamsize size = file.tellg();
-        file.close();
-        
-        // 如果文件大小超过最大限制，进行日志轮转
-        if (size > config.maxLogFileSize) {
-            rotateLogFiles();
+// 用当前时间重新校准时钟
+void Logger::calibrateClock(bool initial) {
+    if (initial) {
+        // 以一小段忙等测量刻度频率，之后以初始点为基线不断修正
+        baseSteady = std::chrono::steady_clock::now();
+        baseTicks = logTicks();
+        while (std::chrono::steady_clock::now() - baseSteady < CALIBRATION_SPIN) {
         }
     }
+
+    std::chrono::steady_clock::time_point nowSteady = std::chrono::steady_clock::now();
+    uint64_t nowTicks = logTicks();
+    long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(nowSteady - baseSteady).count();
+    if (elapsedNs > 0 && nowTicks > baseTicks) {
+        ticksPerNs = static_cast<double>(nowTicks - baseTicks) / static_cast<double>(elapsedNs);
+    }
+    clockTicks = nowTicks;
+    clockWallNs = currentTimeNs();
+    clockSteady = nowSteady;
 }
 
-// 轮转日志文件
-void Logger::rotateLogFiles() {
-    // 删除最旧的备份文件
-    for (int i = config.maxBackupFiles; i > 1; --i) {
-        std::string oldFile = config.logFile + "." + std::to_string(i-1);
-        std::string newFile = config.logFile + "." + std::to_string(i);
-        
-        // 如果文件存在，则重命名
-        if (std::ifstream(oldFile)) {
-            std::rename(oldFile.c_str(), newFile.c_str());
+// 按配置和当前的刻度频率换算限速参数
+void Logger::updateRateLimit(const LoggerConfig& currentConfig) {
+    if (currentConfig.rateLimitPerSecond <= 0) {
+        rateLimitIntervalTicks.store(0, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t interval = std::max<uint64_t>(
+        1, static_cast<uint64_t>(ticksPerNs * 1e9 / currentConfig.rateLimitPerSecond));
+    uint64_t burst = static_cast<uint64_t>(std::max(currentConfig.rateLimitBurst, 1) - 1);
+    rateLimitBurstTicks.store(interval * burst, std::memory_order_relaxed);
+    rateLimitIntervalTicks.store(interval, std::memory_order_relaxed);
+}
+
+// 为被限速丢弃过日志的调用点生成汇总日志
+void Logger::reportSuppressed(std::vector<LogRecord>& batch, const LoggerConfig& currentConfig) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - suppressionReported).count();
+    suppressionReported = now;
+
+    std::lock_guard<std::mutex> lock(siteMutex);
+    for (const auto& info : sites) {
+        if (info->site->suppressed.load(std::memory_order_relaxed) == 0) {
+            continue;
         }
+        uint32_t suppressed = info->site->suppressed.exchange(0, std::memory_order_relaxed);
+        LogRecord record;
+        record.ticks = logTicks();
+        record.timestamp = 0;
+        record.level = info->level;
+        record.siteId = 0;
+        record.threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+        record.message = "Suppressed " + std::to_string(suppressed) + " messages in the last " +
+                         std::to_string(elapsedMs) + " ms (limit " +
+                         std::to_string(currentConfig.rateLimitPerSecond) + "/s): " + info->format;
+        batch.push_back(std::move(record));
     }
-    
-    // 将当前日志文件重命名为.log.1
-    if (std::ifstream(config.logFile)) {
-        std::string backupFile = config.logFile + ".1";
-        std::rename(config.logFile.c_str(), backupFile.c_str());
+}
+
+// 记录日志
+void Logger::log(LogLevel messageLevel, const std::string& message) {
+    if (!shouldLog(messageLevel)) {
+        return;
+    }
+
+    enqueue(messageLevel, message.data(), message.size());
+    if (messageLevel == LogLevel::FATAL) {
+        flush();
     }
 }
 
-// 启动日志线程
-void Logger::startLogThread() {
-    running = true;
-    logThread = new std::thread(&Logger::processLogQueue, this);
+// 格式化日志
+void Logger::logFormat(LogLevel messageLevel, const char* format, ...) {
+    if (!shouldLog(messageLevel)) {
+        return;
+    }
+
+    // 先格式化到栈上，放不下时再按实际长度分配
+    char stackBuffer[STACK_MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+    int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+    va_end(args);
+
+    if (length < 0) {
+        va_end(retry);
+        return;
+    }
+    if (static_cast<size_t>(length) < sizeof(stackBuffer)) {
+        va_end(retry);
+        enqueue(messageLevel, stackBuffer, static_cast<size_t>(length));
+    } else {
+        std::string message(static_cast<size_t>(length) + 1, '\0');
+        vsnprintf(&message[0], message.size(), format, retry);
+        va_end(retry);
+        enqueue(messageLevel, message.data(), static_cast<size_t>(length));
+    }
+
+    if (messageLevel == LogLevel::FATAL) {
+        flush();
+    }
 }
 
-// 停止日志线程
-void Logger::stopLogThread() {
-    running = false;
-    logCV.notify_one();
-    
-    if (logThread != nullptr && logThread->joinable()) {
-        logThread->join();
-        delete logThread;
-        logThread = nullptr;
+// 等待此前提交的日志全部写出
+void Logger::flush() {
+    if (std::this_thread::get_id() == logThread.get_id()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    uint64_t ticket = ++flushRequested;
+    wakeCV.notify_one();
+    flushedCV.wait(lock, [this, ticket] { return flushCompleted >= ticket || !running.load(); });
+}
+
+// 清空日志文件（仅适用于文件日志）
+bool Logger::clearLogFile() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        truncateRequested = true;
+    }
+    flush();
+
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    return truncateSucceeded;
+}
+
+// 取出所有缓冲区中的日志
+bool Logger::drainBuffers(std::vector<LogRecord>& batch) {
+    std::vector<std::shared_ptr<LogBuffer>> current;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        // 移除线程已退出且已取空的缓冲区
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                     [](const std::shared_ptr<LogBuffer>& buffer) {
+                                         return buffer->closed.load(std::memory_order_acquire) && buffer->empty();
+                                     }),
+                      buffers.end());
+        current = buffers;
+    }
+
+    bool pending = false;
+    for (const auto& buffer : current) {
+        buffer->drain(batch);
+        pending = pending || !buffer->empty();
     }
+    return pending;
 }
 
-// 处理日志队列
+// 检查是否有缓冲区未取空
+bool Logger::hasPendingRecords() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return std::any_of(buffers.begin(), buffers.end(),
+                       [](const std::shared_ptr<LogBuffer>& buffer) { return !buffer->empty(); });
+}
+
+// 日志线程主循环
 void Logger::processLogQueue() {
-    while (running) {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        
-        // 等待直到队列非空或需要停止
-        logCV.wait(lock, [this] { return !logQueue.empty() || !running; });
-        
-        // 处理队列中的所有日志消息
-        while (!logQueue.empty()) {
-            LogMessage msg = logQueue.front();
-            logQueue.pop();
-            lock.unlock();
-            
-            // 输出日志
-            outputLog(msg);
-            
-            lock.lock();
-        }
-    }
-}
-
-// 输出日志
-void Logger::outputLog(const LogMessage& msg) {
-    // 获取当前配置（避免在日志输出过程中配置被修改）
-    LoggerConfig currentConfig = getConfig();
-    
-    // 格式化日志消息
-    std::string formattedMessage = formatLogMessage(msg, currentConfig);
-    
-    // 控制台输出
+    std::vector<LogRecord> batch;
+    LoggerConfig currentConfig;
+    uint64_t droppedReported = 0;
+    calibrateClock(true);
+    suppressionReported = std::chrono::steady_clock::now();
+
+    while (true) {
+        // 先记下已请求的刷新，取空缓冲区并写出后即可完成这些请求
+        uint64_t flushTicket = 0;
+        bool truncate = false;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            flushTicket = flushRequested;
+            truncate = truncateRequested;
+            truncateRequested = false;
+        }
+        bool stopping = !running.load();
+
+        // 每批只复制一次配置（先按旧配置写出缓冲的文件输出）
+        if (configChanged.exchange(false, std::memory_order_acq_rel)) {
+            flushFileOutput(currentConfig);
+            currentConfig = getConfig();
+            compileFormats(currentConfig);
+            updateFileStream(currentConfig);
+            updateRateLimit(currentConfig);
+        }
+        if (truncate) {
+            // 清空前缓冲的输出一并丢弃
+            fileOutput.clear();
+            bool opened = outputFile->open(currentConfig.logFile, true);
+            openedFile = opened ? currentConfig.logFile : std::string();
+            fileSize = 0;
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            truncateSucceeded = opened;
+        }
+
+        batch.clear();
+        bool pending = drainBuffers(batch);
+
+        uint64_t dropped = droppedCount.load(std::memory_order_relaxed);
+        if (dropped != droppedReported) {
+            LogRecord record;
+            record.ticks = logTicks();
+            record.timestamp = 0;
+            record.level = LogLevel::WARNING;
+            record.siteId = 0;
+            record.threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+            record.message = "Log buffer full, dropped " + std::to_string(dropped - droppedReported) + " messages";
+            batch.push_back(std::move(record));
+            droppedReported = dropped;
+        }
+
+        // 定期汇总各调用点被限速丢弃的日志数（停止前汇总剩余的部分）
+        if (stopping || std::chrono::steady_clock::now() - suppressionReported >=
+                            std::chrono::milliseconds(std::max(currentConfig.suppressionReportIntervalMs, 0))) {
+            reportSuppressed(batch, currentConfig);
+        }
+
+        // 定期校准时钟，修正刻度频率的误差和墙上时间的调整
+        if (std::chrono::steady_clock::now() - clockSteady >= CALIBRATION_INTERVAL) {
+            calibrateClock(false);
+            updateRateLimit(currentConfig);
+        }
+
+        if (!batch.empty()) {
+            writeBatch(batch, currentConfig);
+        }
+
+        // 文件输出攒满、停留超时、有刷新请求或停止时写出
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::milliseconds flushInterval(std::max(currentConfig.fileFlushIntervalMs, 0));
+        if (!fileOutput.empty() &&
+            (fileOutput.size() >= currentConfig.fileWriteBufferSize || now - fileOutputSince >= flushInterval ||
+             flushTicket > flushCompleted || stopping)) {
+            flushFileOutput(currentConfig);
+        }
+
+        if (flushTicket > flushCompleted || stopping) {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            flushCompleted = std::max(flushCompleted, flushTicket);
+            flushedCV.notify_all();
+        }
+
+        if (stopping && !pending && batch.empty()) {
+            break;
+        }
+        if (pending || !batch.empty()) {
+            continue;
+        }
+
+        // 没有日志时等待：先声明正在等待再持锁复查，业务线程看到等待标志后持锁唤醒；
+        // 业务线程不加内存屏障，极少数情况下错过唤醒，最多延迟IDLE_WAIT写出。
+        // 文件输出缓冲区非空时最多等到它的停留时间到期
+        std::chrono::steady_clock::duration wait = IDLE_WAIT;
+        if (!fileOutput.empty()) {
+            wait = std::min(wait, std::max(fileOutputSince + flushInterval - now,
+                                           std::chrono::steady_clock::duration::zero()));
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        writerWaiting.store(true);
+        if (flushRequested == flushTicket && !truncateRequested && running.load() &&
+            !configChanged.load(std::memory_order_acquire) && !hasPendingRecords()) {
+            wakeCV.wait_for(lock, wait);
+        }
+        writerWaiting.store(false);
+    }
+}
+
+// 格式化并写出一批日志
+void Logger::writeBatch(std::vector<LogRecord>& batch, const LoggerConfig& currentConfig) {
+    // 换算时间戳，并格式化延迟格式化日志的参数
+    std::string decoded;
+    for (auto& record : batch) {
+        record.timestamp = ticksToMs(record.ticks);
+        if (record.siteId != 0) {
+            decodeMessage(record.siteId, record.message, decoded);
+            record.message.swap(decoded);
+        }
+    }
+
+    // 各线程内部有序，线程之间按时间排序
+    std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) {
+        return static_cast<int64_t>(a.ticks - b.ticks) < 0;
+    });
+
     if (currentConfig.enableConsoleOutput) {
-        std::lock_guard<std::mutex> consoleLock(consoleMutex);
-        std::cout << formattedMessage << std::endl;
-    }
-    
-    // 文件输出
-    if (currentConfig.enableFileOutput && fileStream != nullptr) {
-        std::lock_guard<std::mutex> fileLock(fileMutex);
-        if (fileStream->is_open()) {
-            *fileStream << formattedMessage << std::endl;
-            fileStream->flush();
-        }
-    }
-}
-
-// 格式化日志消息
-std::string Logger::formatLogMessage(const LogMessage& msg, const LoggerConfig& config) {
-    std::string format = config.enableFileOutput ? config.fileLogFormat : config.consoleLogFormat;
-    std::string result = format;
-    
-    // 替换时间戳
-    size_t timePos = result.find("%TIME%");
-    if (timePos != std::string::npos) {
-        result.replace(timePos, 6, getFormattedTime(msg.timestamp, config.dateFormat));
-    }
-    
-    // 替换日志级别
-    size_t levelPos = result.find("%LEVEL%");
-    if (levelPos != std::string::npos) {
-        result.replace(levelPos, 6, getLogLevelString(msg.level));
-    }
-    
-    // 替换线程ID
-    size_t threadPos = result.find("%THREAD%");
-    if (threadPos != std::string::npos) {
-        result.replace(threadPos, 8, std::to_string(msg.threadId));
-    }
-    
-    // 替换消息内容
-    size_t messagePos = result.find("%MESSAGE%");
-    if (messagePos != std::string::npos) {
-        result.replace(messagePos, 9, msg.message);
-    }
-    
-    return result;
+        lineBuffer.clear();
+        for (const auto& record : batch) {
+            appendLogLine(record, *consoleFormat, lineBuffer);
+            lineBuffer.push_back('\n');
+        }
+        std::cout.write(lineBuffer.data(), static_cast<std::streamsize>(lineBuffer.size()));
+        std::cout.flush();
+    }
+
+    // 文件输出追加到缓冲区，由日志线程主循环按大小或时间写出
+    if (currentConfig.enableFileOutput && outputFile->isOpen()) {
+        if (fileOutput.empty()) {
+            fileOutputSince = std::chrono::steady_clock::now();
+        }
+        for (const auto& record : batch) {
+            appendLogLine(record, *fileFormat, fileOutput);
+            fileOutput.push_back('\n');
+        }
+    }
+}
+
+// 按配置打开或关闭日志文件
+void Logger::updateFileStream(const LoggerConfig& currentConfig) {
+    if (!currentConfig.enableFileOutput) {
+        outputFile->close();
+        openedFile.clear();
+        return;
+    }
+    if (outputFile->isOpen() && openedFile == currentConfig.logFile) {
+        return;
+    }
+
+    if (!outputFile->open(currentConfig.logFile, false)) {
+        std::cerr << "Failed to open log file: " << currentConfig.logFile << std::endl;
+        openedFile.clear();
+        return;
+    }
+    openedFile = currentConfig.logFile;
+    fileSize = outputFile->size();
+
+    // 已有文件超过最大大小时先轮转
+    if (currentConfig.maxLogFileSize > 0 && fileSize > currentConfig.maxLogFileSize) {
+        rotateLogFile(currentConfig);
+    }
+}
+
+// 写出文件输出缓冲区
+void Logger::flushFileOutput(const LoggerConfig& currentConfig) {
+    if (fileOutput.empty()) {
+        return;
+    }
+    if (outputFile->isOpen()) {
+        if (!outputFile->write(fileOutput.data(), fileOutput.size())) {
+            std::cerr << "Failed to write log file: " << openedFile << std::endl;
+        }
+        fileSize += fileOutput.size();
+    }
+
+    // 偶发的大批量日志之后释放多余的内存
+    if (fileOutput.capacity() > 4 * std::max(currentConfig.fileWriteBufferSize, COMPRESS_CHUNK_SIZE)) {
+        std::string().swap(fileOutput);
+    } else {
+        fileOutput.clear();
+    }
+
+    if (currentConfig.maxLogFileSize > 0 && fileSize > currentConfig.maxLogFileSize) {
+        rotateLogFile(currentConfig);
+    }
+}
+
+// 轮转日志文件
+void Logger::rotateLogFile(const LoggerConfig& currentConfig) {
+    // 日志线程只做一次重命名，临时文件名带上时间和序号，避免与上次运行遗留的文件冲突
+    outputFile->close();
+    std::string rotatedPath = currentConfig.logFile + ".rotating." + std::to_string(currentTimeNs() / 1000000) +
+                              "." + std::to_string(++rotationSequence);
+    std::error_code error;
+    std::filesystem::rename(currentConfig.logFile, rotatedPath, error);
+
+    if (!outputFile->open(currentConfig.logFile, false)) {
+        std::cerr << "Failed to open log file: " << currentConfig.logFile << std::endl;
+        openedFile.clear();
+    }
+    fileSize = outputFile->size();
+
+    if (!error) {
+        {
+            std::lock_guard<std::mutex> lock(rotationMutex);
+            rotationTasks.push_back({rotatedPath, currentConfig.logFile, currentConfig.maxBackupFiles,
+                                     currentConfig.compressRotatedFiles});
+        }
+        rotationCV.notify_one();
+    }
+}
+
+// 轮转线程主循环
+void Logger::processRotations() {
+    std::unique_lock<std::mutex> lock(rotationMutex);
+    while (true) {
+        rotationCV.wait(lock, [this] { return !rotationTasks.empty() || rotationStopping; });
+        if (rotationTasks.empty()) {
+            break;
+        }
+        RotationTask task = std::move(rotationTasks.front());
+        rotationTasks.pop_front();
+
+        lock.unlock();
+        finishRotation(task);
+        lock.lock();
+    }
+}
+
+// 调整备份文件编号并保存（或压缩）轮转出的文件
+void Logger::finishRotation(const RotationTask& task) {
+    std::error_code error;
+    if (task.maxBackupFiles <= 0) {
+        std::filesystem::remove(task.rotatedPath, error);
+        return;
+    }
+
+    bool compress = task.compress;
+#if !defined(LOGGER_HAS_ZLIB)
+    if (compress) {
+        LOG_WARNING("Log compression is not available, keeping rotated log uncompressed");
+        compress = false;
+    }
+#endif
+    std::string suffix = compress ? ".gz" : "";
+    auto backupName = [&task, &suffix](int index) {
+        return task.logFile + "." + std::to_string(index) + suffix;
+    };
+
+    // 删除最旧的备份文件，其余备份编号加一
+    std::filesystem::remove(backupName(task.maxBackupFiles), error);
+    for (int i = task.maxBackupFiles - 1; i >= 1; --i) {
+        if (std::filesystem::exists(backupName(i), error)) {
+            std::filesystem::rename(backupName(i), backupName(i + 1), error);
+        }
+    }
+
+    // 将轮转出的文件保存为.1（压缩失败时保留未压缩的文件）
+    if (compress && compressFile(task.rotatedPath, backupName(1))) {
+        std::filesystem::remove(task.rotatedPath, error);
+        return;
+    }
+    if (compress) {
+        LOG_WARNING("Failed to compress rotated log %s", task.rotatedPath.c_str());
+    }
+    std::filesystem::rename(task.rotatedPath, task.logFile + ".1", error);
+    if (error) {
+        LOG_WARNING("Failed to rename rotated log %s: %s", task.rotatedPath.c_str(), error.message().c_str());
+    }
+}
+
+// 按配置预编译日志格式和时间格式
+void Logger::compileFormats(const LoggerConfig& currentConfig) {
+    if (!consoleFormat) {
+        consoleFormat.reset(new LogLineFormat());
+        fileFormat.reset(new LogLineFormat());
+        timeFormat.reset(new LogTimeFormat());
+    }
+    compileLineFormat(currentConfig.consoleLogFormat, *consoleFormat);
+    compileLineFormat(currentConfig.fileLogFormat, *fileFormat);
+    compileTimeFormat(currentConfig.dateFormat, *timeFormat);
 }
 
-// 获取格式化的时间
-std::string Logger::getFormattedTime(long long timestampMs, const std::string& format) {
-    // 将毫秒时间戳转换为time_t
-    std::time_t timestamp = timestampMs / 1000;
-    int milliseconds = timestampMs % 1000;
-    
-    // 格式化时间
-    std::tm localTime;
+// 按预编译的格式将一条日志追加到out
+void Logger::appendLogLine(const LogRecord& record, const LogLineFormat& format, std::string& out) {
+    for (const auto& op : format.ops) {
+        switch (op.field) {
+            case LogLineFormat::Field::TEXT: out += op.text; break;
+            case LogLineFormat::Field::TIME: appendTime(record.timestamp, out); break;
+            case LogLineFormat::Field::LEVEL: out += levelName(record.level); break;
+            case LogLineFormat::Field::THREAD: appendNumber(out, record.threadId); break;
+            case LogLineFormat::Field::MESSAGE: out += record.message; break;
+        }
+    }
+}
+
+// 按预编译的时间格式将时间戳追加到out
+void Logger::appendTime(long long timestampMs, std::string& out) {
+    LogTimeFormat& format = *timeFormat;
+    long long second = timestampMs / 1000;
+    int millisecond = static_cast<int>(timestampMs % 1000);
+    if (millisecond < 0) {
+        --second;
+        millisecond += 1000;
+    }
+
+    // 进入新的一秒时才重新渲染日期和时间
+    if (second != format.cachedSecond) {
+        std::time_t timestamp = static_cast<std::time_t>(second);
+        std::tm localTime;
 #ifdef _WIN32
-    localtime_s(&localTime, &timestamp);
+        localtime_s(&localTime, &timestamp);
 #else
-    localtime_r(&timestamp, &localTime);
+        localtime_r(&timestamp, &localTime);
 #endif
-    
-    std::stringstream ss;
-    
-    // 处理格式化字符串
-    for (size_t i = 0; i < format.size(); ++i) {
-        if (format[i] == '%' && i + 1 < format.size()) {
-            i++;
-            switch (format[i]) {
-                case 'Y': ss << std::setw(4) << std::setfill('0') << (localTime.tm_year + 1900); break;
-                case 'm': ss << std::setw(2) << std::setfill('0') << (localTime.tm_mon + 1); break;
-                case 'd': ss << std::setw(2) << std::setfill('0') << localTime.tm_mday; break;
-                case 'H': ss << std::setw(2) << std::setfill('0') << localTime.tm_hour; break;
-                case 'M': ss << std::setw(2) << std::setfill('0') << localTime.tm_min; break;
-                case 'S': ss << std::setw(2) << std::setfill('0') << localTime.tm_sec; break;
-                case 'f': case 'MS': ss << std::setw(3) << std::setfill('0') << milliseconds; break;
-                default: ss << format[i]; break;
+
+        format.cachedText.clear();
+        format.millisecondOffsets.clear();
+        for (const auto& op : format.ops) {
+            switch (op.field) {
+                case LogTimeFormat::Field::TEXT: format.cachedText += op.text; break;
+                case LogTimeFormat::Field::YEAR: appendNumber(format.cachedText, localTime.tm_year + 1900, 4); break;
+                case LogTimeFormat::Field::MONTH: appendNumber(format.cachedText, localTime.tm_mon + 1, 2); break;
+                case LogTimeFormat::Field::DAY: appendNumber(format.cachedText, localTime.tm_mday, 2); break;
+                case LogTimeFormat::Field::HOUR: appendNumber(format.cachedText, localTime.tm_hour, 2); break;
+                case LogTimeFormat::Field::MINUTE: appendNumber(format.cachedText, localTime.tm_min, 2); break;
+                case LogTimeFormat::Field::SECOND: appendNumber(format.cachedText, localTime.tm_sec, 2); break;
+                case LogTimeFormat::Field::MILLISECOND:
+                    format.millisecondOffsets.push_back(format.cachedText.size());
+                    format.cachedText += "000";
+                    break;
             }
-        } else {
-            ss << format[i];
         }
+        format.cachedSecond = second;
+    }
+
+    // 复制缓存的时间，只填入毫秒
+    size_t base = out.size();
+    out += format.cachedText;
+    for (size_t offset : format.millisecondOffsets) {
+        out[base + offset] = static_cast<char>('0' + millisecond / 100);
+        out[base + offset + 1] = static_cast<char>('0' + millisecond / 10 % 10);
+        out[base + offset + 2] = static_cast<char>('0' + millisecond % 10);
     }
-    
-    return ss.str();
 }
 
 // 获取日志级别字符串
-std::string Logger::getLogLevelString(LogLevel level) {
-    switch (level) {
-        case LogLevel::DEBUG: return "DEBUG";
-        case LogLevel::INFO: return "INFO";
-        case LogLevel::WARNING: return "WARNING";
-        case LogLevel::ERROR: return "ERROR";
-        case LogLevel::FATAL: return "FATAL";
-        default: return "UNKNOWN";
-    }
+std::string Logger::getLogLevelString(LogLevel logLevel) {
+    return levelName(logLevel);
 }
 
 // 从字符串获取日志级别
@@ -292,59 +1502,15 @@ LogLevel Logger::getLogLevelFromString(const std::string& levelStr) {
     std::string upperStr = levelStr;
     // 转换为大写
     for (char& c : upperStr) {
-        c = std::toupper(c);
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
     }
-    
+
     if (upperStr == "DEBUG") return LogLevel::DEBUG;
     if (upperStr == "INFO") return LogLevel::INFO;
     if (upperStr == "WARNING" || upperStr == "WARN") return LogLevel::WARNING;
     if (upperStr == "ERROR") return LogLevel::ERROR;
     if (upperStr == "FATAL" || upperStr == "CRITICAL") return LogLevel::FATAL;
-    
+
     // 默认返回INFO级别
     return LogLevel::INFO;
 }
-
-// 检查日志级别是否需要输出
-bool Logger::shouldLog(LogLevel level) const {
-    std::lock_guard<std::mutex> lock(configMutex);
-    return level >= config.logLevel;
-}
-
-// 刷新日志
-void Logger::flush() {
-    std::lock_guard<std::mutex> fileLock(fileMutex);
-    if (fileStream != nullptr && fileStream->is_open()) {
-        fileStream->flush();
-    }
-}
-
-// 清空日志文件（仅适用于文件日志）
-bool Logger::clearLogFile() {
-    std::lock_guard<std::mutex> fileLock(fileMutex);
-    
-    try {
-        // 关闭当前文件流
-        if (fileStream != nullptr && fileStream->is_open()) {
-            fileStream->close();
-        }
-        
-        // 重新创建文件（覆盖模式）
-        fileStream = new std::ofstream(config.logFile, std::ios::out | std::ios::trunc);
-        
-        if (!fileStream->is_open()) {
-            delete fileStream;
-            fileStream = nullptr;
-            return false;
-        }
-        
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Exception when clearing log file: " << e.what() << std::endl;
-        if (fileStream != nullptr) {
-            delete fileStream;
-            fileStream = nullptr;
-        }
-        return false;
-    }
-}
\ No newline at end of file
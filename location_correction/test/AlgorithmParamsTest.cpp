@@ -0,0 +1,48 @@
+#include "AlgorithmParams.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// 测试默认值与参数表一致，转换为映射后能原样解析回来
+TEST(AlgorithmParamsTest, DefaultsAndRoundTrip) {
+    AlgorithmParams params;
+    EXPECT_DOUBLE_EQ(params.smoothingFactor, 0.7);
+    EXPECT_DOUBLE_EQ(params.confidenceThreshold, 0.6);
+    EXPECT_FALSE(params.stopOnInvalid);
+
+    std::string error;
+    ASSERT_TRUE(params.set("smoothingFactor", "0.25", error));
+    ASSERT_TRUE(params.set("stopOnInvalid", "true", error));
+
+    std::vector<std::string> errors;
+    AlgorithmParams restored = AlgorithmParams::resolve(params.toMap(), errors);
+    EXPECT_TRUE(errors.empty());
+    EXPECT_DOUBLE_EQ(restored.smoothingFactor, 0.25);
+    EXPECT_DOUBLE_EQ(restored.confidenceThreshold, 0.6);
+    EXPECT_TRUE(restored.stopOnInvalid);
+
+    EXPECT_TRUE(restored.reset("smoothingFactor"));
+    EXPECT_DOUBLE_EQ(restored.smoothingFactor, 0.7);
+    EXPECT_FALSE(restored.reset("noSuchParam"));
+}
+
+// 测试未声明的参数和无效的值在解析时报告，对应字段保留默认值
+TEST(AlgorithmParamsTest, ReportsUnknownAndInvalid) {
+    std::map<std::string, std::string> raw = {{"smoothingFactor", "1.5"},
+                                              {"confidenceThreshold", "0.8x"},
+                                              {"stopOnInvalid", "yes"},
+                                              {"smoothingFacter", "0.5"}};
+    std::vector<std::string> errors;
+    AlgorithmParams params = AlgorithmParams::resolve(raw, errors);
+
+    // 按参数名顺序报告
+    ASSERT_EQ(errors.size(), 4u);
+    EXPECT_NE(errors[0].find("confidenceThreshold"), std::string::npos);
+    EXPECT_NE(errors[1].find("unknown parameter 'smoothingFacter'"), std::string::npos);
+    EXPECT_NE(errors[2].find("out of range"), std::string::npos);
+    EXPECT_NE(errors[3].find("stopOnInvalid"), std::string::npos);
+    EXPECT_DOUBLE_EQ(params.smoothingFactor, 0.7);
+    EXPECT_DOUBLE_EQ(params.confidenceThreshold, 0.6);
+    EXPECT_FALSE(params.stopOnInvalid);
+}
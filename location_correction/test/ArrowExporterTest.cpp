@@ -0,0 +1,299 @@
+#include "ArrowExporter.h"
+#include "SegmentFile.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+// 读取整个文件
+std::vector<char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// 从缓冲区读取小端标量
+template <typename T>
+T readScalar(const char* data, size_t position) {
+    T value;
+    std::memcpy(&value, data + position, sizeof(T));
+    return value;
+}
+
+// 最小的FlatBuffers表读取器（只支持测试用到的字段类型）
+struct FlatTable {
+    const char* data;  // 缓冲区起始位置
+    size_t position;   // 表在缓冲区中的位置
+
+    // 读取根表
+    static FlatTable root(const char* buffer) {
+        return FlatTable{buffer, readScalar<uint32_t>(buffer, 0)};
+    }
+
+    // 字段在表中的偏移（字段不存在时为0）
+    uint16_t fieldOffset(uint16_t id) const {
+        size_t vtable = position - readScalar<int32_t>(data, position);
+        uint16_t vtableSize = readScalar<uint16_t>(data, vtable);
+        if (4u + 2u * id >= vtableSize) {
+            return 0;
+        }
+        return readScalar<uint16_t>(data, vtable + 4 + 2 * id);
+    }
+
+    template <typename T>
+    T scalar(uint16_t id, T defaultValue = 0) const {
+        uint16_t offset = fieldOffset(id);
+        return offset ? readScalar<T>(data, position + offset) : defaultValue;
+    }
+
+    // 偏移量字段指向的位置
+    size_t target(uint16_t id) const {
+        size_t field = position + fieldOffset(id);
+        return field + readScalar<uint32_t>(data, field);
+    }
+
+    FlatTable table(uint16_t id) const {
+        return FlatTable{data, target(id)};
+    }
+
+    std::string string(uint16_t id) const {
+        size_t start = target(id);
+        return std::string(data + start + 4, readScalar<uint32_t>(data, start));
+    }
+
+    // 数组：返回元素个数，first为第一个元素的位置
+    uint32_t vector(uint16_t id, size_t& first) const {
+        size_t start = target(id);
+        first = start + 4;
+        return readScalar<uint32_t>(data, start);
+    }
+
+    // 表数组的第index个元素
+    FlatTable element(uint16_t id, size_t index) const {
+        size_t first = 0;
+        vector(id, first);
+        size_t slot = first + 4 * index;
+        return FlatTable{data, slot + readScalar<uint32_t>(data, slot)};
+    }
+};
+
+// 从Arrow文件读回的一行
+struct ArrowRow {
+    long long timestamp;
+    std::string deviceId;
+    double latitude;
+    double accuracy;
+    uint8_t sourceType;
+    uint8_t status;
+};
+
+// 按文件尾的Block索引读取所有记录批次
+std::vector<ArrowRow> readArrowRows(const std::vector<char>& file) {
+    std::vector<ArrowRow> rows;
+    int32_t footerLength = readScalar<int32_t>(file.data(), file.size() - 10);
+    FlatTable footer = FlatTable::root(file.data() + file.size() - 10 - footerLength);
+
+    size_t first = 0;
+    uint32_t blockCount = footer.vector(3, first);
+    for (uint32_t b = 0; b < blockCount; ++b) {
+        size_t block = first + 24 * b;
+        int64_t offset = readScalar<int64_t>(footer.data, block);
+        int32_t metadataLength = readScalar<int32_t>(footer.data, block + 8);
+        EXPECT_EQ(readScalar<uint32_t>(file.data(), offset), 0xFFFFFFFFu);
+
+        FlatTable message = FlatTable::root(file.data() + offset + 8);
+        EXPECT_EQ(message.scalar<uint8_t>(1), 3); // RecordBatch
+        FlatTable batch = message.table(2);
+        int64_t length = batch.scalar<int64_t>(0);
+        size_t buffersFirst = 0;
+        uint32_t bufferCount = batch.vector(2, buffersFirst);
+        EXPECT_EQ(bufferCount, 21u); // 每列一个有效性缓冲区和数据缓冲区，字符串列多一个偏移量缓冲区
+
+        const char* body = file.data() + offset + metadataLength;
+        auto buffer = [&](size_t index) {
+            return body + readScalar<int64_t>(batch.data, buffersFirst + 16 * index);
+        };
+        for (int64_t i = 0; i < length; ++i) {
+            ArrowRow row;
+            row.timestamp = readScalar<int64_t>(buffer(1), 8 * i);
+            int32_t begin = readScalar<int32_t>(buffer(3), 4 * i);
+            int32_t end = readScalar<int32_t>(buffer(3), 4 * (i + 1));
+            row.deviceId.assign(buffer(4) + begin, end - begin);
+            row.latitude = readScalar<double>(buffer(6), 8 * i);
+            row.accuracy = readScalar<double>(buffer(12), 8 * i);
+            row.sourceType = readScalar<uint8_t>(buffer(18), i);
+            row.status = readScalar<uint8_t>(buffer(20), i);
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+} // namespace
+
+// 测试导出文件的结构：文件头尾魔数、Footer长度和记录批次
+TEST(ArrowExporterTest, FileLayoutTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_arrow_test").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::string> files;
+    for (int segment = 0; segment < 4; ++segment) {
+        std::string path = directory + "/locations_" + std::to_string(segment) + SEGMENT_FILE_EXTENSION;
+        SegmentWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        LocationColumns columns;
+        for (int i = 0; i < 1000; ++i) {
+            LocationInfo location;
+            location.timestamp = segment * 1000 + i;
+            location.latitude = 31.0 + i * 1e-5;
+            location.setExtra(DEVICE_ID_EXTRA_KEY, i % 2 ? "device-a" : "device-b");
+            columns.append(location);
+        }
+        ASSERT_TRUE(writer.appendBlock(columns));
+        ASSERT_TRUE(writer.finish());
+        files.push_back(path);
+    }
+
+    QueryPredicate predicate;
+    predicate.startTime = 500;
+    predicate.endTime = 2499;
+    predicate.deviceId = "device-a";
+
+    ArrowExporter exporter(2);
+    exporter.setBatchRowCount(300);
+    ArrowExportStats stats;
+    std::string output = directory + "/export" + ARROW_FILE_EXTENSION;
+    ASSERT_TRUE(exporter.exportFiles(files, predicate, output, &stats));
+
+    EXPECT_EQ(stats.rowsExported, 1000u);
+    EXPECT_EQ(stats.sourcesPruned, 1u);
+    EXPECT_EQ(stats.recordBatches, 4u); // 各段分别为250、300 + 200、250行
+
+    std::vector<char> data = readFile(output);
+    ASSERT_EQ(data.size(), stats.bytesWritten);
+    ASSERT_GT(data.size(), 16u);
+    EXPECT_EQ(std::memcmp(data.data(), "ARROW1\0\0", 8), 0);
+    EXPECT_EQ(std::memcmp(data.data() + data.size() - 6, "ARROW1", 6), 0);
+
+    int32_t footerLength = 0;
+    std::memcpy(&footerLength, data.data() + data.size() - 10, sizeof(footerLength));
+    ASSERT_GT(footerLength, 0);
+    ASSERT_LT(static_cast<size_t>(footerLength), data.size());
+
+    // Footer之前是流结束标记
+    const char* eos = data.data() + data.size() - 10 - footerLength - 8;
+    uint32_t marker = 0;
+    int32_t length = -1;
+    std::memcpy(&marker, eos, sizeof(marker));
+    std::memcpy(&length, eos + 4, sizeof(length));
+    EXPECT_EQ(marker, 0xFFFFFFFFu);
+    EXPECT_EQ(length, 0);
+
+    EXPECT_FALSE(std::filesystem::exists(output + ".tmp"));
+    std::filesystem::remove_all(directory);
+}
+
+// 测试导出文件能按Schema读回与原始数据一致的行
+TEST(ArrowExporterTest, RoundTripTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_arrow_roundtrip").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::vector<LocationInfo> expected;
+    std::vector<std::string> files;
+    for (int segment = 0; segment < 3; ++segment) {
+        std::string path = directory + "/locations_" + std::to_string(segment) + SEGMENT_FILE_EXTENSION;
+        SegmentWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        LocationColumns columns;
+        for (int i = 0; i < 100; ++i) {
+            LocationInfo location;
+            location.timestamp = 1620000000000LL + segment * 100000 + i * 1000;
+            location.latitude = 31.0 + i * 1e-4;
+            location.accuracy = 3.5 + i % 4;
+            location.sourceType = i % 2 ? DataSourceType::WIFI : DataSourceType::BASE_STATION;
+            location.status = LocationStatus::VALID;
+            location.setExtra(DEVICE_ID_EXTRA_KEY, "device-" + std::to_string(i % 3));
+            columns.append(location);
+            expected.push_back(location);
+        }
+        ASSERT_TRUE(writer.appendBlock(columns));
+        ASSERT_TRUE(writer.finish());
+        files.push_back(path);
+    }
+    // 乱序传入，导出时按段的时间排序
+    std::swap(files[0], files[2]);
+
+    ArrowExporter exporter(2);
+    exporter.setBatchRowCount(64);
+    std::string output = directory + "/export" + ARROW_FILE_EXTENSION;
+    ASSERT_TRUE(exporter.exportFiles(files, QueryPredicate(), output));
+    std::vector<char> data = readFile(output);
+
+    // Schema消息紧跟在8字节文件头之后
+    FlatTable message = FlatTable::root(data.data() + 16);
+    EXPECT_EQ(message.scalar<uint8_t>(1), 1); // Schema
+    FlatTable schema = message.table(2);
+    size_t first = 0;
+    ASSERT_EQ(schema.vector(1, first), 10u);
+    const char* names[] = {"timestamp", "device_id", "latitude", "longitude", "altitude",
+                           "accuracy", "speed", "direction", "source_type", "status"};
+    const uint8_t types[] = {10, 5, 3, 3, 3, 3, 3, 3, 2, 2}; // Timestamp、Utf8、FloatingPoint、Int
+    for (size_t i = 0; i < 10; ++i) {
+        FlatTable field = schema.element(1, i);
+        EXPECT_EQ(field.string(0), names[i]);
+        EXPECT_EQ(field.scalar<uint8_t>(2), types[i]);
+    }
+    FlatTable timestampType = schema.element(1, 0).table(3);
+    EXPECT_EQ(timestampType.scalar<int16_t>(0), 1); // MILLISECOND
+    EXPECT_EQ(timestampType.string(1), "UTC");
+    FlatTable statusType = schema.element(1, 9).table(3);
+    EXPECT_EQ(statusType.scalar<int32_t>(0), 8);
+    EXPECT_EQ(statusType.scalar<uint8_t>(1), 0);
+
+    std::vector<ArrowRow> rows = readArrowRows(data);
+    ASSERT_EQ(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        EXPECT_EQ(rows[i].timestamp, expected[i].timestamp);
+        EXPECT_EQ(rows[i].deviceId, getDeviceIdOf(expected[i]));
+        EXPECT_NEAR(rows[i].latitude, expected[i].latitude, 1e-7);
+        EXPECT_NEAR(rows[i].accuracy, expected[i].accuracy, 0.01);
+        EXPECT_EQ(rows[i].sourceType, static_cast<uint8_t>(expected[i].sourceType));
+        EXPECT_EQ(rows[i].status, static_cast<uint8_t>(expected[i].status));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// 测试无法读取的来源使导出失败且不生成目标文件
+TEST(ArrowExporterTest, UnreadableSourceTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_arrow_failure").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::string segment = directory + "/locations_0" + SEGMENT_FILE_EXTENSION;
+    SegmentWriter writer;
+    ASSERT_TRUE(writer.open(segment));
+    LocationColumns columns;
+    LocationInfo location;
+    location.timestamp = 1000;
+    columns.append(location);
+    ASSERT_TRUE(writer.appendBlock(columns));
+    ASSERT_TRUE(writer.finish());
+
+    std::string logFile = directory + "/locations_1.log";
+    std::ofstream(logFile) << "1000,31.0,121.0\n";
+
+    ArrowExporter exporter(2);
+    std::string output = directory + "/export" + ARROW_FILE_EXTENSION;
+    EXPECT_FALSE(exporter.exportFiles({segment, directory + "/missing" + SEGMENT_FILE_EXTENSION},
+                                      QueryPredicate(), output));
+    EXPECT_FALSE(exporter.exportFiles({segment, logFile}, QueryPredicate(), output));
+    EXPECT_FALSE(std::filesystem::exists(output));
+    EXPECT_FALSE(std::filesystem::exists(output + ".tmp"));
+
+    EXPECT_TRUE(exporter.exportFiles({segment}, QueryPredicate(), output));
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,153 @@
+#include "BulkLoader.h"
+#include "SegmentFile.h"
+#include "StorageQuery.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+// 创建空的存储目录
+std::string makeStorageDirectory() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "location_bulk_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
+
+// 获取目录下的段文件
+std::vector<std::string> listSegments(const std::string& directory) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == SEGMENT_FILE_EXTENSION) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// 生成乱序的位置数据：4个设备，时间戳逆序
+std::vector<LocationInfo> makeLocations(int count) {
+    std::vector<LocationInfo> locations;
+    for (int i = count - 1; i >= 0; --i) {
+        LocationInfo location;
+        location.timestamp = 1000000 + i * 10LL;
+        location.latitude = 30.0 + i * 1e-5;
+        location.longitude = 120.0;
+        location.accuracy = i % 7 == 0 ? 500.0 : 5.0;
+        location.setExtra(DEVICE_ID_EXTRA_KEY, "device-" + std::to_string(i % 4));
+        locations.push_back(location);
+    }
+    return locations;
+}
+
+} // namespace
+
+// 测试批量导入：按设备校正、按时间排序写入多个段文件，完成前对查询不可见
+TEST(BulkLoaderTest, LoadTest) {
+    std::string directory = makeStorageDirectory();
+
+    BulkLoadOptions options;
+    options.threadCount = 4;
+    options.blockRowCount = 100;
+    options.segmentRowCount = 500;
+    options.runRowCount = 2000;
+    options.correction = [](const std::string& deviceId, std::vector<LocationInfo>& track) {
+        ASSERT_FALSE(deviceId.empty());
+        for (size_t i = 1; i < track.size(); ++i) {
+            ASSERT_LE(track[i - 1].timestamp, track[i].timestamp);
+        }
+        // 去掉精度差的定位点
+        track.erase(std::remove_if(track.begin(), track.end(),
+                                   [](const LocationInfo& location) { return location.accuracy > 100.0; }),
+                    track.end());
+    };
+
+    BulkLoader loader(directory, options);
+    std::vector<LocationInfo> locations = makeLocations(5000);
+    ASSERT_TRUE(loader.add(std::vector<LocationInfo>(locations.begin(), locations.begin() + 2500)));
+    LocationColumns columns;
+    for (size_t i = 2500; i < locations.size(); ++i) {
+        columns.append(locations[i]);
+    }
+    ASSERT_TRUE(loader.add(columns));
+    EXPECT_TRUE(listSegments(directory).empty()); // 发布前不可见
+
+    BulkLoadStats stats;
+    ASSERT_TRUE(loader.finish(&stats));
+    EXPECT_EQ(stats.rowsAdded, 5000u);
+    EXPECT_EQ(stats.rowsWritten, 5000u - 715u);
+    EXPECT_EQ(stats.devicesCorrected, 12u); // 3批 x 4个设备
+
+    std::vector<std::string> files = listSegments(directory);
+    EXPECT_EQ(files.size(), stats.segmentsWritten);
+    for (const auto& file : files) {
+        EXPECT_NE(file.find("_bulk"), std::string::npos);
+        SegmentReader reader;
+        ASSERT_TRUE(reader.open(file));
+        EXPECT_TRUE(reader.isComplete());
+        const auto& blocks = reader.getBlocks();
+        for (size_t i = 1; i < blocks.size(); ++i) {
+            EXPECT_LE(blocks[i - 1].maxTimestamp, blocks[i].minTimestamp);
+        }
+    }
+
+    QueryExecutor executor(2);
+    QueryPredicate predicate;
+    predicate.deviceId = "device-1";
+    std::vector<LocationInfo> result = executor.execute(files, predicate);
+    ASSERT_FALSE(result.empty());
+    for (size_t i = 1; i < result.size(); ++i) {
+        EXPECT_LT(result[i - 1].timestamp, result[i].timestamp);
+        EXPECT_LE(result[i].accuracy, 100.0);
+    }
+}
+
+// 测试放弃导入时删除已写入的临时文件
+TEST(BulkLoaderTest, AbortTest) {
+    std::string directory = makeStorageDirectory();
+
+    BulkLoadOptions options;
+    options.blockRowCount = 100;
+    options.segmentRowCount = 100;
+    options.runRowCount = 100;
+    {
+        BulkLoader loader(directory, options);
+        ASSERT_TRUE(loader.add(makeLocations(1000)));
+        EXPECT_FALSE(std::filesystem::is_empty(directory));
+    }
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+
+    // 校正函数抛出异常时导入失败
+    options.correction = [](const std::string&, std::vector<LocationInfo>&) {
+        throw std::runtime_error("bad track");
+    };
+    BulkLoader loader(directory, options);
+    EXPECT_FALSE(loader.add(makeLocations(1000)));
+    EXPECT_FALSE(loader.finish());
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+}
+
+// 测试发布中途失败时撤销已发布的段文件，不留下部分导入的数据
+TEST(BulkLoaderTest, PublishRollbackTest) {
+    std::string directory = makeStorageDirectory();
+
+    BulkLoadOptions options;
+    options.blockRowCount = 100;
+    options.segmentRowCount = 100;
+    options.runRowCount = 1000;
+    BulkLoader loader(directory, options);
+    ASSERT_TRUE(loader.add(makeLocations(1000)));
+
+    // 最后一个段文件的正式路径被非空目录占用，重命名失败
+    std::filesystem::path blocker = std::filesystem::path(directory) /
+                                    ("locations_1009000_bulk" + std::string(SEGMENT_FILE_EXTENSION));
+    ASSERT_TRUE(std::filesystem::exists(blocker.string() + ".tmp"));
+    std::filesystem::create_directories(blocker / "occupied");
+
+    EXPECT_FALSE(loader.finish());
+    std::filesystem::remove_all(blocker);
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+}
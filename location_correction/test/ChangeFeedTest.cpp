@@ -0,0 +1,155 @@
+#include "ChangeFeed.h"
+#include "WriteAheadLog.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace {
+
+// 生成指定数量的位置数据
+LocationColumns makeRows(size_t count, long long startTime) {
+    LocationColumns rows;
+    for (size_t i = 0; i < count; ++i) {
+        LocationInfo location;
+        location.timestamp = startTime + static_cast<long long>(i);
+        location.latitude = 39.9042;
+        location.longitude = 116.4074;
+        location.setExtra(DEVICE_ID_EXTRA_KEY, "device-a");
+        rows.append(location);
+    }
+    return rows;
+}
+
+// 创建空的日志目录
+std::string makeWalDirectory() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "location_change_feed_test";
+    std::filesystem::remove_all(directory);
+    return directory.string();
+}
+
+// 写入一批数据并发布
+uint64_t appendAndPublish(WriteAheadLog& wal, ChangeFeed& feed, long long startTime) {
+    uint64_t endLsn = wal.append(makeRows(10, startTime));
+    feed.publish(endLsn);
+    return endLsn;
+}
+
+} // namespace
+
+// 测试按顺序读取跨多个日志文件的变更，并从保存的偏移继续订阅
+TEST(ChangeFeedTest, ReadAndResumeTest) {
+    WriteAheadLog wal;
+    wal.setMaxFileSize(512); // 每个文件只容纳几条记录
+    ASSERT_TRUE(wal.open(makeWalDirectory()));
+    auto feed = std::make_shared<ChangeFeed>(wal.getDirectory(), wal.getEndLsn());
+
+    for (int i = 0; i < 20; ++i) {
+        appendAndPublish(wal, *feed, i * 100);
+    }
+    ASSERT_GT(WriteAheadLog::listFiles(wal.getDirectory()).size(), 2u);
+
+    auto subscription = feed->subscribeFromStart();
+    ASSERT_NE(subscription, nullptr);
+    ChangeBatch batch;
+    uint64_t resumeOffset = 0;
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(subscription->next(batch));
+        ASSERT_EQ(batch.rows.size(), 10u);
+        EXPECT_EQ(batch.rows.timestamps[0], i * 100);
+        EXPECT_EQ(getDeviceIdOf(batch.rows.toLocationInfo(0)), "device-a");
+        if (i == 11) {
+            resumeOffset = batch.nextOffset;
+        }
+    }
+    EXPECT_FALSE(subscription->next(batch));
+    EXPECT_TRUE(subscription->isValid());
+    EXPECT_EQ(subscription->getPosition(), feed->getEndOffset());
+
+    // 从保存的偏移继续订阅
+    auto resumed = feed->subscribe(resumeOffset);
+    ASSERT_NE(resumed, nullptr);
+    ASSERT_TRUE(resumed->next(batch));
+    EXPECT_EQ(batch.offset, resumeOffset);
+    EXPECT_EQ(batch.rows.timestamps[0], 1200);
+    EXPECT_EQ(feed->getSubscriptionCount(), 2u);
+    EXPECT_EQ(feed->subscribe(feed->getEndOffset() + 1), nullptr);
+}
+
+// 测试阻塞读取在新数据写入或订阅源关闭时被唤醒
+TEST(ChangeFeedTest, TailWakeupTest) {
+    WriteAheadLog wal;
+    ASSERT_TRUE(wal.open(makeWalDirectory()));
+    auto feed = std::make_shared<ChangeFeed>(wal.getDirectory(), wal.getEndLsn());
+    auto subscription = feed->subscribeFromEnd();
+    ASSERT_NE(subscription, nullptr);
+
+    ChangeBatch batch;
+    EXPECT_FALSE(subscription->next(batch, 10));
+
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        appendAndPublish(wal, *feed, 5000);
+    });
+    EXPECT_TRUE(subscription->next(batch, -1));
+    EXPECT_EQ(batch.rows.timestamps[0], 5000);
+    writer.join();
+
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        feed->close();
+    });
+    EXPECT_FALSE(subscription->next(batch, -1));
+    closer.join();
+    EXPECT_EQ(feed->subscribeFromEnd(), nullptr);
+}
+
+// 测试日志清理保留订阅者未读取的部分，清空后偏移不回退
+TEST(ChangeFeedTest, RetentionTest) {
+    WriteAheadLog wal;
+    wal.setMaxFileSize(512);
+    ASSERT_TRUE(wal.open(makeWalDirectory()));
+    auto feed = std::make_shared<ChangeFeed>(wal.getDirectory(), wal.getEndLsn());
+
+    for (int i = 0; i < 10; ++i) {
+        appendAndPublish(wal, *feed, i * 100);
+    }
+    auto subscription = feed->subscribeFromStart();
+    ASSERT_NE(subscription, nullptr);
+    ChangeBatch batch;
+    ASSERT_TRUE(subscription->next(batch));
+
+    // 检查点已到末尾，但订阅者还没有读完
+    feed->truncateLog(wal, wal.getEndLsn());
+    EXPECT_LE(feed->getStartOffset(), subscription->getPosition());
+    int remaining = 0;
+    while (subscription->next(batch)) {
+        ++remaining;
+    }
+    EXPECT_EQ(remaining, 9);
+
+    // 订阅者读完后可以清理
+    uint64_t endOffset = feed->getEndOffset();
+    subscription.reset();
+    feed->truncateLog(wal, endOffset);
+    EXPECT_EQ(feed->subscribe(0), nullptr);
+
+    // 清空日志后从原来的末尾继续编号
+    ASSERT_TRUE(wal.reset());
+    EXPECT_EQ(wal.getEndLsn(), endOffset);
+    auto tail = feed->subscribeFromEnd();
+    ASSERT_NE(tail, nullptr);
+    appendAndPublish(wal, *feed, 9000);
+    ASSERT_TRUE(tail->next(batch));
+    EXPECT_EQ(batch.offset, endOffset);
+    EXPECT_EQ(batch.rows.timestamps[0], 9000);
+
+    // 重新打开后重放不会因检查点之前的日志已删除而中断
+    wal.close();
+    WalCheckpoint checkpoint;
+    ASSERT_TRUE(wal.open(wal.getDirectory(), &checkpoint));
+    EXPECT_EQ(checkpoint.lsn, endOffset);
+    size_t replayed = 0;
+    EXPECT_TRUE(wal.replay(checkpoint.lsn, [&](uint64_t, const LocationColumns& rows) { replayed += rows.size(); }));
+    EXPECT_EQ(replayed, 10u);
+}
@@ -0,0 +1,100 @@
+#include "ConfigStore.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 测试用配置（threshold与name的长度保持一致，用于检查读到的快照是否完整）
+struct TestConfig {
+    int threshold = 0;
+    std::string name;
+};
+
+TestConfig makeConfig(int threshold) {
+    TestConfig config;
+    config.threshold = threshold;
+    config.name = std::string(static_cast<size_t>(threshold % 64), 'x');
+    return config;
+}
+
+} // namespace
+
+// 测试发布新版本，持有旧快照的读取方不受影响，读取方退出后旧快照被回收
+TEST(ConfigStoreTest, PublishAndReclaim) {
+    ConfigStore<TestConfig> store(makeConfig(1));
+    EXPECT_EQ(store.getVersion(), 1u);
+
+    {
+        ConfigReader<TestConfig> held = store.read();
+        EXPECT_EQ(held.version(), 1u);
+
+        EXPECT_EQ(store.publish(makeConfig(2)), 2u);
+        EXPECT_EQ(store.update([](TestConfig& config) { config.threshold += 1; }), 3u);
+
+        // 旧快照仍可访问，新的读取方看到最新版本
+        EXPECT_EQ(held->threshold, 1);
+        EXPECT_EQ(held->name, "x");
+        ConfigReader<TestConfig> latest = store.read();
+        EXPECT_EQ(latest.version(), 3u);
+        EXPECT_EQ(latest->threshold, 3);
+        EXPECT_EQ(latest->name, "xx");
+        EXPECT_GE(EpochDomain::getInstance().getRetiredCount(), 2u);
+    }
+
+    EpochDomain::getInstance().reclaim();
+    EXPECT_EQ(EpochDomain::getInstance().getRetiredCount(), 0u);
+}
+
+// 测试嵌套读取：内层退出后外层持有的快照仍然有效
+TEST(ConfigStoreTest, NestedReaders) {
+    ConfigStore<TestConfig> store(makeConfig(5));
+    ConfigReader<TestConfig> outer = store.read();
+    {
+        ConfigReader<TestConfig> inner = store.read();
+        EXPECT_EQ(inner->threshold, 5);
+    }
+    store.publish(makeConfig(6));
+    EpochDomain::getInstance().reclaim();
+    EXPECT_EQ(outer->threshold, 5);
+    EXPECT_EQ(outer->name, "xxxxx");
+}
+
+// 测试并发读取和发布：读取方看到的快照完整且版本号单调递增，发布方不等待读取方
+TEST(ConfigStoreTest, ConcurrentReadersAndPublisher) {
+    ConfigStore<TestConfig> store(makeConfig(1));
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            uint64_t lastVersion = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                ConfigReader<TestConfig> config = store.read();
+                if (config.version() < lastVersion ||
+                    config->name.size() != static_cast<size_t>(config->threshold % 64)) {
+                    errors.fetch_add(1);
+                }
+                lastVersion = config.version();
+            }
+        });
+    }
+
+    const int publishCount = 2000;
+    for (int i = 2; i <= publishCount; ++i) {
+        store.publish(makeConfig(i));
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(store.getVersion(), static_cast<uint64_t>(publishCount));
+    EXPECT_EQ(store.read()->threshold, publishCount);
+    EpochDomain::getInstance().reclaim();
+    EXPECT_EQ(EpochDomain::getInstance().getRetiredCount(), 0u);
+}
@@ -0,0 +1,175 @@
+#include "ConfigWatcher.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 写入配置文件：先写临时文件再重命名（与同步程序的更新方式相同），或原地覆盖
+void writeConfig(const std::string& path, const std::string& content, bool replace) {
+    std::string target = replace ? path + ".tmp" : path;
+    {
+        std::ofstream file(target, std::ios::out | std::ios::trunc);
+        file << content;
+    }
+    if (replace) {
+        std::filesystem::rename(target, path);
+    }
+}
+
+// 收集处理函数收到的分节变化
+class DiffRecorder {
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<ConfigSectionDiff> diffs;
+
+public:
+    ConfigSectionHandler handler() {
+        return [this](const ConfigSectionDiff& diff) {
+            std::lock_guard<std::mutex> lock(mutex);
+            diffs.push_back(diff);
+            changed.notify_all();
+        };
+    }
+
+    // 等待收到至少count个变化后取出
+    std::vector<ConfigSectionDiff> take(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::seconds(3), [&]() { return diffs.size() >= count; });
+        std::vector<ConfigSectionDiff> result;
+        result.swap(diffs);
+        return result;
+    }
+};
+
+} // namespace
+
+// 测试按分节比较配置项
+TEST(ConfigWatcherTest, DiffBySection) {
+    ConfigEntries previous = {{"logLevel", "3"},
+                              {"scene.indoor.maxSpeed", "5"},
+                              {"scene.outdoor.maxSpeed", "120"},
+                              {"scene.outdoor.minAccuracy", "5"}};
+    ConfigEntries current = {{"logLevel", "3"},
+                             {"scene.indoor.maxSpeed", "5"},
+                             {"scene.outdoor.maxSpeed", "100"},
+                             {"scene.outdoor.smoothing", "true"}};
+
+    std::vector<ConfigSectionDiff> diffs = ConfigWatcher::diff(previous, current);
+    ASSERT_EQ(diffs.size(), 1u);
+    EXPECT_EQ(diffs[0].section, "scene.outdoor");
+    EXPECT_EQ(diffs[0].changed, (ConfigEntries{{"scene.outdoor.maxSpeed", "100"}, {"scene.outdoor.smoothing", "true"}}));
+    EXPECT_EQ(diffs[0].removed, std::vector<std::string>{"scene.outdoor.minAccuracy"});
+
+    EXPECT_EQ(ConfigWatcher::sectionOf("logLevel"), "");
+    EXPECT_EQ(ConfigWatcher::sectionOf("source.weight.0"), "source.weight");
+}
+
+// 测试启动时预加载，文件更新后只通知有变化的分节
+TEST(ConfigWatcherTest, ReloadsChangedSections) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "config_watcher_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "correction.conf").string();
+    writeConfig(path,
+                "# cached config\n"
+                "logLevel = 3\n"
+                "scene.indoor.maxSpeed=5\n"
+                "scene.outdoor.maxSpeed=120\n",
+                true);
+
+    ConfigWatcher watcher(path);
+    DiffRecorder scenes;
+    DiffRecorder all;
+    watcher.addSectionHandler("scene", scenes.handler());
+    watcher.addSectionHandler("", all.handler());
+    ASSERT_TRUE(watcher.start());
+
+    // 预加载时所有分节都作为新增项通知
+    EXPECT_EQ(scenes.take(2).size(), 2u);
+    EXPECT_EQ(all.take(3).size(), 3u);
+    EXPECT_EQ(watcher.getEntries().at("logLevel"), "3");
+
+    // 重命名替换：只修改室外场景的阈值
+    writeConfig(path, "logLevel = 3\nscene.indoor.maxSpeed=5\nscene.outdoor.maxSpeed=100\n", true);
+    std::vector<ConfigSectionDiff> diffs = scenes.take(1);
+    ASSERT_EQ(diffs.size(), 1u);
+    EXPECT_EQ(diffs[0].section, "scene.outdoor");
+    EXPECT_EQ(diffs[0].changed, (ConfigEntries{{"scene.outdoor.maxSpeed", "100"}}));
+    EXPECT_TRUE(diffs[0].removed.empty());
+    EXPECT_EQ(all.take(1).size(), 1u);
+
+    // 原地覆盖：删除一项
+    writeConfig(path, "logLevel = 3\nscene.outdoor.maxSpeed=100\n", false);
+    diffs = scenes.take(1);
+    ASSERT_EQ(diffs.size(), 1u);
+    EXPECT_EQ(diffs[0].section, "scene.indoor");
+    EXPECT_TRUE(diffs[0].changed.empty());
+    EXPECT_EQ(diffs[0].removed, std::vector<std::string>{"scene.indoor.maxSpeed"});
+
+    watcher.stop();
+    std::filesystem::remove_all(directory);
+}
+
+// 测试重新加载处理函数每次加载只调用一次，收到所有有变化的分节
+TEST(ConfigWatcherTest, ReloadHandlerSeesWholeUpdate) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "config_watcher_reload_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "correction.conf").string();
+    writeConfig(path, "logLevel = 3\nscene.indoor.maxSpeed=5\nscene.outdoor.maxSpeed=120\n", true);
+
+    ConfigWatcher watcher(path);
+    std::vector<size_t> reloads;
+    watcher.addReloadHandler([&reloads](const std::vector<ConfigSectionDiff>& changes) {
+        reloads.push_back(changes.size());
+    });
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(reloads, std::vector<size_t>{3});
+
+    // 同一次更新修改两个分节：只调用一次
+    writeConfig(path, "logLevel = 4\nscene.indoor.maxSpeed=5\nscene.outdoor.maxSpeed=100\n", true);
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(reloads, (std::vector<size_t>{3, 2}));
+
+    // 内容没有变化时不调用
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(reloads.size(), 2u);
+    std::filesystem::remove_all(directory);
+}
+
+// 测试修改一个场景区域：只有该区域的分节（scene.<场景ID>）变化，其他区域不受影响
+TEST(ConfigWatcherTest, ChangesOneSceneRegion) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "config_watcher_scene_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "correction.conf").string();
+    const std::string station = "scene.station.latitude=31.25\nscene.station.longitude=121.45\nscene.station.radius=800\n";
+    writeConfig(path,
+                "scene.campus.latitude=31.20\nscene.campus.longitude=121.40\nscene.campus.radius=500\n" + station, true);
+
+    ConfigWatcher watcher(path);
+    std::vector<ConfigSectionDiff> changes;
+    watcher.addReloadHandler([&changes](const std::vector<ConfigSectionDiff>& diffs) { changes = diffs; });
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(changes.size(), 2u);
+
+    // 移动campus区域的中心并关闭纠偏
+    writeConfig(path,
+                "scene.campus.latitude=31.21\nscene.campus.longitude=121.40\nscene.campus.radius=500\n"
+                "scene.campus.enableCorrection=false\n" + station, true);
+    ASSERT_TRUE(watcher.reload());
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].section, "scene.campus");
+    EXPECT_EQ(changes[0].changed,
+              (ConfigEntries{{"scene.campus.enableCorrection", "false"}, {"scene.campus.latitude", "31.21"}}));
+    EXPECT_TRUE(changes[0].removed.empty());
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,114 @@
+#include "DeviceStateStore.h"
+#include "LocationCodec.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// 创建空的检查点路径
+std::string makeCheckpointPath() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "location_state_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return (directory / ("devices" + std::string(DEVICE_STATE_FILE_EXTENSION))).string();
+}
+
+// 生成位置数据
+LocationInfo makeLocation(long long timestamp, double latitude) {
+    LocationInfo location;
+    location.timestamp = timestamp;
+    location.latitude = latitude;
+    location.longitude = 116.4074;
+    location.accuracy = 5.0;
+    return location;
+}
+
+} // namespace
+
+// 测试检查点的保存与恢复：窗口顺序、最近输出和场景在恢复后保持不变，恢复后可继续更新
+TEST(DeviceStateStoreTest, CheckpointRoundTripTest) {
+    std::string path = makeCheckpointPath();
+
+    DeviceStateStore store(4);
+    for (int device = 0; device < 100; ++device) {
+        std::string deviceId = "device-" + std::to_string(device);
+        for (int i = 0; i < 12; ++i) {
+            store.recordInput(deviceId, makeLocation(i * 1000, 30.0 + device));
+        }
+        store.recordOutput(deviceId, makeLocation(11000, 30.5 + device), device % 3, 5000);
+    }
+
+    DeviceCheckpointStats stats;
+    ASSERT_TRUE(store.saveCheckpoint(path, &stats));
+    EXPECT_EQ(stats.deviceCount, 100u);
+    EXPECT_EQ(stats.bytes, std::filesystem::file_size(path));
+
+    DeviceStateStore restored(8);
+    ASSERT_TRUE(restored.loadCheckpoint(path));
+    EXPECT_EQ(restored.getDeviceCount(), 100u);
+
+    std::vector<LocationInfo> window = restored.getWindow("device-7");
+    ASSERT_EQ(window.size(), DEVICE_STATE_WINDOW_SIZE);
+    EXPECT_EQ(window.front().timestamp, 4000); // 只保留最近8个位置
+    EXPECT_EQ(window.back().timestamp, 11000);
+    EXPECT_DOUBLE_EQ(window.back().latitude, 37.0);
+    EXPECT_EQ(getDeviceIdOf(window.back()), "device-7");
+
+    DeviceState state;
+    ASSERT_TRUE(restored.getState("device-7", state));
+    EXPECT_TRUE(state.flags & DEVICE_STATE_HAS_OUTPUT);
+    EXPECT_EQ(state.scene, 1);
+    EXPECT_DOUBLE_EQ(state.lastOutput.latitude, 37.5);
+    EXPECT_FALSE(restored.getState("device-100", state));
+
+    // 所有设备最后更新时间相同，取其中之一；之后更新的设备成为最近设备
+    std::string latestDevice;
+    ASSERT_TRUE(restored.getLatestState(latestDevice, state));
+    EXPECT_EQ(state.updateTime, 11000);
+    restored.recordOutput("device-42", makeLocation(11500, 72.5), 2, 11500);
+    ASSERT_TRUE(restored.getLatestState(latestDevice, state));
+    EXPECT_EQ(latestDevice, "device-42");
+    EXPECT_EQ(state.scene, 2);
+
+    // 恢复的状态和新设备都可以继续更新
+    restored.recordInput("device-7", makeLocation(12000, 37.0));
+    restored.recordInput("device-new", makeLocation(12000, 40.0));
+    EXPECT_EQ(restored.getWindow("device-7").front().timestamp, 5000);
+    EXPECT_EQ(restored.getWindow("device-new").size(), 1u);
+    EXPECT_EQ(restored.getDeviceCount(), 101u);
+
+    // 覆盖写入映射中的检查点后再次恢复
+    ASSERT_TRUE(restored.saveCheckpoint(path));
+    ASSERT_TRUE(restored.loadCheckpoint(path));
+    EXPECT_EQ(restored.getDeviceCount(), 101u);
+    EXPECT_EQ(restored.getWindow("device-7").back().timestamp, 12000);
+
+    std::filesystem::remove_all(std::filesystem::path(path).parent_path());
+}
+
+// 测试损坏的检查点被拒绝，且不影响现有状态
+TEST(DeviceStateStoreTest, CorruptCheckpointTest) {
+    std::string path = makeCheckpointPath();
+
+    DeviceStateStore store;
+    store.recordInput("device-a", makeLocation(1000, 31.0));
+    ASSERT_TRUE(store.saveCheckpoint(path));
+
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(100);
+        file.put('\x5A');
+    }
+
+    DeviceStateStore restored;
+    std::string latestDevice;
+    DeviceState state;
+    EXPECT_FALSE(restored.getLatestState(latestDevice, state));
+    restored.recordInput("device-b", makeLocation(2000, 32.0));
+    EXPECT_FALSE(restored.loadCheckpoint(path));
+    EXPECT_EQ(restored.getDeviceCount(), 1u);
+    EXPECT_EQ(restored.getWindow("device-b").size(), 1u);
+
+    std::filesystem::remove_all(std::filesystem::path(path).parent_path());
+}
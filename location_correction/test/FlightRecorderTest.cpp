@@ -0,0 +1,137 @@
+#include "FlightRecorder.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 使用空的临时目录存放转储文件
+FlightRecorderConfig useDumpDirectory(const std::string& name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    FlightRecorderConfig config;
+    config.dumpDirectory = directory.string();
+    config.anomalyBurstCount = 0;
+    FlightRecorder::getInstance().setConfig(config);
+    return config;
+}
+
+// 列出目录下的转储文件
+std::vector<std::string> listDumps(const std::string& directory) {
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        files.push_back(entry.path().string());
+    }
+    return files;
+}
+
+// 读取整个文件
+std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+} // namespace
+
+// 测试每个线程只保留最近的事件且保持记录顺序
+TEST(FlightRecorderTest, RingKeepsMostRecentEvents) {
+    FlightRecorderConfig config = useDumpDirectory("flight_recorder_ring");
+    config.eventsPerThread = 64;
+    FlightRecorder::getInstance().setConfig(config);
+
+    std::thread recorder([] {
+        for (long long i = 0; i < 100; ++i) {
+            FlightRecorder::getInstance().record(FlightEventType::MARK, 1000000 + i, 31.23, 121.47, 0, 0.0f);
+        }
+    });
+    recorder.join();
+
+    std::vector<long long> timestamps;
+    for (const auto& event : FlightRecorder::getInstance().snapshot()) {
+        if (event.fixTimestamp >= 1000000 && event.fixTimestamp < 1000100) {
+            timestamps.push_back(event.fixTimestamp);
+        }
+    }
+    ASSERT_EQ(timestamps.size(), 64u);
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        EXPECT_EQ(timestamps[i], 1000036 + static_cast<long long>(i));
+    }
+}
+
+// 测试转储文件内容
+TEST(FlightRecorderTest, DumpWritesEvents) {
+    FlightRecorderConfig config = useDumpDirectory("flight_recorder_dump");
+    FlightRecorder::getInstance().record(FlightEventType::FIX_FILTERED, 2000000, 31.2304, 121.4737, 1, 12.5f);
+
+    std::string path = FlightRecorder::getInstance().dump("unit test");
+    ASSERT_FALSE(path.empty());
+    EXPECT_NE(path.find("unit_test"), std::string::npos);
+
+    std::string content = readFile(path);
+    EXPECT_EQ(content.rfind("# flight recorder dump: reason=unit test", 0), 0u);
+    EXPECT_NE(content.find(" FIX_FILTERED 1 2000000 31.2304000 121.4737000 12.500\n"), std::string::npos);
+    EXPECT_EQ(listDumps(config.dumpDirectory).size(), 1u);
+}
+
+// 测试异常突发时自动转储，冷却期内不重复转储
+TEST(FlightRecorderTest, AnomalyBurstTriggersDump) {
+    FlightRecorderConfig config = useDumpDirectory("flight_recorder_burst");
+    config.anomalyBurstCount = 5;
+    config.anomalyBurstWindowMs = 60000;
+    config.dumpCooldownMs = 600000;
+    FlightRecorder::getInstance().setConfig(config);
+
+    for (int i = 0; i < 4; ++i) {
+        FlightRecorder::getInstance().record(FlightEventType::ANOMALY_DETECTED, 3000000 + i, 31.0, 121.0, 0, 0.9f);
+    }
+    EXPECT_TRUE(listDumps(config.dumpDirectory).empty());
+
+    FlightRecorder::getInstance().record(FlightEventType::ANOMALY_DETECTED, 3000004, 31.0, 121.0, 0, 0.9f);
+    FlightRecorder::getInstance().waitForDumps();
+    std::vector<std::string> dumps = listDumps(config.dumpDirectory);
+    ASSERT_EQ(dumps.size(), 1u);
+    EXPECT_NE(dumps[0].find("anomaly_burst"), std::string::npos);
+    EXPECT_NE(readFile(dumps[0]).find(" ANOMALY_DETECTED 0 3000004 "), std::string::npos);
+
+    for (int i = 5; i < 10; ++i) {
+        FlightRecorder::getInstance().record(FlightEventType::ANOMALY_DETECTED, 3000000 + i, 31.0, 121.0, 0, 0.9f);
+    }
+    FlightRecorder::getInstance().waitForDumps();
+    EXPECT_EQ(listDumps(config.dumpDirectory).size(), 1u);
+
+    // 新配置在下一个异常事件时生效：取消冷却后按新的阈值转储
+    config.anomalyBurstCount = 2;
+    config.dumpCooldownMs = 0;
+    FlightRecorder::getInstance().setConfig(config);
+    for (int i = 10; i < 12; ++i) {
+        FlightRecorder::getInstance().record(FlightEventType::ANOMALY_DETECTED, 3000000 + i, 31.0, 121.0, 0, 0.9f);
+    }
+    FlightRecorder::getInstance().waitForDumps();
+    EXPECT_EQ(listDumps(config.dumpDirectory).size(), 2u);
+}
+
+// 测试收到致命信号时写出转储文件
+TEST(FlightRecorderTest, CrashDumpOnFatalSignal) {
+    FlightRecorderConfig config = useDumpDirectory("flight_recorder_crash");
+
+    EXPECT_DEATH({
+        FlightRecorder::getInstance().installCrashHandler();
+        FlightRecorder::getInstance().record(FlightEventType::MARK, 4000000, 31.0, 121.0, 0, 0.0f);
+        std::abort();
+    }, "");
+
+    std::vector<std::string> dumps = listDumps(config.dumpDirectory);
+    ASSERT_EQ(dumps.size(), 1u);
+    std::string content = readFile(dumps[0]);
+    EXPECT_EQ(content.rfind("# flight recorder crash dump: signal=", 0), 0u);
+    EXPECT_NE(content.find(" MARK 0 4000000 31.0000000 121.0000000 0.000\n"), std::string::npos);
+}
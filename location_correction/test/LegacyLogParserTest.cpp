@@ -0,0 +1,115 @@
+#include "LegacyLogParser.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// 按FileStorage的CSV日志格式序列化一行
+std::string serialize(const LocationInfo& location) {
+    std::stringstream ss;
+    ss << location.timestamp << "," << location.latitude << "," << location.longitude << ","
+       << location.altitude << "," << location.accuracy << ","
+       << static_cast<int>(location.sourceType) << "," << static_cast<int>(location.status);
+    for (const auto& [key, value] : location.getExtras()) {
+        ss << ",[" << key << ":" << value << "]";
+    }
+    return ss.str();
+}
+
+// 生成第i条位置数据
+LocationInfo makeLocation(int i) {
+    LocationInfo location;
+    location.timestamp = 1700000000000LL + i;
+    location.latitude = 39.9 + i * 1e-4;
+    location.longitude = -116.4;
+    location.altitude = 50.5;
+    location.accuracy = 3.25;
+    location.sourceType = static_cast<DataSourceType>(i % 3);
+    location.status = static_cast<LocationStatus>(i % 2);
+    location.setExtra(DEVICE_ID_EXTRA_KEY, "device-" + std::to_string(i % 5));
+    if (i % 4 == 0) {
+        location.setExtra("provider", "gps");
+    }
+    return location;
+}
+
+} // namespace
+
+// 测试单行解析与序列化格式一致，格式错误时返回原因而不抛出异常
+TEST(LegacyLogParserTest, ParseLineTest) {
+    LocationInfo expected = makeLocation(8);
+    LocationInfo location;
+    ASSERT_TRUE(LegacyLogParser::parseLine(serialize(expected) + "\r", location));
+    EXPECT_EQ(location.timestamp, expected.timestamp);
+    EXPECT_DOUBLE_EQ(location.latitude, 39.9008);
+    EXPECT_DOUBLE_EQ(location.longitude, -116.4);
+    EXPECT_EQ(location.sourceType, expected.sourceType);
+    EXPECT_EQ(location.getExtra("provider"), "gps");
+    EXPECT_EQ(getDeviceIdOf(location), "device-3");
+
+    const char* reason = nullptr;
+    EXPECT_FALSE(LegacyLogParser::parseLine("1700000000000,39.9,116.4", location, &reason));
+    EXPECT_STREQ(reason, "too few fields");
+    EXPECT_FALSE(LegacyLogParser::parseLine("1700000000000,39.9x,116.4,0,5,1,0", location, &reason));
+    EXPECT_STREQ(reason, "invalid latitude");
+    EXPECT_FALSE(LegacyLogParser::parseLine("1700000000000,39.9,116.4,0,5,1,300", location, &reason));
+    EXPECT_STREQ(reason, "invalid status");
+}
+
+// 测试分片并行解析的结果与逐行解析一致，格式错误的行按文件行号报告
+TEST(LegacyLogParserTest, ParseFileTest) {
+    std::string path = (std::filesystem::temp_directory_path() / "locations_legacy_test.log").string();
+    std::vector<LocationInfo> expected;
+    {
+        std::ofstream file(path, std::ios::trunc);
+        for (int i = 0; i < 3000; ++i) {
+            if (i == 1000) {
+                file << "1700000000000,abc,116.4,0,5,1,0\n"; // 第1001行
+            } else if (i == 2000) {
+                file << "\n";                                 // 空行不计入
+            }
+            expected.push_back(makeLocation(i));
+            file << serialize(expected.back()) << (i % 7 == 0 ? "\r\n" : "\n");
+        }
+        file << "1700000009999,39.9"; // 文件末尾被截断的行，没有换行符
+    }
+
+    LegacyParseOptions options;
+    options.threadCount = 4;
+    options.chunkSize = 4096; // 分片边界落在行中间
+    LegacyLogParser parser(options);
+
+    LocationColumns rows;
+    LegacyParseStats stats;
+    ASSERT_TRUE(parser.parseFile(path, rows, &stats));
+    EXPECT_GT(stats.chunks, 10u);
+    EXPECT_EQ(stats.bytesParsed, std::filesystem::file_size(path));
+    EXPECT_EQ(stats.linesTotal, 3002u);
+    EXPECT_EQ(stats.rowsParsed, 3000u);
+    EXPECT_EQ(stats.linesMalformed, 2u);
+    ASSERT_EQ(stats.errors.size(), 2u);
+    EXPECT_EQ(stats.errors[0].line, 1001u);
+    EXPECT_EQ(stats.errors[0].reason, "invalid latitude");
+    EXPECT_EQ(stats.errors[1].line, 3003u);
+    EXPECT_EQ(stats.errors[1].reason, "too few fields");
+
+    ASSERT_EQ(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        LocationInfo location = rows.toLocationInfo(i);
+        LocationInfo reference;
+        ASSERT_TRUE(LegacyLogParser::parseLine(serialize(expected[i]), reference));
+        EXPECT_EQ(location.timestamp, reference.timestamp);
+        EXPECT_EQ(location.latitude, reference.latitude);
+        EXPECT_EQ(location.status, reference.status);
+        EXPECT_EQ(location.getExtras(), reference.getExtras());
+    }
+
+    // 回调返回false时停止解析
+    size_t chunks = 0;
+    EXPECT_FALSE(parser.parseFile(path, [&chunks](LocationColumns&) { return ++chunks < 2; }));
+    EXPECT_EQ(chunks, 2u);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,119 @@
+#include "LocationCodec.h"
+#include "SegmentFile.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+// 生成一段模拟轨迹
+LocationColumns makeTrack(size_t count) {
+    LocationColumns columns;
+    for (size_t i = 0; i < count; ++i) {
+        LocationInfo location;
+        location.timestamp = 1620000000000LL + static_cast<long long>(i) * 1000 + (i % 7 == 0 ? 3 : 0);
+        location.latitude = 39.9042 + i * 0.00001;
+        location.longitude = 116.4074 - i * 0.00002;
+        location.altitude = 43.5;
+        location.accuracy = 5.0 + (i % 3);
+        location.speed = 1.25;
+        location.direction = 270.5;
+        location.sourceType = static_cast<DataSourceType>(i % 2);
+        location.status = LocationStatus::VALID;
+        location.setExtra(DEVICE_ID_EXTRA_KEY, i % 4 == 0 ? "device-a" : "device-b");
+        if (i % 5 == 0) {
+            location.setExtra("isOutlier", "true");
+        }
+        columns.append(location);
+    }
+    return columns;
+}
+
+} // namespace
+
+// 测试压缩块编解码的往返一致性
+TEST(LocationCodecTest, BlockRoundTripTest) {
+    LocationColumns original = makeTrack(1000);
+
+    std::vector<uint8_t> encoded;
+    LocationCodec::encodeBlock(original, encoded);
+
+    LocationColumns decoded;
+    ASSERT_TRUE(LocationCodec::decodeBlock(encoded.data(), encoded.size(), decoded));
+    ASSERT_EQ(decoded.size(), original.size());
+
+    for (size_t i = 0; i < original.size(); ++i) {
+        EXPECT_EQ(decoded.timestamps[i], original.timestamps[i]);
+        EXPECT_NEAR(decoded.latitudes[i], original.latitudes[i], 1e-7);
+        EXPECT_NEAR(decoded.longitudes[i], original.longitudes[i], 1e-7);
+        EXPECT_NEAR(decoded.accuracies[i], original.accuracies[i], 0.01);
+        EXPECT_EQ(decoded.sourceTypes[i], original.sourceTypes[i]);
+        EXPECT_EQ(decoded.statuses[i], original.statuses[i]);
+        EXPECT_EQ(decoded.getDeviceId(i), original.getDeviceId(i));
+    }
+
+    LocationInfo row = decoded.toLocationInfo(5);
+    EXPECT_EQ(row.getExtra("isOutlier"), "true");
+    EXPECT_EQ(getDeviceIdOf(row), "device-b");
+
+    // 规则轨迹的压缩后大小应远小于原始结构
+    EXPECT_LT(encoded.size(), original.size() * 16);
+}
+
+// 测试损坏的块数据不会修改输出
+TEST(LocationCodecTest, TruncatedBlockTest) {
+    LocationColumns original = makeTrack(100);
+
+    std::vector<uint8_t> encoded;
+    LocationCodec::encodeBlock(original, encoded);
+
+    LocationColumns decoded;
+    EXPECT_FALSE(LocationCodec::decodeBlock(encoded.data(), encoded.size() / 2, decoded));
+    EXPECT_TRUE(decoded.empty());
+
+    // 设备ID和额外信息字典解码后才失败时，字典也回滚到解码前
+    LocationColumns existing = makeTrack(1);
+    size_t deviceCount = existing.deviceDictionary.size();
+    size_t extrasCount = existing.extrasDictionary.size();
+    EXPECT_FALSE(LocationCodec::decodeBlock(encoded.data(), encoded.size() - 1, existing));
+    EXPECT_EQ(existing.size(), 1u);
+    EXPECT_EQ(existing.deviceDictionary.size(), deviceCount);
+    EXPECT_EQ(existing.extrasDictionary.size(), extrasCount);
+    EXPECT_EQ(existing.internDevice("device-b"), deviceCount);
+}
+
+// 测试段文件的写入、块索引和未正常关闭时的恢复
+TEST(LocationCodecTest, SegmentFileTest) {
+    std::string path = (std::filesystem::temp_directory_path() / "location_codec_test.lcs").string();
+
+    LocationColumns first = makeTrack(200);
+    LocationColumns second = makeTrack(300);
+    {
+        SegmentWriter writer;
+        ASSERT_TRUE(writer.open(path));
+        ASSERT_TRUE(writer.appendBlock(first));
+        ASSERT_TRUE(writer.appendBlock(second));
+        ASSERT_TRUE(writer.finish());
+    }
+
+    SegmentReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_TRUE(reader.isComplete());
+    ASSERT_EQ(reader.getBlocks().size(), 2u);
+    EXPECT_EQ(reader.getRowCount(), 500u);
+    EXPECT_EQ(reader.getMinTimestamp(), first.timestamps.front());
+
+    LocationColumns decoded;
+    ASSERT_TRUE(reader.readBlock(1, decoded));
+    EXPECT_EQ(decoded.size(), 300u);
+    reader.close();
+
+    // 截断文件尾，模拟写入过程中崩溃
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.isComplete());
+    EXPECT_EQ(reader.getBlocks().size(), 2u);
+    reader.close();
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,374 @@
+#include "Logger.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 将日志只写入临时文件
+std::string useLogFile(const std::string& name, size_t bufferSize, LogOverflowPolicy policy) {
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+
+    LoggerConfig config;
+    config.logLevel = LogLevel::DEBUG;
+    config.enableConsoleOutput = false;
+    config.enableFileOutput = true;
+    config.logFile = path;
+    config.maxLogFileSize = 0;
+    config.threadBufferSize = bufferSize;
+    config.overflowPolicy = policy;
+    Logger::getInstance().setConfig(config);
+    return path;
+}
+
+// 读取日志文件的所有行
+std::vector<std::string> readLines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// 恢复默认配置
+void restoreLogger() {
+    Logger::getInstance().flush();
+    Logger::getInstance().setConfig(LoggerConfig());
+}
+
+} // namespace
+
+// 测试多线程并发写日志：不丢失，每个线程内的顺序保持不变，低于级别的日志不写出
+TEST(LoggerTest, MultiThreadTest) {
+    std::string path = useLogFile("logger_multi_thread_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+
+    const int threadCount = 4;
+    const int messageCount = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < messageCount; ++i) {
+                LOG_INFO("thread %d message %d", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Logger::getInstance().setLogLevel(LogLevel::WARNING);
+    LOG_INFO("filtered");
+    LOG_WARNING("last %s", std::string(1000, 'x').c_str()); // 超过栈上缓冲区的消息
+    Logger::getInstance().flush();
+
+    std::vector<std::string> lines = readLines(path);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(threadCount * messageCount + 1));
+    std::map<int, int> next;
+    for (size_t i = 0; i + 1 < lines.size(); ++i) {
+        int thread = -1;
+        int message = -1;
+        size_t position = lines[i].find("thread ");
+        ASSERT_NE(position, std::string::npos);
+        ASSERT_EQ(std::sscanf(lines[i].c_str() + position, "thread %d message %d", &thread, &message), 2);
+        EXPECT_EQ(message, next[thread]++);
+        EXPECT_NE(lines[i].find("[INFO]"), std::string::npos);
+    }
+    EXPECT_NE(lines.back().find("[WARNING]"), std::string::npos);
+    EXPECT_NE(lines.back().find(std::string(1000, 'x')), std::string::npos);
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
+
+// 测试缓冲区写满时的阻塞和丢弃策略
+TEST(LoggerTest, OverflowPolicyTest) {
+    const int messageCount = 20000;
+    auto burst = []() {
+        std::thread writer([]() {
+            for (int i = 0; i < messageCount; ++i) {
+                LOG_DEBUG("burst message %d with some padding to fill the buffer quickly", i);
+            }
+        });
+        writer.join();
+        Logger::getInstance().flush();
+    };
+
+    // 阻塞：等待日志线程腾出空间，不丢失日志
+    std::string path = useLogFile("logger_block_test.log", 4096, LogOverflowPolicy::BLOCK);
+    uint64_t dropped = Logger::getInstance().getDroppedCount();
+    burst();
+    EXPECT_EQ(Logger::getInstance().getDroppedCount(), dropped);
+    EXPECT_EQ(readLines(path).size(), static_cast<size_t>(messageCount));
+    std::filesystem::remove(path);
+
+    // 丢弃：业务线程不等待，丢弃的条数计数并由日志线程报告
+    path = useLogFile("logger_drop_test.log", 4096, LogOverflowPolicy::DROP);
+    burst();
+    uint64_t newlyDropped = Logger::getInstance().getDroppedCount() - dropped;
+    EXPECT_GT(newlyDropped, 0u);
+    uint64_t written = 0;
+    uint64_t reported = 0;
+    for (const auto& line : readLines(path)) {
+        size_t position = line.find("dropped ");
+        if (position != std::string::npos) {
+            reported += std::stoull(line.substr(position + 8));
+        } else if (line.find("burst message") != std::string::npos) {
+            ++written;
+        }
+    }
+    EXPECT_EQ(written, messageCount - newlyDropped);
+    EXPECT_EQ(reported, newlyDropped);
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
+
+// 测试延迟格式化：日志线程格式化的结果与printf一致
+TEST(LoggerTest, DeferredFormatTest) {
+    std::string path = useLogFile("logger_deferred_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+
+    const char* nullString = nullptr;
+    char mutableString[] = "mutable";
+    int value = 42;
+    std::string longText(3000, 'y'); // 超过延迟格式化的最大长度，在调用线程中格式化
+    LOG_INFO("no arguments 100%%");
+    LOG_INFO("int=%d uint=%u ll=%lld ull=%llu size=%zu char=%c", -7, 7u, -1234567890123LL, 1234567890123ULL,
+             static_cast<size_t>(99), 'z');
+    LOG_INFO("double=%.3f float=%.1f exp=%e long double=%.2Lf", 3.14159, 2.5f, 1e10, static_cast<long double>(1.25));
+    LOG_INFO("string=[%s] null=[%s] mutable=[%s] padded=[%-6s] precision=[%.3s]", "abc", nullString,
+             mutableString, "ab", "abcdef");
+    LOG_INFO("star=[%*d] starPrecision=[%.*f] hex=%#x", 5, 42, 2, 1.23456, 255);
+    LOG_INFO("pointer=%p", static_cast<void*>(&value));
+    // 带精度的%s不要求以'\0'结尾，%p对应的C字符串只记录地址
+    char unterminated[4] = {'w', 'x', 'y', 'z'};
+    LOG_INFO("bounded=[%.2s] starBounded=[%*.*s] charPointer=%p", unterminated, 4, 3, unterminated, mutableString);
+    LOG_INFO("long=%s", longText.c_str());
+    Logger::getInstance().flush();
+
+    char pointerText[64];
+    std::snprintf(pointerText, sizeof(pointerText), "pointer=%p", static_cast<void*>(&value));
+    char charPointerText[96];
+    std::snprintf(charPointerText, sizeof(charPointerText), "bounded=[wx] starBounded=[ wxy] charPointer=%p",
+                  static_cast<void*>(mutableString));
+    std::vector<std::string> expected = {
+        "no arguments 100%",
+        "int=-7 uint=7 ll=-1234567890123 ull=1234567890123 size=99 char=z",
+        "double=3.142 float=2.5 exp=1.000000e+10 long double=1.25",
+        "string=[abc] null=[(null)] mutable=[mutable] padded=[ab    ] precision=[abc]",
+        "star=[   42] starPrecision=[1.23] hex=0xff",
+        pointerText,
+        charPointerText,
+    };
+
+    std::vector<std::string> lines = readLines(path);
+    ASSERT_EQ(lines.size(), expected.size() + 1);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        size_t position = lines[i].find(expected[i]);
+        ASSERT_NE(position, std::string::npos) << lines[i];
+        EXPECT_EQ(lines[i].substr(position), expected[i]);
+    }
+    EXPECT_NE(lines.back().find("long=" + longText), std::string::npos);
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
+
+// 测试日志级别检查先于参数求值，编译期去掉的日志不对参数求值
+TEST(LoggerTest, LazyArgumentTest) {
+    std::string path = useLogFile("logger_lazy_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+    Logger::getInstance().setLogLevel(LogLevel::INFO);
+
+    int evaluated = 0;
+    auto describe = [&evaluated]() {
+        ++evaluated;
+        return std::string("described");
+    };
+    LOGGER_LOG(LogLevel::DEBUG, "filtered %s", describe().c_str());
+    LOGGER_DISABLED("removed %s", describe().c_str());
+    EXPECT_EQ(evaluated, 0);
+
+    LOG_INFO("kept %s", describe().c_str());
+    EXPECT_EQ(evaluated, 1);
+    Logger::getInstance().flush();
+
+    std::vector<std::string> lines = readLines(path);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("kept described"), std::string::npos);
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
+
+// 测试预编译的日志格式和时间格式，以及修改配置后重新编译
+TEST(LoggerTest, LineFormatTest) {
+    std::string path = useLogFile("logger_format_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+    LoggerConfig config = Logger::getInstance().getConfig();
+    config.fileLogFormat = "%LEVEL%|%MESSAGE%|%TIME%|100%";
+    config.dateFormat = "%Y/%m/%d %H-%M-%S %MS %f %Q";
+    Logger::getInstance().setConfig(config);
+
+    LOG_WARNING("first");
+    LOG_ERROR("second %d", 2);
+    Logger::getInstance().flush();
+
+    config.fileLogFormat = "<%THREAD%> %MESSAGE%";
+    Logger::getInstance().setConfig(config);
+    LOG_INFO("third");
+    Logger::getInstance().flush();
+
+    std::vector<std::string> lines = readLines(path);
+    ASSERT_EQ(lines.size(), 3u);
+    std::regex timed("(WARNING|ERROR)\\|(first|second 2)\\|\\d{4}/\\d{2}/\\d{2} \\d{2}-\\d{2}-\\d{2} (\\d{3}) (\\d{3}) Q\\|100%");
+    for (size_t i = 0; i < 2; ++i) {
+        std::smatch match;
+        ASSERT_TRUE(std::regex_match(lines[i], match, timed)) << lines[i];
+        EXPECT_EQ(match[3].str(), match[4].str());
+    }
+    EXPECT_TRUE(std::regex_match(lines[2], std::regex("<\\d+> third"))) << lines[2];
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
+
+// 测试文件输出按停留时间写出，以及超过最大大小后由轮转线程调整备份文件
+TEST(LoggerTest, BufferedRotationTest) {
+    std::string path = useLogFile("logger_rotation_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+    for (int i = 1; i <= 3; ++i) {
+        std::filesystem::remove(path + "." + std::to_string(i));
+    }
+    LoggerConfig config = Logger::getInstance().getConfig();
+    config.fileWriteBufferSize = 1024 * 1024;
+    config.fileFlushIntervalMs = 50;
+    Logger::getInstance().setConfig(config);
+
+    // 不调用flush，停留时间到期后写出
+    LOG_INFO("timed message");
+    bool written = false;
+    for (int i = 0; i < 100 && !written; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::vector<std::string> lines = readLines(path);
+        written = lines.size() == 1 && lines[0].find("timed message") != std::string::npos;
+    }
+    EXPECT_TRUE(written);
+
+    // 每约2KB轮转一次，只保留2个备份
+    config.maxLogFileSize = 2048;
+    config.maxBackupFiles = 2;
+    config.fileWriteBufferSize = 512;
+    Logger::getInstance().setConfig(config);
+    const int messageCount = 300;
+    for (int i = 0; i < messageCount; ++i) {
+        LOG_INFO("rotation message %d", i);
+        if (i % 10 == 9) {
+            Logger::getInstance().flush();
+        }
+    }
+    Logger::getInstance().flush();
+
+    // 等待轮转线程处理完（不再有临时文件）
+    auto rotating = [&path]() {
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(path).parent_path())) {
+            if (entry.path().string().rfind(path + ".rotating.", 0) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (int i = 0; i < 100 && rotating(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_FALSE(rotating());
+    EXPECT_TRUE(std::filesystem::exists(path + ".1"));
+    EXPECT_TRUE(std::filesystem::exists(path + ".2"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+
+    // 当前文件和备份文件依次衔接，最后一条在当前文件中
+    std::vector<std::string> lines;
+    for (const std::string& file : {path + ".2", path + ".1", path}) {
+        std::vector<std::string> fileLines = readLines(file);
+        EXPECT_LE(std::filesystem::file_size(file), 2048u + 1024u);
+        lines.insert(lines.end(), fileLines.begin(), fileLines.end());
+    }
+    ASSERT_FALSE(lines.empty());
+    int first = -1;
+    ASSERT_EQ(std::sscanf(lines[0].c_str() + lines[0].find("rotation message"), "rotation message %d", &first), 1);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        EXPECT_NE(lines[i].find("rotation message " + std::to_string(first + static_cast<int>(i))), std::string::npos);
+    }
+    EXPECT_NE(lines.back().find("rotation message " + std::to_string(messageCount - 1)), std::string::npos);
+
+    restoreLogger();
+    for (int i = 1; i <= 2; ++i) {
+        std::filesystem::remove(path + "." + std::to_string(i));
+    }
+    std::filesystem::remove(path);
+}
+
+// 测试按调用点限速：超出突发条数的日志被丢弃并定期汇总，不同调用点和较低级别不受影响
+TEST(LoggerTest, RateLimitTest) {
+    std::string path = useLogFile("logger_rate_limit_test.log", 64 * 1024, LogOverflowPolicy::BLOCK);
+    LoggerConfig config = Logger::getInstance().getConfig();
+    config.fileLogFormat = "[%LEVEL%] %MESSAGE%";
+    EXPECT_EQ(LoggerConfig().rateLimitPerSecond, 0); // 默认不限速
+    config.rateLimitPerSecond = 1;
+    config.rateLimitBurst = 5;
+    config.rateLimitLevel = LogLevel::WARNING;
+    config.suppressionReportIntervalMs = 100;
+    Logger::getInstance().setConfig(config);
+    Logger::getInstance().flush();
+
+    const int messageCount = 1000;
+    for (int i = 0; i < messageCount; ++i) {
+        LOG_ERROR("flooding error %d", i);
+        LOG_INFO("info %d", i);
+    }
+    LOG_WARNING("other site");
+
+    // 等待汇总日志写出
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Logger::getInstance().flush();
+        lines = readLines(path);
+        if (!lines.empty() && lines.back().find("Suppressed") != std::string::npos) {
+            break;
+        }
+    }
+
+    int errors = 0;
+    int infos = 0;
+    int others = 0;
+    long long suppressed = 0;
+    for (const auto& line : lines) {
+        if (line.rfind("[ERROR] flooding error ", 0) == 0) {
+            ++errors;
+        } else if (line.rfind("[INFO] info ", 0) == 0) {
+            ++infos;
+        } else if (line == "[WARNING] other site") {
+            ++others;
+        } else if (line.rfind("[ERROR] Suppressed ", 0) == 0) {
+            EXPECT_NE(line.find("(limit 1/s): flooding error %d"), std::string::npos) << line;
+            suppressed += std::stoll(line.substr(std::strlen("[ERROR] Suppressed ")));
+        } else {
+            ADD_FAILURE() << line;
+        }
+    }
+    EXPECT_GE(errors, 5);
+    EXPECT_LE(errors, 7);
+    EXPECT_EQ(errors + suppressed, messageCount);
+    EXPECT_EQ(infos, messageCount);
+    EXPECT_EQ(others, 1);
+
+    restoreLogger();
+    std::filesystem::remove(path);
+}
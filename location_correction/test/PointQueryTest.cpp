@@ -0,0 +1,154 @@
+#include "PointQuery.h"
+#include "LocationCodec.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+
+// 生成设备的位置数据
+LocationInfo makeLocation(const std::string& deviceId, long long timestamp, double latitude, double accuracy) {
+    LocationInfo location;
+    location.timestamp = timestamp;
+    location.latitude = latitude;
+    location.longitude = 116.4074;
+    location.accuracy = accuracy;
+    location.sourceType = DataSourceType::GNSS;
+    location.setExtra(DEVICE_ID_EXTRA_KEY, deviceId);
+    return location;
+}
+
+// 追加一个块：两个设备交替，每个设备每秒一个定位点
+void appendBlock(SegmentWriter& writer, int block) {
+    LocationColumns columns;
+    for (int i = 0; i < 100; ++i) {
+        long long timestamp = (block * 100 + i) * 1000LL;
+        columns.append(makeLocation("device-a", timestamp, 30.0 + timestamp * 1e-6, 5.0));
+        columns.append(makeLocation("device-b", timestamp + 500, 40.0, 5.0));
+    }
+    writer.appendBlock(columns);
+}
+
+} // namespace
+
+// 测试插值：线性插值位置，经度跨180度时取短弧，精度值在两点之间放大
+TEST(PointQueryTest, InterpolationTest) {
+    PointQueryOptions options;
+    std::optional<LocationInfo> before = makeLocation("device-a", 0, 30.0, 4.0);
+    std::optional<LocationInfo> after = makeLocation("device-a", 10000, 31.0, 4.0);
+    before->longitude = 179.5;
+    after->longitude = -179.5;
+
+    auto result = interpolateLocation(before, after, 2500, options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->kind, PointLocationKind::INTERPOLATED);
+    EXPECT_EQ(result->location.timestamp, 2500);
+    EXPECT_DOUBLE_EQ(result->location.latitude, 30.25);
+    EXPECT_NEAR(result->location.longitude, 179.75, 1e-9);
+    EXPECT_EQ(result->beforeTimestamp, 0);
+    EXPECT_EQ(result->afterTimestamp, 10000);
+    EXPECT_GT(result->location.accuracy, std::hypot(0.75 * 4.0, 0.25 * 4.0));
+
+    // 恰有定位点时直接返回
+    result = interpolateLocation(before, after, 10000, options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->kind, PointLocationKind::EXACT);
+    EXPECT_DOUBLE_EQ(result->location.accuracy, 4.0);
+
+    // 间隔过大时不插值，取时间差允许范围内最近的一侧
+    options.maxGapMs = 5000;
+    options.maxExtrapolationMs = 3000;
+    result = interpolateLocation(before, after, 2500, options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->kind, PointLocationKind::NEAREST);
+    EXPECT_DOUBLE_EQ(result->location.latitude, 30.0);
+    EXPECT_DOUBLE_EQ(result->location.accuracy, 4.0 + 2.5 * options.driftSpeed);
+    EXPECT_FALSE(interpolateLocation(before, after, 5000, options).has_value());
+    EXPECT_FALSE(interpolateLocation(std::nullopt, std::nullopt, 0, options).has_value());
+}
+
+// 测试设备时间索引：跨块、跨段查找前后定位点，段文件追加新块后补充索引
+TEST(PointQueryTest, DeviceTimeIndexTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_point_query_test").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::string first = directory + "/locations_0" + SEGMENT_FILE_EXTENSION;
+    std::string second = directory + "/locations_1" + SEGMENT_FILE_EXTENSION;
+    SegmentWriter writer;
+    ASSERT_TRUE(writer.open(first));
+    for (int block = 0; block < 3; ++block) {
+        appendBlock(writer, block);
+    }
+    ASSERT_TRUE(writer.finish());
+
+    // 第二个段文件尚未写完（没有块索引）
+    ASSERT_TRUE(writer.open(second));
+    appendBlock(writer, 3);
+    std::vector<std::string> files = {first, second};
+
+    DeviceTimeIndex index(4);
+    std::optional<LocationInfo> before;
+    std::optional<LocationInfo> after;
+    index.find(files, "device-b", 99800, 60000, before, after);
+    ASSERT_TRUE(before.has_value());
+    ASSERT_TRUE(after.has_value());
+    EXPECT_EQ(before->timestamp, 99500);
+    EXPECT_EQ(after->timestamp, 100500); // 位于下一个块
+    EXPECT_EQ(getDeviceIdOf(*after), "device-b");
+    EXPECT_EQ(index.getSegmentCount(), 2u);
+
+    // 跨段文件：之后的定位点在第二个段文件中
+    before.reset();
+    after.reset();
+    index.find(files, "device-a", 299999, 60000, before, after);
+    ASSERT_TRUE(before.has_value());
+    ASSERT_TRUE(after.has_value());
+    EXPECT_EQ(before->timestamp, 299000);
+    EXPECT_EQ(after->timestamp, 300000);
+
+    // 恰有定位点时前后均为该点
+    before.reset();
+    after.reset();
+    index.find(files, "device-a", 5000, 60000, before, after);
+    ASSERT_TRUE(before.has_value());
+    EXPECT_EQ(before->timestamp, 5000);
+    EXPECT_EQ(after->timestamp, 5000);
+
+    // 超出最大时间差或设备不存在时不返回
+    before.reset();
+    after.reset();
+    index.find(files, "device-a", 500000, 60000, before, after);
+    EXPECT_FALSE(before.has_value());
+    EXPECT_FALSE(after.has_value());
+    index.find(files, "device-c", 5000, 60000, before, after);
+    EXPECT_FALSE(before.has_value());
+
+    // 追加新块后只为新块补充索引
+    appendBlock(writer, 4);
+    index.find(files, "device-a", 450000, 60000, before, after);
+    ASSERT_TRUE(before.has_value());
+    EXPECT_EQ(before->timestamp, 450000);
+    ASSERT_TRUE(writer.finish());
+
+    // 段文件被压实替换（数量不变）后不再保留旧段的索引
+    std::string compacted = directory + "/locations_0_c1" + SEGMENT_FILE_EXTENSION;
+    std::filesystem::copy_file(first, compacted);
+    std::filesystem::remove(first);
+    files = {compacted, second};
+    before.reset();
+    after.reset();
+    index.find(files, "device-a", 5000, 60000, before, after);
+    ASSERT_TRUE(before.has_value());
+    EXPECT_EQ(before->timestamp, 5000);
+    EXPECT_EQ(index.getSegmentCount(), 2u);
+
+    // 段文件删除后不再保留索引
+    std::filesystem::remove(compacted);
+    files = {second};
+    before.reset();
+    after.reset();
+    index.find(files, "device-a", 5000, 60000, before, after);
+    EXPECT_FALSE(before.has_value());
+    EXPECT_EQ(index.getSegmentCount(), 1u);
+}
@@ -0,0 +1,156 @@
+#include "RetentionManager.h"
+#include "SegmentFile.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace {
+
+constexpr long long DAY_MS = 24LL * 3600 * 1000;
+constexpr long long BASE_TIME = 1620000000000LL;
+
+// 写出一个段文件，行按给定的时间戳、设备和精度生成
+void writeSegment(const std::string& path, const std::vector<long long>& timestamps,
+                  const std::vector<std::string>& devices, const std::vector<double>& accuracies) {
+    LocationColumns columns;
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        LocationInfo location;
+        location.timestamp = timestamps[i];
+        location.accuracy = accuracies[i];
+        location.latitude = 31.2;
+        location.longitude = 121.4;
+        location.status = LocationStatus::VALID;
+        location.setExtra(DEVICE_ID_EXTRA_KEY, devices[i]);
+        columns.append(location);
+    }
+    SegmentWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    ASSERT_TRUE(writer.appendBlock(columns));
+    ASSERT_TRUE(writer.finish());
+}
+
+// 读取目录中所有段文件的行
+std::vector<LocationInfo> readAll(const std::string& directory, size_t* segmentCount = nullptr) {
+    std::vector<LocationInfo> rows;
+    size_t segments = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() != SEGMENT_FILE_EXTENSION) {
+            continue;
+        }
+        segments++;
+        SegmentReader reader;
+        EXPECT_TRUE(reader.open(entry.path().string()));
+        for (size_t i = 0; i < reader.getBlocks().size(); ++i) {
+            LocationColumns columns;
+            EXPECT_TRUE(reader.readBlock(i, columns));
+            for (size_t row = 0; row < columns.size(); ++row) {
+                rows.push_back(columns.toLocationInfo(row));
+            }
+        }
+    }
+    if (segmentCount) {
+        *segmentCount = segments;
+    }
+    return rows;
+}
+
+// 只保留一个10秒分辨率层级的配置
+RetentionConfig downsampleConfig() {
+    RetentionConfig config;
+    config.tiers = {RetentionTier(0, 0), RetentionTier(7 * DAY_MS, 10 * 1000)};
+    config.ioBudgetBytesPerSecond = 0;
+    config.blockRowCount = 4;
+    return config;
+}
+
+std::string makeDirectory(const std::string& name) {
+    std::string directory = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+} // namespace
+
+// 测试时间范围重叠的段合并后每个设备每个桶只保留精度最好的一条，且输出按时间排序
+TEST(RetentionManagerTest, CompactsOverlappingSegments) {
+    std::string directory = makeDirectory("location_retention_overlap");
+    writeSegment(directory + "/locations_1" + SEGMENT_FILE_EXTENSION,
+                 {BASE_TIME + 25000, BASE_TIME + 1000, BASE_TIME + 2000, BASE_TIME + 12000},
+                 {"device-a", "device-a", "device-b", "device-a"}, {3.0, 5.0, 4.0, 6.0});
+    // 与上一个段重叠，并包含一条完全相同的行
+    writeSegment(directory + "/locations_2" + SEGMENT_FILE_EXTENSION,
+                 {BASE_TIME + 1000, BASE_TIME + 3000, BASE_TIME + 11000, BASE_TIME + 2000},
+                 {"device-a", "device-a", "device-a", "device-b"}, {5.0, 2.0, 7.0, 4.0});
+
+    RetentionManager manager(directory, downsampleConfig());
+    RetentionStats stats = manager.runOnce(BASE_TIME + 30 * DAY_MS);
+    EXPECT_EQ(stats.segmentsCompacted, 2u);
+    EXPECT_EQ(stats.segmentsWritten, 1u);
+    EXPECT_EQ(stats.rowsBefore, 8u);
+    EXPECT_EQ(stats.rowsAfter, 4u);
+
+    size_t segmentCount = 0;
+    std::vector<LocationInfo> rows = readAll(directory, &segmentCount);
+    EXPECT_EQ(segmentCount, 1u);
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0].timestamp, BASE_TIME + 2000);
+    EXPECT_EQ(getDeviceIdOf(rows[0]), "device-b");
+    EXPECT_EQ(rows[1].timestamp, BASE_TIME + 3000);
+    EXPECT_DOUBLE_EQ(rows[1].accuracy, 2.0);
+    EXPECT_EQ(rows[2].timestamp, BASE_TIME + 12000);
+    EXPECT_EQ(rows[3].timestamp, BASE_TIME + 25000);
+
+    // 再执行一轮：已压实的单个段不再变化
+    stats = manager.runOnce(BASE_TIME + 30 * DAY_MS);
+    EXPECT_EQ(stats.segmentsCompacted, 0u);
+    EXPECT_EQ(readAll(directory).size(), 4u);
+}
+
+// 测试按清单恢复中断的压实：新段已发布时补删旧段，未发布时保留旧段，临时文件被删除
+TEST(RetentionManagerTest, RecoversInterruptedCompaction) {
+    std::string directory = makeDirectory("location_retention_recover");
+    std::string published = directory + "/locations_100_c10000" + SEGMENT_FILE_EXTENSION;
+    std::string replaced = directory + "/locations_100" + SEGMENT_FILE_EXTENSION;
+    std::string kept = directory + "/locations_200" + SEGMENT_FILE_EXTENSION;
+    writeSegment(published, {BASE_TIME}, {"device-a"}, {1.0});
+    writeSegment(replaced, {BASE_TIME}, {"device-a"}, {1.0});
+    writeSegment(kept, {BASE_TIME + 100000}, {"device-b"}, {1.0});
+
+    std::ofstream(published + ".inputs") << "locations_100" << SEGMENT_FILE_EXTENSION << "\n";
+    std::ofstream(directory + "/locations_200_c10000" + SEGMENT_FILE_EXTENSION + ".inputs")
+        << "locations_200" << SEGMENT_FILE_EXTENSION << "\n";
+    std::ofstream(directory + "/locations_200_c10000" + SEGMENT_FILE_EXTENSION + ".compact.tmp") << "partial";
+
+    // 数据尚未到降采样的年龄，本轮只做恢复
+    RetentionManager manager(directory, downsampleConfig());
+    manager.runOnce(BASE_TIME + DAY_MS);
+
+    std::set<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        files.insert(entry.path().filename().string());
+    }
+    EXPECT_EQ(files, (std::set<std::string>{"locations_100_c10000" + std::string(SEGMENT_FILE_EXTENSION),
+                                            "locations_200" + std::string(SEGMENT_FILE_EXTENSION)}));
+    EXPECT_EQ(readAll(directory).size(), 2u);
+}
+
+// 测试超过最长保留时间的段被删除
+TEST(RetentionManagerTest, DeletesExpiredSegments) {
+    std::string directory = makeDirectory("location_retention_expire");
+    writeSegment(directory + "/locations_1" + SEGMENT_FILE_EXTENSION, {BASE_TIME}, {"device-a"}, {1.0});
+    writeSegment(directory + "/locations_2" + SEGMENT_FILE_EXTENSION, {BASE_TIME + 10 * DAY_MS},
+                 {"device-a"}, {1.0});
+
+    RetentionConfig config = downsampleConfig();
+    config.maxRetentionMs = 15 * DAY_MS;
+    RetentionManager manager(directory, config);
+    RetentionStats stats = manager.runOnce(BASE_TIME + 20 * DAY_MS);
+    EXPECT_EQ(stats.filesDeleted, 1u);
+
+    std::vector<LocationInfo> rows = readAll(directory);
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0].timestamp, BASE_TIME + 10 * DAY_MS);
+}
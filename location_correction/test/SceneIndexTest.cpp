@@ -0,0 +1,162 @@
+#include "SceneIndex.h"
+#include "ConfigModel.h"
+#include "Utils.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 测试用场景（与SceneConfig的位置字段相同）
+struct TestScene {
+    double latitude;
+    double longitude;
+    double radius;
+};
+
+// 逐个检查所有场景，结果按半径从小到大（半径相同时按下标）
+std::vector<size_t> bruteForce(const std::vector<TestScene>& scenes, double latitude, double longitude) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        if (scenes[i].radius > 0.0 &&
+            utils::calculateDistance(latitude, longitude, scenes[i].latitude, scenes[i].longitude) <= scenes[i].radius) {
+            result.push_back(i);
+        }
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [&scenes](size_t a, size_t b) { return scenes[a].radius < scenes[b].radius; });
+    return result;
+}
+
+} // namespace
+
+// 测试网格查询结果与逐个检查一致（包括大区域）
+TEST(SceneIndexTest, MatchesLinearScan) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> offset(-0.5, 0.5);
+    std::uniform_real_distribution<double> radius(50.0, 2000.0);
+
+    std::vector<TestScene> scenes;
+    for (int i = 0; i < 3000; ++i) {
+        scenes.push_back(TestScene{31.2 + offset(random), 121.4 + offset(random), radius(random)});
+    }
+    scenes.push_back(TestScene{31.2, 121.4, 50000.0});
+    scenes.push_back(TestScene{31.0, 121.0, 0.0});
+
+    SceneIndex index;
+    index.build(scenes);
+    EXPECT_EQ(index.size(), 3001u);
+
+    std::vector<size_t> found;
+    for (int i = 0; i < 2000; ++i) {
+        double latitude = 31.2 + offset(random) * 1.2;
+        double longitude = 121.4 + offset(random) * 1.2;
+        index.query(latitude, longitude, found);
+        std::vector<size_t> expected = bruteForce(scenes, latitude, longitude);
+        ASSERT_EQ(found, expected) << "at " << latitude << ", " << longitude;
+
+        int64_t region = index.findRegion(latitude, longitude);
+        if (expected.empty()) {
+            EXPECT_EQ(region, -1);
+        } else {
+            ASSERT_GE(region, 0);
+            EXPECT_EQ(index.getRegion(static_cast<size_t>(region)).scene, expected.front());
+        }
+    }
+}
+
+// 测试跨越180度经线的区域
+TEST(SceneIndexTest, WrapsAroundAntimeridian) {
+    std::vector<TestScene> scenes = {{0.0, 179.999, 1000.0}, {10.0, 20.0, 500.0}};
+    SceneIndex index;
+    index.build(scenes);
+
+    std::vector<size_t> found;
+    index.query(0.0, -179.999, found);
+    EXPECT_EQ(found, std::vector<size_t>{0});
+    index.query(0.0, 179.0, found);
+    EXPECT_TRUE(found.empty());
+}
+
+// 测试按设备缓存：留在独立区域内时命中缓存，相交的区域每次查询索引，替换索引后缓存失效
+TEST(SceneIndexTest, LocatorCachesExclusiveRegion) {
+    std::vector<TestScene> scenes = {{31.20, 121.40, 300.0},    // 独立区域
+                                     {31.30, 121.50, 1000.0},   // 与下一个区域相交
+                                     {31.30, 121.501, 200.0}};
+    auto index = std::make_shared<SceneIndex>();
+    index->build(scenes);
+    EXPECT_TRUE(index->isExclusive(index->findRegion(31.20, 121.40)));
+    EXPECT_FALSE(index->isExclusive(index->findRegion(31.30, 121.501)));
+
+    SceneLocator locator(4);
+    EXPECT_EQ(locator.locate("device-1", 31.20, 121.40), -1);
+    locator.setIndex(index);
+
+    EXPECT_EQ(locator.locate("device-1", 31.20, 121.40), 0);
+    EXPECT_EQ(locator.locate("device-1", 31.2005, 121.4005), 0);
+    EXPECT_EQ(locator.getHitCount(), 1u);
+
+    // 相交区域中返回最小的区域，不缓存
+    EXPECT_EQ(locator.locate("device-2", 31.30, 121.501), 2);
+    EXPECT_EQ(locator.locate("device-2", 31.30, 121.501), 2);
+    EXPECT_EQ(locator.locate("device-2", 31.30, 121.495), 1);
+    EXPECT_EQ(locator.getHitCount(), 1u);
+
+    // 离开缓存的区域
+    EXPECT_EQ(locator.locate("device-1", 31.25, 121.45), -1);
+    EXPECT_EQ(locator.getMissCount(), 5u);
+
+    // 替换索引后重新查询
+    EXPECT_EQ(locator.locate("device-1", 31.20, 121.40), 0);
+    auto moved = std::make_shared<SceneIndex>();
+    std::vector<TestScene> movedScenes = {{31.21, 121.40, 300.0}};
+    moved->build(movedScenes);
+    locator.setIndex(moved);
+    EXPECT_EQ(locator.locate("device-1", 31.20, 121.40), -1);
+}
+
+// 测试按调用方传入的索引定位：结果总是属于传入的索引，换用另一个索引时清空缓存
+TEST(SceneIndexTest, LocatorUsesCallerIndex) {
+    std::vector<TestScene> scenes = {{31.20, 121.40, 300.0}};
+    std::vector<TestScene> movedScenes = {{31.10, 121.30, 300.0}, {31.20, 121.40, 300.0}};
+    auto index = std::make_shared<SceneIndex>();
+    index->build(scenes);
+    auto moved = std::make_shared<SceneIndex>();
+    moved->build(movedScenes);
+
+    SceneLocator locator(4);
+    std::shared_ptr<const SceneIndex> none;
+    EXPECT_EQ(locator.locate(none, "device-1", 31.20, 121.40), -1);
+
+    EXPECT_EQ(locator.locate(index, "device-1", 31.20, 121.40), 0);
+    EXPECT_EQ(locator.locate(index, "device-1", 31.2005, 121.4005), 0);
+    EXPECT_EQ(locator.getHitCount(), 1u);
+
+    // 缓存的区域编号属于旧索引，新索引中同一位置的场景下标不同
+    EXPECT_EQ(locator.locate(moved, "device-1", 31.2005, 121.4005), 1);
+    EXPECT_EQ(locator.getHitCount(), 1u);
+    EXPECT_EQ(locator.locate(moved, "device-1", 31.2005, 121.4005), 1);
+    EXPECT_EQ(locator.getHitCount(), 2u);
+}
+
+// 测试只配置了位置字段的场景区域：参与索引且默认启用纠偏
+TEST(SceneIndexTest, DefaultSceneConfigRegion) {
+    std::vector<SceneConfig> scenes(2);
+    scenes[0].sceneId = "campus";
+    scenes[0].latitude = 31.20;
+    scenes[0].longitude = 121.40;
+    scenes[0].radius = 500.0;
+    scenes[1].sceneId = "unplaced"; // 没有半径，不参与索引
+
+    auto index = std::make_shared<SceneIndex>();
+    index->build(scenes);
+    EXPECT_EQ(index->size(), 1u);
+
+    SceneLocator locator(4);
+    int64_t scene = locator.locate(index, "device-1", 31.2001, 121.4001);
+    ASSERT_EQ(scene, 0);
+    EXPECT_TRUE(scenes[static_cast<size_t>(scene)].enableCorrection);
+    EXPECT_TRUE(SceneConfig().enableCorrection);
+}
@@ -0,0 +1,217 @@
+#include "StorageQuery.h"
+#include "SegmentFile.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+
+// 生成多个段文件，每个段4个块，时间戳连续递增
+std::vector<std::string> makeSegments(const std::string& directory, int segmentCount) {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::string> files;
+    for (int segment = 0; segment < segmentCount; ++segment) {
+        std::string path = directory + "/locations_" + std::to_string(1000 + segment) + SEGMENT_FILE_EXTENSION;
+        SegmentWriter writer;
+        writer.open(path);
+        for (int block = 0; block < 4; ++block) {
+            LocationColumns columns;
+            for (int i = 0; i < 250; ++i) {
+                LocationInfo location;
+                location.timestamp = (segment * 1000 + block * 250 + i) * 10LL;
+                location.accuracy = i % 50;
+                location.sourceType = i % 2 ? DataSourceType::GNSS : DataSourceType::WIFI;
+                location.setExtra(DEVICE_ID_EXTRA_KEY, i % 3 ? "device-a" : "device-b");
+                columns.append(location);
+            }
+            writer.appendBlock(columns);
+        }
+        writer.finish();
+        files.push_back(path);
+    }
+    return files;
+}
+
+} // namespace
+
+// 测试并行查询的结果与逐条过滤一致且按时间排序
+TEST(StorageQueryTest, PredicateTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_query_test").string();
+    std::vector<std::string> files = makeSegments(directory, 20);
+    QueryExecutor executor(4);
+
+    std::vector<LocationInfo> all = executor.execute(files, QueryPredicate());
+    ASSERT_EQ(all.size(), 20000u);
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end(), [](const LocationInfo& a, const LocationInfo& b) {
+        return a.timestamp < b.timestamp;
+    }));
+
+    QueryPredicate predicate;
+    predicate.startTime = 50000;
+    predicate.endTime = 59990;
+    predicate.deviceId = "device-b";
+    predicate.sourceType = DataSourceType::GNSS;
+    predicate.maxAccuracy = 10.0;
+
+    QueryStats stats;
+    std::vector<LocationInfo> result = executor.execute(files, predicate, &stats);
+    size_t expected = std::count_if(all.begin(), all.end(), [&](const LocationInfo& location) {
+        return predicate.matches(location);
+    });
+    EXPECT_EQ(result.size(), expected);
+    EXPECT_EQ(stats.segmentsScanned, 1u);
+    EXPECT_EQ(stats.segmentsPruned, 19u);
+
+    std::filesystem::remove_all(directory);
+}
+
+// 测试"最新N条"查询只解码必要的块
+TEST(StorageQueryTest, LatestLimitTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_query_test").string();
+    std::vector<std::string> files = makeSegments(directory, 20);
+    QueryExecutor executor(4);
+
+    QueryPredicate predicate;
+    predicate.limit = 100;
+    predicate.latestFirst = true;
+
+    QueryStats stats;
+    std::vector<LocationInfo> latest = executor.execute(files, predicate, &stats);
+    ASSERT_EQ(latest.size(), 100u);
+    EXPECT_EQ(latest.front().timestamp, 199990);
+    EXPECT_EQ(latest.back().timestamp, 199000);
+    EXPECT_EQ(stats.blocksScanned, 1u);
+
+    // 正序limit返回最早的数据
+    predicate.limit = 3;
+    predicate.latestFirst = false;
+    std::vector<LocationInfo> earliest = executor.execute(files, predicate);
+    ASSERT_EQ(earliest.size(), 3u);
+    EXPECT_EQ(earliest[0].timestamp, 0);
+    EXPECT_EQ(earliest[2].timestamp, 20);
+
+    std::filesystem::remove_all(directory);
+}
+
+// 测试流式游标逐批返回投影后的数据
+TEST(StorageQueryTest, CursorTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_query_test").string();
+    std::vector<std::string> files = makeSegments(directory, 5);
+
+    QueryPredicate predicate;
+    predicate.deviceId = "device-b";
+    predicate.maxAccuracy = 20.0;
+    uint32_t columnMask = codecColumnBit(CodecColumn::LATITUDE) | codecColumnBit(CodecColumn::LONGITUDE);
+    LocationCursor cursor(files, predicate, columnMask, 100);
+
+    LocationColumns batch;
+    size_t total = 0;
+    long long lastTimestamp = -1;
+    while (cursor.next(batch)) {
+        ASSERT_LE(batch.size(), 100u);
+        for (size_t row = 0; row < batch.size(); ++row) {
+            EXPECT_GT(batch.timestamps[row], lastTimestamp);
+            lastTimestamp = batch.timestamps[row];
+            // 未投影的列不返回
+            EXPECT_EQ(batch.accuracies[row], 0.0);
+            EXPECT_TRUE(batch.getDeviceId(row).empty());
+        }
+        total += batch.size();
+    }
+
+    QueryExecutor executor(2);
+    EXPECT_EQ(total, executor.execute(files, predicate).size());
+    EXPECT_EQ(cursor.getStats().rowsMatched, total);
+
+    // 倒序游标配合limit返回最新数据
+    QueryPredicate latest;
+    latest.limit = 10;
+    latest.latestFirst = true;
+    LocationCursor latestCursor(files, latest);
+    ASSERT_TRUE(latestCursor.next(batch));
+    ASSERT_EQ(batch.size(), 10u);
+    EXPECT_EQ(batch.timestamps.front(), 49990);
+    EXPECT_EQ(batch.toLocationInfo(0).getExtra(DEVICE_ID_EXTRA_KEY), "device-b");
+    EXPECT_FALSE(latestCursor.next(batch));
+    EXPECT_EQ(latestCursor.getStats().blocksScanned, 1u);
+
+    std::filesystem::remove_all(directory);
+}
+
+// 测试按数据源类型和状态查询时根据块掩码和行位图跳过块
+TEST(StorageQueryTest, BitmapIndexTest) {
+    std::string directory = (std::filesystem::temp_directory_path() / "location_bitmap_test").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = directory + "/locations_0" + SEGMENT_FILE_EXTENSION;
+
+    // 块0全部为GNSS；块1每100行有一行WIFI（稀疏），状态交替；块2一半GNSS一半基站（稠密）
+    SegmentWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    for (int block = 0; block < 3; ++block) {
+        LocationColumns columns;
+        for (int i = 0; i < 1000; ++i) {
+            LocationInfo location;
+            location.timestamp = block * 1000 + i;
+            location.latitude = 30.0 + i * 1e-5;
+            location.status = LocationStatus::VALID;
+            location.sourceType = DataSourceType::GNSS;
+            if (block == 1) {
+                location.sourceType = i % 100 == 0 ? DataSourceType::WIFI : DataSourceType::BASE_STATION;
+                location.status = i % 2 ? LocationStatus::INVALID : LocationStatus::VALID;
+            } else if (block == 2 && i % 2) {
+                location.sourceType = DataSourceType::BASE_STATION;
+            }
+            columns.append(location);
+        }
+        ASSERT_TRUE(writer.appendBlock(columns));
+    }
+    ASSERT_TRUE(writer.finish());
+    std::vector<std::string> files = {path};
+
+    SegmentReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_FALSE(reader.getBlocks()[0].mayContain(DataSourceType::WIFI, std::nullopt));
+    EXPECT_TRUE(reader.getBlocks()[1].mayContain(DataSourceType::WIFI, LocationStatus::INVALID));
+    EXPECT_FALSE(reader.mayContain(DataSourceType::SENSOR, std::nullopt));
+
+    QueryExecutor executor(2);
+    QueryPredicate predicate;
+    predicate.sourceType = DataSourceType::WIFI;
+    QueryStats stats;
+    EXPECT_EQ(executor.execute(files, predicate, &stats).size(), 10u);
+    EXPECT_EQ(stats.blocksPruned, 2u);
+    EXPECT_EQ(stats.blocksScanned, 1u);
+
+    // 两个条件各自存在于块中，但行位图的交集为空，不解码
+    predicate.status = LocationStatus::INVALID;
+    EXPECT_TRUE(executor.execute(files, predicate, &stats).empty());
+    EXPECT_EQ(stats.blocksPruned, 3u);
+    EXPECT_EQ(stats.blocksScanned, 0u);
+
+    predicate.sourceType = DataSourceType::GNSS;
+    predicate.status = LocationStatus::VALID;
+    std::vector<LocationInfo> result = executor.execute(files, predicate, &stats);
+    ASSERT_EQ(result.size(), 1500u);
+    EXPECT_EQ(stats.blocksPruned, 1u);
+    for (const auto& location : result) {
+        EXPECT_EQ(location.sourceType, DataSourceType::GNSS);
+    }
+
+    // 游标只返回纬度列，数据源类型和状态由行位图判断
+    LocationCursor cursor(files, predicate, codecColumnBit(CodecColumn::LATITUDE), 256);
+    LocationColumns batch;
+    size_t total = 0;
+    while (cursor.next(batch)) {
+        for (size_t row = 0; row < batch.size(); ++row) {
+            EXPECT_TRUE(batch.timestamps[row] < 1000 || (batch.timestamps[row] >= 2000 && batch.timestamps[row] % 2 == 0));
+        }
+        total += batch.size();
+    }
+    EXPECT_EQ(total, 1500u);
+    EXPECT_EQ(cursor.getStats().blocksPruned, 1u);
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,219 @@
+#include "StorageTee.h"
+#include "DataStorage.h"
+#include <gtest/gtest.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 记录写入数据的测试后端，可设置为写入失败或暂停写入
+class RecordingStorage : public MemoryStorage {
+public:
+    enum class Mode { NORMAL, FAIL, THROW };
+
+    explicit RecordingStorage(Mode storageMode = Mode::NORMAL) : mode(storageMode), paused(false), calls(0) {}
+
+    bool store(const LocationInfo& location) override {
+        return batchStore(std::vector<LocationInfo>{location});
+    }
+
+    bool batchStore(const std::vector<LocationInfo>& locations) override {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        calls++;
+        callCV.notify_all();
+        resumeCV.wait(lock, [this] { return !paused; });
+        if (mode == Mode::THROW) {
+            throw std::runtime_error("backend unavailable");
+        }
+        if (mode == Mode::FAIL) {
+            return false;
+        }
+        for (const auto& location : locations) {
+            timestamps.push_back(location.timestamp);
+        }
+        return true;
+    }
+
+    // 暂停写入（写入线程停在下一次写入中）
+    void pause() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        paused = true;
+    }
+
+    // 恢复写入
+    void resume() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            paused = false;
+        }
+        resumeCV.notify_all();
+    }
+
+    // 等待写入线程进入第n次写入
+    void waitForCalls(size_t count) {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        callCV.wait(lock, [&] { return calls >= count; });
+    }
+
+    std::vector<long long> getTimestamps() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return timestamps;
+    }
+
+private:
+    Mode mode;
+    bool paused;
+    size_t calls;
+    std::vector<long long> timestamps;
+    std::mutex stateMutex;
+    std::condition_variable callCV;
+    std::condition_variable resumeCV;
+};
+
+LocationInfo makeLocation(long long timestamp) {
+    LocationInfo location;
+    location.timestamp = timestamp;
+    location.status = LocationStatus::VALID;
+    return location;
+}
+
+// 每条数据单独成批，便于控制写入线程的进度
+TeeBackendConfig singleRowConfig(TeeOverflowPolicy policy) {
+    TeeBackendConfig config;
+    config.batchSize = 1;
+    config.maxBatchDelayMs = 0;
+    config.policy = policy;
+    return config;
+}
+
+} // namespace
+
+// 测试DROP_OLDEST：慢后端只丢弃自己最早的数据，生产者和其他后端不受影响
+TEST(StorageTeeTest, DropOldestSkipsOnlySlowBackend) {
+    StorageTee tee(4);
+    auto slow = std::make_shared<RecordingStorage>();
+    auto fast = std::make_shared<RecordingStorage>();
+    slow->pause();
+    ASSERT_TRUE(tee.addBackend("slow", slow, singleRowConfig(TeeOverflowPolicy::DROP_OLDEST)));
+    ASSERT_TRUE(tee.addBackend("fast", fast, singleRowConfig(TeeOverflowPolicy::BLOCK)));
+
+    // 慢后端取走第0条后停住，之后的数据只能留在缓冲区中
+    ASSERT_TRUE(tee.publish(makeLocation(0)));
+    slow->waitForCalls(1);
+    for (long long i = 1; i < 10; ++i) {
+        ASSERT_TRUE(tee.publish(makeLocation(i)));
+    }
+
+    TeeBackendStats stats;
+    ASSERT_TRUE(tee.getStats("slow", stats));
+    EXPECT_EQ(stats.dropped, 5u);
+    EXPECT_EQ(stats.pending, 5u); // 写入中的1条和缓冲区中的4条
+
+    slow->resume();
+    tee.flush();
+    EXPECT_EQ(slow->getTimestamps(), (std::vector<long long>{0, 6, 7, 8, 9}));
+    EXPECT_EQ(fast->getTimestamps(), (std::vector<long long>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    ASSERT_TRUE(tee.getStats("fast", stats));
+    EXPECT_EQ(stats.written, 10u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.pending, 0u);
+}
+
+// 测试BLOCK：缓冲区满时生产者等待该后端，数据不丢失
+TEST(StorageTeeTest, BlockWaitsForBackend) {
+    StorageTee tee(4);
+    auto storage = std::make_shared<RecordingStorage>();
+    storage->pause();
+    ASSERT_TRUE(tee.addBackend("archive", storage, singleRowConfig(TeeOverflowPolicy::BLOCK)));
+
+    ASSERT_TRUE(tee.publish(makeLocation(0)));
+    storage->waitForCalls(1);
+    for (long long i = 1; i <= 4; ++i) {
+        ASSERT_TRUE(tee.publish(makeLocation(i)));
+    }
+
+    // 缓冲区已满，下一条数据要等后端写入后才能入队
+    std::atomic<bool> published(false);
+    std::thread producer([&] {
+        tee.publish(makeLocation(5));
+        published = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(published.load());
+
+    storage->resume();
+    producer.join();
+    EXPECT_TRUE(published.load());
+    tee.flush();
+
+    EXPECT_EQ(storage->getTimestamps(), (std::vector<long long>{0, 1, 2, 3, 4, 5}));
+    TeeBackendStats stats;
+    ASSERT_TRUE(tee.getStats("archive", stats));
+    EXPECT_EQ(stats.written, 6u);
+    EXPECT_EQ(stats.dropped, 0u);
+}
+
+// 测试写入失败和抛出异常的后端只计入失败统计，不影响其他后端
+TEST(StorageTeeTest, FailingBackendIsIsolated) {
+    StorageTee tee(16);
+    auto failing = std::make_shared<RecordingStorage>(RecordingStorage::Mode::FAIL);
+    auto throwing = std::make_shared<RecordingStorage>(RecordingStorage::Mode::THROW);
+    auto healthy = std::make_shared<RecordingStorage>();
+    TeeBackendConfig config;
+    config.batchSize = 4;
+    config.maxBatchDelayMs = 5;
+    ASSERT_TRUE(tee.addBackend("failing", failing, config));
+    ASSERT_TRUE(tee.addBackend("throwing", throwing, config));
+    ASSERT_TRUE(tee.addBackend("healthy", healthy, config));
+
+    std::vector<LocationInfo> locations;
+    for (long long i = 0; i < 10; ++i) {
+        locations.push_back(makeLocation(i));
+    }
+    ASSERT_TRUE(tee.publish(locations));
+    tee.flush();
+
+    TeeBackendStats stats;
+    ASSERT_TRUE(tee.getStats("failing", stats));
+    EXPECT_EQ(stats.failed, 10u);
+    EXPECT_EQ(stats.written, 0u);
+    ASSERT_TRUE(tee.getStats("throwing", stats));
+    EXPECT_EQ(stats.failed, 10u);
+    ASSERT_TRUE(tee.getStats("healthy", stats));
+    EXPECT_EQ(stats.written, 10u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(healthy->getTimestamps().size(), 10u);
+}
+
+// 测试每个后端有独立的读位置：后加入的后端只接收加入之后的数据，移除后端时写完积压数据
+TEST(StorageTeeTest, PerBackendCursors) {
+    StorageTee tee(16);
+    auto first = std::make_shared<RecordingStorage>();
+    ASSERT_TRUE(tee.addBackend("first", first));
+    ASSERT_FALSE(tee.addBackend("first", first));
+    ASSERT_TRUE(tee.publish(makeLocation(1)));
+    ASSERT_TRUE(tee.publish(makeLocation(2)));
+    tee.flush();
+
+    auto second = std::make_shared<RecordingStorage>();
+    ASSERT_TRUE(tee.addBackend("second", second));
+    ASSERT_TRUE(tee.publish(makeLocation(3)));
+
+    ASSERT_TRUE(tee.removeBackend("second"));
+    EXPECT_FALSE(tee.removeBackend("second"));
+    TeeBackendStats stats;
+    EXPECT_FALSE(tee.getStats("second", stats));
+    tee.flush();
+
+    EXPECT_EQ(first->getTimestamps(), (std::vector<long long>{1, 2, 3}));
+    EXPECT_EQ(second->getTimestamps(), (std::vector<long long>{3}));
+
+    tee.shutdown();
+    EXPECT_FALSE(tee.publish(makeLocation(4)));
+    EXPECT_FALSE(tee.addBackend("third", std::make_shared<RecordingStorage>()));
+}
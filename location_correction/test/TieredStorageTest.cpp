@@ -0,0 +1,170 @@
+#include "DataStorage.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <thread>
+
+namespace {
+
+constexpr long long BASE_TIME = 1620000000000LL;
+
+LocationInfo makeLocation(long long index) {
+    LocationInfo location;
+    location.timestamp = BASE_TIME + index * 1000;
+    location.latitude = 31.2 + index * 1e-5;
+    location.longitude = 121.4;
+    location.accuracy = 5.0;
+    location.status = LocationStatus::VALID;
+    location.setExtra(DEVICE_ID_EXTRA_KEY, index % 2 ? "device-a" : "device-b");
+    return location;
+}
+
+// 在临时目录中初始化分层存储
+std::unique_ptr<TieredStorage> makeStorage(const std::string& name) {
+    std::string directory = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove_all(directory);
+
+    auto storage = std::make_unique<TieredStorage>();
+    StorageConfig config;
+    config.storagePath = directory;
+    EXPECT_TRUE(storage->initialize(config));
+    return storage;
+}
+
+// 等待后台降级把热层降到预算以内
+bool waitForDemotion(TieredStorage& storage, uint64_t minDemotedRows) {
+    for (int i = 0; i < 500; ++i) {
+        TieredStorageStats stats = storage.getStats();
+        if (stats.demotedRows >= minDemotedRows && stats.hotMemoryBytes <= storage.getHotMemoryBudget()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// 热层预算设为大约rows条数据的占用
+size_t budgetFor(size_t rows) {
+    return rows * (sizeof(LocationInfo) + 2 * sizeof(std::string) + 64);
+}
+
+} // namespace
+
+// 测试降级后查询合并两层数据，结果按时间排序且不重复
+TEST(TieredStorageTest, MergesTiersInOrder) {
+    auto storage = makeStorage("location_tiered_merge");
+    storage->setHotMemoryBudget(budgetFor(40));
+
+    // 乱序写入：冷层和热层的时间范围交错
+    std::vector<LocationInfo> locations;
+    for (long long i = 0; i < 200; ++i) {
+        locations.push_back(makeLocation(i % 2 ? 199 - i / 2 : i / 2));
+    }
+    ASSERT_TRUE(storage->batchStore(locations));
+    ASSERT_TRUE(waitForDemotion(*storage, 100));
+
+    TieredStorageStats stats = storage->getStats();
+    EXPECT_GT(stats.hotRows, 0u);
+    EXPECT_EQ(stats.hotRows + stats.demotedRows, 200u);
+
+    std::vector<LocationInfo> ascending = storage->queryByTimeRange(BASE_TIME, BASE_TIME + 199 * 1000);
+    ASSERT_EQ(ascending.size(), 200u);
+    for (size_t i = 0; i < ascending.size(); ++i) {
+        EXPECT_EQ(ascending[i].timestamp, BASE_TIME + static_cast<long long>(i) * 1000);
+    }
+
+    QueryPredicate predicate;
+    predicate.latestFirst = true;
+    std::vector<LocationInfo> descending = storage->query(predicate);
+    ASSERT_EQ(descending.size(), 200u);
+    EXPECT_EQ(descending.front().timestamp, BASE_TIME + 199 * 1000);
+    EXPECT_EQ(descending.back().timestamp, BASE_TIME);
+    EXPECT_EQ(storage->getStats().coldQueries, 2u);
+    storage->close();
+}
+
+// 测试热层已有足够多比冷层更新的数据、或查询范围晚于冷层时只访问热层
+TEST(TieredStorageTest, SkipsColdTierWhenHotSuffices) {
+    auto storage = makeStorage("location_tiered_skip");
+    storage->setHotMemoryBudget(budgetFor(40));
+    for (long long i = 0; i < 200; ++i) {
+        ASSERT_TRUE(storage->store(makeLocation(i)));
+    }
+    ASSERT_TRUE(waitForDemotion(*storage, 100));
+    uint64_t demoted = storage->getStats().demotedRows;
+
+    // 最新的5条都在热层
+    QueryPredicate latest;
+    latest.latestFirst = true;
+    latest.limit = 5;
+    std::vector<LocationInfo> rows = storage->query(latest);
+    ASSERT_EQ(rows.size(), 5u);
+    EXPECT_EQ(rows.front().timestamp, BASE_TIME + 199 * 1000);
+    EXPECT_EQ(rows.back().timestamp, BASE_TIME + 195 * 1000);
+    std::optional<LocationInfo> newest = storage->getLatestLocation();
+    ASSERT_TRUE(newest.has_value());
+    EXPECT_EQ(newest->timestamp, BASE_TIME + 199 * 1000);
+
+    // 查询范围晚于冷层最新数据
+    rows = storage->queryByTimeRange(BASE_TIME + static_cast<long long>(demoted) * 1000, BASE_TIME + 199 * 1000);
+    EXPECT_EQ(rows.size(), 200u - demoted);
+
+    TieredStorageStats stats = storage->getStats();
+    EXPECT_EQ(stats.hotOnlyQueries, 3u);
+    EXPECT_EQ(stats.coldQueries, 0u);
+
+    // 超出热层的条数限制需要访问冷层
+    latest.limit = 150;
+    rows = storage->query(latest);
+    ASSERT_EQ(rows.size(), 150u);
+    EXPECT_EQ(rows.back().timestamp, BASE_TIME + 50 * 1000);
+    EXPECT_EQ(storage->getStats().coldQueries, 1u);
+    storage->close();
+}
+
+// 测试降级与查询并发时查询结果既不丢失也不重复
+TEST(TieredStorageTest, ConcurrentDemotionKeepsResultsExact) {
+    auto storage = makeStorage("location_tiered_concurrent");
+    storage->setHotMemoryBudget(budgetFor(50));
+
+    const long long total = 20000;
+    std::atomic<long long> stored(0);
+    std::thread producer([&] {
+        for (long long i = 0; i < total; ++i) {
+            storage->store(makeLocation(i));
+            stored = i + 1;
+        }
+    });
+
+    while (stored < total) {
+        long long before = stored;
+        std::vector<LocationInfo> rows = storage->queryByTimeRange(BASE_TIME, BASE_TIME + total * 1000);
+        std::set<long long> timestamps;
+        for (const auto& row : rows) {
+            ASSERT_TRUE(timestamps.insert(row.timestamp).second) << "duplicate " << row.timestamp;
+        }
+        ASSERT_GE(rows.size(), static_cast<size_t>(before));
+        for (long long i = 0; i < before; ++i) {
+            ASSERT_TRUE(timestamps.count(BASE_TIME + i * 1000)) << "missing " << i;
+        }
+
+        auto cursor = storage->openCursor(QueryPredicate());
+        std::set<long long> cursorTimestamps;
+        LocationColumns batch;
+        while (cursor->next(batch)) {
+            for (size_t row = 0; row < batch.size(); ++row) {
+                ASSERT_TRUE(cursorTimestamps.insert(batch.timestamps[row]).second)
+                    << "cursor duplicate " << batch.timestamps[row];
+            }
+        }
+        ASSERT_GE(cursorTimestamps.size(), static_cast<size_t>(before));
+    }
+    producer.join();
+
+    EXPECT_GT(storage->getStats().demotedRows, 0u);
+    EXPECT_EQ(storage->queryByTimeRange(BASE_TIME, BASE_TIME + total * 1000).size(), static_cast<size_t>(total));
+    storage->close();
+}
@@ -0,0 +1,113 @@
+#include "WriteAheadLog.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+
+namespace {
+
+// 生成指定数量的位置数据
+LocationColumns makeRows(size_t count, long long startTime) {
+    LocationColumns rows;
+    for (size_t i = 0; i < count; ++i) {
+        LocationInfo location;
+        location.timestamp = startTime + static_cast<long long>(i) * 1000;
+        location.latitude = 39.9042;
+        location.longitude = 116.4074;
+        location.accuracy = 5.0;
+        location.setExtra(DEVICE_ID_EXTRA_KEY, "device-a");
+        rows.append(location);
+    }
+    return rows;
+}
+
+// 创建空的日志目录
+std::string makeWalDirectory() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "location_wal_test";
+    std::filesystem::remove_all(directory);
+    return directory.string();
+}
+
+// 重放日志并返回所有时间戳
+std::vector<long long> replayTimestamps(const WriteAheadLog& wal, uint64_t fromLsn) {
+    std::vector<long long> timestamps;
+    wal.replay(fromLsn, [&](uint64_t, const LocationColumns& rows) {
+        timestamps.insert(timestamps.end(), rows.timestamps.begin(), rows.timestamps.end());
+    });
+    return timestamps;
+}
+
+} // namespace
+
+// 测试CRC32C标准测试向量
+TEST(WriteAheadLogTest, Crc32cTest) {
+    const std::string data = "123456789";
+    EXPECT_EQ(WriteAheadLog::crc32c(reinterpret_cast<const uint8_t*>(data.data()), data.size()), 0xE3069283u);
+
+    // 分段计算结果应与整体计算一致
+    uint32_t partial = WriteAheadLog::crc32c(reinterpret_cast<const uint8_t*>(data.data()), 4);
+    partial = WriteAheadLog::crc32c(reinterpret_cast<const uint8_t*>(data.data()) + 4, 5, partial);
+    EXPECT_EQ(partial, 0xE3069283u);
+}
+
+// 测试写入、重放以及末尾不完整记录的截断
+TEST(WriteAheadLogTest, TornTailRecoveryTest) {
+    std::string directory = makeWalDirectory();
+
+    uint64_t firstEnd = 0;
+    {
+        WriteAheadLog wal;
+        ASSERT_TRUE(wal.open(directory));
+        firstEnd = wal.append(makeRows(10, 1000000));
+        ASSERT_GT(firstEnd, 0u);
+        ASSERT_GT(wal.append(makeRows(5, 2000000)), firstEnd);
+    }
+
+    // 截掉最后一条记录的末尾，模拟写入过程中崩溃
+    std::string walFile = std::filesystem::directory_iterator(directory)->path().string();
+    std::filesystem::resize_file(walFile, std::filesystem::file_size(walFile) - 3);
+
+    WriteAheadLog wal;
+    ASSERT_TRUE(wal.open(directory));
+    EXPECT_EQ(wal.getEndLsn(), firstEnd);
+    EXPECT_EQ(replayTimestamps(wal, 0).size(), 10u);
+
+    // 截断后可以继续追加
+    ASSERT_GT(wal.append(makeRows(3, 3000000)), firstEnd);
+    std::vector<long long> timestamps = replayTimestamps(wal, 0);
+    ASSERT_EQ(timestamps.size(), 13u);
+    EXPECT_EQ(timestamps.back(), 3002000);
+
+    wal.close();
+    std::filesystem::remove_all(directory);
+}
+
+// 测试检查点之后只重放新记录，并清理旧日志文件
+TEST(WriteAheadLogTest, CheckpointTest) {
+    std::string directory = makeWalDirectory();
+
+    WriteAheadLog wal;
+    wal.setMaxFileSize(256);
+    ASSERT_TRUE(wal.open(directory));
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_GT(wal.append(makeRows(4, 1000000 + i * 10000)), 0u);
+    }
+
+    WalCheckpoint checkpoint;
+    checkpoint.lsn = wal.getEndLsn();
+    checkpoint.meta = "snapshot";
+    ASSERT_TRUE(wal.writeCheckpoint(checkpoint));
+    wal.truncateBefore(checkpoint.lsn);
+    ASSERT_GT(wal.append(makeRows(2, 9000000)), checkpoint.lsn);
+    wal.close();
+
+    WalCheckpoint loaded;
+    ASSERT_TRUE(wal.open(directory, &loaded));
+    EXPECT_EQ(loaded.lsn, checkpoint.lsn);
+    EXPECT_EQ(loaded.meta, "snapshot");
+
+    std::vector<long long> timestamps = replayTimestamps(wal, loaded.lsn);
+    ASSERT_EQ(timestamps.size(), 2u);
+    EXPECT_EQ(timestamps.front(), 9000000);
+
+    wal.close();
+    std::filesystem::remove_all(directory);
+}